@@ -40,21 +40,27 @@
 #include "compiler/CompilerEngine.h"
 #include "compiler/CallingConvention.h"
 #include "compiler/MethodCompiler.h"
+#include "compiler/MethodInliner.h"
 #include "compiler/CompilerInterface.h"
 #include "compiler/CompilerTrace.h"
 #include "compiler/opcodes/RegisterEvaluatorOpcodes.h"
+#include "compiler/opcodes/ConstOpcodes.h"
 #include "compiler/opcodes/CompilerOpcodes.h"
 
 const char CallingConvention::gCILMethodPrefix[] = "?CIL?STD?MTD?";
+const char CallingConvention::gCILRegisterEntryPrefix[] = "?CIL?REG?MTD?";
 const char CallingConvention::gCILTokenPrefix[]  = "?CIL?STD?TKN?";
 const char CallingConvention::gCILGlobalPrefix[] = "?CIL?STD?BSS?";
 const char CallingConvention::gCILGlobalDataPrefix[] = "?CIL?STD?DATA?";
+const char CallingConvention::gUnwindDataName[] = "?CIL?STD?UNWIND?DATA";
+const char CallingConvention::gUnwindTableName[] = "?CIL?STD?UNWIND?TABLE";
 
 const char CallingConvention::gCallingConventionCustomAttributeName[] = "CallingConvention";
 const char CallingConvention::gCallingArgumentName[] = "callingConvention";
 const char CallingConvention::gCallingConventionStdcall[] = "stdcall";
 const char CallingConvention::gCallingConventionCdecl[] = "cdecl";
 const char CallingConvention::gCallingConventionFastcall[] = "fastcall";
+const char CallingConvention::gImportCustomAttributeName[] = "Import";
 
 MethodDefOrRefSignaturePtr CallingConvention::readMethodSignature(
                            const Apartment& apartment,
@@ -94,9 +100,7 @@ MethodDefOrRefSignaturePtr CallingConvention::readMethodSignature(
     {
         if (signature == 0)
             CHECK_FAIL();
-        cForkStreamPtr blob = apartment.getStreams().getBlobStream()->fork();
-        blob->seek(signature, basicInput::IO_SEEK_SET);
-        methodSignature = MethodDefOrRefSignaturePtr(new MethodDefOrRefSignature(*blob,
+        methodSignature = MethodDefOrRefSignaturePtr(new MethodDefOrRefSignature(apartment.getStreams().getBlob(signature),
                                                             apartment.getUniqueID(),
                                                             apartment.getObjects().getTypedefRepository()));
     }
@@ -211,11 +215,24 @@ bool CallingConvention::compareElements(ResolverInterface& resolver,
     return false;
 }
 
+void CallingConvention::copyStruct(EmitContext& emitContext)
+{
+    if (!CompilerOpcodes::inlineMemcpy(emitContext))
+        call(emitContext, emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getMemcpy());
+}
+
+void CallingConvention::clearStruct(EmitContext& emitContext)
+{
+    if (!CompilerOpcodes::inlineMemset(emitContext))
+        call(emitContext, emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getMemset());
+}
+
 void CallingConvention::call(EmitContext& emitContext,
                              const TokenIndex& mid,
                              ThisObjectHandling thisHandling,
                              bool isVirtual,
-                             bool skipPush)
+                             bool skipPush,
+                             bool isTailCall)
 {
     uint32 argSize = 0;
     MethodBlock& currentBlock = emitContext.currentBlock;
@@ -288,6 +305,14 @@ void CallingConvention::call(EmitContext& emitContext,
         }
     }
 
+    // Small methods are compiled into the caller, instead of a call
+    if ((!skipPush) &&
+        ((thisHandling == None) || (thisHandling == ThisBelowParams)) &&
+        MethodInliner::inlineCall(emitContext, methodToken, *methodSignature, isVirtual))
+    {
+        return;
+    }
+
     //check return type
     const ElementType& retType = methodSignature->getReturnType();
     uint retSize = 0;
@@ -348,6 +373,23 @@ void CallingConvention::call(EmitContext& emitContext,
         break;
     }
 
+    // The leading arguments of internal methods are passed in registers, into
+    // their register entry. They are loaded just before the call, after all
+    // the other arguments were evaluated and pushed.
+    // Virtual methods have no register entry, so a callvirt of a non-virtual
+    // method, which is called directly, passes its arguments in registers.
+    // NOTE: The optimizer's dummy registers don't model the argument
+    //       registers, so its methods call with stack arguments only
+    uint registerArguments = 0;
+    if (!skipPush && !isTailCall && !compiler.isOptimizerCompiler())
+    {
+        registerArguments = getRegisterArgumentsCount(compiler,
+                                                      emitContext.methodContext.getApartment()->getApt(methodToken),
+                                                      mdMethodToken);
+    }
+    cSArray<StackEntity*> registerValues(registerArguments);
+    uint thisSlots = methodSignature->isHasThis() ? 1 : 0;
+
     if (!skipPush)
     {
         const ElementsArrayType& args = methodSignature->getParams();
@@ -355,6 +397,7 @@ void CallingConvention::call(EmitContext& emitContext,
         while (i > 0)
         {
             i--;
+            bool isRegisterArgument = (thisSlots + i) < registerArguments;
             // For each argument, get a reference to it
             // And remember to pop it from the stack eventually
             StackEntity& value = stack.getArg(stackIndex++);
@@ -405,17 +448,31 @@ void CallingConvention::call(EmitContext& emitContext,
                 structSizeEntity.getConst().setConstValue(objectSize);
                 stack.push(structSizeEntity);
 
-                // Add a "call" instruction to memcpy
-                CallingConvention::call(emitContext,
-                                    emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getMemcpy());
+                // Copy the struct into the arguments
+                copyStruct(emitContext);
 
                 argSize += objectSize;
             }
+            else if (isRegisterArgument && !args[i].isObject() &&
+                     isArgumentDirect(emitContext, value))
+            {
+                // Loaded straight into its register. See loadArgumentRegister
+                registerValues[thisSlots + i] = &value;
+                argSize += 4;
+            }
+            else if (!isRegisterArgument && !args[i].isObject() &&
+                     pushArgumentDirect(emitContext, value))
+            {
+                // Pushed without occupying a register
+                value = StackEntity();
+                argSize += 4;
+            }
             else
             {
                 RegisterEvaluatorOpcodes::evaluateInt32(emitContext, value);
                 // And push as method argument
-                compiler.pushArg32(value.getStackHolderObject()->getTemporaryObject());
+                if (!isRegisterArgument)
+                    compiler.pushArg32(value.getStackHolderObject()->getTemporaryObject());
 
                 if (!emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().isFrameworkMethod(mid))
                 {
@@ -439,7 +496,10 @@ void CallingConvention::call(EmitContext& emitContext,
                     }
                 }
 
-                value = StackEntity();
+                if (isRegisterArgument)
+                    registerValues[thisSlots + i] = &value;
+                else
+                    value = StackEntity();
                 argSize += 4;
             }
         }
@@ -473,7 +533,10 @@ void CallingConvention::call(EmitContext& emitContext,
         }
 
         RegisterEvaluatorOpcodes::evaluateInt32(emitContext, *thisObj);
-        compiler.pushArg32(thisObj->getStackHolderObject()->getTemporaryObject());
+        if (registerArguments > 0)
+            registerValues[0] = thisObj;
+        else
+            compiler.pushArg32(thisObj->getStackHolderObject()->getTemporaryObject());
         argSize += 4;
 
         if (isVirtual)
@@ -499,6 +562,9 @@ void CallingConvention::call(EmitContext& emitContext,
             // Invoke a call to index
             if (index >= 0)
             {
+                // Methods in the vtbl are virtual, and have no register entry
+                CHECK(registerArguments == 0);
+
                 // Determine the correct vtbl
                 if (isConstrained)
                 {
@@ -584,6 +650,14 @@ void CallingConvention::call(EmitContext& emitContext,
         }
     }
 
+    // Load the register arguments, and reserve their stack slots
+    if (registerArguments > 0)
+    {
+        for (uint r = 0; r < registerArguments; r++)
+            loadArgumentRegister(emitContext, *registerValues[r], compiler.getArgumentRegister(r));
+        compiler.pushArgRegisters32(registerArguments);
+    }
+
     if ((thisObj != NULL) && (thisHandling == ThisAboveParamsDup))
         {
         // Create a temporary copy of "this"
@@ -603,7 +677,17 @@ void CallingConvention::call(EmitContext& emitContext,
     thisObj = NULL;
 
     // Get dependency name
-    cString dependencyTokenName(serializedMethod(methodToken));
+    cString dependencyTokenName((registerArguments > 0) ?
+                                    serializedRegisterEntry(methodToken) :
+                                    serializedMethod(methodToken));
+
+    if (isTailCall)
+    {
+        // The arguments replace our own, and the returned value is left for
+        // our caller. See tailCall()
+        compiler.tailCall(dependencyTokenName, argSize);
+        return;
+    }
 
     // Calling the method itself, and setup stack for returned address
     if (retType.isVoid())
@@ -647,6 +731,137 @@ void CallingConvention::call(EmitContext& emitContext,
     }
 }
 
+bool CallingConvention::isFrameAddressTaken(const MSILInstructions& instructions)
+{
+    for (uint i = 0; i < instructions.getCount(); i++)
+    {
+        const MSILInstruction& instruction = instructions[i];
+        uint8 opcode = instruction.getOpcodeByte();
+        if (instruction.isExtended())
+        {
+            // ldarga, ldloca, localloc
+            if ((opcode == 0x0A) || (opcode == 0x0D) || (opcode == 0x0F))
+                return true;
+        } else
+        {
+            // ldarga.s, ldloca.s
+            if ((opcode == 0x0F) || (opcode == 0x12))
+                return true;
+        }
+    }
+    return false;
+}
+
+bool CallingConvention::tailCall(EmitContext& emitContext,
+                                 const TokenIndex& mid,
+                                 bool isJump,
+                                 bool isExplicit)
+{
+    MethodRuntimeBoundle& methodRuntime = emitContext.methodRuntime;
+    CompilerInterface& compiler = *methodRuntime.m_compiler;
+
+    // The frame of the current method is released before the jump, so
+    // nothing may run after the called method returns
+    if (!compiler.isTailCallSupported())
+        return false;
+    if ((emitContext.pCurrentHelper != NULL) ||
+        (methodRuntime.m_cleanupIndex != ElementType::UnresolvedTokenIndex) ||
+        (!emitContext.currentBlock.getExceptionsStack().isEmpty()))
+        return false;
+    if (emitContext.methodContext.isSystemObject())
+        return false;
+
+    // Resolve method
+    TokenIndex methodToken = ClrResolver::resolve(emitContext.methodContext.getApartment(), mid);
+    if (methodToken == ElementType::UnresolvedTokenIndex)
+        methodToken = mid;
+    mdToken mdMethodToken = getTokenID(methodToken);
+    if (EncodingUtils::getTokenTableIndex(mdMethodToken) != TABLE_METHOD_TABLE)
+        return false;
+
+    ApartmentPtr calleeApartment = emitContext.methodContext.getApartment()->getApt(methodToken);
+    Apartment& apartment = *calleeApartment;
+
+    // Methods which are implemented by the compiler are never jumped into
+    CustomAttributes customAttributes;
+    CustomAttribute::getAttributes(calleeApartment,
+                                   mdMethodToken,
+                                   "CompilerOpcodes",
+                                   customAttributes);
+    if (0 != customAttributes.getSize())
+        return false;
+
+    // Small methods are better off inlined by call()
+    if ((!isJump) && compiler.getCompilerParameters().m_bEnableOptimizations &&
+        (MethodInliner::getInlineCode(calleeApartment, methodToken).getSize() != 0))
+        return false;
+
+    // The called method returns into our caller, so it should clean the same
+    // arguments area
+    CompilerInterface::CallingConvention callingMethod = getDesiredCallingMethod(mdMethodToken,
+                                                                                 apartment,
+                                                                                 methodRuntime.getCompiler());
+    if ((callingMethod == CompilerInterface::STDCALL) != compiler.getFirstPassPtr()->isStdCall())
+        return false;
+
+    MethodDefOrRefSignaturePtr methodSignature = readMethodSignature(apartment, mdMethodToken);
+    ASSERT(!methodSignature.isEmpty());
+    const ResolverInterface& resolver = apartment.getObjects().getTypedefRepository();
+    uint stackSize = (uint)compiler.getStackSize();
+
+    // Structures are returned through a pointer into our frame
+    const ElementType& retType = methodSignature->getReturnType();
+    if ((!retType.isVoid()) && (resolver.getTypeSize(retType) > stackSize))
+        return false;
+
+    const ElementsArrayType& params = methodSignature->getParams();
+
+    // Without the 'tail.' prefix the program may pass an address of our frame,
+    // which is released before the jump
+    if ((!isJump) && (!isExplicit))
+    {
+        for (uint i = 0; i < params.getSize(); i++)
+        {
+            if (params[i].isPointer() || params[i].isReference() ||
+                (params[i].getType() == ELEMENT_TYPE_I) ||
+                (params[i].getType() == ELEMENT_TYPE_U))
+                return false;
+        }
+        if (isFrameAddressTaken(emitContext.methodContext.getInstructions()))
+            return false;
+    }
+
+    // Calculate the arguments size the same way call() pushes them
+    uint argSize = methodSignature->isHasThis() ? stackSize : 0;
+    for (uint i = 0; i < params.getSize(); i++)
+    {
+        uint objectSize = resolver.getTypeSize(params[i]);
+        if (objectSize > stackSize)
+            argSize += MethodCompiler::stackAlign(objectSize, compiler);
+        else
+            argSize += stackSize;
+    }
+    if (argSize != methodRuntime.m_args.getTotalArgumentsSize())
+        return false;
+
+    if (isJump)
+    {
+        // The arguments are already in place
+        CompilerTrace("\t\tJump to method:  " << getMethodName(apartment, mdMethodToken) << " " << HEXTOKEN(methodToken) << endl);
+        compiler.tailCall(serializedMethod(methodToken), 0);
+        return true;
+    }
+
+    // Only the arguments may be left on the evaluation stack
+    uint argumentsCount = params.getSize() + (methodSignature->isHasThis() ? 1 : 0);
+    if (emitContext.currentBlock.getCurrentStack().getStackCount() != argumentsCount)
+        return false;
+
+    CompilerTrace("\t\tTail call:  " << getMethodName(apartment, mdMethodToken) << " " << HEXTOKEN(methodToken) << endl);
+    call(emitContext, mid, ThisBelowParams, false, false, true);
+    return true;
+}
+
 TokenIndex CallingConvention::buildCCTOR(const TokenIndex& parentTypedef)
 {
     return buildTokenIndex(getApartmentID(parentTypedef),
@@ -678,6 +893,65 @@ cString CallingConvention::serializedMethod(const TokenIndex& token)
     return relocationTokenName;
 }
 
+cString CallingConvention::serializedRegisterEntry(const TokenIndex& token)
+{
+    cString relocationTokenName(gCILRegisterEntryPrefix);
+    relocationTokenName+= serializedMethod(token).part(arraysize(gCILMethodPrefix) - 1,
+                                                       MAX_UINT32);
+    return relocationTokenName;
+}
+
+uint CallingConvention::getRegisterArgumentsCount(const CompilerInterface& compiler,
+                                                  const ApartmentPtr& apartment,
+                                                  mdToken methodToken)
+{
+    uint registers = compiler.getArgumentRegistersCount();
+    if (registers == 0)
+        return 0;
+
+    // Only compiled methods have a register entry
+    if (EncodingUtils::getTokenTableIndex(methodToken) != TABLE_METHOD_TABLE)
+        return 0;
+    const MethodTable& methodTable = (const MethodTable&)
+                                (*apartment->getTables().getTableByToken(methodToken));
+    if (methodTable.getHeader().m_rva == 0)
+        return 0;
+    // Virtual methods are mostly called through the vtbl, by their stack entry
+    if ((methodTable.getHeader().m_flags & MethodTable::mdVirtual) != 0)
+        return 0;
+    CustomAttributes customAttributes;
+    CustomAttribute::getAttributes(apartment,
+                                   methodToken,
+                                   gImportCustomAttributeName,
+                                   customAttributes);
+    if (0 != customAttributes.getSize())
+        return 0;
+
+    // The signature of the definition, so that the method and its callers
+    // count the same slots
+    MethodDefOrRefSignaturePtr signature = readMethodSignature(*apartment, methodToken);
+    const ElementsArrayType& params = signature->getParams();
+    for (uint i = 0; i < params.getSize(); i++)
+    {
+        // The size of a generic parameter depends on the instantiation
+        if ((params[i].getType() == ELEMENT_TYPE_VAR) ||
+            (params[i].getType() == ELEMENT_TYPE_GENERICINST))
+            return 0;
+    }
+
+    uint count = signature->isHasThis() ? 1 : 0;
+    const TypedefRepository& typedefRepository =
+        apartment->getObjects().getTypedefRepository();
+    for (uint i = 0; (i < params.getSize()) && (count < registers); i++)
+    {
+        if (typedefRepository.getTypeSize(params[i]) > (uint)compiler.getStackSize())
+            break;
+        count++;
+    }
+
+    return count;
+}
+
 /*
 cString CallingConvention::serializeGlobal(uint offset)
 {
@@ -715,11 +989,16 @@ cString CallingConvention::serializeToken(const TokenIndex& token)
 }
 
 bool CallingConvention::deserializeMethod(const cString& dependency,
-                                          TokenIndex& token)
+                                          TokenIndex& token,
+                                          bool* isRegisterEntry)
 {
     token = ElementType::UnresolvedTokenIndex;
     uint len = arraysize(gCILMethodPrefix) - 1;
-    if (dependency.left(len) != gCILMethodPrefix)
+    bool registerEntry = (isRegisterEntry != NULL) &&
+                         (dependency.left(len) == gCILRegisterEntryPrefix);
+    if (isRegisterEntry != NULL)
+        *isRegisterEntry = registerEntry;
+    if ((dependency.left(len) != gCILMethodPrefix) && !registerEntry)
         return false;
 
     cSArray<char> ascii = dependency.part(len, MAX_UINT32).getASCIIstring();
@@ -775,6 +1054,113 @@ bool CallingConvention::deserializeGlobalData(const cString& dependency,
     return true;
 }
 
+bool CallingConvention::isArgumentDirect(EmitContext& emitContext,
+                                         const StackEntity& value)
+{
+    MethodRuntimeBoundle& methodRuntime = emitContext.methodRuntime;
+    TypedefRepository& typedefRepository =
+        emitContext.methodContext.getApartment()->getObjects().getTypedefRepository();
+    uint stackSize = (uint)methodRuntime.m_compiler->getStackSize();
+
+    if (ConstOpcodes::isConst32(value))
+        return true;
+
+    // Only full stack-sized variables can be passed as-is. Smaller ones
+    // should be sign/zero extended by load32.
+    if (value.getType() == StackEntity::ENTITY_LOCAL)
+    {
+        mdToken localIndex = value.getConst().getLocalOrArgValue();
+        const ElementType& localType = methodRuntime.m_locals.getLocalStackVariableType(localIndex);
+        return typedefRepository.getTypeSize(localType) == stackSize;
+    }
+
+    if (value.getType() == StackEntity::ENTITY_ARGUMENT)
+    {
+        int argIndex = value.getConst().getLocalOrArgValue();
+        const ElementType& argType = methodRuntime.m_args.getArgumentStackVariableType(argIndex);
+        return !argType.isObjectAndNotValueType() &&
+               (typedefRepository.getTypeSize(argType) == stackSize);
+    }
+
+    return false;
+}
+
+bool CallingConvention::pushArgumentDirect(EmitContext& emitContext,
+                                           const StackEntity& value)
+{
+    MethodRuntimeBoundle& methodRuntime = emitContext.methodRuntime;
+    CompilerInterface& compiler = *methodRuntime.m_compiler;
+
+    if (!isArgumentDirect(emitContext, value))
+        return false;
+
+    switch (value.getType())
+    {
+    case StackEntity::ENTITY_LOCAL:
+        compiler.pushArgStack32(methodRuntime.m_locals.getLocalPosition(
+                                    value.getConst().getLocalOrArgValue()), false);
+        break;
+    case StackEntity::ENTITY_ARGUMENT:
+        compiler.pushArgStack32(methodRuntime.m_args.getArgumentPosition(
+                                    value.getConst().getLocalOrArgValue()), true);
+        break;
+    default:
+        compiler.pushArgConst32(value.getConst().getConstValue());
+        break;
+    }
+    return true;
+}
+
+void CallingConvention::loadArgumentRegister(EmitContext& emitContext,
+                                             const StackEntity& value,
+                                             StackLocation destination)
+{
+    MethodRuntimeBoundle& methodRuntime = emitContext.methodRuntime;
+    CompilerInterface& compiler = *methodRuntime.m_compiler;
+    MethodBlock& currentBlock = emitContext.currentBlock;
+    uint stackSize = (uint)compiler.getStackSize();
+
+    if ((value.getType() == StackEntity::ENTITY_REGISTER) &&
+        (value.getStackHolderObject()->getTemporaryObject().u.reg == destination.u.reg))
+        return;
+
+    // Move whatever lives in the register aside. This also updates the
+    // arguments which are still on the stack
+    if (!currentBlock.isFreeTemporaryRegister(destination))
+    {
+        StackLocation temp = currentBlock.replaceRegisterToStackVariable(destination);
+        compiler.store32(temp.u.reg, stackSize, destination, false, true);
+    }
+
+    switch (value.getType())
+    {
+    case StackEntity::ENTITY_CONST:
+        compiler.loadInt32(destination, value.getConst().getConstValue());
+        break;
+    case StackEntity::ENTITY_LOCAL:
+        compiler.load32(methodRuntime.m_locals.getLocalPosition(
+                            value.getConst().getLocalOrArgValue()),
+                        stackSize, destination, false, false);
+        break;
+    case StackEntity::ENTITY_ARGUMENT:
+        compiler.load32(methodRuntime.m_args.getArgumentPosition(
+                            value.getConst().getLocalOrArgValue()),
+                        stackSize, destination, false, true);
+        break;
+    case StackEntity::ENTITY_REGISTER:
+        compiler.move32(destination, value.getStackHolderObject()->getTemporaryObject(),
+                        stackSize, false);
+        break;
+    case StackEntity::ENTITY_LOCAL_TEMP_STACK:
+        compiler.load32(value.getStackHolderObject()->getTemporaryObject().u.reg,
+                        stackSize, destination, false, false, true);
+        break;
+    default:
+        // Evaluated values are either registers or spilled registers
+        CHECK_FAIL();
+    }
+}
+
 void CallingConvention::calculateArgumentsSizes(const CompilerInterface& compiler,
                                                 ApartmentPtr& apartment,
                                                 const MethodCompiler& methodCompiler,
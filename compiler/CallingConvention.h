@@ -86,6 +86,8 @@ public:
      *               Throw exception if the function is static one.
      * skipPush - Use in incobj/decobj api where pushing the arguments is done in the
      *            calle code
+     * isTailCall - Set by tailCall() only. The current method jumps into the
+     *            called method instead of calling it
      * duplicateCtor - Set to true if the current function is .ctor function. In this case
      *            the .ctor function will push the object into the stack as a return
      *            value
@@ -97,7 +99,45 @@ public:
                      const TokenIndex& methodToken,
                      ThisObjectHandling thisHandling = None,
                      bool isVirtual = false,
-                     bool skipPush = false);
+                     bool skipPush = false,
+                     bool isTailCall = false);
+
+    /*
+     * Copy or clear a struct for the compiler (struct arguments, returns and
+     * stores, initobj). The arguments of the framework memcpy/memset are on
+     * the stack. Structs are aligned by the memory layout, so small constant
+     * sizes are expanded inline, see CompilerOpcodes::inlineMemcpy.
+     *
+     * NOTE: Calls to memcpy/memset made by the code itself always call the
+     *       framework, their addresses may not be aligned.
+     */
+    static void copyStruct(EmitContext& emitContext);
+    static void clearStruct(EmitContext& emitContext);
+
+    /*
+     * Compile a call in tail position (a 'call' which is followed by 'ret', or
+     * the 'jmp' instruction) into a jump. The called method reuses the
+     * arguments area of the current method and returns directly into our
+     * caller.
+     *
+     * emitContext - The context of the current method
+     * methodToken - The called method
+     * isJump      - Set to true for 'jmp'. The current arguments are passed
+     *               as-is and nothing is popped from the evaluation stack
+     * isExplicit  - Set to true if the call has the 'tail.' prefix. A call
+     *               without the prefix is jumped into only if it cannot
+     *               receive an address of the current frame
+     *
+     * Return true if the jump was emitted and the current block should be
+     * concluded as if 'ret' was executed.
+     * Return false if nothing was emitted. The current method has something
+     * to clean up, or the called method has a different calling convention
+     * or arguments size.
+     */
+    static bool tailCall(EmitContext& emitContext,
+                         const TokenIndex& methodToken,
+                         bool isJump = false,
+                         bool isExplicit = false);
 
     /*
      * Helper function. From apartment and method-token, get the method signature
@@ -131,6 +171,47 @@ public:
      */
     static cString serializedMethod(const TokenIndex& token);
 
+    /*
+     * Encode the register entry of a method as a dependency. The linker
+     * resolves it into the method address plus
+     * CompilerInterface::REGISTER_ENTRY_OFFSET
+     *
+     * token - The method token
+     *
+     * Return the encoded string
+     */
+    static cString serializedRegisterEntry(const TokenIndex& token);
+
+    /*
+     * The dependency at the head of the unwind data of a method (See
+     * CompilerInterface::generateUnwindData). The linker resolves it into the
+     * address of the method, and adds the method to the unwind table.
+     */
+    static const char gUnwindDataName[];
+
+    /*
+     * The dependency of the unwind table header. See ExceptionHandling.cs
+     */
+    static const char gUnwindTableName[];
+
+    /*
+     * Return the number of the leading argument slots ("this" and then the
+     * parameters) which are passed in registers into the register entry of a
+     * method. Calculated the same way by the method itself and by its callers.
+     *
+     * Only non-virtual methods with a body, which are not imported from an
+     * external module and have no generic parameters, have a register entry.
+     * The count is read from the signature of the method definition. The
+     * slots end at the first argument which is larger than a stack word.
+     *
+     * compiler    - The compiler settings
+     * apartment   - The apartment of the method
+     * methodToken - The method
+     */
+    static uint getRegisterArgumentsCount(const CompilerInterface& compiler,
+                                          const ApartmentPtr& apartment,
+                                          mdToken methodToken);
+
     /*
      * Encode a global variable
      *
@@ -164,11 +245,16 @@ public:
      * methodName    - Will be filled with the method name
      * signature     - Will be filled with the method signature
      *
+     * isRegisterEntry - If not NULL, register entries (See
+     *                   serializedRegisterEntry) are accepted as well, and
+     *                   this is set to true for them.
+     *
      * Return true if the dependency is a CIL method token.
      * Return false otherwise and nullify all output parameters.
      */
     static bool deserializeMethod(const cString& dependency,
-                                  TokenIndex& token);
+                                  TokenIndex& token,
+                                  bool* isRegisterEntry = NULL);
 
     /*
      * Tries to deserialized a dependency for encoded token.
@@ -233,8 +319,46 @@ private:
                                 const ElementType& a,
                                 const StackEntity& b);
 
+    /*
+     * Push a 32 bit constant, local or argument straight into the method
+     * arguments, without loading it into a register first.
+     *
+     * Return false if 'value' should be evaluated and pushed using pushArg32
+     */
+    static bool pushArgumentDirect(EmitContext& emitContext,
+                                   const StackEntity& value);
+
+    /*
+     * Return true if 'value' is a 32 bit constant, local or argument which
+     * pushArgumentDirect and loadArgumentRegister handle without evaluating it
+     */
+    static bool isArgumentDirect(EmitContext& emitContext,
+                                 const StackEntity& value);
+
+    /*
+     * Load a method argument into its argument register, just before the
+     * call. Whatever else the register holds is moved into a temporary stack
+     * variable first.
+     *
+     * value       - A direct value (See isArgumentDirect) or an evaluated one
+     * destination - The argument register
+     */
+    static void loadArgumentRegister(EmitContext& emitContext,
+                                     const StackEntity& value,
+                                     StackLocation destination);
+
+    /*
+     * Return true if the method takes the address of one of its locals or
+     * arguments (ldloca, ldarga) or allocates memory on its frame (localloc).
+     * Such an address may be passed to a called method, so the frame must
+     * outlive the call.
+     */
+    static bool isFrameAddressTaken(const MSILInstructions& instructions);
+
     // CIL method prefix
     static const char gCILMethodPrefix[];
+    // CIL method register entry prefix. The same length as gCILMethodPrefix
+    static const char gCILRegisterEntryPrefix[];
     // CIL token prefix
     static const char gCILTokenPrefix[];
     // CIL global prefix
@@ -246,6 +370,9 @@ private:
     static const char gCallingConventionStdcall[];
     static const char gCallingConventionCdecl[];
     static const char gCallingConventionFastcall[];
+    // Methods which are imported from an external module. See
+    // ExternalModuleResolver
+    static const char gImportCustomAttributeName[];
 
     // Map between custom attribute value to method convention enum.
     static CompilerInterface::CallingConvention
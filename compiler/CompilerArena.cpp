@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * CompilerArena.cpp
+ *
+ * Implementation file
+ */
+#include "compiler/stdafx.h"
+#include "xStl/types.h"
+#include "xStl/os/lock.h"
+#include "xStl/os/xstlLockable.h"
+#include "compiler/CompilerArena.h"
+
+#ifdef XSTL_WINDOWS
+    #define COMPILER_ARENA_THREAD __declspec(thread)
+#else
+    #define COMPILER_ARENA_THREAD __thread
+#endif
+
+// Each object is preceded by the arena which allocated it (or NULL for heap
+// objects). The header size keeps the objects aligned
+enum { OBJECT_HEADER_SIZE = 16,
+       // The maximum number of chunks kept in the global pool
+       MAX_POOLED_CHUNKS = 16 };
+
+// The active arena of the current thread. See CompilerArena::Scope
+static COMPILER_ARENA_THREAD CompilerArena* gCurrentArena = NULL;
+
+// Free chunks of the default size, protected by gChunksPoolLock
+static cXstlLockable gChunksPoolLock;
+static void* gChunksPool = NULL;
+static uint gChunksPoolCount = 0;
+
+CompilerArena::CompilerArena() :
+    m_chunks(NULL),
+    m_liveObjects(0)
+{
+}
+
+CompilerArena::~CompilerArena()
+{
+    // Objects which are still alive points to the chunks
+    if (m_liveObjects == 0)
+        releaseChunks(m_chunks);
+    m_chunks = NULL;
+}
+
+bool CompilerArena::reset()
+{
+    if (m_liveObjects != 0)
+        return false;
+
+    if (m_chunks == NULL)
+        return true;
+
+    // Keep the first chunk only
+    releaseChunks(m_chunks->m_next);
+    m_chunks->m_next = NULL;
+    m_chunks->m_used = 0;
+    return true;
+}
+
+uint CompilerArena::getLiveObjectsCount() const
+{
+    return m_liveObjects;
+}
+
+CompilerArena::Scope::Scope(CompilerArena& arena) :
+    m_previous(gCurrentArena)
+{
+    gCurrentArena = &arena;
+}
+
+CompilerArena::Scope::~Scope()
+{
+    gCurrentArena = m_previous;
+}
+
+void* CompilerArena::allocateObject(uint size)
+{
+    CompilerArena* arena = gCurrentArena;
+    uint8* ret;
+    if (arena != NULL)
+    {
+        ret = arena->bump(size + OBJECT_HEADER_SIZE);
+        arena->m_liveObjects++;
+    } else
+    {
+        ret = new uint8[size + OBJECT_HEADER_SIZE];
+    }
+
+    *((CompilerArena**)ret) = arena;
+    return ret + OBJECT_HEADER_SIZE;
+}
+
+void CompilerArena::freeObject(void* object)
+{
+    if (object == NULL)
+        return;
+
+    uint8* header = ((uint8*)object) - OBJECT_HEADER_SIZE;
+    CompilerArena* arena = *((CompilerArena**)header);
+    if (arena == NULL)
+    {
+        delete[] header;
+        return;
+    }
+
+    // The memory is reused when the arena is reset
+    CHECK(arena->m_liveObjects > 0);
+    arena->m_liveObjects--;
+}
+
+uint8* CompilerArena::bump(uint size)
+{
+    // Keep the objects aligned
+    size = (size + OBJECT_HEADER_SIZE - 1) & ~(OBJECT_HEADER_SIZE - 1);
+
+    if ((m_chunks == NULL) || (m_chunks->m_size - m_chunks->m_used < size))
+    {
+        Chunk* chunk = allocateChunk(size);
+        chunk->m_next = m_chunks;
+        m_chunks = chunk;
+    }
+
+    uint8* ret = ((uint8*)m_chunks) + OBJECT_HEADER_SIZE + m_chunks->m_used;
+    m_chunks->m_used += size;
+    return ret;
+}
+
+CompilerArena::Chunk* CompilerArena::allocateChunk(uint size)
+{
+    Chunk* chunk = NULL;
+    if (size <= DEFAULT_CHUNK_SIZE)
+    {
+        size = DEFAULT_CHUNK_SIZE;
+        cLock lock(gChunksPoolLock);
+        if (gChunksPool != NULL)
+        {
+            chunk = (Chunk*)gChunksPool;
+            gChunksPool = chunk->m_next;
+            gChunksPoolCount--;
+        }
+    }
+
+    if (chunk == NULL)
+    {
+        // The chunk header is padded as the objects header
+        chunk = (Chunk*)(new uint8[size + OBJECT_HEADER_SIZE]);
+    }
+
+    chunk->m_next = NULL;
+    chunk->m_size = size;
+    chunk->m_used = 0;
+    return chunk;
+}
+
+void CompilerArena::releaseChunks(Chunk* chunks)
+{
+    while (chunks != NULL)
+    {
+        Chunk* next = chunks->m_next;
+        bool isPooled = false;
+        if (chunks->m_size == DEFAULT_CHUNK_SIZE)
+        {
+            cLock lock(gChunksPoolLock);
+            if (gChunksPoolCount < MAX_POOLED_CHUNKS)
+            {
+                chunks->m_next = (Chunk*)gChunksPool;
+                gChunksPool = chunks;
+                gChunksPoolCount++;
+                isPooled = true;
+            }
+        }
+        if (!isPooled)
+            delete[] ((uint8*)chunks);
+        chunks = next;
+    }
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_COMPILER_COMPILERARENA_H
+#define __TBA_CLR_COMPILER_COMPILERARENA_H
+
+/*
+ * CompilerArena.h
+ *
+ * Bump allocator for the short-lived objects of a single method compilation.
+ */
+#include "xStl/types.h"
+
+/*
+ * Bump allocator for the short-lived objects of a single method compilation
+ * (method blocks, temporary stack holders, etc.)
+ *
+ * Objects are allocated from large chunks by advancing a pointer. Freeing an
+ * object only updates a counter, and the memory of all the objects is reused
+ * once the arena is reset. The chunks of a destroyed arena are kept in a
+ * global pool for the next method.
+ *
+ * Usage:
+ *     CompilerArena arena;
+ *     {
+ *         CompilerArena::Scope scope(arena);
+ *         // Any CompilerArenaObject allocated by this thread is allocated
+ *         // from 'arena'
+ *         StackInterfacePtr block(new MethodBlock(...));
+ *     }
+ *     arena.reset();
+ *
+ * NOTE: An arena should be used by a single thread. Objects can be freed after
+ *       their scope was closed, but not after the arena was destructed.
+ */
+class CompilerArena {
+public:
+    // The default size of a single chunk
+    enum { DEFAULT_CHUNK_SIZE = 0x10000 };
+
+    /*
+     * Constructor. No memory is allocated until the first object
+     */
+    CompilerArena();
+
+    /*
+     * Destructor. Return the chunks to the global pool.
+     * If there are still live objects, the chunks are never freed.
+     */
+    ~CompilerArena();
+
+    /*
+     * Reuse the memory of all the objects.
+     *
+     * Return false if there are still live objects. In that case the arena
+     * isn't changed.
+     */
+    bool reset();
+
+    /*
+     * Return the number of objects which weren't freed yet
+     */
+    uint getLiveObjectsCount() const;
+
+    /*
+     * Route the allocations of CompilerArenaObject by the current thread into
+     * an arena, as long as this object exist.
+     */
+    class Scope {
+    public:
+        Scope(CompilerArena& arena);
+        ~Scope();
+    private:
+        // Deny copy-constructor and operator =
+        Scope(const Scope& other);
+        Scope& operator = (const Scope& other);
+
+        // The previous arena of the thread, or NULL
+        CompilerArena* m_previous;
+    };
+
+    /*
+     * Allocate memory from the arena of the current thread. If there is no
+     * active arena, the memory is allocated from the heap.
+     * See CompilerArenaObject
+     */
+    static void* allocateObject(uint size);
+
+    /*
+     * Free memory which was returned by allocateObject
+     */
+    static void freeObject(void* object);
+
+private:
+    // Deny copy-constructor and operator =
+    CompilerArena(const CompilerArena& other);
+    CompilerArena& operator = (const CompilerArena& other);
+
+    // The header of a chunk. The chunk data follows the header
+    struct Chunk {
+        // The next chunk
+        Chunk* m_next;
+        // The number of data bytes
+        uint m_size;
+        // The number of used data bytes
+        uint m_used;
+    };
+
+    /*
+     * Allocate 'size' bytes from the current chunk, or from a new one
+     */
+    uint8* bump(uint size);
+
+    /*
+     * Return a new chunk with at least 'size' bytes, from the pool if possible
+     */
+    static Chunk* allocateChunk(uint size);
+
+    /*
+     * Return a list of chunks into the pool (or free them)
+     */
+    static void releaseChunks(Chunk* chunks);
+
+    // The chunks. The first chunk is the current one
+    Chunk* m_chunks;
+    // The number of allocated objects which weren't freed
+    uint m_liveObjects;
+};
+
+#ifdef _DEBUG
+// See stdafx.h
+#pragma push_macro("new")
+#undef new
+#endif
+
+/*
+ * Inherit from this class in order to allocate the objects from the active
+ * CompilerArena. See CompilerArena::Scope
+ */
+class CompilerArenaObject {
+public:
+    static void* operator new(size_t size)
+    {
+        return CompilerArena::allocateObject((uint)size);
+    }
+
+    static void operator delete(void* object)
+    {
+        CompilerArena::freeObject(object);
+    }
+
+#ifdef _DEBUG
+    // The debug new of stdafx.h
+    static void* operator new(size_t size, int, const char*, int)
+    {
+        return CompilerArena::allocateObject((uint)size);
+    }
+
+    static void operator delete(void* object, int, const char*, int)
+    {
+        CompilerArena::freeObject(object);
+    }
+#endif
+};
+
+#ifdef _DEBUG
+#pragma pop_macro("new")
+#endif
+
+#endif // __TBA_CLR_COMPILER_COMPILERARENA_H
@@ -45,15 +45,16 @@
 #include "compiler/opcodes/ArrayOpcodes.h"
 #include "compiler/opcodes/Bin32Opcodes.h"
 #include "compiler/opcodes/CompilerOpcodes.h"
+#include "compiler/opcodes/ConstOpcodes.h"
+#include "compiler/opcodes/LoopOpcodes.h"
 #include "compiler/opcodes/ObjectOpcodes.h"
 #include "compiler/opcodes/RegisterEvaluatorOpcodes.h"
 #include "compiler/opcodes/ExceptionOpcodes.h"
 
-bool CompilerEngine::handleSplit(EmitContext& emitContext, basicInput& instructionCache)
+bool CompilerEngine::handleSplit(EmitContext& emitContext, const MSILInstruction& instruction)
 {
     // Determine the next instruction's index
-    uint instructionIndex = instructionCache.getPointer() -
-        emitContext.methodContext.getMethodStreamStartAddress();
+    uint instructionIndex = instruction.m_offset;
 
     // Check for block split, if this offset is referred-to by another instruction in the method
     if (emitContext.methodRuntime.m_blockSplit.isSet(instructionIndex) &&
@@ -68,8 +69,8 @@ bool CompilerEngine::handleSplit(EmitContext& emitContext, basicInput& instructi
 }
 
 bool CompilerEngine::step(EmitContext& emitContext,
-    basicInput& instructionCache,
-    uint initializedDummyPosition)
+    const MSILInstruction& instruction,
+    bool isLogical)
 {
     // Get apartment
     MethodRunnable& methodContext = emitContext.methodContext;
@@ -87,10 +88,9 @@ bool CompilerEngine::step(EmitContext& emitContext,
     Stack& stack = currentBlock.getCurrentStack();
 
     // Check for previous compiled code
-    uint32 instructionIndex = initializedDummyPosition + instructionCache.getPointer() -
-        methodContext.getMethodStreamStartAddress();
+    uint32 instructionIndex = instruction.m_offset;
 
-    if (initializedDummyPosition == 0)
+    if (!isLogical)
     {
         if (methodRuntime.m_methodSet.isSet(instructionIndex))
         {
@@ -110,8 +110,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     }
 
     // Read the instruction
-    uint8 instructionPrefix;
-    instructionCache.streamReadUint8(instructionPrefix);
+    uint8 instructionPrefix = instruction.isExtended() ? 0xFE : instruction.getOpcodeByte();
 
     // Set to false for opcode extension
     bool  shouldExecuteSwitch = true;
@@ -137,7 +136,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     if (instructionPrefix == 0xFE)
     {
         shouldExecuteSwitch = false;
-        instructionCache.streamReadUint8(instructionPrefix);
+        instructionPrefix = instruction.getOpcodeByte();
         switch (instructionPrefix)
         {
         case 0x01: // ceq     compare equal
@@ -166,19 +165,19 @@ bool CompilerEngine::step(EmitContext& emitContext,
             break;
 
         case 0x06: // ldftn
-            instructionCache.streamReadUint32(u32);
+            u32 = instruction.getUint32();
             CompilerTraceOpcode("ldftn " << HEXDWORD(u32) << endl);
             CHECK_FAIL();
             break;
 
         case 0x07: // ldvirtftn
-            instructionCache.streamReadUint32(u32);
+            u32 = instruction.getUint32();
             CompilerTraceOpcode("ldftn " << HEXDWORD(u32) << endl);
             CHECK_FAIL();
             break;
 
         case 0x09:  // ldarg
-            instructionCache.streamReadUint16(u16);
+            u16 = (uint16)instruction.m_operand;
             opIndex = u16;
             CompilerTraceOpcode("ldarg  #" << opIndex << endl);
 
@@ -189,7 +188,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
             break;
 
         case 0x0A:  // ldarga
-            instructionCache.streamReadUint16(u16);
+            u16 = (uint16)instruction.m_operand;
             opIndex = u16;
             CompilerTraceOpcode("ldarga  #" << opIndex << endl);
 
@@ -200,7 +199,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
             break;
 
         case 0x0B:  // starg
-            instructionCache.streamReadUint16(u16);
+            u16 = (uint16)instruction.m_operand;
             opIndex = u16;
             CompilerTraceOpcode("starg  #" << opIndex << endl);
             // And store value
@@ -213,7 +212,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
             break;
 
         case 0x0C: // ldloc
-            instructionCache.streamReadUint16(u16);
+            u16 = (uint16)instruction.m_operand;
             opIndex = u16;
             CompilerTraceOpcode("ldloc  #" << opIndex << endl);
 
@@ -224,7 +223,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
             break;
 
         case 0x0D: // ldloca
-            instructionCache.streamReadUint16(u16);
+            u16 = (uint16)instruction.m_operand;
             opIndex = u16;
             CompilerTraceOpcode("ldloca  #" << opIndex << endl);
 
@@ -237,7 +236,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
             break;
 
         case 0x0E: // stloc
-            instructionCache.streamReadUint16(u16);
+            u16 = (uint16)instruction.m_operand;
             opIndex = u16;
             CompilerTraceOpcode("stloc  #" << opIndex << endl);
             varEntity2 = StackEntity(StackEntity::ENTITY_LOCAL, locals.getLocalStackVariableType(opIndex));
@@ -247,6 +246,9 @@ bool CompilerEngine::step(EmitContext& emitContext,
             RegisterEvaluatorOpcodes::storeVar(emitContext, stack.getArg(1), stack.getArg(0));
             CompilerOpcodes::pop2null(emitContext);
             stack.pop2null();
+            // Move the array cursors of an induction variable
+            if (!isLogical)
+                LoopOpcodes::storeLocal(emitContext, instructionIndex, opIndex);
 
             break;
 
@@ -275,7 +277,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
             stack.getArg(0).setStackHolderObject(destination);
             break;
         case 0x15: // initobj
-            instructionCache.streamReadUint32(u32);
+            u32 = instruction.getUint32();
             CompilerTraceOpcode("initobj " << HEXDWORD(u32) << endl);
 
             // Get type
@@ -298,11 +300,17 @@ bool CompilerEngine::step(EmitContext& emitContext,
             stack.push(varEntity1);
 
             // Call memset
-            CallingConvention::call(emitContext, globalContext.getFrameworkMethods().getMemset());
+            CallingConvention::clearStruct(emitContext);
+            break;
+
+        case 0x14: // tail.
+            // The call which follows is in tail position anyway, since 'ret'
+            // must follow it. See case 0x28 and isTailPrefixed()
+            CompilerTraceOpcode("tail." << endl);
             break;
 
         case 0x16: // constrained
-            instructionCache.streamReadUint32(u32);
+            u32 = instruction.getUint32();
             CompilerTraceOpcode(".constrained " << HEXDWORD(u32) << endl);
             // Pushing vtbl, mark callvirt of using this vtbl and not object
             resolveTypeToken(u32, apartmentId, globalContext.getTypedefRepository(), type);
@@ -312,7 +320,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
             break;
 
         case 0x1C: // sizeof
-            instructionCache.streamReadUint32(u32);
+            u32 = instruction.getUint32();
             CompilerTraceOpcode("sizeof " << HEXDWORD(u32) << endl);
 
             resolveTypeToken(u32, apartmentId, globalContext.getTypedefRepository(), type);
@@ -355,7 +363,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
         else
         {
             // Read unsigned8 for argument position
-            instructionCache.streamReadUint8(u8);
+            u8 = (uint8)instruction.m_operand;
             opIndex = u8;
             CompilerTraceOpcode("ldarg.s  #" << opIndex << endl);
         }
@@ -373,7 +381,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
         else
         {
             // Read unsigned8 for argument position
-            instructionCache.streamReadUint8(u8);
+            u8 = (uint8)instruction.m_operand;
             opIndex = u8;
             CompilerTraceOpcode("ldloc.s  #" << opIndex << endl);
         }
@@ -393,7 +401,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
         else
         {
             // Read unsigned8 for argument position
-            instructionCache.streamReadUint8(u8);
+            u8 = (uint8)instruction.m_operand;
             opIndex = u8;
             CompilerTraceOpcode("stloc.s  #" << opIndex << endl);
         }
@@ -405,11 +413,14 @@ bool CompilerEngine::step(EmitContext& emitContext,
         RegisterEvaluatorOpcodes::storeVar(emitContext, stack.getArg(1), stack.getArg(0));
         CompilerOpcodes::pop2null(emitContext);
         stack.pop2null();
+        // Move the array cursors of an induction variable
+        if (!isLogical)
+            LoopOpcodes::storeLocal(emitContext, instructionIndex, opIndex);
         break;
 
     case 0x0F:          // ldarga.s
         // Get argument index
-        instructionCache.streamReadUint8(u8);
+        u8 = (uint8)instruction.m_operand;
         opIndex = u8;
         CompilerTraceOpcode("ldarga.s  #" << opIndex << endl);
 
@@ -421,7 +432,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0x10:              // starg (uint8)
         // Get argument index
-        instructionCache.streamReadUint8(u8);
+        u8 = (uint8)instruction.m_operand;
         opIndex = u8;
         CompilerTraceOpcode("starg.s  #" << opIndex << endl);
 
@@ -438,7 +449,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     // case 0xFE 0x0D   // ldloca
     case 0x12: // ldloca.s
         // Get argument index
-        instructionCache.streamReadUint8(u8);
+        u8 = (uint8)instruction.m_operand;
         opIndex = u8;
         CompilerTraceOpcode("ldloca.s  #" << opIndex << endl);
 
@@ -471,13 +482,13 @@ bool CompilerEngine::step(EmitContext& emitContext,
         if (instructionPrefix == 0x1F)
         {
             // Read and convert
-            instructionCache.streamReadInt8(i8);
+            i8 = (int8)instruction.m_operand;
             CompilerTraceOpcode("ldc.i4.s 0x" << HEXBYTE(i8) << endl);
             i32 = i8;
         } else if (instructionPrefix == 0x20)
         {
             // Read and convert
-            instructionCache.streamReadInt32(i32);
+            i32 = (int32)instruction.m_operand;
             CompilerTraceOpcode("ldc.i4." << HEXDWORD(i32) << endl);
         } else
         {
@@ -494,7 +505,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0x21: // ldc.i8 <int64> as int64
         CompilerTraceOpcode("ldc.i8" << endl);
-        instructionCache.streamReadInt64(i64);
+        i64 = (int64)instruction.m_operand;
 #ifdef CLR_I8_ENABLE
         varEntity1 = StackEntity(StackEntity::ENTITY_CONST, ConstElements::gI8);
         varEntity1.getConst().setConst64Value(i64);
@@ -513,13 +524,13 @@ bool CompilerEngine::step(EmitContext& emitContext,
         {
             CompilerTraceOpcode("ldc.r4" << endl);
             ClrR4Float m_r4Float;
-            instructionCache.pipeRead(m_r4Float, sizeof(m_r4Float));
+            cOS::memcpy(&m_r4Float, &instruction.m_operand, sizeof(m_r4Float));
             m_float = floatLoadFromR4(m_r4Float);
         } else
         {
             CompilerTraceOpcode("ldc.r8" << endl);
             ClrR8Float m_r8Float;
-            instructionCache.pipeRead(m_r8Float, sizeof(m_r8Float));
+            cOS::memcpy(&m_r8Float, &instruction.m_operand, sizeof(m_r8Float));
             m_float = floatLoadFromR8(m_r8Float);
         }
         CHECK_FAIL();
@@ -544,8 +555,25 @@ bool CompilerEngine::step(EmitContext& emitContext,
         CompilerOpcodes::pop2null(emitContext);
         break;
 
+    case 0x27: // jmp <token> - Exit current method and jump to specified method
+        u32 = instruction.getUint32();
+        CompilerTraceOpcode("jmp " << "(" << HEXDWORD(u32) << ")" << endl);
+
+        // The evaluation stack must be empty, the current arguments are passed
+        CHECK(stack.isEmpty());
+        if (!CallingConvention::tailCall(emitContext, buildTokenIndex(apartmentId, u32), true))
+        {
+            CompilerTraceOpcode("jmp - Not supported for this method!" << endl);
+            XSTL_THROW(ClrIllegalInstruction);
+        }
+
+        // Conclude the current block as if 'ret' was executed
+        currentBlock.terminateMethodBlock(&emitContext, MethodBlock::COND_RETURN,
+            MethodBlock::BLOCK_RET,
+            instructionIndex);
+        return true;
+
         // TODO!
-        // case 0x27: // jmp <token> - Exit current method and jump to specified method
         // case 0x29: // calli
     case 0x2A: // ret
         CompilerTraceOpcode("ret" << endl);
@@ -562,8 +590,21 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x6F: // callvirt <methodToken>
         mBool = (instructionPrefix == 0x6F); // isVirtual
         // Read the method token
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CompilerTraceOpcode(((mBool) ? "callvirt" : "call") << " " << "(" << HEXDWORD(u32) << ")" << endl);
+
+        // A call followed by 'ret' jumps into the method, and the current
+        // block is concluded as if 'ret' was executed
+        if ((!mBool) && (!isLogical) && isFollowedByReturn(emitContext, instruction) &&
+            CallingConvention::tailCall(emitContext, buildTokenIndex(apartmentId, u32), false,
+                                        isTailPrefixed(emitContext, instruction)))
+        {
+            currentBlock.terminateMethodBlock(&emitContext, MethodBlock::COND_RETURN,
+                MethodBlock::BLOCK_RET,
+                instructionIndex);
+            return true;
+        }
+
         // Check stack and push arguments.
         // Call into implementation
         CallingConvention::call(emitContext, buildTokenIndex(apartmentId, u32), CallingConvention::ThisBelowParams, mBool);
@@ -571,18 +612,16 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0x2B:  // br.s <int8>    - Branch always, continue execuation from
     case 0x38:  // br   <int32>     new method location.
-        offset = readOffset(instructionCache,
-            instructionPrefix == 0x2B);
+        offset = instruction.getBranchOffset();
         CompilerTraceOpcode("br" <<
             ((instructionPrefix == 0x2B) ? ".s" : "") << endl);
 
         // Generate new block for the jump instruction.
-        if (initializedDummyPosition == 0)
-        {
-            opIndex = initializedDummyPosition + instructionCache.getPointer() -
-                methodContext.getMethodStreamStartAddress();
-        }
+        opIndex = instruction.m_nextOffset;
         opIndex += offset;
+        // Jumping into a loop header
+        if (!isLogical)
+            LoopOpcodes::enterLoop(emitContext, instructionIndex, opIndex);
         methodRuntime.AddMethodBlock(currentBlock, emitContext, opIndex);
 
         // Just mark the current block as conditional true execution.
@@ -594,19 +633,19 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x2C: // brfalse.s   brnull.s    brzero.s      <int8>
     case 0x39: // brfalse     brnull      brzero        <int32>
         {
-            offset = readOffset(instructionCache,
-                instructionPrefix == 0x2C);
+            offset = instruction.getBranchOffset();
             CompilerTraceOpcode("brfalse" <<
                 ((instructionPrefix == 0x2c) ? ".s" : "") << endl);
 
             // Check for zero/null/false
-
-            // Generate two new blocks for both conditions.
-            if (initializedDummyPosition == 0)
+            if (ConstOpcodes::isConstCondition(stack.peek(), mBool))
             {
-                opIndex = initializedDummyPosition + instructionCache.getPointer() -
-                    methodContext.getMethodStreamStartAddress();
+                branchConst(emitContext, instruction, !mBool);
+                return true;
             }
+
+            // Generate two new blocks for both conditions.
+            opIndex = instruction.m_nextOffset;
             // Remove the current entry from tos(), but keep it for the evaluation
             // process
             methodRuntime.AddMethodBlock(currentBlock, emitContext, opIndex + offset, true);
@@ -623,18 +662,18 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x2D: // brtrue.s   brinst.s   <int8>
     case 0x3A: // brtrue     brinst     <int32>
         {
-            offset = readOffset(instructionCache,
-                instructionPrefix == 0x2D);
+            offset = instruction.getBranchOffset();
             CompilerTraceOpcode("brtrue" << ((instructionPrefix == 0x2D) ? ".s " : " ") << HEXDWORD(offset) << endl);
 
             // Check for non zero/non null/true
-
-            // Generate two new blocks for both conditions.
-            if (initializedDummyPosition == 0)
+            if (ConstOpcodes::isConstCondition(stack.peek(), mBool))
             {
-                opIndex = initializedDummyPosition + instructionCache.getPointer() -
-                    methodContext.getMethodStreamStartAddress();
+                branchConst(emitContext, instruction, mBool);
+                return true;
             }
+
+            // Generate two new blocks for both conditions.
+            opIndex = instruction.m_nextOffset;
             // Remove the current entry from tos(), but keep it for the evaluation
             // process
             methodRuntime.AddMethodBlock(currentBlock, emitContext, opIndex + offset, true);
@@ -651,18 +690,20 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x3B:  // beq    <int32>
         CompilerTraceOpcode("beq" <<
             ((instructionPrefix == 0x2E) ? ".s" : "") << endl);
-        offset = readOffset(instructionCache,
-            instructionPrefix == 0x2E);
+        offset = instruction.getBranchOffset();
+
+        if (branchCompare(emitContext, instruction, CompilerInterface::COMPARE_EQUAL, true))
+            return true;
 
         // Perform the ceq instruction
         step(emitContext,
-            *generateInstructionStream(ILASM_CEQ, 0),
-            methodContext.getMethodStreamStartAddress() + instructionIndex);
+            generateInstruction(ILASM_CEQ, instruction, 0),
+            true);
 
         // Call brtrue with offset offset and RETURN!
         return step(emitContext,
-            *generateInstructionStream(ILASM_BRTRUE, offset),
-            instructionCache.getPointer());
+            generateInstruction(ILASM_BRTRUE, instruction, offset),
+            true);
 
     case 0x2F:  // bge.s <int8>     branch on greater than or equal to
     case 0x3C:  // bge   <int32>
@@ -672,22 +713,23 @@ bool CompilerEngine::step(EmitContext& emitContext,
             ((instructionPrefix == 0x34) ? ".un.s" : "") <<
             ((instructionPrefix == 0x41) ? ".un" : "") <<
             ((instructionPrefix == 0x2F) ? ".s" : "") << endl);
-        offset = readOffset(instructionCache,
-            (instructionPrefix == 0x2F) ||
-            (instructionPrefix == 0x34));
+        offset = instruction.getBranchOffset();
 
         // Set to true if unsigned comparison should be in order
         mBool = ((instructionPrefix == 0x41) || (instructionPrefix == 0x34));
 
+        if (branchCompare(emitContext, instruction, CompilerInterface::COMPARE_GREATER_EQUAL, !mBool))
+            return true;
+
         // Perform the clt instruction
         step(emitContext,
-            *generateInstructionStream(mBool ? ILASM_CLT_UN : ILASM_CLT, 0),
-            methodContext.getMethodStreamStartAddress() + instructionIndex);
+            generateInstruction(mBool ? ILASM_CLT_UN : ILASM_CLT, instruction, 0),
+            true);
 
         // Call brfalse with offset offset and RETURN!
         return step(emitContext,
-            *generateInstructionStream(ILASM_BRFALSE, offset),
-            instructionCache.getPointer());
+            generateInstruction(ILASM_BRFALSE, instruction, offset),
+            true);
 
     case 0x30:  // bgt.s <int8>    branch on greater than
     case 0x3D:  // bgt   <int32>
@@ -697,22 +739,23 @@ bool CompilerEngine::step(EmitContext& emitContext,
             ((instructionPrefix == 0x35) ? ".un.s" : "") <<
             ((instructionPrefix == 0x42) ? ".un" : "") <<
             ((instructionPrefix == 0x30) ? ".s" : "") << endl);
-        offset = readOffset(instructionCache,
-            (instructionPrefix == 0x30) ||
-            (instructionPrefix == 0x35));
+        offset = instruction.getBranchOffset();
 
         // Set to true if unsigned comparison should be in order
         mBool = ((instructionPrefix == 0x42) || (instructionPrefix == 0x35));
 
+        if (branchCompare(emitContext, instruction, CompilerInterface::COMPARE_GREATER, !mBool))
+            return true;
+
         // Perform the cgt instruction
         step(emitContext,
-            *generateInstructionStream(mBool ? ILASM_CGT_UN : ILASM_CGT, 0),
-            methodContext.getMethodStreamStartAddress() + instructionIndex);
+            generateInstruction(mBool ? ILASM_CGT_UN : ILASM_CGT, instruction, 0),
+            true);
 
         // Call brtrue with offset and RETURN!
         return step(emitContext,
-            *generateInstructionStream(ILASM_BRTRUE, offset),
-            instructionCache.getPointer());
+            generateInstruction(ILASM_BRTRUE, instruction, offset),
+            true);
 
     case 0x31:  // ble.s  <int8>     branch on less than or equal to
     case 0x3E:  // ble    <int32>
@@ -722,22 +765,23 @@ bool CompilerEngine::step(EmitContext& emitContext,
             ((instructionPrefix == 0x36) ? ".un.s" : "") <<
             ((instructionPrefix == 0x43) ? ".un" : "") <<
             ((instructionPrefix == 0x31) ? ".s" : "") << endl);
-        offset = readOffset(instructionCache,
-            (instructionPrefix == 0x31) ||
-            (instructionPrefix == 0x36));
+        offset = instruction.getBranchOffset();
 
         // Set to true if unsigned comparison should be in order
         mBool = ((instructionPrefix == 0x43) || (instructionPrefix == 0x36));
 
+        if (branchCompare(emitContext, instruction, CompilerInterface::COMPARE_LESS_EQUAL, !mBool))
+            return true;
+
         // Perform the cgt instruction
         step(emitContext,
-            *generateInstructionStream(mBool ? ILASM_CGT_UN : ILASM_CGT, 0),
-            methodContext.getMethodStreamStartAddress() + instructionIndex);
+            generateInstruction(mBool ? ILASM_CGT_UN : ILASM_CGT, instruction, 0),
+            true);
 
         // Call brfalse with offset and RETURN!
         return step(emitContext,
-            *generateInstructionStream(ILASM_BRFALSE, offset),
-            instructionCache.getPointer());
+            generateInstruction(ILASM_BRFALSE, instruction, offset),
+            true);
 
     case 0x32: // blt.s  <int8>     branch on less than
     case 0x3F: // blt    <int32>
@@ -747,51 +791,54 @@ bool CompilerEngine::step(EmitContext& emitContext,
             ((instructionPrefix == 0x37) ? ".un.s" : "") <<
             ((instructionPrefix == 0x44) ? ".un" : "") <<
             ((instructionPrefix == 0x32) ? ".s" : "") << endl);
-        offset = readOffset(instructionCache,
-            (instructionPrefix == 0x32) ||
-            (instructionPrefix == 0x37));
+        offset = instruction.getBranchOffset();
 
         // Recursive on recursive is invalid!
-        CHECK(initializedDummyPosition == 0);
+        CHECK(!isLogical);
 
         // Set to true if unsigned comparison should be in order
         mBool = ((instructionPrefix == 0x44) || (instructionPrefix == 0x37));
 
+        if (branchCompare(emitContext, instruction, CompilerInterface::COMPARE_LESS, !mBool))
+            return true;
+
         // Perform the clt instruction
         step(emitContext,
-            *generateInstructionStream(mBool ? ILASM_CLT_UN : ILASM_CLT, 0),
-            methodContext.getMethodStreamStartAddress() + instructionIndex);
+            generateInstruction(mBool ? ILASM_CLT_UN : ILASM_CLT, instruction, 0),
+            true);
 
         // Call brtrue with offset offset and RETURN!
         return step(emitContext,
-            *generateInstructionStream(ILASM_BRTRUE, offset),
-            instructionCache.getPointer());
+            generateInstruction(ILASM_BRTRUE, instruction, offset),
+            true);
 
     case 0x33:  // bne.un.s <int8>   branch on not equal or unordered
     case 0x40:  // bne.un   <int32>
         CompilerTraceOpcode("bne.un" <<
             ((instructionPrefix == 0x33) ? ".s" : "") << endl);
-        offset = readOffset(instructionCache,
-            instructionPrefix == 0x33);
+        offset = instruction.getBranchOffset();
 
         // Recursive on recursive is invalid!
-        CHECK(initializedDummyPosition == 0);
+        CHECK(!isLogical);
+
+        if (branchCompare(emitContext, instruction, CompilerInterface::COMPARE_NOT_EQUAL, true))
+            return true;
 
         // Perform the ceq instruction
         step(emitContext,
-            *generateInstructionStream(ILASM_CEQ, 0),
-            methodContext.getMethodStreamStartAddress() + instructionIndex);
+            generateInstruction(ILASM_CEQ, instruction, 0),
+            true);
 
         // Call brfalse with offset offset and RETURN!
         return step(emitContext,
-            *generateInstructionStream(ILASM_BRFALSE, offset),
-            instructionCache.getPointer());
+            generateInstruction(ILASM_BRFALSE, instruction, offset),
+            true);
 
     case 0x45: // switch
         CompilerTraceOpcode("switch" << endl);
         // Read the instruction switch table
         // Pop the jump position
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CHECK_FAIL();
         break;
 
@@ -950,19 +997,27 @@ bool CompilerEngine::step(EmitContext& emitContext,
         break;
 
     case 0x63: // shr
-    case 0x64: // shr.un   See div.un, rem.un comment
-        CompilerTraceOpcode("shr" << ((instructionPrefix == 0x64) ? ".un" : "") << endl);
+        CompilerTraceOpcode("shr" << endl);
         BinaryOpcodes::binary(emitContext, BinaryOpcodes::BIN_SHR);
         break;
 
+    case 0x64: // shr.un
+        CompilerTraceOpcode("shr.un" << endl);
+        BinaryOpcodes::binary(emitContext, BinaryOpcodes::BIN_SHR_UN);
+        break;
+
     case 0x65: // neg - Minus number
         CompilerTraceOpcode("neg" << endl);
+        if (ConstOpcodes::unary(emitContext, ConstOpcodes::UNARY_NEG))
+            break;
         RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(0));
         methodRuntime.m_compiler->neg32(stack.getArg(0).getStackHolderObject()->getTemporaryObject());
         break;
 
     case 0x66: // not - bitwise not
         CompilerTraceOpcode("not" << endl);
+        if (ConstOpcodes::unary(emitContext, ConstOpcodes::UNARY_NOT))
+            break;
         RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(0));
         methodRuntime.m_compiler->not32(stack.getArg(0).getStackHolderObject()->getTemporaryObject());
         break;
@@ -1021,7 +1076,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0x70: // cpobj <token>
         // Read the token of the object
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CompilerTraceOpcode("cpobj " << HEXDWORD(u32) << endl);
         // Invoke either memcpy or storeVar (for objects)
         CHECK_FAIL();
@@ -1030,7 +1085,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x71: // ldobj <token>
         CompilerTraceOpcode("ldobj" << endl);
         // Read the token of the object
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         resolveTypeToken(u32, apartmentId, globalContext.getTypedefRepository(), type);
         // Read the variable address
         ArrayOpcodes::ldind(emitContext, type);
@@ -1039,7 +1094,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x72: // ldstr <token>
         CompilerTraceOpcode("ldstr" << endl);
         // Read the token of the string
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
 
         switch (EncodingUtils::getTokenTableIndex((mdToken)u32))
         {
@@ -1061,7 +1116,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0x73: // newobj <T>
         // Read the token of the object's constructor
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CompilerTraceOpcode("newobj " << HEXDWORD(u32) << endl);
         mdtoken = apartment.getTables().getTypedefParent(u32);
         resolveTypeToken(mdtoken, apartmentId, globalContext.getTypedefRepository(), type);
@@ -1077,7 +1132,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
         break;
 
     case 0x74: // castclass <T>
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CompilerTraceOpcode("castclass " << HEXDWORD(u32) << endl);
         resolveTypeToken(u32, apartmentId, globalContext.getTypedefRepository(), type);
 
@@ -1114,7 +1169,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
         break;
 
     case 0x75: // isinst <T>
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CompilerTraceOpcode("isinst " << HEXDWORD(u32) << endl);
         resolveTypeToken(u32, apartmentId, globalContext.getTypedefRepository(), type);
 
@@ -1135,7 +1190,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x79: // unbox
         CompilerTraceOpcode("unbox" << ((instructionPrefix == 0xA5) ? ".any" : "") << endl);
         // Read the token
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(0));
         stack.getArg(0).setType(StackEntity::ENTITY_REGISTER_ADDRESS);
         // Change the element size to the unbox form
@@ -1151,7 +1206,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0x7B: // ldfld <fieldToken>  Load field of an object
         // Read the field-id for the new array
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CompilerTraceOpcode("ldfld " << HEXDWORD(u32) << endl);
         token = buildTokenIndex(apartmentId, u32);
 
@@ -1161,7 +1216,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0x7C: // ldflda <fieldToken>  Load field address
         // Read the field-id for the new array
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CompilerTraceOpcode("ldflda " << HEXDWORD(u32) << endl);
         token = buildTokenIndex(apartmentId, u32);
 
@@ -1172,7 +1227,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0x7D: // stfld <fieldToken>   Store into a field of an object
         // Read the field-id for the new array
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CompilerTraceOpcode("stfld " << HEXDWORD(u32) << endl);
         token = buildTokenIndex(apartmentId, u32);
 
@@ -1186,7 +1241,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x7E: // ldsfld <fieldToken>   Load static field of a class
         CompilerTraceOpcode("ldsfld" << endl);
         // Read the field-id for the new array
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         token = buildTokenIndex(apartmentId, u32);
         // Check to see whether the class .cctor should be called
 
@@ -1210,7 +1265,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x7F: // ldsflda <fieldToken>   Load static field address
         CompilerTraceOpcode("ldsflda" << endl);
         // Read the field-id for the new array
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         token = buildTokenIndex(apartmentId, u32);
         // Check to see whether the class .cctor should be called
         // Add a call jump (if !initialize) to .cctor if there is one
@@ -1231,7 +1286,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x80: // stsfld <fieldToken>   Store a static field of a class
         CompilerTraceOpcode("stsfld" << endl);
         // Read the field-id for the new array
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         token = buildTokenIndex(apartmentId, u32);
 
         // Check to see whether the class .cctor should be called
@@ -1258,7 +1313,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x81: // stobj <token>
         CompilerTraceOpcode("stobj" << endl);
         // Read the token of the object
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         resolveTypeToken(u32, apartmentId, globalContext.getTypedefRepository(), type);
         ArrayOpcodes::stind(emitContext, type);
         break;
@@ -1266,7 +1321,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
     case 0x8C: // box <valueType>
         CompilerTraceOpcode("box" << endl);
         // Read the typedef or ref for the new array
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         resolveTypeToken(u32, apartmentId, globalContext.getTypedefRepository(), type);
 
         // Pop the value from the stack and evaluate it
@@ -1290,7 +1345,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
         break;
 
     case 0x8D: // newarr <token>
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CompilerTraceOpcode("newarr (type: " << HEXDWORD(u32) << ")" << endl);
         resolveTypeToken(u32, apartmentId, globalContext.getTypedefRepository(), type);
         ArrayOpcodes::handleNewArray(emitContext, type);
@@ -1303,7 +1358,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0x8F: // ldelema <T> Load address of an element of an array
         CompilerTraceOpcode("ldelema" << endl);
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         resolveTypeToken(u32, apartmentId, globalContext.getTypedefRepository(), type);
         ArrayOpcodes::handleLoadAddressOfAnElement(emitContext, type);
         break;
@@ -1324,7 +1379,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0xA3: // ldelem - TODO!
     case 0xA4: // stelem - TODO!
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         resolveTypeToken(u32, apartmentId, globalContext.getTypedefRepository(), type);
         CompilerTraceOpcode("st/ldelem not implemmented yet for " << HEXTOKEN(type.getClassToken()) << endl);
         CHECK_FAIL();
@@ -1361,7 +1416,7 @@ bool CompilerEngine::step(EmitContext& emitContext,
         // TODO!!! From B3
 
     case 0xD0: // ldtoken
-        instructionCache.streamReadUint32(u32);
+        u32 = instruction.getUint32();
         CompilerTraceOpcode("ldtoken " << HEXDWORD(u32) << endl);
         RegisterEvaluatorOpcodes::implementLoadToken(emitContext, u32);
         break;
@@ -1388,24 +1443,20 @@ bool CompilerEngine::step(EmitContext& emitContext,
 
     case 0xDD: // leave <int32>    Exit a protected region of code.
     case 0xDE: // leave <int8>     Exit a protected region of code, short form
-        offset = readOffset(instructionCache, instructionPrefix == 0xDE);
+        offset = instruction.getBranchOffset();
         CompilerTraceOpcode("leave" <<
             ((instructionPrefix == 0xDE) ? ".s" : "") << endl);
 
         // Calculate the target index
-        if (initializedDummyPosition == 0)
-        {
-            opIndex = initializedDummyPosition + instructionCache.getPointer() -
-                methodContext.getMethodStreamStartAddress();
-        }
+        opIndex = instruction.m_nextOffset;
         opIndex += offset;
 
         if (!ExceptionOpcodes::implementLeave(emitContext, instructionIndex, opIndex))
         {
             // Bad "leave" instruction - treat like "br"
             return step(emitContext,
-                *generateInstructionStream(ILASM_BR, offset),
-                instructionCache.getPointer());
+                generateInstruction(ILASM_BR, instruction, offset),
+                true);
         }
         return true;
 
@@ -1420,10 +1471,9 @@ bool CompilerEngine::step(EmitContext& emitContext,
     }
 
     // Instruction compiled. Check for block merging
-    if (initializedDummyPosition == 0)
+    if (!isLogical)
     {
-        opIndex = instructionCache.getPointer() -
-            methodContext.getMethodStreamStartAddress();
+        opIndex = instruction.m_nextOffset;
         if (methodRuntime.m_methodSet.isSet(opIndex))
         {
             // Terminate block, merging should be in progress
@@ -1473,6 +1523,49 @@ void CompilerEngine::jumpToAddress(EmitContext& emitContext,
         emitContext.methodRuntime.m_compiler->jump(blockNumber);
 }
 
+void CompilerEngine::branchConst(EmitContext& emitContext,
+    const MSILInstruction& instruction,
+    bool isTaken)
+{
+    // The condition is no longer needed
+    emitContext.currentBlock.getCurrentStack().pop2null();
+
+    uint nextBlock = instruction.m_nextOffset;
+    if (isTaken)
+        nextBlock += instruction.getBranchOffset();
+    CompilerTrace("\t\tConstant branch to " << HEXDWORD(nextBlock) << endl);
+
+    // Only the taken successor is generated. The other block is compiled only
+    // if it is reached by another branch.
+    emitContext.methodRuntime.AddMethodBlock(emitContext.currentBlock, emitContext, nextBlock);
+    emitContext.currentBlock.terminateMethodBlock(&emitContext, MethodBlock::COND_ALWAYS,
+        nextBlock, instruction.m_nextOffset);
+}
+
+bool CompilerEngine::isFollowedByReturn(EmitContext& emitContext,
+                                        const MSILInstruction& instruction)
+{
+    const MSILInstructions& instructions = emitContext.methodContext.getInstructions();
+    uint position = instructions.getInstructionIndex(instruction.m_nextOffset);
+    if (position == MAX_UINT32)
+        return false;
+
+    const MSILInstruction& next = instructions[position];
+    return (!next.isExtended()) && (next.getOpcodeByte() == 0x2A);
+}
+
+bool CompilerEngine::isTailPrefixed(EmitContext& emitContext,
+                                    const MSILInstruction& instruction)
+{
+    const MSILInstructions& instructions = emitContext.methodContext.getInstructions();
+    uint position = instructions.getInstructionIndex(instruction.m_offset);
+    if ((position == MAX_UINT32) || (position == 0))
+        return false;
+
+    const MSILInstruction& prefix = instructions[position - 1];
+    return prefix.isExtended() && (prefix.getOpcodeByte() == 0x14);
+}
+
 void CompilerEngine::simpleConditionalJump(EmitContext& emitContext,
     int blockNumber,
     bool shortAddress,
@@ -1500,6 +1593,66 @@ void CompilerEngine::simpleConditionalJump(EmitContext& emitContext,
     }
 }
 
+void CompilerEngine::compareConditionalJump(EmitContext& emitContext,
+    int blockNumber,
+    bool shortAddress,
+    CompilerInterface::CompareCondition condition,
+    bool isSigned)
+{
+    // Pop both operands, exception will be thrown if the stack is invalid.
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+    StackEntity secondObject(stack.peek());
+    stack.pop2null();
+    StackEntity firstObject(stack.peek());
+    stack.pop2null();
+
+    // COMPLEXSTRUCT
+    RegisterEvaluatorOpcodes::evaluateInt32(emitContext, firstObject);
+    RegisterEvaluatorOpcodes::evaluateInt32(emitContext, secondObject);
+    const StackLocation& first = firstObject.getStackHolderObject()->getTemporaryObject();
+    const StackLocation& second = secondObject.getStackHolderObject()->getTemporaryObject();
+
+    if (!shortAddress)
+    {
+        // Long form
+        emitContext.methodRuntime.m_compiler->jumpCompare(first, second, condition, isSigned, blockNumber);
+    } else
+    {
+        // Short form
+        emitContext.methodRuntime.m_compiler->jumpCompareShort(first, second, condition, isSigned, blockNumber);
+    }
+}
+
+bool CompilerEngine::branchCompare(EmitContext& emitContext,
+    const MSILInstruction& instruction,
+    CompilerInterface::CompareCondition condition,
+    bool isSigned)
+{
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+
+    // Constant comparisons are folded by ConstOpcodes
+    if (ConstOpcodes::isConst32(stack.getArg(0)) &&
+        ConstOpcodes::isConst32(stack.getArg(1)))
+        return false;
+
+    // Load the operands now, so the code which is appended when the method is
+    // concluded is only the compare and the jump. See
+    // MethodCompiler::getMaxBlockSize
+    RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(1));
+    RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(0));
+
+    // Generate two new blocks for both conditions, without the operands
+    uint target = instruction.getBranchTarget();
+    emitContext.methodRuntime.AddMethodBlock(emitContext.currentBlock, emitContext, target, 2);
+    emitContext.methodRuntime.AddMethodBlock(emitContext.currentBlock, emitContext, instruction.m_nextOffset, 2);
+
+    // The compare and the jump are generated when the method is concluded
+    emitContext.currentBlock.setCompareCondition(condition, isSigned);
+    emitContext.currentBlock.terminateMethodBlock(&emitContext, MethodBlock::COND_COMPARE,
+        target, instruction.m_nextOffset);
+    return true;
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 void CompilerEngine::fixStack(EmitContext& emitContext,
@@ -1582,63 +1735,33 @@ uint CompilerEngine::translateIndexEncoding(uint8 opcode, uint8 opcodeBase)
     return MAX_UINT32;
 }
 
-int CompilerEngine::readOffset(basicInput& stream, bool shortForm)
-{
-    if (shortForm)
-    {
-        int8 offset;
-        stream.streamReadInt8(offset);
-        return offset;
-    } else
-    {
-        int32 offset;
-        stream.streamReadInt32(offset);
-        return offset;
-    }
-}
-
-cForkStreamPtr CompilerEngine::generateInstructionStream(
+MSILInstruction CompilerEngine::generateInstruction(
     ILasmInstruction instruction,
+    const MSILInstruction& original,
     int32 immediate)
 {
-    static const uint8 gCeq[]     = {0xFE, 0x01};
-    static const uint8 gCgt[]     = {0xFE, 0x02};
-    static const uint8 gCgtUn[]   = {0xFE, 0x03};
-    static const uint8 gClt[]     = {0xFE, 0x04};
-    static const uint8 gCltUn[]   = {0xFE, 0x05};
-    static const uint8 gBrfalse[] = {0x39};
-    static const uint8 gBrtrue[]  = {0x3A};
-    static const uint8 gBr[]      = {0x38};
-
-    cForkStreamPtr stream(new cMemoryStream());
+    uint16 opcode;
     switch (instruction)
     {
-    case ILASM_CEQ: stream->pipeWrite(gCeq, arraysize(gCeq)); break;
-    case ILASM_CGT: stream->pipeWrite(gCgt, arraysize(gCgt)); break;
-    case ILASM_CLT: stream->pipeWrite(gClt, arraysize(gClt)); break;
-    case ILASM_CGT_UN: stream->pipeWrite(gCgtUn, arraysize(gCgtUn)); break;
-    case ILASM_CLT_UN: stream->pipeWrite(gCltUn, arraysize(gCltUn)); break;
-
-    case ILASM_BRFALSE:
-        stream->pipeWrite(gBrfalse, arraysize(gBrfalse));
-        stream->streamWriteInt32(immediate);
-        break;
-    case ILASM_BRTRUE:
-        stream->pipeWrite(gBrtrue, arraysize(gBrtrue));
-        stream->streamWriteInt32(immediate);
-        break;
-    case ILASM_BR:
-        stream->pipeWrite(gBr, arraysize(gBr));
-        stream->streamWriteInt32(immediate);
-        break;
+    case ILASM_CEQ: opcode = 0xFE01; break;
+    case ILASM_CGT: opcode = 0xFE02; break;
+    case ILASM_CLT: opcode = 0xFE04; break;
+    case ILASM_CGT_UN: opcode = 0xFE03; break;
+    case ILASM_CLT_UN: opcode = 0xFE05; break;
+    case ILASM_BRFALSE: opcode = 0x39; break;
+    case ILASM_BRTRUE: opcode = 0x3A; break;
+    case ILASM_BR: opcode = 0x38; break;
     default:
         // Unknown opcode
-        CompilerTrace("generateInstructionStream: Unknown instruction!" << endl);
+        CompilerTrace("generateInstruction: Unknown instruction!" << endl);
         CHECK_FAIL();
     }
 
-    stream->seek(0, basicInput::IO_SEEK_SET);
-    return stream;
+    // Branch offsets are relative to the end of the original instruction
+    return MSILInstruction(opcode,
+                           original.m_offset,
+                           original.m_nextOffset,
+                           (uint64)(int64)immediate);
 }
 
 void CompilerEngine::checkUnsafe(MethodRuntimeBoundle& methodRuntime)
@@ -1660,9 +1783,27 @@ void CompilerEngine::resolveTypeToken(mdToken u32,
 void CompilerEngine::emitStaticInitializer(EmitContext& emitContext,
     const ElementType& tokenType)
 {
-    if (emitContext.methodContext.getApartment()->getObjects().
-        getTypedefRepository().getStaticInitializerMethod(tokenType.getClassToken()) != ElementType::UnresolvedTokenIndex)
+    const TokenIndex& typeToken = tokenType.getClassToken();
+    TypedefRepository& typedefRepository = emitContext.methodContext.getApartment()->getObjects().
+        getTypedefRepository();
+    if (typedefRepository.getStaticInitializerMethod(typeToken) == ElementType::UnresolvedTokenIndex)
+        return;
+
+    // Once the first check of the block returns, the initializer was invoked
+    if (emitContext.initializedTypes.hasKey(typeToken))
+        return;
+    emitContext.initializedTypes.append(typeToken, true);
+
+    TokenIndex wrapper = CallingConvention::buildCCTOR(typeToken);
+    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
+    if (!compiler.isGuardedCallSupported())
     {
-        CallingConvention::call(emitContext, CallingConvention::buildCCTOR(tokenType.getClassToken()));
+        CallingConvention::call(emitContext, wrapper);
+        return;
     }
+
+    // Test the wrapper's boolean inline, so only the first access pays for a call
+    compiler.guardedCall(
+        CallingConvention::serializeToken(typedefRepository.getStaticInitializerGuard(typeToken)),
+        CallingConvention::serializedMethod(wrapper));
 }
@@ -50,6 +50,7 @@
 #include "compiler/StackEntity.h"
 #include "compiler/EmitContext.h"
 #include "runnable/ResolverInterface.h"
+#include "format/MSILInstructions.h"
 
 // Forward decelerations
 class CallingConvention;
@@ -67,24 +68,20 @@ public:
     /*
      * Compile one MSIL instruction
      *
-     * emitContext      - Method context. See EmitContext
-     * instructionCache - Current block instruction cache
-     *
-     * NOTE: Argument which you mustn't use! (TODO! Refactor this code)
-     * ================================================================
-     * initializedDummyPosition   - Used in instruction reuse. The original
-     *                              stream location. Used in pointers
-     *                              calculation. If this number is different
-     *                              then 0, then the engine assumes that
-     *                              'instructionCache' is logical stream
+     * emitContext - Method context. See EmitContext
+     * instruction - The decoded instruction. See MethodRunnable::getInstructions
+     * isLogical   - Set to true for instructions which are generated by the
+     *               engine (See generateInstruction) in order to implement
+     *               another instruction. Logical instructions are not marked
+     *               as compiled and don't trigger block merging.
      *
      * Return true if the current block is completed.
      * Return false if the current block is not ready yet and there are more
      * instruction to be compiled.
      */
     static bool step(EmitContext& emitContext,
-                     basicInput& instructionCache,
-                     uint initializedDummyPosition = 0);
+                     const MSILInstruction& instruction,
+                     bool isLogical = false);
 
 
     /*
@@ -92,15 +89,15 @@ public:
      *    - Terminate the current block with COND_NON
      *    - Generate a new block at next instruction with same stack
      *
-     * emitContext      - Method context. See EmitContext
-     * instructionCache - Current block instruction cache
+     * emitContext - Method context. See EmitContext
+     * instruction - The next instruction to be compiled
      *
      * Return true if there is a split, so the current block is done.
      * Return false if the current block is not split and there are more
      *        instructions to be compiled.
      */
     static bool handleSplit(EmitContext& emitContext,
-                     basicInput& instructionCache);
+                            const MSILInstruction& instruction);
 
     /*
      * Jump into a basic block address
@@ -129,6 +126,75 @@ public:
                                       bool shortAddress,
                                       bool isZero);
 
+    /*
+     * Jump into a basic block address if the two top-of-stack values compare.
+     * See CompilerInterface::jumpCompare
+     *
+     * emitContext      - Method context. See EmitContext
+     * blockNumber      - The block to jump to (See Compiler MANGLED names)
+     * shortAddress     - Set to true if the jump into address can be decoded as
+     *                    short relative jump
+     * condition        - The comparison between the values
+     * isSigned         - Set to false for unsigned comparison
+     *
+     * Exception will be thrown if the stack is invalid.
+     */
+    static void compareConditionalJump(EmitContext& emitContext,
+                                       int blockNumber,
+                                       bool shortAddress,
+                                       CompilerInterface::CompareCondition condition,
+                                       bool isSigned);
+
+    /*
+     * Implement beq/bne/bge/bgt/ble/blt by terminating the block with a
+     * COND_COMPARE condition. The comparison is fused with the jump when the
+     * block is finalized.
+     *
+     * emitContext      - Method context. See EmitContext
+     * instruction      - The branch instruction
+     * condition        - The comparison between the two top-of-stack values
+     * isSigned         - Set to false for unsigned comparison
+     *
+     * Return false if the comparison should be compiled by ceq/cgt/clt
+     * (constant operands, which are folded), true if the block is terminated.
+     */
+    static bool branchCompare(EmitContext& emitContext,
+                              const MSILInstruction& instruction,
+                              CompilerInterface::CompareCondition condition,
+                              bool isSigned);
+
+    /*
+     * Implement brtrue/brfalse over a constant condition as an unconditional
+     * jump. The block which is not taken is not generated.
+     *
+     * emitContext      - Method context. See EmitContext
+     * instruction      - The branch instruction
+     * isTaken          - Set to true if the branch is taken
+     */
+    static void branchConst(EmitContext& emitContext,
+                            const MSILInstruction& instruction,
+                            bool isTaken);
+
+    /*
+     * Return true if 'instruction' is directly followed by 'ret'. A call
+     * which is followed by 'ret' is in tail position. See
+     * CallingConvention::tailCall
+     *
+     * emitContext      - Method context. See EmitContext
+     * instruction      - The call instruction
+     */
+    static bool isFollowedByReturn(EmitContext& emitContext,
+                                   const MSILInstruction& instruction);
+
+    /*
+     * Return true if 'instruction' has the 'tail.' prefix
+     *
+     * emitContext      - Method context. See EmitContext
+     * instruction      - The call instruction
+     */
+    static bool isTailPrefixed(EmitContext& emitContext,
+                               const MSILInstruction& instruction);
+
     /*
      * Make sure that a specific block terminates as the same state as a require
      * stack "customStack"
@@ -176,16 +242,7 @@ private:
      */
     static uint translateIndexEncoding(uint8 opcode, uint8 opcodeBase);
 
-    /*
-     * Read an offset from the stream.
-     *
-     * stream    - The instruction stream
-     * shortForm - Set to true in order to read 8 bit encoded offset, otherwise
-     *             the function will read 32 bit offset.
-     */
-    static int readOffset(basicInput& stream, bool shortForm);
-
-    // The command for generateInstructionStream
+    // The command for generateInstruction
     enum ILasmInstruction {
         // FE 01 - Compare equal
         ILASM_CEQ,
@@ -207,13 +264,17 @@ private:
     };
 
     /*
-     * Generate new assembler stream containing a single instruction.
+     * Generate a logical instruction which implements part of another
+     * instruction.
      *
      * instruction - The instruction to generate
+     * original    - The instruction which is implemented. The new instruction
+     *               is located at the same offsets.
      * immediate   - Hard-coded immediate in the right cases
      */
-    static cForkStreamPtr generateInstructionStream(ILasmInstruction instruction,
-                                                    int32 immediate);
+    static MSILInstruction generateInstruction(ILasmInstruction instruction,
+                                               const MSILInstruction& original,
+                                               int32 immediate);
 
     /*
      * Check that the current context allows unsafe execution.
@@ -42,6 +42,7 @@
 #include "compiler/OptimizerOperationCompilerInterface.h"
 #include "compiler/processors/arm/ARMCompilerInterface.h"
 #include "compiler/processors/arm/THUMBCompilerInterface.h"
+#include "compiler/processors/arm/THUMB2CompilerInterface.h"
 #include "compiler/processors/ia32/IA32CompilerInterface.h"
 #include "compiler/processors/c/32C.h"
 
@@ -92,6 +93,9 @@ CompilerInterfacePtr CompilerFactory::getCompiler(CompilerType type, const Frame
     case COMPILER_THUMB:
         pCompiler = new THUMBCompilerInterface(framework, params);
         break;
+    case COMPILER_THUMB2:
+        pCompiler = new THUMB2CompilerInterface(framework, params);
+        break;
     default:
         CHECK_FAIL();
     }
@@ -113,21 +117,35 @@ CompilerInterfacePtr CompilerFactory::getCompiler(CompilerType type, const Frame
 }
 
 MemoryLayoutInterfacePtr CompilerFactory::getMemoryLayout(CompilerType type)
+{
+    switch(getMemoryLayoutType(type))
+    {
+    case LAYOUT_IA32:
+        return MemoryLayoutInterfacePtr(new IA32MemoryLayout());
+    case LAYOUT_ARM:
+        return MemoryLayoutInterfacePtr(new ARMMemoryLayout());
+    default:
+        CHECK_FAIL();
+        break;
+    }
+    return MemoryLayoutInterfacePtr(NULL);
+}
+
+CompilerFactory::MemoryLayoutType CompilerFactory::getMemoryLayoutType(CompilerType type)
 {
     switch(type)
     {
     case COMPILER_IA32:
-        return MemoryLayoutInterfacePtr(new IA32MemoryLayout());
     case COMPILER_32C:
-        return MemoryLayoutInterfacePtr(new IA32MemoryLayout());
+        return LAYOUT_IA32;
     case COMPILER_ARM:
-        return MemoryLayoutInterfacePtr(new ARMMemoryLayout());
     case COMPILER_THUMB:
-        return MemoryLayoutInterfacePtr(new ARMMemoryLayout());
+    case COMPILER_THUMB2:
+        return LAYOUT_ARM;
     default:
         CHECK_FAIL();
         break;
     }
-    return MemoryLayoutInterfacePtr(NULL);
+    return LAYOUT_IA32;
 }
 
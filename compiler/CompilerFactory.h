@@ -55,10 +55,21 @@ public:
         COMPILER_ARM,
         // Compiler for THUMB based machines
         COMPILER_THUMB,
+        // Compiler for THUMB-2 based machines (ARMv7-M)
+        COMPILER_THUMB2,
         // Compiler for 32bit C program
         COMPILER_32C
     };
 
+    // A list of all memory layouts. Compilers which share the same layout
+    // can share the same global objects (typedefs, strings, etc.)
+    enum MemoryLayoutType {
+        // 32bit, packed layout. See IA32MemoryLayout
+        LAYOUT_IA32,
+        // 32bit, dword aligned layout. See ARMMemoryLayout
+        LAYOUT_ARM
+    };
+
     /*
      * Build a new compiler for a specific machine
      *
@@ -72,6 +83,11 @@ public:
      * Return the memory layout for a compiler interface
      */
     static MemoryLayoutInterfacePtr getMemoryLayout(CompilerType type);
+
+    /*
+     * Return the type of the memory layout of a compiler interface
+     */
+    static MemoryLayoutType getMemoryLayoutType(CompilerType type);
 };
 
 #endif // __TBA_CLR_COMPILER_COMPILERFACTORY_H
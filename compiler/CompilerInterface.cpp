@@ -137,6 +137,84 @@ bool CompilerInterface::isOptimizerCompiler() const
     return false;
 }
 
+bool CompilerInterface::isMultiplyHighSupported() const
+{
+    return false;
+}
+
+bool CompilerInterface::isTailCallSupported() const
+{
+    return false;
+}
+
+void CompilerInterface::tailCall(const cString&, uint)
+{
+    // See isTailCallSupported()
+    CHECK_FAIL();
+}
+
+bool CompilerInterface::isGuardedCallSupported() const
+{
+    return false;
+}
+
+void CompilerInterface::guardedCall(const cString&, const cString&)
+{
+    // See isGuardedCallSupported()
+    CHECK_FAIL();
+}
+
+uint CompilerInterface::getArgumentRegistersCount() const
+{
+    return 0;
+}
+
+StackLocation CompilerInterface::getArgumentRegister(uint) const
+{
+    // See getArgumentRegistersCount()
+    CHECK_FAIL();
+    return StackInterface::EMPTY;
+}
+
+void CompilerInterface::pushArgRegisters32(uint)
+{
+    // See getArgumentRegistersCount()
+    CHECK_FAIL();
+}
+
+void CompilerInterface::setRegisterEntry(uint count)
+{
+    // See getArgumentRegistersCount()
+    CHECK(count == 0);
+}
+
+bool CompilerInterface::isUnwindDataSupported() const
+{
+    return false;
+}
+
+void CompilerInterface::generateUnwindData(bool, const cString&, const UnwindClauseList&)
+{
+    // See isUnwindDataSupported()
+    CHECK_FAIL();
+}
+
+uint CompilerInterface::getInlineCopySize() const
+{
+    return 4 * getStackSize();
+}
+
+bool CompilerInterface::isCopyMemorySupported() const
+{
+    return false;
+}
+
+void CompilerInterface::copyMemory(StackLocation, StackLocation, uint)
+{
+    // See isCopyMemorySupported()
+    CHECK_FAIL();
+}
+
 StackLocation CompilerInterface::getMethodBaseStackRegister() const
 {
     return m_binary->getCurrentStack()->getBaseStackRegister();
@@ -42,6 +42,7 @@
 #include "xStl/types.h"
 #include "xStl/data/setArray.h"
 #include "xStl/data/smartptr.h"
+#include "xStl/data/list.h"
 #include "dismount/assembler/FirstPassBinary.h"
 #include "dismount/assembler/AssemblerInterface.h"
 #include "runnable/FrameworkMethods.h"
@@ -231,7 +232,25 @@ public:
         OPCODE_LOCALLOC,  //43
         OPCODE_REVERT_STACK,  //44
         OPCODE_RESET_BASE_STACK_REGISTER, // 45
-        OPCODE_SET_FRAME_POINTER
+        OPCODE_SET_FRAME_POINTER, // 46
+        OPCODE_JUMP_COMPARE, // 47
+        OPCODE_JUMP_COMPARE_SHORT, // 48
+        OPCODE_PUSH_ARG_CONST_32, // 49
+        OPCODE_PUSH_ARG_STACK_32, // 50
+        OPCODE_TAIL_CALL, // 51
+        OPCODE_COPY_MEMORY, // 52
+        OPCODE_GUARDED_CALL, // 53
+        OPCODE_SAR_32 // 54
+    };
+
+    // The conditions of jumpCompare()
+    enum CompareCondition {
+        COMPARE_EQUAL,
+        COMPARE_NOT_EQUAL,
+        COMPARE_GREATER,
+        COMPARE_GREATER_EQUAL,
+        COMPARE_LESS,
+        COMPARE_LESS_EQUAL
     };
 
     class CompilerOperation
@@ -249,12 +268,14 @@ public:
             bool cond2,
             bool cond3,
             const cString& dependencyName,
-            const uint8* buf) :
+            const uint8* buf,
+            const cString& secondDependencyName = cString()) :
                 opcode(opcode),
                 uval1(uval1), uval2(uval2), val(val), size(size),
                 sloc1(sloc1), sloc2(sloc2),
                 cond1(cond1), cond2(cond2), cond3(cond3),
-                dependencyName(dependencyName)
+                dependencyName(dependencyName),
+                secondDependencyName(secondDependencyName)
             { if (buf != 0) {
                 memcpy (buffer, buf, STORE_CONST_MAX_SIZE);
                 }
@@ -271,6 +292,7 @@ public:
         bool cond2;
         bool cond3;
         cString dependencyName;
+        cString secondDependencyName;
         uint8 buffer[STORE_CONST_MAX_SIZE];
     };
 
@@ -430,6 +452,23 @@ public:
      */
     virtual void pushArg32(StackLocation source) = 0;
 
+    /*
+     * Push 32 bit method argument without evaluating it into a register first
+     *
+     * value - The immediate to push for the next method
+     */
+    virtual void pushArgConst32(int32 value) = 0;
+
+    /*
+     * Push a 32 bit local or argument variable as the next method argument
+     * without evaluating it into a register first.
+     *
+     * stackPosition         - The location in the stack. See load32
+     * argumentStackLocation - Set to true if the stack element is located at
+     *                         the arguments pool, false for the locals pool
+     */
+    virtual void pushArgStack32(uint stackPosition, bool argumentStackLocation) = 0;
+
     /*
      * Pop entry from stack
      */
@@ -461,6 +500,125 @@ public:
                         StackLocation destination,
                         uint numberOfArguments) = 0;
 
+    /*
+     * Return true if the architecture implements tailCall. The default is false
+     */
+    virtual bool isTailCallSupported() const;
+
+    /*
+     * Leave the current method and jump into another method, which returns
+     * directly into our caller.
+     *
+     * dependencyName    - The method to jump into
+     * argumentsSize     - The size of the arguments which were pushed for the
+     *                     new method. They replace the current method's
+     *                     arguments, so both areas must have the same size.
+     *                     0 passes the current arguments as-is (IL 'jmp').
+     *
+     * NOTE: The method must not have anything left to clean up.
+     */
+    virtual void tailCall(const cString& dependencyName, uint argumentsSize);
+
+    /*
+     * Return true if the architecture implements guardedCall. The default is
+     * false
+     */
+    virtual bool isGuardedCallSupported() const;
+
+    /*
+     * Call a method without arguments or return value, only if a global byte
+     * flag is zero:
+     *      if (*guardName == 0) dependencyName();
+     *
+     * guardName      - The dependency of the flag byte
+     * dependencyName - The method to call
+     *
+     * Used for the static-constructor wrappers, so the common (already
+     * initialized) path is a single compare instead of a call.
+     */
+    virtual void guardedCall(const cString& guardName,
+                             const cString& dependencyName);
+
+    /*
+     * The offset of the register entry from the start of a method. A method
+     * which receives its first arguments in registers starts with a jump over
+     * the register entry, which stores the registers into the arguments
+     * slots. The offset is the same on every architecture, so the linkers
+     * don't depend on the compiler type.
+     */
+    enum { REGISTER_ENTRY_OFFSET = 4 };
+
+    /*
+     * Return the number of argument registers of the register entry. The
+     * default is 0, all the arguments are passed on the stack.
+     */
+    virtual uint getArgumentRegistersCount() const;
+
+    /*
+     * Return the register which passes the argument slot 'index', smaller than
+     * getArgumentRegistersCount(), to a register entry
+     */
+    virtual StackLocation getArgumentRegister(uint index) const;
+
+    /*
+     * Reserve the stack slots of the first 'count' arguments of the next
+     * method, after the rest were pushed. These arguments are passed in the
+     * argument registers, and the register entry stores them into the slots.
+     */
+    virtual void pushArgRegisters32(uint count);
+
+    /*
+     * Start the method with a register entry which stores the first 'count'
+     * argument registers into their stack slots. Must be called before
+     * generateMethodEpiProLogs. 0 (the default) means no register entry.
+     */
+    virtual void setRegisterEntry(uint count);
+
+    //////////////////////////////////////////////////////////////////////////
+    // Exception handling
+
+    /*
+     * Return true if the architecture describes the protected blocks of each
+     * method by unwind data (See generateUnwindData). The runtime walks the
+     * frame pointer chain and reads the data only when an exception is thrown,
+     * so entering a protected block costs nothing. The default is false, the
+     * handlers are registered on the exception stack when the blocks are
+     * entered.
+     */
+    virtual bool isUnwindDataSupported() const;
+
+    /*
+     * A protected block of the unwind data
+     */
+    struct UnwindClause
+    {
+        // The first block of the protected code, and the block which follows it
+        int m_tryStartBlock;
+        int m_tryEndBlock;
+        // The handler type. See FrameworkMethods::ExceptionRoutineType
+        uint m_type;
+        // The dependency of the handler helper
+        cString m_handlerName;
+        // The RTTI of the caught class, for catch handlers
+        uint m_exceptionRtti;
+    };
+    typedef cList<UnwindClause> UnwindClauseList;
+
+    /*
+     * Append the unwind data of the method, after all of its blocks. The
+     * linker collects the data of all the methods into the unwind table. See
+     * ExceptionHandling.cs
+     *
+     * isHelper    - Set to true for an exception handler helper. The frame
+     *               of the method is passed to the helper as argument
+     * cleanupName - The dependency of the method cleanup routine, or an empty
+     *               string
+     * clauses     - The protected blocks. Inner blocks come first
+     */
+    virtual void generateUnwindData(bool isHelper,
+                                    const cString& cleanupName,
+                                    const UnwindClauseList& clauses);
+
     //////////////////////////////////////////////////////////////////////////
     // Memory handling
 
@@ -503,6 +661,33 @@ public:
                             uint size,
                             bool signExtend = false) = 0;
 
+    /*
+     * Return the largest constant size (in bytes) which memcpy/memset are
+     * expanded inline for, as a sequence of loadMemory/storeMemory operations,
+     * instead of calling the framework. The default is four stack words.
+     */
+    virtual uint getInlineCopySize() const;
+
+    /*
+     * Return true if the architecture implements copyMemory. The default is false
+     */
+    virtual bool isCopyMemorySupported() const;
+
+    /*
+     * Copy a memory block:
+     *      memcpy(destination, source, size);
+     *
+     * destination    - The register holding the destination address
+     * source         - The register holding the source address
+     * size           - The number of bytes to copy. Must be a multiple of 4.
+     *
+     * NOTE: Both registers, and all other allocated registers, keep their
+     *       values.
+     */
+    virtual void copyMemory(StackLocation destination,
+                            StackLocation source,
+                            uint size);
+
     //////////////////////////////////////////////////////////////////////////
     // Unary operations
 
@@ -554,6 +739,7 @@ public:
      *    xor32 - Bitwise eXclusive or (^)
      *    shl32 - Bitwise shift to left (>>)
      *    shr32 - Bitwise shift to right (<<)
+     *    sar32 - Arithmetic shift to right, the sign bit is copied (>>)
      *
      * destination - The 'a' variable. Used as result holder
      * source      - The 'b' variable.
@@ -572,6 +758,7 @@ public:
     virtual void and32(StackLocation destination, StackLocation source) = 0;
     virtual void xor32(StackLocation destination, StackLocation source) = 0;
     virtual void shr32(StackLocation destination, StackLocation source) = 0;
+    virtual void sar32(StackLocation destination, StackLocation source) = 0;
     virtual void shl32(StackLocation destination, StackLocation source) = 0;
     virtual void or32 (StackLocation destination, StackLocation source) = 0;
 
@@ -584,9 +771,13 @@ public:
      */
     virtual void adc32 (StackLocation destination, StackLocation source) = 0;
     virtual void sbb32 (StackLocation destination, StackLocation source) = 0;
-    /* ILANK: Ignoring this method for optimization at first step. FIX later */
     virtual void mul32h(StackLocation destlow, StackLocation desthigh, StackLocation source, bool sign) = 0;
 
+    /*
+     * Return true if the architecture implements mul32h. The default is false
+     */
+    virtual bool isMultiplyHighSupported() const;
+
     /*
      * Perform add operation between stack register(s) and const integer 32. The
      * integer can be either sign or unsigned. The result is stored at the
@@ -634,6 +825,30 @@ public:
     virtual void jumpCond(StackLocation compare, int blockID, bool isZero) = 0;
     virtual void jumpCondShort(StackLocation compare, int blockID, bool isZero) = 0;
 
+    // Compare and jump
+
+    /*
+     * Generate a single compare and conditional jump into 'blockID' in normal
+     * form (long) or with the Short postfix (-128...127 bytes long):
+     *    if (first <condition> second) goto blockID;
+     *
+     * Unlike cXX32() + jumpCond() the comparison result is never materialized
+     * into a register.
+     *
+     * first     - The left side of the comparison
+     * second    - The right side of the comparison
+     * condition - The comparison to perform
+     * isSigned  - Set to false for unsigned comparison (ignored for equality)
+     * blockID   - The block to jump to. Mangled and add into the
+     *             dependency-tree
+     */
+    virtual void jumpCompare(StackLocation first, StackLocation second,
+                             CompareCondition condition, bool isSigned,
+                             int blockID) = 0;
+    virtual void jumpCompareShort(StackLocation first, StackLocation second,
+                                  CompareCondition condition, bool isSigned,
+                                  int blockID) = 0;
+
     //////////////////////////////////////////////////////////////////////////
     // Comparison methods
 
@@ -655,12 +870,7 @@ public:
      * source      - The 'b' variable.
      * isSigned    - Set to true if the operation reffering to unsigned numbers
      *
-     * OPTIMIZATION NOTE: Store the result of the operation in the processor's
-     *                    flag register and expand the jumpCondXXX to take in
-     *                    account for that special case (And uses special
-     *                    condition).
-     *                    Problem may occurred if the flag result will be used
-     *                    later on, and overlapped by another instruction.
+     * NOTE: Conditional branches should use jumpCompare() instead.
      */
     virtual void ceq32(StackLocation destination, StackLocation source) = 0;
     virtual void cgt32(StackLocation destination, StackLocation source, bool isSigned) = 0;
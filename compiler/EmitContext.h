@@ -37,6 +37,7 @@
  *
  * A collection of structures that allows binary operations
  */
+#include "xStl/data/hash.h"
 #include "data/ElementType.h"
 #include "compiler/CompilerInterface.h"
 #include "runnable/MethodRunnable.h"
@@ -60,6 +61,9 @@ struct EmitContext
     MethodBlock& currentBlock;
     // The exception cluase whose handler we are now compiling, or NULL regularly
     MethodHelper* pCurrentHelper;
+    // The types whose static initializer was already checked in this block.
+    // See CompilerEngine::emitStaticInitializer
+    cHash<TokenIndex, bool> initializedTypes;
 };
 
 
@@ -49,6 +49,8 @@ MethodBlock::MethodBlock(int firstBlockID,
     StackInterface(*compiler.getFirstPassPtr(), true, compiler.getStackSize()),
     m_compiler(compiler),
     m_isSeal(false),
+    m_compareCondition(CompilerInterface::COMPARE_EQUAL),
+    m_isCompareSigned(false),
     m_blockID(firstBlockID),
     m_stack(),
     m_registers(compiler.getArchRegisters()),
@@ -63,6 +65,8 @@ MethodBlock::MethodBlock(int blockID,
     StackInterface(other),
     m_compiler(other.m_compiler),
     m_isSeal(false),
+    m_compareCondition(CompilerInterface::COMPARE_EQUAL),
+    m_isCompareSigned(false),
     m_blockID(blockID),
     m_stack(other.m_stack),
     m_registers(other.m_registers),
@@ -190,17 +194,18 @@ void MethodBlock::fixStack(Stack& stack, MethodBlock& newBlock)
 
 MethodBlock* MethodBlock::duplicate(EmitContext& emitContext,
                                     int newBlockID,
-                                    bool shouldRemoveTOS)
+                                    uint removeCount)
 {
     // Make sure that the evaulate stack has no locals
     uint floatCount = m_stack.getStackCount();
-    for (uint i = (shouldRemoveTOS) ? 1 : 0; i < floatCount; i++)
+    for (uint i = removeCount; i < floatCount; i++)
     {
         RegisterEvaluatorOpcodes::evaluateInt32(emitContext, m_stack.getArg(i), true, 0, true);
     }
 
 
-    // Duplicate block
+    // Duplicate block. The new block has no condition yet, see the
+    // constructor
     MethodBlock* newBlock(new MethodBlock(newBlockID,
                                           *this));
 
@@ -210,9 +215,8 @@ MethodBlock* MethodBlock::duplicate(EmitContext& emitContext,
     // Change the stack
     fixStack(newBlock->m_stack, *newBlock);
 
-    // This will cause the last value to be removed from the NEW stack!
-    if (shouldRemoveTOS)
-        newBlock->m_stack.pop2null();
+    // This will cause the last values to be removed from the NEW stack!
+    newBlock->m_stack.pop2null(removeCount);
 
     // Just return the new object
     //return ref;
@@ -365,6 +369,26 @@ void MethodBlock::terminateMethodBlock(EmitContext* emitContext, ConditionalType
     // CompilerTrace("End of block. Return to: " << HEXDWORD(terminateAt) << " " << "Cond block at: " << HEXDWORD(m_conditionBlock) << endl);
 }
 
+void MethodBlock::setCompareCondition(CompilerInterface::CompareCondition condition,
+                                      bool isSigned)
+{
+    ASSERT(!m_isSeal);
+    m_compareCondition = condition;
+    m_isCompareSigned = isSigned;
+}
+
+CompilerInterface::CompareCondition MethodBlock::getCompareCondition() const
+{
+    CHECK(m_isSeal);
+    return m_compareCondition;
+}
+
+bool MethodBlock::isCompareSigned() const
+{
+    CHECK(m_isSeal);
+    return m_isCompareSigned;
+}
+
 void MethodBlock::finalizeCondition()
 {
     ASSERT(m_isSeal);
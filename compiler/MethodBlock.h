@@ -48,6 +48,7 @@
 #include "runnable/Stack.h"
 #include "format/methodHeader.h"
 #include "compiler/CompilerInterface.h"
+#include "compiler/CompilerArena.h"
 
 // Forward declaration
 struct EmitContext;
@@ -65,9 +66,12 @@ struct EmitContext;
  *
  * Just to clarify a block is a set of instructions ends with conditional jump.
  *
+ * The blocks are allocated from the active CompilerArena (See MethodCompiler)
+ *
  * NOTE: This class is not thread safe
  */
-class MethodBlock : public StackInterface {
+class MethodBlock : public StackInterface,
+                    public CompilerArenaObject {
 public:
     // Possible parts of an Exception clause
     enum ExceptionPart
@@ -205,12 +209,13 @@ public:
      *
      * NOTE: The stack reference objects are regenerated!
      *
-     * newBlockID      - The new block ID
-     * shouldRemoveTOS - Set to true to remove the top-os-stack.
+     * newBlockID  - The new block ID
+     * removeCount - The number of top-of-stack entries to remove (the
+     *               operands of the block condition).
      */
     MethodBlock* duplicate(EmitContext& emitContext,
                            int newBlockID,
-                           bool shouldRemoveTOS = false);
+                           uint removeCount = 0);
 
     /*
      * Mark a new instruction at block position.
@@ -288,6 +293,9 @@ public:
         COND_NON_ZERO   = 3,
         // Terminate the method, go to return block  (.NET instruction ret)
         COND_RETURN     = 4,
+        // Jump if the two last values compares (beq, blt, ...)
+        // See getCompareCondition()
+        COND_COMPARE    = 5,
 
         // TODO! Add exception handling blocks
 
@@ -341,6 +349,22 @@ public:
     void terminateMethodBlock(EmitContext* emitContext, ConditionalType type,
                               int conditionBlock, int terminateAt = -1);
 
+    /*
+     * Set the comparison of a COND_COMPARE block. Should be called before
+     * terminateMethodBlock()
+     *
+     * condition - The comparison between the two top-of-stack values
+     * isSigned  - Set to false for unsigned comparison
+     */
+    void setCompareCondition(CompilerInterface::CompareCondition condition,
+                             bool isSigned);
+
+    /*
+     * Return the comparison of a COND_COMPARE block
+     */
+    CompilerInterface::CompareCondition getCompareCondition() const;
+    bool isCompareSigned() const;
+
     /*
      * Changes the COND_HANDLED_BIT to indicate that the current block was
      * handled by the MethodCompiler (Useful to determine block size).
@@ -389,6 +413,9 @@ private:
     ConditionalType m_type;
     // The next block if the condition is true
     int m_conditionBlock;
+    // The comparison of COND_COMPARE
+    CompilerInterface::CompareCondition m_compareCondition;
+    bool m_isCompareSigned;
 
     // The current block ID
     int m_blockID;
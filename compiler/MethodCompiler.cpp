@@ -48,6 +48,7 @@
 #include "compiler/MethodRuntimeBoundle.h"
 #include "compiler/CallingConvention.h"
 #include "compiler/CompilerTrace.h"
+#include "compiler/opcodes/LoopOpcodes.h"
 #include "compiler/opcodes/ObjectOpcodes.h"
 #include "compiler/opcodes/RegisterEvaluatorOpcodes.h"
 
@@ -496,6 +497,11 @@ void MethodCompiler::methodRegisterCleanupFunction(MethodRunnable& method, Metho
     if (!m_compilerParams.m_bSupportExceptionHandling)
         return;
 
+    // The cleanup function is found through the unwind data instead.
+    // See methodGenerateUnwindData
+    if (m_interface->isUnwindDataSupported())
+        return;
+
     // Generate the block with a clean stack
     MethodBlock* pInitBlock = new MethodBlock(MethodBlock::BLOCK_REG_CLEANUP, *m_interface->getInnerCompilerInterface());
     StackInterfacePtr stack(pInitBlock);
@@ -507,6 +513,17 @@ void MethodCompiler::methodRegisterCleanupFunction(MethodRunnable& method, Metho
     // Create an EmitContext for this block
     EmitContext emitContext(method, boundle, *pInitBlock);
 
+    // Param0 is the entry, inside the method frame
+    StackEntity entry(StackEntity::ENTITY_REGISTER, ConstElements::gVoidPtr);
+    entry.setStackHolderObject(
+        TemporaryStackHolderPtr(new TemporaryStackHolder(
+            *stack, ELEMENT_TYPE_PTR, m_interface->getStackSize(), TemporaryStackHolder::TEMP_ONLY_REGISTER)));
+    m_interface->load32addr(boundle.m_cleanupEntryPosition,
+                            FrameworkMethods::EXCEPTION_ENTRY_WORDS * m_interface->getStackSize(),
+                            0,
+                            entry.getStackHolderObject()->getTemporaryObject());
+    pInitBlock->getCurrentStack().push(entry);
+
     // Param1 is the type - method cleanup
     StackEntity type(StackEntity::ENTITY_CONST, ConstElements::gU4);
     type.getConst().setConstValue(FrameworkMethods::EXCEPTION_ROUTINE_METHOD_CLEANUP);
@@ -524,13 +541,86 @@ void MethodCompiler::methodRegisterCleanupFunction(MethodRunnable& method, Metho
             *stack, pInitBlock->getBaseStackRegister())));
     pInitBlock->getCurrentStack().push(stackPointer);
 
-    // Call clrRegisterRoutine
+    // Call clrRegisterFrameRoutine
     CallingConvention::call(emitContext,
-                            m_apartment->getObjects().getFrameworkMethods().getRegisterRoutine());
+                            m_apartment->getObjects().getFrameworkMethods().getRegisterFrameRoutine());
 
     pInitBlock->terminateMethodBlock(NULL, MethodBlock::COND_NON, 0);
 }
 
+void MethodCompiler::methodGenerateUnwindData(CompilerInterface& compiler, MethodHelper* pOwner)
+{
+    if (!m_compilerParams.m_bSupportExceptionHandling)
+        return;
+    if (!compiler.isUnwindDataSupported())
+        return;
+
+    // Only the method itself has a cleanup function
+    cString cleanupName;
+    if ((pOwner == NULL) && (m_cleanupIndex != ElementType::UnresolvedTokenIndex))
+        cleanupName = CallingConvention::serializedMethod(m_cleanupIndex);
+
+    // The clauses are ordered from the innermost to the outermost, the same as
+    // in the method header. Only the protected blocks which were compiled into
+    // this function are described
+    const FirstPassBinary::BasicBlockList& blocks = compiler.getFirstPassPtr()->getBlocksList();
+    const MethodHeader::ExceptionHandlingClauseList& exceptions = m_methodRunnable.getMethodHeader().getExceptionsHandlers();
+    CompilerInterface::UnwindClauseList clauses;
+    for (MethodHeader::ExceptionHandlingClauseList::iterator i = exceptions.begin(); i != exceptions.end(); i++)
+    {
+        const MethodHeader::ExceptionHandlingClause& clause = (*i);
+
+        // Find the handler which was created when the protected block was entered
+        MethodHelper* pHelper = NULL;
+        for (MethodHelperList::iterator iHelper = m_helpers.begin(); iHelper != m_helpers.end(); iHelper++)
+        {
+            if (((*iHelper).m_parent == pOwner) &&
+                ((*iHelper).getClause().tryOffset == clause.tryOffset) &&
+                ((*iHelper).getClause().handlerOffset == clause.handlerOffset))
+            {
+                pHelper = &(*iHelper);
+                break;
+            }
+        }
+        if (pHelper == NULL)
+            continue;
+
+        // The protected block ends at the first block after it. The handlers
+        // are compiled into their own functions, so it's the return block at
+        // worst
+        int tryEnd = clause.tryOffset + clause.tryLength;
+        int tryEndBlock = MethodBlock::BLOCK_RET;
+        bool isTryStartFound = false;
+        for (FirstPassBinary::BasicBlockList::iterator iBlock = blocks.begin(); iBlock != blocks.end(); iBlock++)
+        {
+            int blockNumber = (*iBlock).m_blockNumber;
+            if (blockNumber == (int)clause.tryOffset)
+                isTryStartFound = true;
+            if ((blockNumber >= tryEnd) && (blockNumber < tryEndBlock))
+                tryEndBlock = blockNumber;
+        }
+        // The protected block is unreachable
+        if (!isTryStartFound)
+            continue;
+
+        CompilerInterface::UnwindClause unwindClause;
+        unwindClause.m_tryStartBlock = clause.tryOffset;
+        unwindClause.m_tryEndBlock = tryEndBlock;
+        unwindClause.m_type = FrameworkMethods::GetExceptionRoutineType(clause.flags);
+        unwindClause.m_handlerName = CallingConvention::serializedMethod(pHelper->getHandlerTokenIndex());
+        unwindClause.m_exceptionRtti = 0;
+        if (clause.flags == MethodHeader::ClauseCatch)
+            unwindClause.m_exceptionRtti = ExceptionOpcodes::getCatchRTTI(m_apartment, clause);
+        clauses.append(unwindClause);
+    }
+
+    // The function is transparent to exceptions
+    if (clauses.isEmpty() && (cleanupName.length() == 0))
+        return;
+
+    compiler.generateUnwindData(pOwner != NULL, cleanupName, clauses);
+}
+
 void MethodCompiler::compileBlocks(MethodRuntimeBoundle& boundle, MethodHelper* pCurrentHandler)
 {
     boundle.m_compiler->enableOptimizations();
@@ -576,11 +666,10 @@ void MethodCompiler::compileBlocks(MethodRuntimeBoundle& boundle, MethodHelper*
             }
         }
 
-        // Seek into method address
-        cForkStreamPtr stream = m_methodRunnable.getStreamPointer()->fork();
-        stream->seek(nextBlock.getBlockID() +
-                     m_methodRunnable.getMethodStreamStartAddress(),
-                     basicInput::IO_SEEK_SET);
+        // Find the first instruction of the block
+        const MSILInstructions& instructions = m_methodRunnable.getInstructions();
+        uint position = instructions.getInstructionIndex(nextBlock.getBlockID());
+        CHECK(position != MAX_UINT32);
         // Create new binary pass with method address.
         // This code cannot be failed, since the instruction is yet to be
         // compiled
@@ -596,11 +685,18 @@ void MethodCompiler::compileBlocks(MethodRuntimeBoundle& boundle, MethodHelper*
             // Compile current block instruction
             while (true)
             {
-                uint index = stream->getPointer() - m_methodRunnable.getMethodStreamStartAddress();
+                // Running past the end of the method
+                CHECK(position < instructions.getCount());
+                const MSILInstruction& instruction = instructions[position++];
+                uint index = instruction.m_offset;
 
                 // Handle block-split condition, before entering protected block
-                if (CompilerEngine::handleSplit(emitContext, *stream))
+                if (CompilerEngine::handleSplit(emitContext, instruction))
                 {
+                    // Falling into a loop header
+                    if (position >= 2)
+                        LoopOpcodes::enterLoop(emitContext, instructions[position - 2].m_offset, index);
+
                     emitContext.methodRuntime.m_blockStack.add(StackInterfacePtr(emitContext.currentBlock.duplicate(emitContext, index)));
 
                     // Flush the optimizer cache
@@ -613,7 +709,7 @@ void MethodCompiler::compileBlocks(MethodRuntimeBoundle& boundle, MethodHelper*
                 // Detect entering a protected block
                 ExceptionOpcodes::enterProtectedBlock(emitContext, index, m_helpers);
 
-                if (CompilerEngine::step(emitContext, *stream))
+                if (CompilerEngine::step(emitContext, instruction))
                 {
                     // Flush the optimizer cache
                     emitContext.methodRuntime.m_compiler->renderBlock();
@@ -649,6 +745,12 @@ SecondPassBinaryPtr MethodCompiler::compile(CompilerEngineThread& engineThread)
     m_interface->getFirstPassPtr()->setStdCall(CallingConvention::getDesiredCallingMethod(m_methodToken, *m_apartment, *m_interface)
         == CompilerInterface::STDCALL);
 
+    // The blocks of a previous compilation were freed with the previous
+    // compiler interface, reuse their memory. Blocks and temporaries of this
+    // method are allocated from the arena
+    m_arena.reset();
+    CompilerArena::Scope arenaScope(m_arena);
+
     // Trace the executed code
     CompilerTrace("Entering " << m_methodRunnable.getFullMethodName() << endl);
 
@@ -695,6 +797,42 @@ SecondPassBinaryPtr MethodCompiler::compile(CompilerEngineThread& engineThread)
     // Create a dependency name for the cleanup function of this method
     generateCleanupTokenIndex(locals, args, m_methodRunnable.getFullMethodName());
 
+    // Reserve the exception stack entries of the cleanup function and of the
+    // exception clauses after the locals, so registering them on the
+    // exception stack doesn't allocate memory. Processors with unwind data
+    // don't register anything
+    uint cleanupEntryPosition = MAX_UINT32;
+    uint clauseEntriesPosition = MAX_UINT32;
+    if (m_compilerParams.m_bSupportExceptionHandling &&
+        !m_interface->isUnwindDataSupported())
+    {
+        uint entrySize = FrameworkMethods::EXCEPTION_ENTRY_WORDS * m_interface->getStackSize();
+        if (m_cleanupIndex != ElementType::UnresolvedTokenIndex)
+        {
+            cleanupEntryPosition = stackSize;
+            stackSize+= entrySize;
+        }
+
+        uint clauses = m_methodRunnable.getMethodHeader().getExceptionsHandlers().length();
+        if (clauses != 0)
+        {
+            clauseEntriesPosition = stackSize;
+            stackSize+= clauses * entrySize;
+        }
+    }
+
+    // Reserve the array cursors of the loops. See MethodLoops
+    cSmartPtr<MethodLoops> loops;
+    if (m_compilerParams.m_bEnableOptimizations &&
+        m_methodRunnable.getMethodHeader().getExceptionsHandlers().isEmpty())
+    {
+        loops = cSmartPtr<MethodLoops>(new MethodLoops(m_methodRunnable.getInstructions()));
+        loops->reserveCursors(locals, args,
+                              m_apartment->getObjects().getTypedefRepository(),
+                              m_interface->getStackSize(),
+                              stackSize);
+    }
+
     // Prepare for this method
     m_interface->setLocalsSize(stackSize);
     m_interface->setArgumentsSize(args.getTotalArgumentsSize());
@@ -702,20 +840,26 @@ SecondPassBinaryPtr MethodCompiler::compile(CompilerEngineThread& engineThread)
     // Compiling method using the engine...
     MethodRuntimeBoundle boundle(m_interface, locals, args,
                                  m_methodRunnable.getMethodHeader(), m_cleanupIndex);
+    boundle.m_cleanupEntryPosition = cleanupEntryPosition;
+    boundle.m_clauseEntriesPosition = clauseEntriesPosition;
+    boundle.m_loops = loops.getPointer();
 
     {
         // Scan and locate all block-split points in the MSIL before starting to compile
-        cForkStreamPtr stream = m_methodRunnable.getStreamPointer()->fork();
-        stream->seek(m_methodRunnable.getMethodStreamStartAddress(), basicInput::IO_SEEK_SET);
-        cBuffer methodData;
-        stream->pipeRead(methodData, m_methodRunnable.getMethodHeader().getFunctionLength());
-        // Start parsing MSIL opcodes and check for dependencies inside the code
-        const uint8* msil = methodData.getBuffer();
-        const uint size = methodData.getSize();
-
-        boundle.m_blockSplit.changeSize(size);
+        const MSILInstructions& instructions = m_methodRunnable.getInstructions();
+        boundle.m_blockSplit.changeSize(instructions.getCode().getSize());
         boundle.m_blockSplit.resetArray();
-        boundle.scanMSIL(msil, size);
+        boundle.scanMSIL(instructions);
+
+        // The unwind data refers to the first block of each protected block
+        if (m_compilerParams.m_bSupportExceptionHandling &&
+            m_interface->isUnwindDataSupported())
+        {
+            const MethodHeader::ExceptionHandlingClauseList& clauses =
+                m_methodRunnable.getMethodHeader().getExceptionsHandlers();
+            for (MethodHeader::ExceptionHandlingClauseList::iterator i = clauses.begin(); i != clauses.end(); i++)
+                boundle.m_blockSplit.set((*i).tryOffset);
+        }
     }
 
     // Generate object-locals initialization block (set objects to null)
@@ -820,7 +964,12 @@ SecondPassBinaryPtr MethodCompiler::compile(CompilerEngineThread& engineThread)
         m_interface->getFirstPassPtr()->getTouchedRegisters() = oldTouched;
     }
 
-    // Generate method header and closer
+    // Generate method header and closer. Callers pass the leading arguments
+    // in registers into the method's register entry
+    m_interface->setRegisterEntry(CallingConvention::getRegisterArgumentsCount(
+                                        *m_interface,
+                                        m_apartment,
+                                        m_methodToken));
     m_interface->generateMethodEpiProLogs(boundle.m_bHasCatch);
 
     // link and finish the helpers
@@ -844,6 +993,7 @@ SecondPassBinaryPtr MethodCompiler::compile(CompilerEngineThread& engineThread)
 
         // Second pass linker for helper function
         helper.m_compiler->generateMethodEpiProLogs(helper.m_boundle->m_bHasCatch);
+        methodGenerateUnwindData(*helper.m_compiler, &helper);
 
         // Run the FP method linker, with the correct base pointer
         helper.m_boundle->m_compiler = CompilerInterfacePtr(helper.m_boundle->m_compiler, SMARTPTR_DESTRUCT_NONE);
@@ -853,6 +1003,9 @@ SecondPassBinaryPtr MethodCompiler::compile(CompilerEngineThread& engineThread)
         helper.m_compiler->getFirstPassPtr()->seal();
     }
 
+    // The unwind data of the method itself
+    methodGenerateUnwindData(*m_interface, NULL);
+
     // First pass method linker
     methodEstimateEncoding(boundle);
 
@@ -1002,6 +1155,21 @@ void MethodCompiler::methodEstimateEncoding(MethodRuntimeBoundle& boundle,
                           block.getConditionalCase() == MethodBlock::COND_ZERO);
             break;
 
+        case MethodBlock::COND_COMPARE:
+            shouldUseShortAddress = canUseShortRelativeAddress(
+                                                block.getBlockID(),
+                                                block.getConditionBlock(),
+                                                boundle.m_compiler->getShortJumpLength(),
+                                                blocks);
+
+            // Encode a single compare and jump
+            CompilerEngine::compareConditionalJump(emitContext,
+                          block.getConditionBlock(),
+                          shouldUseShortAddress,
+                          block.getCompareCondition(),
+                          block.isCompareSigned());
+            break;
+
         case MethodBlock::COND_RETURN:
 
             // Optimization, check if the next block is return block
@@ -1141,6 +1309,12 @@ uint MethodCompiler::getMaxBlockSize(const MethodBlock& block,
         // Max jmp instruction for all CPU is 8 bytes
         ret+= 8;
         break;
+
+    case MethodBlock::COND_COMPARE:
+        // The operands are already registers (See CompilerEngine::branchCompare)
+        // Max cmp instruction and jmp instruction for all CPU are 8 bytes each
+        ret+= 16;
+        break;
     default:
         if (!block.isConditionFinialized())
         {
@@ -48,6 +48,7 @@
 #include "compiler/StackEntity.h"
 #include "compiler/CompilerInterface.h"
 #include "compiler/CompilerFactory.h"
+#include "compiler/CompilerArena.h"
 #include "compiler/LocalPositions.h"
 #include "compiler/MethodRuntimeBoundle.h"
 #include "compiler/opcodes/ExceptionOpcodes.h"
@@ -156,6 +157,17 @@ private:
      */
     void methodRegisterCleanupFunction(MethodRunnable& method, MethodRuntimeBoundle& boundle);
 
+    /*
+     * Describe the protected blocks and the cleanup function of a compiled
+     * function for the exception unwinder, when the processor supports it.
+     * See CompilerInterface::generateUnwindData
+     *
+     * compiler - The compiler which holds the function's blocks
+     * pOwner   - The helper whose code is in the function, or NULL for the
+     *            method itself
+     */
+    void methodGenerateUnwindData(CompilerInterface& compiler, MethodHelper* pOwner);
+
     /*
      * Take a list of all basic blocks, and write estimates condition according
      * to estimate number of blocks.
@@ -230,6 +242,9 @@ private:
     CompilerFactory::CompilerType m_compilerType;
     // The compiler parameters
     const CompilerParameters& m_compilerParams;
+    // The short-lived objects of the compilation (blocks, temporaries).
+    // Must be destructed after all the objects which refer to the blocks
+    CompilerArena m_arena;
     // The compiler interface to be in used
     CompilerInterfacePtr m_interface;
     // Method runnable context
@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * MethodInliner.cpp
+ *
+ * Implementation file
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "compiler/stdafx.h"
+#include "xStl/types.h"
+#include "xStl/data/array.h"
+#include "xStl/os/lock.h"
+#include "format/EncodingUtils.h"
+#include "format/tables/TablesID.h"
+#include "format/tables/MethodTable.h"
+#include "runnable/GlobalContext.h"
+#include "compiler/MethodInliner.h"
+#include "compiler/CompilerEngine.h"
+#include "compiler/CompilerTrace.h"
+#include "compiler/opcodes/ObjectOpcodes.h"
+#include "compiler/opcodes/RegisterEvaluatorOpcodes.h"
+
+uint MethodInliner::getArgumentsCount(const MethodDefOrRefSignature& signature)
+{
+    return signature.getParams().getSize() + (signature.isHasThis() ? 1 : 0);
+}
+
+bool MethodInliner::isLoadArgument(const MSILInstruction& instruction, uint& index)
+{
+    if (instruction.isExtended())
+    {
+        // 0xFE 0x09 - ldarg <uint16>
+        if (instruction.getOpcodeByte() != 0x09)
+            return false;
+        index = (uint16)instruction.m_operand;
+        return true;
+    }
+
+    switch (instruction.getOpcodeByte())
+    {
+    case 2: case 3: case 4: case 5: // ldarg 0-3
+        index = instruction.getOpcodeByte() - 2;
+        return true;
+    case 0x0E:                      // ldarg.s (uint8)
+        index = (uint8)instruction.m_operand;
+        return true;
+    }
+    return false;
+}
+
+bool MethodInliner::getStackEffect(const MSILInstruction& instruction,
+                                   uint& pops,
+                                   uint& pushes,
+                                   bool& isStore)
+{
+    pops = 0;
+    pushes = 0;
+    isStore = false;
+
+    if (instruction.isExtended())
+    {
+        switch (instruction.getOpcodeByte())
+        {
+        case 0x01: // ceq
+        case 0x02: // cgt
+        case 0x03: // cgt.un
+        case 0x04: // clt
+        case 0x05: // clt.un
+            pops = 2; pushes = 1;
+            return true;
+        }
+        return false;
+    }
+
+    switch (instruction.getOpcodeByte())
+    {
+    case 0x00: // nop
+        return true;
+
+    case 0x14: // ldnull
+    case 0x15: case 0x16: case 0x17: case 0x18: case 0x19: // ldc.i4.m1 - ldc.i4.3
+    case 0x1A: case 0x1B: case 0x1C: case 0x1D: case 0x1E: // ldc.i4.4 - ldc.i4.8
+    case 0x1F: // ldc.i4.s
+    case 0x20: // ldc.i4
+    case 0x7E: // ldsfld
+    case 0x7F: // ldsflda
+        pushes = 1;
+        return true;
+
+    case 0x25: // dup
+        pops = 1; pushes = 2;
+        return true;
+
+    case 0x26: // pop
+        pops = 1;
+        return true;
+
+    case 0x46: case 0x47: case 0x48: case 0x49: // ldind.i1/u1/i2/u2
+    case 0x4A: case 0x4B: case 0x4D: case 0x50: // ldind.i4/u4/i/ref
+    case 0x65: // neg
+    case 0x66: // not
+    case 0x67: case 0x68: case 0x69: case 0x6D: // conv.i1/i2/i4/u4
+    case 0xD1: case 0xD2: case 0xD3: case 0xE0: // conv.u2/u1/i/u
+    case 0x7B: // ldfld
+    case 0x7C: // ldflda
+        pops = 1; pushes = 1;
+        return true;
+
+    case 0x58: case 0x59: case 0x5A: // add, sub, mul
+    case 0x5F: case 0x60: case 0x61: // and, or, xor
+    case 0x62: case 0x63: case 0x64: // shl, shr, shr.un
+        pops = 2; pushes = 1;
+        return true;
+
+    case 0x51: case 0x52: case 0x53: case 0x54: // stind.ref/i1/i2/i4
+    case 0xDF: // stind.i
+    case 0x7D: // stfld
+        pops = 2;
+        isStore = true;
+        return true;
+
+    case 0x80: // stsfld
+        pops = 1;
+        isStore = true;
+        return true;
+    }
+    return false;
+}
+
+bool MethodInliner::isInlineCandidate(MethodRunnable& method)
+{
+    // Only methods with simple bodies
+    if (method.isEmptyMethod())
+        return false;
+    if (method.getLocals().getSize() != 0)
+        return false;
+    if (!method.getMethodHeader().getExceptionsHandlers().isEmpty())
+        return false;
+
+    const MSILInstructions& instructions = method.getInstructions();
+    if ((instructions.getCode().getSize() > MAX_INLINE_CODE_SIZE) ||
+        (instructions.getCount() == 0))
+        return false;
+
+    // Simulate the evaluation stack of the body. The last instruction must be
+    // the only 'ret'
+    const MethodDefOrRefSignature& signature = method.getMethodSignature();
+    uint argumentsCount = getArgumentsCount(signature);
+    uint depth = 0;
+    for (uint i = 0; i < instructions.getCount(); i++)
+    {
+        const MSILInstruction& instruction = instructions[i];
+        uint index, pops, pushes;
+        bool isStore;
+
+        if ((!instruction.isExtended()) && (instruction.getOpcodeByte() == 0x2A))
+        {
+            // ret
+            return (i == instructions.getCount() - 1) &&
+                   (depth == (signature.getReturnType().isVoid() ? 0U : 1U));
+        }
+
+        if (isLoadArgument(instruction, index))
+        {
+            if (index >= argumentsCount)
+                return false;
+            depth++;
+            continue;
+        }
+
+        if (!getStackEffect(instruction, pops, pushes, isStore))
+            return false;
+        if (depth < pops)
+            return false;
+        depth = depth - pops + pushes;
+    }
+
+    // No 'ret' instruction
+    return false;
+}
+
+cBuffer MethodInliner::getInlineCode(const ApartmentPtr& apartment,
+                                     const TokenIndex& method)
+{
+    GlobalContext& globalContext = apartment->getObjects();
+    {
+        cLock lock(globalContext.getInlineCodeLock());
+        if (globalContext.getInlineCodeCache().hasKey(method))
+            return globalContext.getInlineCodeCache()[method];
+    }
+
+    // Decode the method outside the lock
+    cBuffer code;
+    MethodRunnable callee(apartment->getApt(method));
+    callee.loadMethod(getTokenID(method));
+    if (isInlineCandidate(callee))
+        code = callee.getInstructions().getCode();
+
+    cLock lock(globalContext.getInlineCodeLock());
+    if (!globalContext.getInlineCodeCache().hasKey(method))
+        globalContext.getInlineCodeCache().append(method, code);
+    return code;
+}
+
+bool MethodInliner::inlineCall(EmitContext& emitContext,
+                               const TokenIndex& methodToken,
+                               const MethodDefOrRefSignature& signature,
+                               bool isVirtual)
+{
+    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
+
+    // Inlining is an optimization. Exception handlers are compiled into
+    // helper functions with their own frame, leave them alone
+    if (!compiler.getCompilerParameters().m_bEnableOptimizations)
+        return false;
+    if (emitContext.pCurrentHelper != NULL)
+        return false;
+
+    // Only methods of the loaded assemblies
+    mdToken mdMethodToken = getTokenID(methodToken);
+    if (EncodingUtils::getTokenTableIndex(mdMethodToken) != TABLE_METHOD_TABLE)
+        return false;
+
+    ApartmentPtr apartment = emitContext.methodContext.getApartment()->getApt(methodToken);
+    if (isVirtual)
+    {
+        // A virtual method may be overridden
+        const MethodTable& methodTable = (const MethodTable&)
+                                    (*apartment->getTables().getTableByToken(mdMethodToken));
+        uint16 flags = methodTable.getHeader().m_flags;
+        if (((flags & MethodTable::mdVirtual) != 0) &&
+            ((flags & MethodTable::mdFinal) == 0))
+            return false;
+    }
+
+    if (getInlineCode(apartment, methodToken).getSize() == 0)
+        return false;
+    MethodRunnable callee(apartment);
+    callee.loadMethod(mdMethodToken);
+
+    // Only arguments and return value which fits a register
+    const ResolverInterface& resolver = apartment->getObjects().getTypedefRepository();
+    uint stackSize = (uint)compiler.getStackSize();
+    const ElementsArrayType& params = signature.getParams();
+    for (uint i = 0; i < params.getSize(); i++)
+    {
+        if (resolver.getTypeSize(params[i]) > stackSize)
+            return false;
+    }
+    if ((!signature.getReturnType().isVoid()) &&
+        (resolver.getTypeSize(signature.getReturnType()) > stackSize))
+        return false;
+
+    // Collect the arguments, 'this' is the first one
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+    uint argumentsCount = getArgumentsCount(signature);
+    if (stack.getStackCount() < argumentsCount)
+        return false;
+
+    cArray<StackEntity> arguments(argumentsCount);
+    for (uint i = 0; i < argumentsCount; i++)
+    {
+        StackEntity& argument = stack.getArg(argumentsCount - 1 - i);
+        // A constrained call pushes a type token above 'this'
+        if (argument.getType() == StackEntity::ENTITY_TOKEN_ADDRESS)
+            return false;
+        // Objects which are owned by the evaluation stack are released by the
+        // callee cleanup
+        if (argument.isReturned() && argument.getElementType().isObjectAndNotValueType())
+            return false;
+        arguments[i] = argument;
+    }
+
+    // Count the uses of each argument
+    const MSILInstructions& instructions = callee.getInstructions();
+    cArray<uint> uses(argumentsCount);
+    bool hasStores = false;
+    for (uint i = 0; i < argumentsCount; i++)
+        uses[i] = 0;
+    for (uint i = 0; i < instructions.getCount(); i++)
+    {
+        uint index, pops, pushes;
+        bool isStore;
+        if (isLoadArgument(instructions[i], index))
+            uses[index]++;
+        else if (getStackEffect(instructions[i], pops, pushes, isStore) && isStore)
+            hasStores = true;
+    }
+
+    CompilerTrace("\t\tInlining method:  " << callee.getFullMethodName() << " " << HEXTOKEN(methodToken) << endl);
+
+    stack.pop2null(argumentsCount);
+
+    // callvirt throws for a null 'this' even when the method isn't dispatched
+    // through the vtbl. Touch the object, like the real call does
+    if (isVirtual && signature.isHasThis())
+    {
+        ObjectOpcodes::duplicateStack(emitContext, arguments[0], true);
+        StackEntity object(stack.getArg(0));
+        stack.pop2null();
+        RegisterEvaluatorOpcodes::evaluateInt32(emitContext, object);
+        compiler.loadMemory(object.getStackHolderObject()->getTemporaryObject(),
+                            object.getStackHolderObject()->getTemporaryObject(),
+                            0,
+                            compiler.getStackSize());
+    }
+
+    // The arguments of a call are evaluated before the callee writes to the
+    // memory
+    if (hasStores)
+    {
+        for (uint i = 0; i < argumentsCount; i++)
+        {
+            if ((uses[i] != 0) &&
+                (arguments[i].getType() != StackEntity::ENTITY_CONST) &&
+                (arguments[i].getType() != StackEntity::ENTITY_REGISTER))
+                RegisterEvaluatorOpcodes::evaluateInt32(emitContext, arguments[i]);
+        }
+    }
+
+    // Tokens of the body are resolved in the callee context, the code is
+    // emitted into the caller block
+    EmitContext inlineContext(callee, emitContext.methodRuntime, emitContext.currentBlock);
+    for (uint i = 0; i < instructions.getCount() - 1; i++)
+    {
+        const MSILInstruction& instruction = instructions[i];
+        uint index;
+        if (isLoadArgument(instruction, index))
+        {
+            if (uses[index] == 1)
+                stack.push(arguments[index]);
+            else
+                ObjectOpcodes::duplicateStack(inlineContext, arguments[index], true);
+            continue;
+        }
+
+        // Straight-line code never terminates the block
+        CHECK(!CompilerEngine::step(inlineContext, instruction, true));
+    }
+
+    return true;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_COMPILER_METHODINLINER_H
+#define __TBA_CLR_COMPILER_METHODINLINER_H
+
+/*
+ * MethodInliner.h
+ *
+ * Splice the body of small methods (property getters and setters, tiny
+ * framework helpers) into the calling method instead of emitting a call.
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "xStl/types.h"
+#include "format/coreHeadersTypes.h"
+#include "format/MSILInstructions.h"
+#include "format/signatures/MethodDefOrRefSignature.h"
+#include "runnable/MethodRunnable.h"
+#include "compiler/EmitContext.h"
+
+/*
+ * A method can be inlined if its body is a short straight-line sequence of
+ * argument loads, constants, field and indirect memory accesses and simple
+ * arithmetic which ends with a single 'ret'. Such a method doesn't have
+ * locals, exception clauses, branches or calls, so its MSIL can be compiled
+ * directly into the current block of the caller. The callee arguments are
+ * taken from the caller evaluation stack.
+ *
+ * Since the inlined code becomes part of the caller, the caller signature
+ * includes the callee code (See MethodSignature).
+ */
+class MethodInliner {
+public:
+    // The maximum size of an inlined method body, in bytes
+    enum { MAX_INLINE_CODE_SIZE = 32 };
+
+    /*
+     * Return true if the body of 'method' can be spliced into a caller.
+     *
+     * method - The loaded callee
+     */
+    static bool isInlineCandidate(MethodRunnable& method);
+
+    /*
+     * Return the code of a method if it can be inlined, or an empty buffer.
+     * The verdict is cached per method in the GlobalContext so the callee is
+     * decoded only once, no matter how many callers sign or compile it.
+     *
+     * apartment - Any apartment of the main apartment
+     * method    - The MethodDef to test
+     */
+    static cBuffer getInlineCode(const ApartmentPtr& apartment,
+                                 const TokenIndex& method);
+
+    /*
+     * Try to compile a call instruction by splicing the callee body into the
+     * current block.
+     *
+     * emitContext - The context of the calling method. The arguments of the
+     *               method are on the evaluation stack, see CallingConvention
+     * methodToken - The resolved method to be called
+     * signature   - The signature of the called method
+     * isVirtual   - Set to true for callvirt
+     *
+     * Return true if the call was inlined. The arguments were consumed and the
+     * return value (if any) is pushed onto the evaluation stack.
+     * Return false if the method cannot be inlined and no code was generated.
+     */
+    static bool inlineCall(EmitContext& emitContext,
+                           const TokenIndex& methodToken,
+                           const MethodDefOrRefSignature& signature,
+                           bool isVirtual);
+
+private:
+    /*
+     * Return the number of stack entries which are consumed and produced by
+     * an instruction which can be inlined.
+     *
+     * instruction - The instruction to test
+     * pops        - Will be filled with the number of consumed entries
+     * pushes      - Will be filled with the number of produced entries
+     * isStore     - Will be set to true if the instruction writes to memory
+     *
+     * Return false if the instruction cannot be inlined.
+     */
+    static bool getStackEffect(const MSILInstruction& instruction,
+                               uint& pops,
+                               uint& pushes,
+                               bool& isStore);
+
+    /*
+     * Return true if 'instruction' is ldarg, and fill 'index' with the
+     * argument number.
+     */
+    static bool isLoadArgument(const MSILInstruction& instruction, uint& index);
+
+    /*
+     * Return the number of arguments of a method, including 'this'
+     */
+    static uint getArgumentsCount(const MethodDefOrRefSignature& signature);
+};
+
+#endif // __TBA_CLR_COMPILER_METHODINLINER_H
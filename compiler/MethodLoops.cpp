@@ -0,0 +1,805 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * MethodLoops.cpp
+ *
+ * Implementation file
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "compiler/stdafx.h"
+#include "xStl/types.h"
+#include "xStl/data/array.h"
+#include "xStl/data/list.h"
+#include "xStl/data/setArray.h"
+#include "compiler/MethodLoops.h"
+
+MethodLoops::Cursor::Cursor() :
+    m_header(0),
+    m_isArgument(false),
+    m_array(0),
+    m_inductionVariable(0),
+    m_elementSize(0),
+    m_position(MAX_UINT32)
+{
+}
+
+MethodLoops::MethodLoops(const MSILInstructions& instructions) :
+    m_instructions(instructions),
+    m_blocksCount(0),
+    m_reachableCount(0)
+{
+    uint count = m_instructions.getCount();
+    m_inductionStores.changeSize(count);
+    m_inductionStores.resetArray();
+    m_inductionSteps.changeSize(count);
+
+    if (!buildBlocks())
+        return;
+    buildDominators();
+    buildLoops();
+
+    CursorList candidates;
+    for (LoopList::iterator i = m_loops.begin(); i != m_loops.end(); i++)
+        buildCursors(*i, candidates);
+
+    // A cursor of an outer loop is also valid inside the inner loops. Don't
+    // calculate the same address again when an inner loop is entered
+    for (CursorList::iterator i = candidates.begin(); i != candidates.end(); i++)
+    {
+        bool isCovered = false;
+        for (CursorList::iterator j = candidates.begin(); j != candidates.end(); j++)
+        {
+            if (((*j).m_header != (*i).m_header) &&
+                ((*j).m_isArgument == (*i).m_isArgument) &&
+                ((*j).m_array == (*i).m_array) &&
+                ((*j).m_inductionVariable == (*i).m_inductionVariable) &&
+                isInLoop((*j).m_header, (*i).m_header))
+            {
+                isCovered = true;
+                break;
+            }
+        }
+        if (!isCovered)
+            m_cursors.append(*i);
+    }
+}
+
+uint MethodLoops::getLoopsCount() const
+{
+    return m_loops.length();
+}
+
+const MethodLoops::CursorList& MethodLoops::getCursors() const
+{
+    return m_cursors;
+}
+
+void MethodLoops::reserveCursors(const LocalPositions& locals,
+                                 const ArgumentsPositions& args,
+                                 ResolverInterface& resolver,
+                                 uint wordSize,
+                                 uint& stackSize)
+{
+    for (CursorList::iterator i = m_cursors.begin(); i != m_cursors.end(); i++)
+    {
+        Cursor& cursor = *i;
+
+        // The induction variable must be a 32 bit integer
+        if (cursor.m_inductionVariable >= locals.getSize())
+            continue;
+        const ElementType& indexType = locals.getLocalStackVariableType(cursor.m_inductionVariable);
+        if ((indexType.getType() != ELEMENT_TYPE_I4) &&
+            (indexType.getType() != ELEMENT_TYPE_U4))
+            continue;
+        if (indexType.isPointer() || indexType.isReference() ||
+            indexType.isSingleDimensionArray())
+            continue;
+
+        // The array must be a vector
+        if (cursor.m_array >= (cursor.m_isArgument ? args.getCount() : locals.getSize()))
+            continue;
+        ElementType arrayType(cursor.m_isArgument ?
+                              args.getArgumentStackVariableType(cursor.m_array) :
+                              locals.getLocalStackVariableType(cursor.m_array));
+        if ((!arrayType.isSingleDimensionArray()) || arrayType.isPointer() ||
+            arrayType.isReference())
+            continue;
+
+        arrayType.unconvertFromArray();
+        cursor.m_elementSize = resolver.getTypeSize(arrayType);
+        cursor.m_position = stackSize;
+        stackSize+= wordSize;
+    }
+}
+
+bool MethodLoops::isLoopEntry(uint header, uint source) const
+{
+    const Loop* loop = getLoop(getBlock(header));
+    if (loop == NULL)
+        return false;
+
+    for (cList<uint>::iterator i = loop->m_entries.begin(); i != loop->m_entries.end(); i++)
+    {
+        if (*i == source)
+            return true;
+    }
+    return false;
+}
+
+bool MethodLoops::isInLoop(uint header, uint offset) const
+{
+    const Loop* loop = getLoop(getBlock(header));
+    uint block = getBlock(offset);
+    if ((loop == NULL) || (block == MAX_UINT32))
+        return false;
+    return loop->m_blocks.isSet(block);
+}
+
+bool MethodLoops::getInductionStep(uint offset, int& step) const
+{
+    uint index = m_instructions.getInstructionIndex(offset);
+    if ((index == MAX_UINT32) || (!m_inductionStores.isSet(index)))
+        return false;
+    step = m_inductionSteps[index];
+    return true;
+}
+
+bool MethodLoops::buildBlocks()
+{
+    uint count = m_instructions.getCount();
+    if (count == 0)
+        return false;
+
+    // The leaders are the method start, the branch targets and the
+    // instructions which follow a branch or the end of the control flow
+    cSetArray leaders(count);
+    leaders.resetArray();
+    leaders.set(0);
+    m_branchTargets.changeSize(count);
+    m_branchTargets.resetArray();
+    uint i;
+    for (i = 0; i < count; i++)
+    {
+        const MSILInstruction& instruction = m_instructions[i];
+        Flow flow = getFlow(instruction);
+        if ((flow == FLOW_BRANCH) || (flow == FLOW_CONDITIONAL) || (flow == FLOW_LEAVE))
+        {
+            uint target = m_instructions.getInstructionIndex(instruction.getBranchTarget());
+            if (target == MAX_UINT32)
+                return false;
+            leaders.set(target);
+            m_branchTargets.set(target);
+        }
+        if ((flow != FLOW_NEXT) && (i + 1 < count))
+            leaders.set(i + 1);
+    }
+
+    // Number the blocks
+    m_instructionBlock.changeSize(count);
+    m_blocksCount = 0;
+    for (i = 0; i < count; i++)
+    {
+        if (leaders.isSet(i))
+            m_blocksCount++;
+        m_instructionBlock[i] = m_blocksCount - 1;
+    }
+    m_blockStart.changeSize(m_blocksCount);
+    for (i = 0; i < count; i++)
+    {
+        if (leaders.isSet(i))
+            m_blockStart[m_instructionBlock[i]] = i;
+    }
+
+    // Connect the blocks
+    m_successors.changeSize(m_blocksCount * MAX_SUCCESSORS);
+    m_simpleEdges.changeSize(m_blocksCount * MAX_SUCCESSORS);
+    m_simpleEdges.resetArray();
+    for (uint block = 0; block < m_blocksCount; block++)
+    {
+        uint last = ((block + 1 < m_blocksCount) ? m_blockStart[block + 1] : count) - 1;
+        const MSILInstruction& instruction = m_instructions[last];
+        uint edge = block * MAX_SUCCESSORS;
+        m_successors[edge] = MAX_UINT32;
+        m_successors[edge + 1] = MAX_UINT32;
+
+        switch (getFlow(instruction))
+        {
+        case FLOW_NEXT:
+            // Running past the end of the method
+            if (last + 1 >= count)
+                return false;
+            m_successors[edge] = block + 1;
+            m_simpleEdges.set(edge);
+            break;
+
+        case FLOW_BRANCH:
+            m_successors[edge] = getBlock(instruction.getBranchTarget());
+            m_simpleEdges.set(edge);
+            break;
+
+        case FLOW_CONDITIONAL:
+            if (last + 1 >= count)
+                return false;
+            m_successors[edge] = getBlock(instruction.getBranchTarget());
+            m_successors[edge + 1] = block + 1;
+            break;
+
+        case FLOW_LEAVE:
+            m_successors[edge] = getBlock(instruction.getBranchTarget());
+            break;
+
+        case FLOW_END:
+            break;
+        }
+    }
+
+    return true;
+}
+
+void MethodLoops::buildDominators()
+{
+    // Depth first search from the method start, without recursion
+    cSArray<uint> postOrder(m_blocksCount);
+    cSArray<uint> stack(m_blocksCount);
+    cSArray<uint> nextSuccessor(m_blocksCount);
+    cSetArray visited(m_blocksCount);
+    visited.resetArray();
+    visited.set(0);
+    stack[0] = 0;
+    nextSuccessor[0] = 0;
+    uint depth = 1;
+    uint block, i, j;
+    while (depth > 0)
+    {
+        block = stack[depth - 1];
+        if (nextSuccessor[depth - 1] == MAX_SUCCESSORS)
+        {
+            postOrder[m_reachableCount++] = block;
+            depth--;
+            continue;
+        }
+
+        uint successor = m_successors[block * MAX_SUCCESSORS + nextSuccessor[depth - 1]];
+        nextSuccessor[depth - 1]++;
+        if ((successor != MAX_UINT32) && (!visited.isSet(successor)))
+        {
+            visited.set(successor);
+            stack[depth] = successor;
+            nextSuccessor[depth] = 0;
+            depth++;
+        }
+    }
+
+    m_order.changeSize(m_reachableCount);
+    m_orderNumber.changeSize(m_blocksCount);
+    for (block = 0; block < m_blocksCount; block++)
+        m_orderNumber[block] = MAX_UINT32;
+    for (i = 0; i < m_reachableCount; i++)
+    {
+        m_order[i] = postOrder[m_reachableCount - 1 - i];
+        m_orderNumber[m_order[i]] = i;
+    }
+
+    // Collect the predecessors of the reachable blocks
+    m_predecessorStart.changeSize(m_blocksCount + 1);
+    for (block = 0; block <= m_blocksCount; block++)
+        m_predecessorStart[block] = 0;
+    for (i = 0; i < m_reachableCount; i++)
+    {
+        for (j = 0; j < MAX_SUCCESSORS; j++)
+        {
+            uint successor = m_successors[m_order[i] * MAX_SUCCESSORS + j];
+            if (successor != MAX_UINT32)
+                m_predecessorStart[successor + 1]++;
+        }
+    }
+    for (block = 0; block < m_blocksCount; block++)
+        m_predecessorStart[block + 1]+= m_predecessorStart[block];
+    m_predecessors.changeSize(m_predecessorStart[m_blocksCount]);
+    cSArray<uint> position(m_blocksCount);
+    for (block = 0; block < m_blocksCount; block++)
+        position[block] = m_predecessorStart[block];
+    for (i = 0; i < m_reachableCount; i++)
+    {
+        for (j = 0; j < MAX_SUCCESSORS; j++)
+        {
+            uint successor = m_successors[m_order[i] * MAX_SUCCESSORS + j];
+            if (successor != MAX_UINT32)
+                m_predecessors[position[successor]++] = m_order[i];
+        }
+    }
+
+    // The immediate dominators. See "A Simple, Fast Dominance Algorithm" by
+    // Cooper, Harvey and Kennedy
+    m_dominator.changeSize(m_blocksCount);
+    for (block = 0; block < m_blocksCount; block++)
+        m_dominator[block] = MAX_UINT32;
+    m_dominator[0] = 0;
+    bool isChanged = true;
+    while (isChanged)
+    {
+        isChanged = false;
+        for (i = 1; i < m_reachableCount; i++)
+        {
+            block = m_order[i];
+            uint dominator = MAX_UINT32;
+            for (j = m_predecessorStart[block]; j < m_predecessorStart[block + 1]; j++)
+            {
+                uint predecessor = m_predecessors[j];
+                if (m_dominator[predecessor] == MAX_UINT32)
+                    continue;
+                dominator = (dominator == MAX_UINT32) ? predecessor :
+                                                        intersect(predecessor, dominator);
+            }
+            if (dominator != m_dominator[block])
+            {
+                m_dominator[block] = dominator;
+                isChanged = true;
+            }
+        }
+    }
+}
+
+uint MethodLoops::intersect(uint a, uint b) const
+{
+    while (a != b)
+    {
+        while (m_orderNumber[a] > m_orderNumber[b])
+            a = m_dominator[a];
+        while (m_orderNumber[b] > m_orderNumber[a])
+            b = m_dominator[b];
+    }
+    return a;
+}
+
+bool MethodLoops::isDominate(uint a, uint b) const
+{
+    while (true)
+    {
+        if (b == a)
+            return true;
+        if (b == 0)
+            return false;
+        b = m_dominator[b];
+    }
+}
+
+void MethodLoops::buildLoops()
+{
+    // Every edge to a dominating block closes a loop. Collect the blocks
+    // which reach the edge without passing the header.
+    LoopList loops;
+    cSArray<uint> work(m_blocksCount);
+    uint i, j;
+    for (i = 0; i < m_reachableCount; i++)
+    {
+        uint block = m_order[i];
+        for (j = 0; j < MAX_SUCCESSORS; j++)
+        {
+            uint header = m_successors[block * MAX_SUCCESSORS + j];
+            if ((header == MAX_UINT32) || (!isDominate(header, block)))
+                continue;
+
+            LoopList::iterator loop = loops.begin();
+            while ((loop != loops.end()) && ((*loop).m_header != header))
+                loop++;
+            if (loop == loops.end())
+            {
+                Loop newLoop;
+                newLoop.m_header = header;
+                newLoop.m_blocks.changeSize(m_blocksCount);
+                newLoop.m_blocks.resetArray();
+                newLoop.m_blocks.set(header);
+                loops.append(newLoop);
+                loop = loops.end() - 1;
+            }
+
+            cSetArray& blocks = (*loop).m_blocks;
+            uint count = 0;
+            if (!blocks.isSet(block))
+            {
+                blocks.set(block);
+                work[count++] = block;
+            }
+            while (count > 0)
+            {
+                uint current = work[--count];
+                for (uint k = m_predecessorStart[current]; k < m_predecessorStart[current + 1]; k++)
+                {
+                    uint predecessor = m_predecessors[k];
+                    if (!blocks.isSet(predecessor))
+                    {
+                        blocks.set(predecessor);
+                        work[count++] = predecessor;
+                    }
+                }
+            }
+        }
+    }
+
+    // The code which enters a loop is generated at the end of the entering
+    // block, so the loop must be entered only through its header, by 'br'
+    // or by falling into it. The method start is never a header since the
+    // method prolog precedes it. The header must also be a branch target,
+    // otherwise the compiler doesn't split the block before it.
+    for (LoopList::iterator loop = loops.begin(); loop != loops.end(); loop++)
+    {
+        uint header = (*loop).m_header;
+        bool isValid = (header != 0) && m_branchTargets.isSet(m_blockStart[header]);
+        for (uint block = 0; isValid && (block < m_blocksCount); block++)
+        {
+            if ((*loop).m_blocks.isSet(block))
+                continue;
+            for (j = 0; j < MAX_SUCCESSORS; j++)
+            {
+                uint edge = block * MAX_SUCCESSORS + j;
+                uint successor = m_successors[edge];
+                if ((successor == MAX_UINT32) || (!(*loop).m_blocks.isSet(successor)))
+                    continue;
+                if ((successor != header) || (!m_simpleEdges.isSet(edge)))
+                {
+                    isValid = false;
+                    break;
+                }
+
+                uint last = ((block + 1 < m_blocksCount) ? m_blockStart[block + 1] :
+                                                           m_instructions.getCount()) - 1;
+                (*loop).m_entries.append(m_instructions[last].m_offset);
+            }
+        }
+
+        if (isValid)
+            m_loops.append(*loop);
+    }
+}
+
+void MethodLoops::buildCursors(const Loop& loop, CursorList& cursors)
+{
+    uint count = m_instructions.getCount();
+    uint header = m_instructions[m_blockStart[loop.m_header]].m_offset;
+    for (uint i = 0; i + 2 < count; i++)
+    {
+        // Look for 'ldloc/ldarg array; ldloc index' which are the operands of
+        // an element access in the same block:
+        //     ldelem/ldelema
+        //     ldloc/ldarg/ldc.i4 value; stelem
+        uint block = m_instructionBlock[i];
+        if (!loop.m_blocks.isSet(block))
+            continue;
+
+        uint array, index, variable;
+        int value;
+        bool isArgument = false;
+        if (!isLoadLocal(m_instructions[i], array))
+        {
+            if (!isLoadArgument(m_instructions[i], array))
+                continue;
+            isArgument = true;
+        }
+        if ((!isLoadLocal(m_instructions[i + 1], index)) ||
+            (m_instructionBlock[i + 2] != block))
+            continue;
+
+        bool isAccess = isLoadElement(m_instructions[i + 2]);
+        if ((!isAccess) && (i + 3 < count) && (m_instructionBlock[i + 3] == block))
+        {
+            isAccess = (isLoadLocal(m_instructions[i + 2], variable) ||
+                        isLoadArgument(m_instructions[i + 2], variable) ||
+                        isLoadConst32(m_instructions[i + 2], value)) &&
+                       isStoreElement(m_instructions[i + 3]);
+        }
+        if (!isAccess)
+            continue;
+
+        // The array is loop invariant, the index moves by constants. The
+        // header reads the array before any iteration, so calculating the
+        // slot, which throws for a null array, doesn't add an exception
+        if ((!isLengthLoaded(loop.m_header, isArgument, array)) ||
+            isStoredInLoop(loop, isArgument, array) ||
+            isAddressTaken(isArgument, array) ||
+            isAddressTaken(false, index) ||
+            (!isInductionVariable(loop, index)))
+            continue;
+
+        bool isExist = false;
+        for (CursorList::iterator j = cursors.begin(); j != cursors.end(); j++)
+        {
+            if (((*j).m_header == header) &&
+                ((*j).m_isArgument == isArgument) &&
+                ((*j).m_array == array) &&
+                ((*j).m_inductionVariable == index))
+            {
+                isExist = true;
+                break;
+            }
+        }
+        if (isExist)
+            continue;
+
+        Cursor cursor;
+        cursor.m_header = header;
+        cursor.m_isArgument = isArgument;
+        cursor.m_array = array;
+        cursor.m_inductionVariable = index;
+        cursors.append(cursor);
+    }
+}
+
+bool MethodLoops::isInductionVariable(const Loop& loop, uint local)
+{
+    // Every store must be 'ldloc local; [dup;] ldc.i4 step; add/sub; stloc local'
+    // inside a single block. A local which isn't stored at all is loop
+    // invariant, which is a step of 0.
+    for (uint i = 0; i < m_instructions.getCount(); i++)
+    {
+        uint index;
+        uint block = m_instructionBlock[i];
+        if ((!isStoreLocal(m_instructions[i], index)) || (index != local) ||
+            (!loop.m_blocks.isSet(block)))
+            continue;
+
+        int step;
+        if ((i < 3) || (!isLoadConst32(m_instructions[i - 2], step)))
+            return false;
+        switch (m_instructions[i - 1].m_opcode)
+        {
+        case 0x58: break;              // add
+        case 0x59: step = -step; break; // sub
+        default:
+            return false;
+        }
+
+        uint first = i - 3;
+        if ((m_instructions[first].m_opcode == 0x25) && (first > 0)) // dup
+            first--;
+        uint source;
+        if ((!isLoadLocal(m_instructions[first], source)) || (source != local) ||
+            (m_instructionBlock[first] != block))
+            return false;
+
+        m_inductionStores.set(i);
+        m_inductionSteps[i] = step;
+    }
+    return true;
+}
+
+bool MethodLoops::isStoredInLoop(const Loop& loop, bool isArgument, uint variable) const
+{
+    for (uint i = 0; i < m_instructions.getCount(); i++)
+    {
+        uint index;
+        bool isStore = isArgument ? isStoreArgument(m_instructions[i], index) :
+                                    isStoreLocal(m_instructions[i], index);
+        if (isStore && (index == variable) && loop.m_blocks.isSet(m_instructionBlock[i]))
+            return true;
+    }
+    return false;
+}
+
+bool MethodLoops::isAddressTaken(bool isArgument, uint variable) const
+{
+    for (uint i = 0; i < m_instructions.getCount(); i++)
+    {
+        uint index;
+        bool isAddress = isArgument ? isAddressOfArgument(m_instructions[i], index) :
+                                      isAddressOfLocal(m_instructions[i], index);
+        if (isAddress && (index == variable))
+            return true;
+    }
+    return false;
+}
+
+bool MethodLoops::isLengthLoaded(uint block, bool isArgument, uint variable) const
+{
+    for (uint i = m_blockStart[block];
+         (i + 1 < m_instructions.getCount()) && (m_instructionBlock[i + 1] == block);
+         i++)
+    {
+        uint index;
+        bool isLoad = isArgument ? isLoadArgument(m_instructions[i], index) :
+                                   isLoadLocal(m_instructions[i], index);
+        // ldlen
+        if (isLoad && (index == variable) && (m_instructions[i + 1].m_opcode == 0x8E))
+            return true;
+    }
+    return false;
+}
+
+const MethodLoops::Loop* MethodLoops::getLoop(uint header) const
+{
+    for (LoopList::iterator i = m_loops.begin(); i != m_loops.end(); i++)
+    {
+        if ((*i).m_header == header)
+            return &(*i);
+    }
+    return NULL;
+}
+
+uint MethodLoops::getBlock(uint offset) const
+{
+    uint index = m_instructions.getInstructionIndex(offset);
+    if ((index == MAX_UINT32) || (index >= m_instructionBlock.getSize()))
+        return MAX_UINT32;
+    return m_instructionBlock[index];
+}
+
+MethodLoops::Flow MethodLoops::getFlow(const MSILInstruction& instruction)
+{
+    switch (instruction.m_opcode)
+    {
+    case 0x2B: // br.s
+    case 0x38: // br
+        return FLOW_BRANCH;
+
+    case 0xDD: // leave
+    case 0xDE: // leave.s
+        return FLOW_LEAVE;
+
+    case 0x2A:   // ret
+    case 0x7A:   // throw
+    case 0xDC:   // endfinally
+    case 0x27:   // jmp
+    case 0xFE11: // endfilter
+    case 0xFE1A: // rethrow
+        return FLOW_END;
+    }
+
+    if (((instruction.m_opcode >= 0x2C) && (instruction.m_opcode <= 0x37)) ||  // b*.s
+        ((instruction.m_opcode >= 0x39) && (instruction.m_opcode <= 0x44)))    // b*
+        return FLOW_CONDITIONAL;
+
+    return FLOW_NEXT;
+}
+
+bool MethodLoops::isLoadLocal(const MSILInstruction& instruction, uint& index)
+{
+    switch (instruction.m_opcode)
+    {
+    case 0x06: case 0x07: case 0x08: case 0x09: // ldloc.0-3
+        index = instruction.m_opcode - 0x06;
+        return true;
+    case 0x11:   // ldloc.s
+        index = (uint8)instruction.m_operand;
+        return true;
+    case 0xFE0C: // ldloc
+        index = (uint16)instruction.m_operand;
+        return true;
+    }
+    return false;
+}
+
+bool MethodLoops::isLoadArgument(const MSILInstruction& instruction, uint& index)
+{
+    switch (instruction.m_opcode)
+    {
+    case 0x02: case 0x03: case 0x04: case 0x05: // ldarg.0-3
+        index = instruction.m_opcode - 0x02;
+        return true;
+    case 0x0E:   // ldarg.s
+        index = (uint8)instruction.m_operand;
+        return true;
+    case 0xFE09: // ldarg
+        index = (uint16)instruction.m_operand;
+        return true;
+    }
+    return false;
+}
+
+bool MethodLoops::isStoreLocal(const MSILInstruction& instruction, uint& index)
+{
+    switch (instruction.m_opcode)
+    {
+    case 0x0A: case 0x0B: case 0x0C: case 0x0D: // stloc.0-3
+        index = instruction.m_opcode - 0x0A;
+        return true;
+    case 0x13:   // stloc.s
+        index = (uint8)instruction.m_operand;
+        return true;
+    case 0xFE0E: // stloc
+        index = (uint16)instruction.m_operand;
+        return true;
+    }
+    return false;
+}
+
+bool MethodLoops::isStoreArgument(const MSILInstruction& instruction, uint& index)
+{
+    switch (instruction.m_opcode)
+    {
+    case 0x10:   // starg.s
+        index = (uint8)instruction.m_operand;
+        return true;
+    case 0xFE0B: // starg
+        index = (uint16)instruction.m_operand;
+        return true;
+    }
+    return false;
+}
+
+bool MethodLoops::isAddressOfLocal(const MSILInstruction& instruction, uint& index)
+{
+    switch (instruction.m_opcode)
+    {
+    case 0x12:   // ldloca.s
+        index = (uint8)instruction.m_operand;
+        return true;
+    case 0xFE0D: // ldloca
+        index = (uint16)instruction.m_operand;
+        return true;
+    }
+    return false;
+}
+
+bool MethodLoops::isAddressOfArgument(const MSILInstruction& instruction, uint& index)
+{
+    switch (instruction.m_opcode)
+    {
+    case 0x0F:   // ldarga.s
+        index = (uint8)instruction.m_operand;
+        return true;
+    case 0xFE0A: // ldarga
+        index = (uint16)instruction.m_operand;
+        return true;
+    }
+    return false;
+}
+
+bool MethodLoops::isLoadConst32(const MSILInstruction& instruction, int& value)
+{
+    switch (instruction.m_opcode)
+    {
+    case 0x15: case 0x16: case 0x17: case 0x18: case 0x19: // ldc.i4.m1 - ldc.i4.3
+    case 0x1A: case 0x1B: case 0x1C: case 0x1D: case 0x1E: // ldc.i4.4 - ldc.i4.8
+        value = (int)instruction.m_opcode - 0x16;
+        return true;
+    case 0x1F: // ldc.i4.s
+    case 0x20: // ldc.i4
+        value = (int32)instruction.m_operand;
+        return true;
+    }
+    return false;
+}
+
+bool MethodLoops::isLoadElement(const MSILInstruction& instruction)
+{
+    // ldelema, ldelem.i1 - ldelem.ref, ldelem <T>
+    return ((instruction.m_opcode >= 0x8F) && (instruction.m_opcode <= 0x9A)) ||
+           (instruction.m_opcode == 0xA3);
+}
+
+bool MethodLoops::isStoreElement(const MSILInstruction& instruction)
+{
+    // stelem.i, stelem.i1 - stelem.ref, stelem <T>
+    return ((instruction.m_opcode >= 0x9B) && (instruction.m_opcode <= 0xA2)) ||
+           (instruction.m_opcode == 0xA4);
+}
@@ -0,0 +1,323 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_COMPILER_METHODLOOPS_H
+#define __TBA_CLR_COMPILER_METHODLOOPS_H
+
+/*
+ * MethodLoops.h
+ *
+ * Find the natural loops of a method, their induction variables and the array
+ * elements which are addressed by them.
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "xStl/types.h"
+#include "xStl/data/array.h"
+#include "xStl/data/list.h"
+#include "xStl/data/setArray.h"
+#include "format/MSILInstructions.h"
+#include "runnable/ResolverInterface.h"
+#include "compiler/LocalPositions.h"
+#include "compiler/ArgumentsPositions.h"
+
+/*
+ * The compiler allocates registers per basic block, so an array access inside
+ * a loop calls compilerGetArrayOffset() and multiplies the index on every
+ * iteration. When the array variable isn't changed inside the loop and the
+ * index is an induction variable (a local which is only changed by adding a
+ * constant), the address of the element can be kept in a frame slot instead.
+ * The loop header must also load the length of the array (as in
+ * 'i < a.Length'), since the slot is calculated before the first condition
+ * and throws for a null array:
+ *   - The slot is calculated once on every edge which enters the loop. The
+ *     loop pre-header is the end of the block which jumps (or falls) into the
+ *     loop header.
+ *   - Every store to the induction variable inside the loop adds
+ *     'step * sizeof(element)' to the slot.
+ *   - The element access inside the loop loads the slot.
+ * See LoopOpcodes for the generated code.
+ *
+ * The analysis works on the MSIL control flow graph. Loops are found by back
+ * edges to a dominating block. A loop is only used when it's entered by 'br'
+ * or by falling into its header, since the code of the slot is placed at the
+ * end of the entering block.
+ *
+ * NOTE: Methods with exception clauses aren't analyzed, since their handlers
+ *       are compiled as different functions.
+ */
+class MethodLoops {
+public:
+    /*
+     * Analyze a method
+     *
+     * instructions - The decoded method. The object must stay valid for the
+     *                lifetime of this object
+     *
+     * NOTE: A method which cannot be analyzed doesn't have loops.
+     */
+    MethodLoops(const MSILInstructions& instructions);
+
+    /*
+     * An element address which moves together with an induction variable
+     */
+    struct Cursor {
+        // Default constructor, for cList
+        Cursor();
+
+        // The offset of the header of the loop
+        uint m_header;
+        // Set to true if the array is an argument, false for a local
+        bool m_isArgument;
+        // The local/argument index of the array
+        uint m_array;
+        // The local index of the induction variable
+        uint m_inductionVariable;
+        // The size of an array element. See reserveCursors()
+        uint m_elementSize;
+        // The locals-stack position of the address, or MAX_UINT32 if the
+        // cursor isn't used. See reserveCursors()
+        uint m_position;
+    };
+    typedef cList<Cursor> CursorList;
+
+    /*
+     * Return the number of loops which were found
+     */
+    uint getLoopsCount() const;
+
+    /*
+     * Return the candidate cursors of all loops
+     */
+    const CursorList& getCursors() const;
+
+    /*
+     * Allocate a locals-stack slot for each cursor whose array is a vector
+     * and whose induction variable is a 32 bit integer. Other cursors are
+     * left with m_position == MAX_UINT32.
+     *
+     * locals    - The locals of the method
+     * args      - The arguments of the method
+     * resolver  - Used to calculate the size of the array elements
+     * wordSize  - The size of a slot. See CompilerInterface::getStackSize()
+     * stackSize - The size of the locals-stack. The slots are added at the end
+     */
+    void reserveCursors(const LocalPositions& locals,
+                        const ArgumentsPositions& args,
+                        ResolverInterface& resolver,
+                        uint wordSize,
+                        uint& stackSize);
+
+    /*
+     * Return true if the instruction at offset 'source' enters the loop
+     * whose header is at offset 'header'. 'source' is either a 'br' to the
+     * header or the instruction which is followed by the header.
+     */
+    bool isLoopEntry(uint header, uint source) const;
+
+    /*
+     * Return true if the instruction at offset 'offset' is inside the loop
+     * whose header is at offset 'header'
+     */
+    bool isInLoop(uint header, uint offset) const;
+
+    /*
+     * Return true if the instruction at offset 'offset' is a 'stloc' of an
+     * induction variable, and fill 'step' with the added constant
+     */
+    bool getInductionStep(uint offset, int& step) const;
+
+private:
+    // Deny copy-constructor and operator =
+    MethodLoops(const MethodLoops& other);
+    MethodLoops& operator = (const MethodLoops& other);
+
+    // A single loop of the method
+    struct Loop {
+        // The block number of the header
+        uint m_header;
+        // The block numbers inside the loop
+        cSetArray m_blocks;
+        // The offsets of the instructions which enter the loop
+        cList<uint> m_entries;
+    };
+    typedef cList<Loop> LoopList;
+
+    // The number of successors of a block
+    enum { MAX_SUCCESSORS = 2 };
+
+    // The control flow of an instruction
+    enum Flow {
+        // Continue to the next instruction
+        FLOW_NEXT,
+        // br. Continue to the branch target
+        FLOW_BRANCH,
+        // Conditional branch. Continue to the branch target or to the next
+        // instruction
+        FLOW_CONDITIONAL,
+        // leave. Continue to the branch target after the finally handlers
+        FLOW_LEAVE,
+        // ret, throw, rethrow, endfinally, endfilter and jmp
+        FLOW_END
+    };
+
+    /*
+     * Return the control flow of an instruction
+     */
+    static Flow getFlow(const MSILInstruction& instruction);
+
+    /*
+     * Build the basic blocks and their successors.
+     * Return false if the control flow cannot be analyzed.
+     */
+    bool buildBlocks();
+
+    /*
+     * Calculate the reverse post order and the immediate dominators of the
+     * blocks which are reachable from the method start
+     */
+    void buildDominators();
+
+    /*
+     * Return the nearest common dominator of two reachable blocks
+     */
+    uint intersect(uint a, uint b) const;
+
+    /*
+     * Return true if block 'a' dominates the reachable block 'b'
+     */
+    bool isDominate(uint a, uint b) const;
+
+    /*
+     * Find the natural loops. Loops with the same header are merged, loops
+     * which cannot have a pre-header are dropped.
+     */
+    void buildLoops();
+
+    /*
+     * Find the induction variables and the cursors of a loop
+     *
+     * loop    - The loop to scan
+     * cursors - The cursors of the loop are appended to this list
+     */
+    void buildCursors(const Loop& loop, CursorList& cursors);
+
+    /*
+     * Return true if every store to 'local' inside 'loop' adds a constant to
+     * it. The steps of the stores are recorded.
+     */
+    bool isInductionVariable(const Loop& loop, uint local);
+
+    /*
+     * Return true if the local or argument 'variable' is stored inside 'loop'
+     */
+    bool isStoredInLoop(const Loop& loop, bool isArgument, uint variable) const;
+
+    /*
+     * Return true if the address of a local or an argument is taken anywhere
+     * in the method
+     */
+    bool isAddressTaken(bool isArgument, uint variable) const;
+
+    /*
+     * Return true if block 'block' loads the length of the local or argument
+     * 'variable' ('ldloc/ldarg variable; ldlen')
+     */
+    bool isLengthLoaded(uint block, bool isArgument, uint variable) const;
+
+    /*
+     * Return the loop with a header at block 'header', or NULL
+     */
+    const Loop* getLoop(uint header) const;
+
+    /*
+     * Return the block number of the instruction at offset 'offset', or
+     * MAX_UINT32
+     */
+    uint getBlock(uint offset) const;
+
+    /*
+     * Decode the variable accessing instructions. Return false if the
+     * instruction doesn't match, otherwise fill 'index'.
+     */
+    static bool isLoadLocal(const MSILInstruction& instruction, uint& index);
+    static bool isLoadArgument(const MSILInstruction& instruction, uint& index);
+    static bool isStoreLocal(const MSILInstruction& instruction, uint& index);
+    static bool isStoreArgument(const MSILInstruction& instruction, uint& index);
+    static bool isAddressOfLocal(const MSILInstruction& instruction, uint& index);
+    static bool isAddressOfArgument(const MSILInstruction& instruction, uint& index);
+
+    /*
+     * Return true if the instruction is ldc.i4 and fill 'value'
+     */
+    static bool isLoadConst32(const MSILInstruction& instruction, int& value);
+
+    /*
+     * Return true for ldelem/ldelema and stelem instructions
+     */
+    static bool isLoadElement(const MSILInstruction& instruction);
+    static bool isStoreElement(const MSILInstruction& instruction);
+
+    // The decoded method
+    const MSILInstructions& m_instructions;
+    // The number of basic blocks
+    uint m_blocksCount;
+    // For each instruction, the number of its block
+    cSArray<uint> m_instructionBlock;
+    // For each block, the index of its first instruction
+    cSArray<uint> m_blockStart;
+    // The instructions which are targets of a branch
+    cSetArray m_branchTargets;
+    // For each block, MAX_SUCCESSORS successors, or MAX_UINT32
+    cSArray<uint> m_successors;
+    // For each successor, set if the edge is a 'br' or a fall through
+    cSetArray m_simpleEdges;
+    // The reachable predecessors of block b are
+    // m_predecessors[m_predecessorStart[b]..m_predecessorStart[b+1]-1]
+    cSArray<uint> m_predecessorStart;
+    cSArray<uint> m_predecessors;
+    // The blocks in reverse post order, and the order of each block
+    // (MAX_UINT32 for unreachable blocks)
+    cSArray<uint> m_order;
+    cSArray<uint> m_orderNumber;
+    uint m_reachableCount;
+    // The immediate dominator of each reachable block
+    cSArray<uint> m_dominator;
+    // The loops of the method
+    LoopList m_loops;
+    // The cursors of all loops
+    CursorList m_cursors;
+    // The 'stloc' instructions of induction variables and their steps
+    cSetArray m_inductionStores;
+    cSArray<int> m_inductionSteps;
+};
+
+#endif // __TBA_CLR_COMPILER_METHODLOOPS_H
@@ -50,7 +50,10 @@ MethodRuntimeBoundle::MethodRuntimeBoundle(CompilerInterfacePtr compiler,
     m_args(args),
     m_methodSet(methodHeader.getFunctionLength()),
     m_bHasCatch(false),
-    m_cleanupIndex(cleanupIndex)
+    m_cleanupIndex(cleanupIndex),
+    m_cleanupEntryPosition(MAX_UINT32),
+    m_clauseEntriesPosition(MAX_UINT32),
+    m_loops(NULL)
 {
     // Initialize first block
     m_blockStack.add(StackInterfacePtr(new MethodBlock(DEFAULT_BASIC_BLOCK_START, *m_compiler)));
@@ -63,7 +66,12 @@ MethodRuntimeBoundle::MethodRuntimeBoundle(const MethodRuntimeBoundle& other, ui
     m_methodSet(other.m_methodSet.getLength()),
     m_bHasCatch(false),
     m_blockSplit(other.m_blockSplit),
-    m_cleanupIndex(other.m_cleanupIndex)
+    m_cleanupIndex(other.m_cleanupIndex),
+    // Helpers have their own frame. Their entries are allocated by the runtime
+    m_cleanupEntryPosition(MAX_UINT32),
+    m_clauseEntriesPosition(MAX_UINT32),
+    // Helpers don't have the loop slots in their frame
+    m_loops(NULL)
 {
     // Initialize first block - at handler's initial index
     m_blockStack.add(StackInterfacePtr(new MethodBlock(handlerIndex, *m_compiler)));
@@ -83,7 +91,7 @@ void MethodRuntimeBoundle::OnOffset(uint instructionIndex)
     m_blockSplit.set(instructionIndex);
 }
 
-void MethodRuntimeBoundle::AddMethodBlock(MethodBlock& block, EmitContext& emitContext, int newBlockID, bool bRemoveTOS /* = false */)
+void MethodRuntimeBoundle::AddMethodBlock(MethodBlock& block, EmitContext& emitContext, int newBlockID, uint removeCount /* = 0 */)
 {
     // Look for an existing block
     for (MethodBlockOrderedList::iterator i = m_blockStack.begin(); i != m_blockStack.end(); i++)
@@ -99,5 +107,5 @@ void MethodRuntimeBoundle::AddMethodBlock(MethodBlock& block, EmitContext& emitC
     }
 
     // Block does not exist. Add it
-    m_blockStack.add(StackInterfacePtr(block.duplicate(emitContext, newBlockID, bRemoveTOS)));
+    m_blockStack.add(StackInterfacePtr(block.duplicate(emitContext, newBlockID, removeCount)));
 }
@@ -48,6 +48,7 @@
 #include "compiler/LocalPositions.h"
 #include "compiler/ArgumentsPositions.h"
 #include "compiler/MethodBlock.h"
+#include "compiler/MethodLoops.h"
 
 /*
  * A collection of data-structs need for a method.
@@ -83,8 +84,10 @@ public:
 
     /*
      * Add a method block to the block-stack by duplicating an existing one, or use its parameters to update an existing block
+     *
+     * removeCount - The number of top-of-stack entries which aren't passed to the new block
      */
-    void AddMethodBlock(MethodBlock& block, struct EmitContext& emitContext, int newBlockID, bool bRemoveTOS = false);
+    void AddMethodBlock(MethodBlock& block, struct EmitContext& emitContext, int newBlockID, uint removeCount = 0);
 
     /*
      * Overrides MSILScanInterface::OnOffset()
@@ -129,6 +132,19 @@ public:
     // To access the cleanupIndex from CompilerOpcodes::compilerReturn. Updated in methodEstimateEncoding.
     TokenIndex m_cleanupIndex;
 
+    // The locals-stack position of the exception stack entries which are
+    // reserved inside the method frame (See FrameworkMethods::EXCEPTION_ENTRY_WORDS).
+    // MAX_UINT32 if there is no such entry, and the runtime should allocate it.
+    // The entry of the cleanup function
+    uint m_cleanupEntryPosition;
+    // The entry of the first exception clause. The rest of the clauses follow
+    // in the order of the method header.
+    uint m_clauseEntriesPosition;
+
+    // The loops of the method and their array cursors, or NULL if the loops
+    // aren't optimized. See MethodLoops
+    const MethodLoops* m_loops;
+
 private:
     // Disable copy-constructor and operator =
     MethodRuntimeBoundle(const MethodRuntimeBoundle& other);
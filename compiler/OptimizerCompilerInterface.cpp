@@ -202,14 +202,14 @@ void OptimizerCompilerInterface::udpateRegisterStartEndIndexes()
         // If is not alive yet but in alive list, update start time
         if (allocatedRegisters.isIn(dummyRegister))
         {
-            if (!m_dummyRegistersMapping.m_entries.hasKey(dummyRegister))
+            if (!m_dummyRegistersMapping.hasRegister(dummyRegister))
             {
-                m_dummyRegistersMapping.m_entries.append(dummyRegister, DummyRegistersMapping::DummyRegisterEntry());
+                m_dummyRegistersMapping.addRegister(dummyRegister);
                 // Make room for one more entry in the timeline
                 m_dummyRegistersMapping.resize(m_blockOperations.length());
             }
             // Set this register to active in this entry
-            m_dummyRegistersMapping.getAtRegister(dummyRegister).setActive(operationIndex, true);
+            m_dummyRegistersMapping.getAtRegister(dummyRegister).setActive(operationIndex);
             // Update the possible registers according to if it is volatile or non-volatile
             for (int i = 0; i < m_dummyRegistersMapping.m_numberOfRealRegisters; ++i)
             {
@@ -350,6 +350,44 @@ void OptimizerCompilerInterface::move32(StackLocation destination,
     udpateRegisterStartEndIndexes();
 }
 
+uint OptimizerCompilerInterface::getInlineCopySize() const
+{
+    return m_interface->getInlineCopySize();
+}
+
+bool OptimizerCompilerInterface::isCopyMemorySupported() const
+{
+    return m_interface->isCopyMemorySupported();
+}
+
+void OptimizerCompilerInterface::copyMemory(StackLocation destination,
+                                            StackLocation source,
+                                            uint size)
+{
+    if (!isOptimizerOn()) {
+        m_interface->copyMemory(destination, source, size);
+        return;
+    }
+
+    CompilerInterface::CompilerOperation opcode(
+        OPCODE_COPY_MEMORY,
+        0,
+        0,
+        0,
+        size,
+        source,
+        destination,
+        0,
+        0,
+        0,
+        cString(0),
+        0);
+
+    m_blockOperations.append(opcode);
+
+    udpateRegisterStartEndIndexes();
+}
+
 void OptimizerCompilerInterface::load32(uint stackPosition,
                                         uint size,
                                         StackLocation destination,
@@ -574,6 +612,59 @@ void OptimizerCompilerInterface::pushArg32(StackLocation source)
     udpateRegisterStartEndIndexes();
 }
 
+void OptimizerCompilerInterface::pushArgConst32(int32 value)
+{
+    if (!isOptimizerOn()) {
+        m_interface->pushArgConst32(value);
+        return;
+    }
+
+    CompilerInterface::CompilerOperation opcode(
+        OPCODE_PUSH_ARG_CONST_32,
+        0,
+        0,
+        value,
+        0,
+        StackInterface::EMPTY,
+        StackInterface::EMPTY,
+        0,
+        0,
+        0,
+        cString(0),
+        0);
+
+    m_blockOperations.append(opcode);
+
+    udpateRegisterStartEndIndexes();
+}
+
+void OptimizerCompilerInterface::pushArgStack32(uint stackPosition,
+                                                bool argumentStackLocation)
+{
+    if (!isOptimizerOn()) {
+        m_interface->pushArgStack32(stackPosition, argumentStackLocation);
+        return;
+    }
+
+    CompilerInterface::CompilerOperation opcode(
+        OPCODE_PUSH_ARG_STACK_32,
+        stackPosition,
+        0,
+        0,
+        0,
+        StackInterface::EMPTY,
+        StackInterface::EMPTY,
+        argumentStackLocation,
+        0,
+        0,
+        cString(0),
+        0);
+
+    m_blockOperations.append(opcode);
+
+    udpateRegisterStartEndIndexes();
+}
+
 void OptimizerCompilerInterface::popArg32(StackLocation source)
 {
     if (!isOptimizerOn()) {
@@ -1046,6 +1137,32 @@ void OptimizerCompilerInterface::shr32(StackLocation destination, StackLocation
     udpateRegisterStartEndIndexes();
 }
 
+void OptimizerCompilerInterface::sar32(StackLocation destination, StackLocation source)
+{
+    if (!isOptimizerOn()) {
+        m_interface->sar32(destination, source);
+        return;
+    }
+
+    CompilerInterface::CompilerOperation opcode(
+        OPCODE_SAR_32,
+        0,
+        0,
+        0,
+        0,
+        source,
+        destination,
+        0,
+        0,
+        0,
+        cString(0),
+        0);
+
+    m_blockOperations.append(opcode);
+
+    udpateRegisterStartEndIndexes();
+}
+
 void OptimizerCompilerInterface::shl32(StackLocation destination, StackLocation source)
 {
     if (!isOptimizerOn()) {
@@ -1152,22 +1269,22 @@ void OptimizerCompilerInterface::sbb32 (StackLocation destination, StackLocation
 
 void OptimizerCompilerInterface::mul32h(StackLocation destlow, StackLocation desthigh, StackLocation source, bool sign)
 {
-    /* NOT IMPLEMENTED YET!!! */
-
     if (!isOptimizerOn()) {
         m_interface->mul32h(destlow, desthigh, source, sign);
         return;
     }
 
-    /*
-    udpateRegisterStartEndIndexes();
+    // An operation has only two registers.
+    //     desthigh = destlow; desthigh = mulhi(desthigh, source); destlow *= source
+    move32(desthigh, destlow, getStackSize(), false);
+
     CompilerInterface::CompilerOperation opcode(
         OPCODE_MUL_32H,
         0,
         0,
         0,
+        0,
         source,
-        destlow,
         desthigh,
         sign,
         0,
@@ -1175,7 +1292,103 @@ void OptimizerCompilerInterface::mul32h(StackLocation destlow, StackLocation des
         cString(0),
         0);
 
-    m_blockOperations.append(opcode);*/
+    m_blockOperations.append(opcode);
+
+    udpateRegisterStartEndIndexes();
+
+    mul32(destlow, source);
+}
+
+bool OptimizerCompilerInterface::isTailCallSupported() const
+{
+    return m_interface->isTailCallSupported();
+}
+
+void OptimizerCompilerInterface::tailCall(const cString& dependencyName,
+                                          uint argumentsSize)
+{
+    if (!isOptimizerOn()) {
+        m_interface->tailCall(dependencyName, argumentsSize);
+        return;
+    }
+
+    CompilerInterface::CompilerOperation opcode(
+        OPCODE_TAIL_CALL,
+        argumentsSize,
+        0,
+        0,
+        0,
+        StackInterface::EMPTY,
+        StackInterface::EMPTY,
+        0,
+        0,
+        0,
+        dependencyName,
+        0);
+
+    m_blockOperations.append(opcode);
+
+    udpateRegisterStartEndIndexes();
+}
+
+bool OptimizerCompilerInterface::isGuardedCallSupported() const
+{
+    return m_interface->isGuardedCallSupported();
+}
+
+void OptimizerCompilerInterface::guardedCall(const cString& guardName,
+                                             const cString& dependencyName)
+{
+    if (!isOptimizerOn()) {
+        m_interface->guardedCall(guardName, dependencyName);
+        return;
+    }
+
+    CompilerInterface::CompilerOperation opcode(
+        OPCODE_GUARDED_CALL,
+        0,
+        0,
+        0,
+        0,
+        StackInterface::EMPTY,
+        StackInterface::EMPTY,
+        0,
+        0,
+        0,
+        dependencyName,
+        0,
+        guardName);
+
+    m_blockOperations.append(opcode);
+
+    udpateRegisterStartEndIndexes();
+}
+
+uint OptimizerCompilerInterface::getArgumentRegistersCount() const
+{
+    return m_interface->getArgumentRegistersCount();
+}
+
+void OptimizerCompilerInterface::setRegisterEntry(uint count)
+{
+    m_interface->setRegisterEntry(count);
+}
+
+bool OptimizerCompilerInterface::isUnwindDataSupported() const
+{
+    return m_interface->isUnwindDataSupported();
+}
+
+void OptimizerCompilerInterface::generateUnwindData(bool isHelper,
+                                                    const cString& cleanupName,
+                                                    const UnwindClauseList& clauses)
+{
+    m_interface->generateUnwindData(isHelper, cleanupName, clauses);
+}
+
+bool OptimizerCompilerInterface::isMultiplyHighSupported() const
+{
+    return m_interface->isMultiplyHighSupported();
 }
 
 void OptimizerCompilerInterface::addConst32(const StackLocation destination,
@@ -1310,6 +1523,62 @@ void OptimizerCompilerInterface::jumpCondShort(StackLocation compare, int blockI
 }
 
 
+void OptimizerCompilerInterface::jumpCompare(StackLocation first, StackLocation second,
+                                             CompareCondition condition, bool isSigned,
+                                             int blockID)
+{
+    if (!isOptimizerOn()) {
+        m_interface->jumpCompare(first, second, condition, isSigned, blockID);
+        return;
+    }
+
+    CompilerInterface::CompilerOperation opcode(
+        OPCODE_JUMP_COMPARE,
+        condition,
+        0,
+        blockID,
+        0,
+        second,
+        first,
+        isSigned,
+        0,
+        0,
+        cString(0),
+        0);
+
+    m_blockOperations.append(opcode);
+
+    udpateRegisterStartEndIndexes();
+}
+
+void OptimizerCompilerInterface::jumpCompareShort(StackLocation first, StackLocation second,
+                                                  CompareCondition condition, bool isSigned,
+                                                  int blockID)
+{
+    if (!isOptimizerOn()) {
+        m_interface->jumpCompareShort(first, second, condition, isSigned, blockID);
+        return;
+    }
+
+    CompilerInterface::CompilerOperation opcode(
+        OPCODE_JUMP_COMPARE_SHORT,
+        condition,
+        0,
+        blockID,
+        0,
+        second,
+        first,
+        isSigned,
+        0,
+        0,
+        cString(0),
+        0);
+
+    m_blockOperations.append(opcode);
+
+    udpateRegisterStartEndIndexes();
+}
+
 void OptimizerCompilerInterface::ceq32(StackLocation destination, StackLocation source)
 {
     if (!isOptimizerOn()) {
@@ -1564,22 +1833,18 @@ void OptimizerCompilerInterface::updateDummyRegistersMapping(CompilerInterface::
 
 void OptimizerCompilerInterface::backupRegisters(BlockOperationList::iterator operationsPosition, int operationIndex)
 {
-    cList<int> dummyRegisters(m_dummyRegistersMapping.m_entries.keys());
-    cList<int>::iterator dummyRegistersIterator(dummyRegisters.begin());
     StackLocation stackLocation;
 
-    cList<int> dummyRegistersInner(m_dummyRegistersMapping.m_entries.keys());
-    cList<int>::iterator dummyRegistersInnerIterator(dummyRegistersInner.begin());
-
-    for (; dummyRegistersIterator != dummyRegisters.end() ; ++dummyRegistersIterator)
+    for (uint r = 0; r < m_dummyRegistersMapping.getRegistersCount(); ++r)
     {
-        int dummyRegister = *dummyRegistersIterator;
+        int dummyRegister = m_dummyRegistersMapping.getRegister(r);
+        DummyRegistersMapping::DummyRegisterEntry& dummyRegisterEntry = m_dummyRegistersMapping.getEntry(r);
         int currentMappingOfDummyRegister = -1;
         int previousMappingOfDummyRegister = -1;
 
         // If register is not alive in current operation or already on stack from previous operation, ignore it.
-        if ((!(m_dummyRegistersMapping.getAtRegister(dummyRegister).isActive(operationIndex))) ||
-            (m_dummyRegistersMapping.getAtRegister(dummyRegister).m_stackLocation != StackInterface::EMPTY))
+        if ((!(dummyRegisterEntry.isActive(operationIndex))) ||
+            (dummyRegisterEntry.m_stackLocation != StackInterface::EMPTY))
             continue;
 
         // Optimization: Dont touch the destination of the operation (it is going to be overwritten anyway)
@@ -1588,41 +1853,38 @@ void OptimizerCompilerInterface::backupRegisters(BlockOperationList::iterator op
             continue;
 
         // Get current mapping
-        currentMappingOfDummyRegister = m_interface->m_indexToRegister[m_dummyRegistersMapping.getAtRegister(dummyRegister, operationIndex).m_chosenRegister];
+        currentMappingOfDummyRegister = m_interface->m_indexToRegister[dummyRegisterEntry[operationIndex].m_chosenRegister];
 
         // Check if there is history
-        if (m_dummyRegistersMapping.getAtRegister(dummyRegister).m_historyChosenRegister != -1)
+        if (dummyRegisterEntry.m_historyChosenRegister != -1)
         {
             // The previous mapping is from the history
-            previousMappingOfDummyRegister = m_interface->m_indexToRegister[m_dummyRegistersMapping.getAtRegister(dummyRegister).m_historyChosenRegister];
+            previousMappingOfDummyRegister = m_interface->m_indexToRegister[dummyRegisterEntry.m_historyChosenRegister];
             // Mark that there is no more history
-            m_dummyRegistersMapping.getAtRegister(dummyRegister).m_historyChosenRegister = -1;
+            dummyRegisterEntry.m_historyChosenRegister = -1;
         }
         else // No history
         {
             // If this is the first operation or register was not alive in previous operation, there is nothing to do
             if ((operationIndex == 0) ||
-                (!(m_dummyRegistersMapping.getAtRegister(dummyRegister).isActive(operationIndex-1))))
+                (!(dummyRegisterEntry.isActive(operationIndex-1))))
                 continue;
 
             // take previous mapping from previous operation.
-            previousMappingOfDummyRegister = m_interface->m_indexToRegister[m_dummyRegistersMapping.getAtRegister(dummyRegister, operationIndex-1).m_chosenRegister];
+            previousMappingOfDummyRegister = m_interface->m_indexToRegister[dummyRegisterEntry[operationIndex-1].m_chosenRegister];
         }
         // If mapping changed from previous operation, save the previous mapping on the temp-stack.
         if (currentMappingOfDummyRegister != previousMappingOfDummyRegister)
         {
             /*// Check if the destination is used by another register in the previous operation. If not we can optimize by doing a move.
             bool isUsed = false;
-            for (dummyRegistersInnerIterator = dummyRegistersInner.begin();
-                 dummyRegistersInnerIterator != dummyRegistersInner.end() ;
-                 ++dummyRegistersInnerIterator)
+            for (uint inner = 0; inner < m_dummyRegistersMapping.getRegistersCount(); ++inner)
             {
-                int dummyRegisterInner = *dummyRegistersInnerIterator;
                 // If other register is alive at previous time
-                if (m_dummyRegistersMapping.getAtRegister(dummyRegisterInner, operationIndex-1).m_isAlive)
+                if (m_dummyRegistersMapping.getEntry(inner).isActive(operationIndex-1))
                     // If alive,
                     if (currentMappingOfDummyRegister ==
-                        m_interface->m_indexToRegister[m_dummyRegistersMapping.getAtRegister(dummyRegisterInner, operationIndex-1).m_chosenRegister])
+                        m_interface->m_indexToRegister[m_dummyRegistersMapping.getEntry(inner)[operationIndex-1].m_chosenRegister])
                     {
                         isUsed = true;
                         break;
@@ -1632,13 +1894,13 @@ void OptimizerCompilerInterface::backupRegisters(BlockOperationList::iterator op
             if (isUsed)
             {*/
             stackLocation = storeRegisterToStackLocation(operationsPosition, previousMappingOfDummyRegister);
-            m_dummyRegistersMapping.getAtRegister(dummyRegister).m_stackLocation = stackLocation;
+            dummyRegisterEntry.m_stackLocation = stackLocation;
             /*}
             // If the destination is not used, just do a mov. Notice this is not the first operation
             else
             {
                 switchRegisters(operationsPosition, previousMappingOfDummyRegister, currentMappingOfDummyRegister);
-                m_dummyRegistersMapping.getAtRegister(dummyRegister).m_stackLocation = StackInterface::EMPTY;
+                dummyRegisterEntry.m_stackLocation = StackInterface::EMPTY;
             }*/
         }
     }
@@ -1679,27 +1941,22 @@ void OptimizerCompilerInterface::handleModifications(BlockOperationList::iterato
     const cSetArray& modifiableRegisters = m_interface->getOperationRegisterAllocationInfo(*operationsPosition).m_modifiable;
     StackLocation stackLocation;
 
-    cList<int> dummyRegisters(m_dummyRegistersMapping.m_entries.keys());
-    cList<int>::iterator dummyRegistersIterator(dummyRegisters.begin());
-
     for (uint i = 0 ; i < modifiableRegisters.getLength() ; ++i)
     {
         // If the register is not modifiable by the operation, ignore it
         if (!modifiableRegisters.isSet(i))
             continue;
 
-        for (dummyRegistersIterator = dummyRegisters.begin();
-             dummyRegistersIterator != dummyRegisters.end() ;
-             ++dummyRegistersIterator)
+        for (uint r = 0; r < m_dummyRegistersMapping.getRegistersCount(); ++r)
         {
-            int dummyRegister = *dummyRegistersIterator;
+            DummyRegistersMapping::DummyRegisterEntry& dummyRegisterEntry = m_dummyRegistersMapping.getEntry(r);
             // If active and mathes the modifiable and NOT already on stack, save it.
-            if (m_dummyRegistersMapping.getAtRegister(dummyRegister).isActive(operationIndex) &&
-                m_dummyRegistersMapping.getAtRegister(dummyRegister, operationIndex).m_chosenRegister == i &&
-                m_dummyRegistersMapping.getAtRegister(dummyRegister).m_stackLocation == StackInterface::EMPTY)
+            if (dummyRegisterEntry.isActive(operationIndex) &&
+                dummyRegisterEntry[operationIndex].m_chosenRegister == i &&
+                dummyRegisterEntry.m_stackLocation == StackInterface::EMPTY)
             {
                 stackLocation = storeRegisterToStackLocation(operationsPosition, m_interface->m_indexToRegister[i]);
-                m_dummyRegistersMapping.getAtRegister(dummyRegister).m_stackLocation = stackLocation;
+                dummyRegisterEntry.m_stackLocation = stackLocation;
             }
         }
     }
@@ -1745,6 +2002,18 @@ void OptimizerCompilerInterface::doOperation(CompilerInterface::CompilerOperatio
     case OPCODE_PUSH_ARG_32:
         m_interface->pushArg32(operation.sloc1);
         break;
+    case OPCODE_PUSH_ARG_CONST_32:
+        m_interface->pushArgConst32(operation.val);
+        break;
+    case OPCODE_PUSH_ARG_STACK_32:
+        m_interface->pushArgStack32(operation.uval1, operation.cond1);
+        break;
+    case OPCODE_TAIL_CALL:
+        m_interface->tailCall(operation.dependencyName, operation.uval1);
+        break;
+    case OPCODE_GUARDED_CALL:
+        m_interface->guardedCall(operation.secondDependencyName, operation.dependencyName);
+        break;
     case OPCODE_POP_ARG_32:
         m_interface->popArg32(operation.sloc1);
         break;
@@ -1766,6 +2035,9 @@ void OptimizerCompilerInterface::doOperation(CompilerInterface::CompilerOperatio
     case OPCODE_LOAD_MEMORY:
         m_interface->loadMemory(operation.sloc2, operation.sloc1, operation.uval1, operation.size, operation.cond1);
         break;
+    case OPCODE_COPY_MEMORY:
+        m_interface->copyMemory(operation.sloc2, operation.sloc1, operation.size);
+        break;
     case OPCODE_CONV_32:
         m_interface->conv32(operation.sloc2, operation.size, operation.cond1);
         break;
@@ -1799,6 +2071,9 @@ void OptimizerCompilerInterface::doOperation(CompilerInterface::CompilerOperatio
     case OPCODE_SHR_32:
         m_interface->shr32(operation.sloc2, operation.sloc1);
         break;
+    case OPCODE_SAR_32:
+        m_interface->sar32(operation.sloc2, operation.sloc1);
+        break;
     case OPCODE_SHL_32:
         m_interface->shl32(operation.sloc2, operation.sloc1);
         break;
@@ -1812,7 +2087,7 @@ void OptimizerCompilerInterface::doOperation(CompilerInterface::CompilerOperatio
         m_interface->sbb32(operation.sloc2, operation.sloc1);
         break;
     case OPCODE_MUL_32H:
-        ASSERT(0); //Not implemented
+        m_interface->mulHigh32(operation.sloc2, operation.sloc1, operation.cond1);
         break;
     case OPCODE_ADD_CONST_32:
         m_interface->addConst32(operation.sloc2, operation.val);
@@ -1829,6 +2104,16 @@ void OptimizerCompilerInterface::doOperation(CompilerInterface::CompilerOperatio
     case OPCODE_JUMP_COND_SHORT:
         m_interface->jumpCondShort(operation.sloc1, operation.val, operation.cond1);
         break;
+    case OPCODE_JUMP_COMPARE:
+        m_interface->jumpCompare(operation.sloc2, operation.sloc1,
+                                 (CompareCondition)operation.uval1,
+                                 operation.cond1, operation.val);
+        break;
+    case OPCODE_JUMP_COMPARE_SHORT:
+        m_interface->jumpCompareShort(operation.sloc2, operation.sloc1,
+                                      (CompareCondition)operation.uval1,
+                                      operation.cond1, operation.val);
+        break;
     case OPCODE_CEQ_32:
         m_interface->ceq32(operation.sloc2, operation.sloc1);
         break;
@@ -2002,7 +2287,7 @@ void OptimizerCompilerInterface::updateTouchedRegisters()
          ++touchedRegistersIterator)
     {
         int touchedRegister = *touchedRegistersIterator;
-        if (m_dummyRegistersMapping.m_entries.hasKey(touchedRegister))
+        if (m_dummyRegistersMapping.hasRegister(touchedRegister))
         {
             for (int i = 0 ; i < m_dummyRegistersMapping.m_numberOfOperations ; ++i)
             {
@@ -2018,9 +2303,6 @@ void OptimizerCompilerInterface::updateTouchedRegisters()
 
 void OptimizerCompilerInterface::saveHistoryForNextBlock()
 {
-    cList<int> dummyRegisters(m_dummyRegistersMapping.m_entries.keys());
-    cList<int>::iterator dummyRegistersIterator(dummyRegisters.begin());
-
     cList<int> registers(m_interface->m_binary->getCurrentStack()->getRegistersTable().keys());
     cList<int>::iterator registersIterator(registers.begin());
     cList<int> allocatedRegisters;
@@ -2034,17 +2316,16 @@ void OptimizerCompilerInterface::saveHistoryForNextBlock()
             allocatedRegisters.append(*registersIterator);
     }
 
-    for (dummyRegistersIterator = dummyRegisters.begin();
-         dummyRegistersIterator != dummyRegisters.end();
-         ++dummyRegistersIterator)
+    for (uint r = 0; r < m_dummyRegistersMapping.getRegistersCount(); ++r)
     {
-        int dummyRegister = *dummyRegistersIterator;
+        int dummyRegister = m_dummyRegistersMapping.getRegister(r);
         // If the dummy register is in the alive list, it should be saved for the next run.
         if (allocatedRegisters.isIn(dummyRegister))
         {
-            int lastChosenRegister = m_dummyRegistersMapping.getAtRegister(dummyRegister).getLastEntry().m_chosenRegister;
+            DummyRegistersMapping::DummyRegisterEntry& dummyRegisterEntry = m_dummyRegistersMapping.getEntry(r);
+            int lastChosenRegister = dummyRegisterEntry.getLastEntry().m_chosenRegister;
             // Save the last mapping of the dummy register for the next block.
-            m_dummyRegistersMapping.getAtRegister(dummyRegister).m_historyChosenRegister = lastChosenRegister;
+            dummyRegisterEntry.m_historyChosenRegister = lastChosenRegister;
         }
     }
 }
@@ -2070,19 +2351,14 @@ void DummyRegistersMapping::assignRegistersSimple()
 
 int DummyRegistersMapping::countSwaps()
 {
-    cList<int> dummyRegisters(m_entries.keys());
-    cList<int>::iterator dummyRegistersIter(dummyRegisters.begin());
-
     uint count = 0;
 
-    for (dummyRegistersIter = dummyRegisters.begin();
-                dummyRegistersIter != dummyRegisters.end() ;
-                ++dummyRegistersIter)
+    for (uint r = 0; r < m_registers.getSize(); ++r)
     {
-        DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = m_entries[*dummyRegistersIter];
+        DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = *m_entries[r];
         for (int index = 0 ; index < m_numberOfOperations-1 ; ++index)
         {
-            DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = m_entries[*dummyRegistersIter];
+            DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = *m_entries[r];
             DummyRegistersMapping::Entry &entry = dummyRegisterEntry[index];
             DummyRegistersMapping::Entry &nextEntry = dummyRegisterEntry[index + 1];
 
@@ -2101,8 +2377,6 @@ int DummyRegistersMapping::countSwaps()
 
 void DummyRegistersMapping::assignRegistersMust(StackLocation baseRegister)
 {
-    cList<int> dummyRegisters(m_entries.keys());
-    cList<int>::iterator dummyRegistersIter(dummyRegisters.begin());
     bool foundSingle = false;
 
     for (int index = 0 ; index < m_numberOfOperations ; ++index)
@@ -2110,11 +2384,9 @@ void DummyRegistersMapping::assignRegistersMust(StackLocation baseRegister)
         do
         {
             foundSingle = false;
-            for (dummyRegistersIter = dummyRegisters.begin();
-                 dummyRegistersIter != dummyRegisters.end() ;
-                 ++dummyRegistersIter)
+            for (uint r = 0; r < m_registers.getSize(); ++r)
             {
-                DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = m_entries[*dummyRegistersIter];
+                DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = *m_entries[r];
                 DummyRegistersMapping::Entry &entry = dummyRegisterEntry[index];
                 // Ignore entries which correspond to registers which are not alive.
                 if ((entry.m_chosenRegister != -1) ||
@@ -2146,7 +2418,7 @@ void DummyRegistersMapping::assignRegistersMust(StackLocation baseRegister)
             for (int index = 0 ; index < m_numberOfOperations ; ++index)
             {
                 // If register is alive and reg is not allowed there
-                if ((getAtRegister(baseRegister.u.reg, index).m_isAlive) &&
+                if ((getAtRegister(baseRegister.u.reg).isActive(index)) &&
                     (!getAtRegister(baseRegister.u.reg, index).m_possibleRegisters.isSet(reg)))
                     isAvailable = false;
             }
@@ -2167,18 +2439,14 @@ void DummyRegistersMapping::assignRegistersMust(StackLocation baseRegister)
 
 void DummyRegistersMapping::assignRegistersExtend()
 {
-    cList<int> dummyRegisters(m_entries.keys());
-    cList<int>::iterator dummyRegistersIter(dummyRegisters.begin());
     bool extended = false;
 
     do
     {
         extended = false;
-        for (dummyRegistersIter = dummyRegisters.begin();
-              dummyRegistersIter != dummyRegisters.end() ;
-             ++dummyRegistersIter)
+        for (uint r = 0; r < m_registers.getSize(); ++r)
         {
-            DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = m_entries[*dummyRegistersIter];
+            DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = *m_entries[r];
             for (int index = 1 ; index < m_numberOfOperations-1 ; ++index)
             {
                 if ((!dummyRegisterEntry.isActive(index)) ||
@@ -2213,16 +2481,11 @@ void DummyRegistersMapping::assignRegistersExtend()
 
 void DummyRegistersMapping::assignRegistersFini()
 {
-    cList<int> dummyRegisters(m_entries.keys());
-    cList<int>::iterator dummyRegistersIter(dummyRegisters.begin());
-
     for (int index = 0 ; index < m_numberOfOperations ; ++index)
     {
-        for (dummyRegistersIter = dummyRegisters.begin();
-                dummyRegistersIter != dummyRegisters.end() ;
-                ++dummyRegistersIter)
+        for (uint r = 0; r < m_registers.getSize(); ++r)
         {
-            DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = m_entries[*dummyRegistersIter];
+            DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = *m_entries[r];
             if (!dummyRegisterEntry.isActive(index))
                 continue;
 
@@ -2262,8 +2525,6 @@ void DummyRegistersMapping::assignRegistersFini()
 
 void DummyRegistersMapping::assignRegistersClever(StackLocation basePointer)
 {
-    cList<int> dummyRegisters(m_entries.keys());
-    cList<int>::iterator dummyRegistersIter(dummyRegisters.begin());
     bool foundSingle = false;
 
     assignRegistersMust(basePointer);
@@ -2273,16 +2534,11 @@ void DummyRegistersMapping::assignRegistersClever(StackLocation basePointer)
 
 bool DummyRegistersMapping::assignRegistersVerify()
 {
-    cList<int> dummyRegisters(m_entries.keys());
-    cList<int>::iterator dummyRegistersIter(dummyRegisters.begin());
-
     for (int index = 0 ; index < m_numberOfOperations ; ++index)
     {
-        for (dummyRegistersIter = dummyRegisters.begin();
-                dummyRegistersIter != dummyRegisters.end() ;
-                ++dummyRegistersIter)
+        for (uint r = 0; r < m_registers.getSize(); ++r)
         {
-            DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = m_entries[*dummyRegistersIter];
+            DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = *m_entries[r];
             if (!dummyRegisterEntry.isActive(index))
                 continue;
             if (dummyRegisterEntry[index].m_chosenRegister == -1)
@@ -2295,27 +2551,20 @@ bool DummyRegistersMapping::assignRegistersVerify()
 
 void DummyRegistersMapping::printTimeline()
 {
-    cList<int> dummyRegisters(m_entries.keys());
-    cList<int>::iterator dummyRegistersIter(dummyRegisters.begin());
-
-    for (dummyRegistersIter = dummyRegisters.begin();
-            dummyRegistersIter != dummyRegisters.end() ;
-            ++dummyRegistersIter)
+    for (uint r = 0; r < m_registers.getSize(); ++r)
     {
-        DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = m_entries[*dummyRegistersIter];
-        cout << "Register Number: " << HEXDWORD(*dummyRegistersIter) << ", ";
+        DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = *m_entries[r];
+        cout << "Register Number: " << HEXDWORD(m_registers[r]) << ", ";
     }
     cout << endl;
 
     cout << "Number of Operations: " << m_numberOfOperations << endl;
     cout << "Number of Real Registers: " << m_numberOfRealRegisters << endl;
 
-    for (dummyRegistersIter = dummyRegisters.begin();
-         dummyRegistersIter != dummyRegisters.end() ;
-         ++dummyRegistersIter)
+    for (uint r = 0; r < m_registers.getSize(); ++r)
     {
-        DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = m_entries[*dummyRegistersIter];
-        cout << "Register Number: " << HEXDWORD(*dummyRegistersIter);
+        DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = *m_entries[r];
+        cout << "Register Number: " << HEXDWORD(m_registers[r]);
         cout << "StackLocation "<< HEXDWORD(dummyRegisterEntry.m_stackLocation.raw);
 
         for (int index = 0 ; index < m_numberOfOperations ; ++index)
@@ -39,6 +39,8 @@
 
 #include "xStl/data/smartptr.h"
 #include "xStl/data/hash.h"
+#include "xStl/data/array.h"
+#include "xStl/data/setArray.h"
 
 #include "compiler/CompilerInterface.h"
 #include "compiler/OptimizerOperationCompilerInterface.h"
@@ -57,65 +59,189 @@ typedef cList<CompilerInterface::CompilerOperation> BlockOperationList;
 class DummyRegistersMapping
 {
 public:
-    class Entry
+    /*
+     * A set of real registers, stored in a single machine word. Bit 'i'
+     * stands for the real register m_indexToRegister[i]
+     */
+    class RegisterSet
     {
     public:
-        Entry() :
-           m_isAlive(false),
-           m_possibleRegisters(0, true, true),
-           m_chosenRegister(-1)
-        {};
+        // The maximum number of real registers
+        enum { MAX_REAL_REGISTERS = 32 };
 
-        Entry(int numberOfRealRegisters) :
-            m_isAlive(false),
-            m_possibleRegisters(numberOfRealRegisters, true, true),
-            m_chosenRegister(-1)
+        RegisterSet() :
+            m_bits(0),
+            m_length(0)
         {};
 
-        Entry(const Entry& infoInEntry) :
-            m_isAlive(infoInEntry.m_isAlive),
-            m_possibleRegisters(infoInEntry.m_possibleRegisters),
-            m_chosenRegister(infoInEntry.m_chosenRegister)
+        // Set all the real registers
+        void initSet(uint numberOfRealRegisters)
+        {
+            CHECK(numberOfRealRegisters <= MAX_REAL_REGISTERS);
+            m_length = numberOfRealRegisters;
+            m_bits = (m_length == MAX_REAL_REGISTERS) ? 0xFFFFFFFF :
+                                                        (((uint32)1 << m_length) - 1);
+        }
+
+        // Return the number of real registers
+        uint getLength() const
+        {
+            return m_length;
+        }
+
+        bool isSet(uint index) const
+        {
+            return (index < m_length) && (((m_bits >> index) & 1) != 0);
+        }
+
+        void clear(uint index)
+        {
+            if (index < m_length)
+                m_bits &= ~((uint32)1 << index);
+        }
+
+        // Return the first set register, or getLength() if the set is empty
+        uint first() const
+        {
+            if (m_bits == 0)
+                return m_length;
+            uint index = 0;
+            while (((m_bits >> index) & 1) == 0)
+                index++;
+            return index;
+        }
+
+        // Return true if exactly one register is set
+        bool isSetInOnePlace() const
+        {
+            return (m_bits != 0) && ((m_bits & (m_bits - 1)) == 0);
+        }
+
+        // Intersect with the constraints of an operation
+        RegisterSet& operator &= (const cSetArray& other)
+        {
+            for (uint i = 0; i < m_length; i++)
+            {
+                if ((i >= other.getLength()) || (!other.isSet(i)))
+                    clear(i);
+            }
+            return *this;
+        }
+
+    private:
+        // The registers bitmap
+        uint32 m_bits;
+        // The number of real registers
+        uint m_length;
+    };
+
+    class Entry
+    {
+    public:
+        Entry() :
+           m_chosenRegister(-1)
         {};
 
         void initEntry(uint numberOfRealRegisters)
         {
-            m_possibleRegisters.changeSize(numberOfRealRegisters);
-            for (uint i = 0  ; i < m_possibleRegisters.getLength() ; ++i)
-                m_possibleRegisters.set(i);
+            m_possibleRegisters.initSet(numberOfRealRegisters);
             m_chosenRegister = -1;
-            m_isAlive = false;
         }
 
-        bool m_isAlive;
-        cSetArray m_possibleRegisters;
+        RegisterSet m_possibleRegisters;
         int m_chosenRegister;
     };
 
-    class DummyRegisterEntry : public cArray<Entry>
+    /*
+     * The timeline of a single dummy register: the possible and chosen real
+     * register for each operation of the block, and the operations in which
+     * the register is alive, as a sorted list of intervals.
+     */
+    class DummyRegisterEntry
     {
     public:
         DummyRegisterEntry() :
+            m_size(0),
+            m_intervalsCount(0),
             m_stackLocation(StackInterface::buildStackLocation(0, 0)),
             m_historyChosenRegister(-1)
         {};
 
         void resize(int numberOfOperations, int numberOfRealRegisters)
         {
-            int oldNumberOfOperations = getSize();
-            changeSize(numberOfOperations);
-            for (int i = oldNumberOfOperations ; i < numberOfOperations ; ++i)
-                (*this)[i].initEntry(numberOfRealRegisters);
+            uint newSize = (uint)numberOfOperations;
+            if (newSize > m_timeline.getSize())
+            {
+                // Blocks are built one operation at a time, grow geometrically
+                uint capacity = m_timeline.getSize() * 2;
+                if (capacity < newSize)
+                    capacity = newSize;
+                m_timeline.changeSize(capacity);
+            }
+            for (uint i = m_size; i < newSize; ++i)
+                m_timeline[i].initEntry(numberOfRealRegisters);
+            m_size = newSize;
+
+            // Forget the liveness beyond the timeline
+            while ((m_intervalsCount > 0) &&
+                   (m_intervals[m_intervalsCount - 1].m_start >= newSize))
+                m_intervalsCount--;
+            if ((m_intervalsCount > 0) &&
+                (m_intervals[m_intervalsCount - 1].m_end >= newSize))
+                m_intervals[m_intervalsCount - 1].m_end = newSize - 1;
         };
 
-        bool isActive(int index)
+        uint getSize() const
+        {
+            return m_size;
+        }
+
+        Entry& operator[] (int index)
+        {
+            CHECK((uint)index < m_size);
+            return m_timeline[index];
+        }
+
+        bool isActive(int index) const
         {
-            return (*this)[index].m_isAlive;
+            // Binary search the interval which starts before index
+            uint low = 0;
+            uint high = m_intervalsCount;
+            while (low < high)
+            {
+                uint middle = (low + high) / 2;
+                if (m_intervals[middle].m_start <= (uint)index)
+                    low = middle + 1;
+                else
+                    high = middle;
+            }
+            return (low > 0) && ((uint)index <= m_intervals[low - 1].m_end);
         };
 
-        void setActive(int index, bool val)
+        /*
+         * Mark the register as alive at operation 'index'. The operations are
+         * marked in order of the timeline
+         */
+        void setActive(int index)
         {
-            (*this)[index].m_isAlive = val;
+            uint position = (uint)index;
+            if (m_intervalsCount > 0)
+            {
+                Interval& last = m_intervals[m_intervalsCount - 1];
+                if (position <= last.m_end + 1)
+                {
+                    CHECK(position >= last.m_start);
+                    if (position > last.m_end)
+                        last.m_end = position;
+                    return;
+                }
+            }
+
+            if (m_intervalsCount == m_intervals.getSize())
+                m_intervals.changeSize((m_intervalsCount == 0) ? 4 : (m_intervalsCount * 2));
+            m_intervals[m_intervalsCount].m_start = position;
+            m_intervals[m_intervalsCount].m_end = position;
+            m_intervalsCount++;
         };
 
         Entry& getLastEntry()
@@ -123,50 +249,121 @@ public:
             return (*this)[getSize()-1];
         };
 
+    private:
+        // A range of operations in which the register is alive (inclusive)
+        struct Interval
+        {
+            uint m_start;
+            uint m_end;
+        };
+
+        // The entries of the timeline, m_size are in use
+        cArray<Entry> m_timeline;
+        uint m_size;
+        // The liveness intervals, m_intervalsCount are in use
+        cArray<Interval> m_intervals;
+        uint m_intervalsCount;
+
+    public:
         StackLocation m_stackLocation;
         int m_historyChosenRegister;
     };
 
+    // The reference countable object
+    typedef cSmartPtr<DummyRegisterEntry> DummyRegisterEntryPtr;
+
     DummyRegistersMapping(int numberOfOperations, int numberOfRealRegisters):
-        m_entries(),
         m_numberOfRealRegisters(numberOfRealRegisters),
         m_numberOfOperations(numberOfOperations)
         //m_dummyStackPointerRegister(-(NUMBER_OF_DUMMY_REGISTER+1)) // The first dummy register after the official list of free registers.
-    {};
+    {
+        CHECK(numberOfRealRegisters <= RegisterSet::MAX_REAL_REGISTERS);
+    };
 
     void initialize()
     {
-        cList<int> keys(m_entries.keys());
-        cList<int>::iterator keysIter(keys.begin());
-
         m_numberOfOperations = 0;
 
-        for (; keysIter != keys.end() ; ++keysIter)
+        // Keep only the registers with history, renumber them
+        uint count = 0;
+        for (uint i = 0; i < m_registers.getSize(); ++i)
         {
-            // If there is NO history to keep, remove the key and value from hash
-            if (m_entries[*keysIter].m_historyChosenRegister == -1)
-            {
-                m_entries.remove(*keysIter);
-            }
-            else // There is history. Only init the array operations.
-            {
-                m_entries[*keysIter].resize(m_numberOfOperations, m_numberOfRealRegisters);
-                m_entries[*keysIter].m_stackLocation = StackInterface::buildStackLocation(0,0);
-            }
+            int dummyRegister = m_registers[i];
+            m_indexes.remove(dummyRegister);
+
+            // If there is NO history to keep, remove the register
+            if (m_entries[i]->m_historyChosenRegister == -1)
+                continue;
+
+            // There is history. Only init the array operations.
+            m_entries[i]->resize(m_numberOfOperations, m_numberOfRealRegisters);
+            m_entries[i]->m_stackLocation = StackInterface::buildStackLocation(0,0);
+            m_registers[count] = dummyRegister;
+            m_entries[count] = m_entries[i];
+            m_indexes.append(dummyRegister, count);
+            count++;
         }
+        m_registers.changeSize(count);
+        m_entries.changeSize(count);
     }
 
     void resize(int numberOfOperations)
     {
-        cList<int> keys(m_entries.keys());
-        cList<int>::iterator keysIter(keys.begin());
-
         m_numberOfOperations = numberOfOperations;
 
-        for (; keysIter != keys.end() ; ++keysIter)
-            m_entries[*keysIter].resize(m_numberOfOperations, m_numberOfRealRegisters);
+        for (uint i = 0; i < m_entries.getSize(); ++i)
+            m_entries[i]->resize(m_numberOfOperations, m_numberOfRealRegisters);
     };
 
+    /*
+     * Return true if a dummy register has a timeline
+     */
+    bool hasRegister(int dummyRegister) const
+    {
+        return m_indexes.hasKey(dummyRegister);
+    }
+
+    /*
+     * Add a timeline for a new dummy register
+     */
+    DummyRegisterEntry& addRegister(int dummyRegister)
+    {
+        CHECK(!hasRegister(dummyRegister));
+        uint index = m_registers.getSize();
+        m_registers.changeSize(index + 1);
+        m_entries.changeSize(index + 1);
+        m_registers[index] = dummyRegister;
+        m_entries[index] = DummyRegisterEntryPtr(new DummyRegisterEntry());
+        m_entries[index]->resize(m_numberOfOperations, m_numberOfRealRegisters);
+        m_indexes.append(dummyRegister, index);
+        return *m_entries[index];
+    }
+
+    /*
+     * Return the number of dummy registers. The dummy registers are numbered
+     * from 0 to getRegistersCount() - 1, see getRegister() and getEntry()
+     */
+    uint getRegistersCount() const
+    {
+        return m_registers.getSize();
+    }
+
+    /*
+     * Return the dummy register of a dense index
+     */
+    int getRegister(uint index) const
+    {
+        return m_registers[index];
+    }
+
+    /*
+     * Return the timeline of a dense index
+     */
+    DummyRegisterEntry& getEntry(uint index)
+    {
+        return *m_entries[index];
+    }
+
     /*
      * Gets a register and an index of an operation.
      * Returns the info in the entry (possible register, chosen register etc)
@@ -177,7 +374,7 @@ public:
     {
         CHECK(index <= m_numberOfOperations);
 
-        return m_entries[dummyRegister][index];
+        return getAtRegister(dummyRegister)[index];
     };
 
     /*
@@ -187,7 +384,7 @@ public:
      */
     DummyRegisterEntry& getAtRegister(int dummyRegister)
     {
-        return m_entries[dummyRegister];
+        return *m_entries[m_indexes[dummyRegister]];
     };
 
     /*
@@ -197,14 +394,9 @@ public:
 
     void dontAllowAssignment(int chosenRegister, int index)
     {
-        cList<int> dummyRegisters(m_entries.keys());
-        cList<int>::iterator dummyRegistersIter(dummyRegisters.begin());
-
-        for (dummyRegistersIter = dummyRegisters.begin();
-             dummyRegistersIter!= dummyRegisters.end() ;
-             ++dummyRegistersIter)
+        for (uint i = 0; i < m_entries.getSize(); ++i)
         {
-            DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = m_entries[*dummyRegistersIter];
+            DummyRegistersMapping::DummyRegisterEntry &dummyRegisterEntry = *m_entries[i];
             // Ignore entries which correspond to registers which are not alive.
             if ((dummyRegisterEntry[index].m_chosenRegister != -1) ||
                 (!dummyRegisterEntry.isActive(index)))
@@ -231,8 +423,12 @@ public:
     bool assignRegistersVerify();
     int countSwaps();
 
-    // Entries per dummy register
-    cHash<int, DummyRegisterEntry> m_entries;
+    // The dummy registers, by their dense index
+    cArray<int> m_registers;
+    // Entries per dummy register, by their dense index
+    cArray<DummyRegisterEntryPtr> m_entries;
+    // The dense index of each dummy register
+    cHash<int, uint> m_indexes;
     // number of real registers in platform
     int m_numberOfRealRegisters;
     // number of operations in block
@@ -242,7 +438,6 @@ public:
 
 };
 
-
 class OptimizerCompilerInterface : public CompilerInterface
 {
 public:
@@ -328,6 +523,10 @@ public:
     virtual void assignRet32(StackLocation source);
     // See CompilerInterface::pushArg32
     virtual void pushArg32(StackLocation source);
+    // See CompilerInterface::pushArgConst32
+    virtual void pushArgConst32(int32 value);
+    // See CompilerInterface::pushArgStack32
+    virtual void pushArgStack32(uint stackPosition, bool argumentStackLocation);
     // See CompilerInterface::popArg32
     virtual void popArg32(StackLocation source);
     // See CompilerInterface::call
@@ -338,6 +537,26 @@ public:
                         StackLocation destination, uint numberOfArguments);
     virtual void call32(StackLocation address,
                         StackLocation destination, uint numberOfArguments);
+    // See CompilerInterface::isTailCallSupported
+    virtual bool isTailCallSupported() const;
+    // See CompilerInterface::tailCall
+    virtual void tailCall(const cString& dependencyName, uint argumentsSize);
+    // See CompilerInterface::isGuardedCallSupported
+    virtual bool isGuardedCallSupported() const;
+    // See CompilerInterface::guardedCall
+    virtual void guardedCall(const cString& guardName, const cString& dependencyName);
+    // See CompilerInterface::getArgumentRegistersCount. The optimized methods
+    // have a register entry, but call the other methods with all the arguments
+    // on the stack. The dummy registers don't model the argument registers
+    virtual uint getArgumentRegistersCount() const;
+    // See CompilerInterface::setRegisterEntry
+    virtual void setRegisterEntry(uint count);
+    // See CompilerInterface::isUnwindDataSupported
+    virtual bool isUnwindDataSupported() const;
+    // See CompilerInterface::generateUnwindData
+    virtual void generateUnwindData(bool isHelper,
+                                    const cString& cleanupName,
+                                    const UnwindClauseList& clauses);
     //////////////////////////////////////////////////////////////////////////
     // Memory handling
 
@@ -349,6 +568,12 @@ public:
     // See CompilerInterface::loadMemory
     virtual void loadMemory(StackLocation destination, StackLocation value, uint offset,
                             uint size, bool signExtend = false);
+    // See CompilerInterface::getInlineCopySize
+    virtual uint getInlineCopySize() const;
+    // See CompilerInterface::isCopyMemorySupported
+    virtual bool isCopyMemorySupported() const;
+    // See CompilerInterface::copyMemory
+    virtual void copyMemory(StackLocation destination, StackLocation source, uint size);
 
 
 
@@ -374,12 +599,15 @@ public:
     virtual void and32(StackLocation destination, StackLocation source);
     virtual void xor32(StackLocation destination, StackLocation source);
     virtual void shr32(StackLocation destination, StackLocation source);
+    virtual void sar32(StackLocation destination, StackLocation source);
     virtual void shl32(StackLocation destination, StackLocation source);
     virtual void or32 (StackLocation destination, StackLocation source);
 
     virtual void adc32 (StackLocation destination, StackLocation source);
     virtual void sbb32 (StackLocation destination, StackLocation source);
     virtual void mul32h(StackLocation destlow, StackLocation desthigh, StackLocation source, bool sign);
+    // See CompilerInterface::isMultiplyHighSupported
+    virtual bool isMultiplyHighSupported() const;
 
     // See CompilerInterface::addConst32
     virtual void addConst32(const StackLocation destination,
@@ -397,6 +625,14 @@ public:
     virtual void jumpCond(StackLocation compare, int blockID, bool isZero);
     virtual void jumpCondShort(StackLocation compare, int blockID, bool isZero);
 
+    // See CompilerInterface::jumpCompare.s
+    virtual void jumpCompare(StackLocation first, StackLocation second,
+                             CompareCondition condition, bool isSigned,
+                             int blockID);
+    virtual void jumpCompareShort(StackLocation first, StackLocation second,
+                                  CompareCondition condition, bool isSigned,
+                                  int blockID);
+
     //////////////////////////////////////////////////////////////////////////
     // Comparison methods
 
@@ -45,6 +45,17 @@ public:
      */
     virtual RegisterAllocationInfo getOperationRegisterAllocationInfo(CompilerOperation& operation) = 0;
 
+    /*
+     * Multiply two registers and store only the higher 32 bits of the result
+     * into "destination". The optimizer allocates two registers per operation,
+     * so a buffered mul32h is split into a move, mulHigh32 and mul32.
+     *
+     * destination - The first operand and the result holder
+     * source      - The second operand
+     * sign        - Set to true for a signed multiplication
+     */
+    virtual void mulHigh32(StackLocation destination, StackLocation source, bool sign) = 0;
+
 protected:
     friend class OptimizerCompilerInterface;
 };
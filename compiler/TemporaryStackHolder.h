@@ -43,6 +43,7 @@
 #include "xStl/data/smartptr.h"
 #include "format/coreHeadersTypes.h"
 #include "dismount/assembler/StackInterface.h"
+#include "compiler/CompilerArena.h"
 
 // Forward deceleration
 class TemporaryStackHolder;
@@ -56,8 +57,10 @@ typedef cSmartPtr<TemporaryStackHolder> TemporaryStackHolderPtr;
  *
  * See StackEntity for detailed information regarding the needs for this
  * struct.
+ *
+ * The holders are allocated from the active CompilerArena (See MethodCompiler)
  */
-class TemporaryStackHolder {
+class TemporaryStackHolder : public CompilerArenaObject {
 public:
     // The different types for the stack allocation holding
     enum StackHolderAllocationRequest {
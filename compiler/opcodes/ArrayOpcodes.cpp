@@ -41,6 +41,7 @@
 #include "compiler/opcodes/RegisterEvaluatorOpcodes.h"
 #include "compiler/opcodes/ObjectOpcodes.h"
 #include "compiler/opcodes/ArrayOpcodes.h"
+#include "compiler/opcodes/LoopOpcodes.h"
 
 void ArrayOpcodes::handleNewArray(EmitContext& emitContext,
                                   const ElementType& tokenType)
@@ -95,17 +96,21 @@ uint ArrayOpcodes::arrayCalculateOffset(EmitContext& emitContext, ElementType& a
     arrayInnerType.unconvertFromArray(); // Remove array attribute.
     uint sizeofElement = globalContext.getTypedefRepository().getTypeSize(arrayInnerType);
 
-    stack.push(arr);     arr = StackEntity();
-    stack.push(index);   index = StackEntity();
+    // Inside a loop the address might be kept by the loop. See MethodLoops
+    if (!LoopOpcodes::loadElementAddress(emitContext, arr, index, sizeofElement))
+    {
+        stack.push(arr);     arr = StackEntity();
+        stack.push(index);   index = StackEntity();
 
-    StackEntity stackSizeofElement(StackEntity::ENTITY_CONST, ConstElements::gU);
-    stackSizeofElement.getConst().setConstValue(sizeofElement);
+        StackEntity stackSizeofElement(StackEntity::ENTITY_CONST, ConstElements::gU);
+        stackSizeofElement.getConst().setConstValue(sizeofElement);
 
-    stack.push(stackSizeofElement);
+        stack.push(stackSizeofElement);
 
-    // Call compilerGetArrayOffset()
-    CallingConvention::call(emitContext,
-                            emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getArrayBuffer());
+        // Call compilerGetArrayOffset()
+        CallingConvention::call(emitContext,
+                                emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getArrayBuffer());
+    }
 
     // Now byte* pointer to start address is on the stack, change the type of the array
     arrayInnerType.setPointerLevel(arrayInnerType.getPointerLevel() + 1);
@@ -41,6 +41,7 @@
 #include "compiler/CallingConvention.h"
 #include "compiler/CompilerEngine.h"
 #include "compiler/opcodes/Bin32Opcodes.h"
+#include "compiler/opcodes/ConstOpcodes.h"
 #include "compiler/opcodes/RegisterEvaluatorOpcodes.h"
 
 void Bin32Opcodes::convert32(EmitContext& emitContext,
@@ -74,16 +75,108 @@ void Bin32Opcodes::binary32(EmitContext& emitContext,
                             BinaryOpcodes::BinaryOperation operation)
 {
     Stack& stack = emitContext.currentBlock.getCurrentStack();
+    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
+
+    // Strength reduction. Constants are moved to the source operand
+    if ((operation == BinaryOpcodes::BIN_MUL) &&
+        ConstOpcodes::isConst32(stack.getArg(1)) &&
+        !ConstOpcodes::isConst32(stack.getArg(0)))
+    {
+        StackEntity constEntity(stack.getArg(1));
+        stack.getArg(1) = stack.getArg(0);
+        stack.getArg(0) = constEntity;
+    }
+
+    if (ConstOpcodes::isConst32(stack.getArg(0)))
+    {
+        uint32 value = (uint32)stack.getArg(0).getConst().getConstValue();
+        uint shift;
+
+        // Multiply by 2^n is a shift left by n
+        if ((operation == BinaryOpcodes::BIN_MUL) && getShiftCount(value, shift))
+        {
+            operation = BinaryOpcodes::BIN_SHL;
+            value = shift;
+            stack.getArg(0).getConst().setConstValue((int)value);
+        }
+
+        // Unsigned division by 2^n is a shift right by n, and the remainder
+        // is the lower n bits
+        if ((operation == BinaryOpcodes::BIN_DIV_UN) && getShiftCount(value, shift))
+        {
+            operation = BinaryOpcodes::BIN_SHR_UN;
+            value = shift;
+            stack.getArg(0).getConst().setConstValue((int)value);
+        } else if ((operation == BinaryOpcodes::BIN_REM_UN) && getShiftCount(value, shift))
+        {
+            operation = BinaryOpcodes::BIN_AND;
+            value = value - 1;
+            stack.getArg(0).getConst().setConstValue((int)value);
+        }
+
+        // Division by one doesn't change the destination
+        if ((value == 1) &&
+            ((operation == BinaryOpcodes::BIN_DIV) ||
+             (operation == BinaryOpcodes::BIN_DIV_UN)))
+        {
+            stack.pop2null();
+            return;
+        }
+
+        // Operations which doesn't change the destination
+        if ((value == 0) &&
+            ((operation == BinaryOpcodes::BIN_ADD) ||
+             (operation == BinaryOpcodes::BIN_SUB) ||
+             (operation == BinaryOpcodes::BIN_OR)  ||
+             (operation == BinaryOpcodes::BIN_XOR) ||
+             (operation == BinaryOpcodes::BIN_SHL) ||
+             (operation == BinaryOpcodes::BIN_SHR) ||
+             (operation == BinaryOpcodes::BIN_SHR_UN)))
+        {
+            stack.pop2null();
+            return;
+        }
+
+        // Small offsets (fields, elements) are encoded as immediate
+        if ((operation == BinaryOpcodes::BIN_ADD) && (value < MAX_IMMEDIATE_ADD))
+        {
+            RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(1));
+            compiler.addConst32(stack.getArg(1).getStackHolderObject()->getTemporaryObject(),
+                                (int32)value);
+            stack.pop2null();
+            return;
+        }
+
+        // Other divisors are replaced by a multiplication with their
+        // reciprocal
+        if (((operation == BinaryOpcodes::BIN_DIV_UN) ||
+             (operation == BinaryOpcodes::BIN_REM_UN)) &&
+            (value > 1) &&
+            compiler.isMultiplyHighSupported())
+        {
+            divideByConstant(emitContext, value,
+                             (operation == BinaryOpcodes::BIN_DIV_UN), false);
+            return;
+        }
+        // A signed division by -1 may overflow, which is raised at runtime
+        if (((operation == BinaryOpcodes::BIN_DIV) ||
+             (operation == BinaryOpcodes::BIN_REM)) &&
+            (value > 1) && (value != 0x80000000) && (value != 0xFFFFFFFF) &&
+            compiler.isMultiplyHighSupported())
+        {
+            divideByConstant(emitContext, value,
+                             (operation == BinaryOpcodes::BIN_DIV), true);
+            return;
+        }
+    }
 
     // COMPLEXSTRUCT
     // TODO!!! Check binary operation types
     RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(1)); // destinationEntity
     RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(0)); // sourceEntity
 
-    // TODO! Check for source constance and translate them into optimization
     StackLocation source = stack.getArg(0).getStackHolderObject()->getTemporaryObject();
     StackLocation destination = stack.getArg(1).getStackHolderObject()->getTemporaryObject();
-    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
 
     // Evaluate operation
     switch (operation)
@@ -95,12 +188,13 @@ void Bin32Opcodes::binary32(EmitContext& emitContext,
     case BinaryOpcodes::BIN_REM: compiler.rem32(destination, source, true); break;
     case BinaryOpcodes::BIN_AND: compiler.and32(destination, source); break;
     case BinaryOpcodes::BIN_SHL: compiler.shl32(destination, source); break;
-    case BinaryOpcodes::BIN_SHR: compiler.shr32(destination, source); break;
+    case BinaryOpcodes::BIN_SHR: compiler.sar32(destination, source); break;
     case BinaryOpcodes::BIN_XOR: compiler.xor32(destination, source); break;
     case BinaryOpcodes::BIN_OR:  compiler.or32 (destination, source); break;
     // Unsigned operations
     case BinaryOpcodes::BIN_DIV_UN: compiler.div32(destination, source, false); break;
     case BinaryOpcodes::BIN_REM_UN: compiler.rem32(destination, source, false); break;
+    case BinaryOpcodes::BIN_SHR_UN: compiler.shr32(destination, source); break;
     default:
         // Not ready yet
         CHECK_FAIL();
@@ -112,6 +206,207 @@ void Bin32Opcodes::binary32(EmitContext& emitContext,
     stack.pop2null();
 }
 
+bool Bin32Opcodes::getShiftCount(uint32 value, uint& shift)
+{
+    // Test for a single bit
+    if ((value == 0) || ((value & (value - 1)) != 0))
+        return false;
+
+    shift = 0;
+    while ((value >>= 1) != 0)
+        shift++;
+    return true;
+}
+
+void Bin32Opcodes::getUnsignedMagic(uint32 divisor,
+                                    uint32& magic,
+                                    bool& isAdd,
+                                    uint& shift)
+{
+    // See Hacker's Delight, 10-8 "Unsigned Division by Divisors >= 1"
+    uint32 nc = 0xFFFFFFFF - (0 - divisor) % divisor;
+    uint32 q1 = 0x80000000 / nc;
+    uint32 r1 = 0x80000000 - q1 * nc;
+    uint32 q2 = 0x7FFFFFFF / divisor;
+    uint32 r2 = 0x7FFFFFFF - q2 * divisor;
+    uint32 delta;
+    uint p = 31;
+
+    isAdd = false;
+    do
+    {
+        p++;
+        if (r1 >= nc - r1)
+        {
+            q1 = 2 * q1 + 1;
+            r1 = 2 * r1 - nc;
+        } else
+        {
+            q1 = 2 * q1;
+            r1 = 2 * r1;
+        }
+
+        if (r2 + 1 >= divisor - r2)
+        {
+            if (q2 >= 0x7FFFFFFF)
+                isAdd = true;
+            q2 = 2 * q2 + 1;
+            r2 = 2 * r2 + 1 - divisor;
+        } else
+        {
+            if (q2 >= 0x80000000)
+                isAdd = true;
+            q2 = 2 * q2;
+            r2 = 2 * r2 + 1;
+        }
+        delta = divisor - 1 - r2;
+    } while ((p < 64) && ((q1 < delta) || ((q1 == delta) && (r1 == 0))));
+
+    magic = q2 + 1;
+    shift = p - 32;
+}
+
+void Bin32Opcodes::getSignedMagic(int32 divisor,
+                                  int32& magic,
+                                  uint& shift)
+{
+    // See Hacker's Delight, 10-6 "Signed Division by Divisors >= 2"
+    uint32 ad = (divisor < 0) ? (0 - (uint32)divisor) : (uint32)divisor;
+    uint32 t = 0x80000000 + ((uint32)divisor >> 31);
+    uint32 anc = t - 1 - t % ad;
+    uint32 q1 = 0x80000000 / anc;
+    uint32 r1 = 0x80000000 - q1 * anc;
+    uint32 q2 = 0x80000000 / ad;
+    uint32 r2 = 0x80000000 - q2 * ad;
+    uint32 delta;
+    uint p = 31;
+
+    do
+    {
+        p++;
+        q1 = 2 * q1;
+        r1 = 2 * r1;
+        if (r1 >= anc)
+        {
+            q1++;
+            r1 -= anc;
+        }
+        q2 = 2 * q2;
+        r2 = 2 * r2;
+        if (r2 >= ad)
+        {
+            q2++;
+            r2 -= ad;
+        }
+        delta = ad - r2;
+    } while ((q1 < delta) || ((q1 == delta) && (r1 == 0)));
+
+    magic = (int32)(q2 + 1);
+    if (divisor < 0)
+        magic = (int32)(0 - (q2 + 1));
+    shift = p - 32;
+}
+
+void Bin32Opcodes::divideByConstant(EmitContext& emitContext,
+                                    uint32 divisor,
+                                    bool isDiv,
+                                    bool isSigned)
+{
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
+
+    uint32 magic;
+    bool isAdd = false;
+    uint shift;
+    int32 signedMagic = 0;
+    if (isSigned)
+    {
+        getSignedMagic((int32)divisor, signedMagic, shift);
+        magic = (uint32)signedMagic;
+    } else
+        getUnsignedMagic(divisor, magic, isAdd, shift);
+
+    RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(1)); // destinationEntity
+    StackLocation dividend = stack.getArg(1).getStackHolderObject()->getTemporaryObject();
+
+    TemporaryStackHolderPtr low(new TemporaryStackHolder(
+                                    emitContext.currentBlock,
+                                    ELEMENT_TYPE_I4,
+                                    CompilerInterface::STACK_32,
+                                    TemporaryStackHolder::TEMP_ONLY_REGISTER));
+    TemporaryStackHolderPtr high(new TemporaryStackHolder(
+                                    emitContext.currentBlock,
+                                    ELEMENT_TYPE_I4,
+                                    CompilerInterface::STACK_32,
+                                    TemporaryStackHolder::TEMP_ONLY_REGISTER));
+    TemporaryStackHolderPtr temp(new TemporaryStackHolder(
+                                    emitContext.currentBlock,
+                                    ELEMENT_TYPE_I4,
+                                    CompilerInterface::STACK_32,
+                                    TemporaryStackHolder::TEMP_ONLY_REGISTER));
+
+    // high = (dividend * magic) >> 32
+    compiler.move32(low->getTemporaryObject(), dividend, CompilerInterface::STACK_32, false);
+    compiler.loadInt32(temp->getTemporaryObject(), magic);
+    compiler.mul32h(low->getTemporaryObject(), high->getTemporaryObject(),
+                    temp->getTemporaryObject(), isSigned);
+
+    TemporaryStackHolderPtr quotient = high;
+    if (isSigned)
+    {
+        //     quotient = (high +/- dividend) >> shift
+        //     quotient += (quotient >>> 31)
+        if (((int32)divisor > 0) && (signedMagic < 0))
+            compiler.add32(high->getTemporaryObject(), dividend);
+        else if (((int32)divisor < 0) && (signedMagic > 0))
+            compiler.sub32(high->getTemporaryObject(), dividend);
+        if (shift != 0)
+        {
+            compiler.loadInt32(temp->getTemporaryObject(), shift);
+            compiler.sar32(high->getTemporaryObject(), temp->getTemporaryObject());
+        }
+        // Round towards zero, add one to a negative quotient
+        compiler.move32(low->getTemporaryObject(), high->getTemporaryObject(),
+                        CompilerInterface::STACK_32, false);
+        compiler.loadInt32(temp->getTemporaryObject(), 31);
+        compiler.shr32(low->getTemporaryObject(), temp->getTemporaryObject());
+        compiler.add32(high->getTemporaryObject(), low->getTemporaryObject());
+        shift = 0;
+    } else if (isAdd)
+    {
+        // The magic number is 33 bit long:
+        //     quotient = (((dividend - high) >> 1) + high) >> (shift - 1)
+        compiler.move32(low->getTemporaryObject(), dividend, CompilerInterface::STACK_32, false);
+        compiler.sub32(low->getTemporaryObject(), high->getTemporaryObject());
+        compiler.loadInt32(temp->getTemporaryObject(), 1);
+        compiler.shr32(low->getTemporaryObject(), temp->getTemporaryObject());
+        compiler.add32(low->getTemporaryObject(), high->getTemporaryObject());
+        quotient = low;
+        shift--;
+    }
+
+    if (shift != 0)
+    {
+        compiler.loadInt32(temp->getTemporaryObject(), shift);
+        compiler.shr32(quotient->getTemporaryObject(), temp->getTemporaryObject());
+    }
+
+    if (isDiv)
+    {
+        // The quotient replaces the destination
+        stack.getArg(1).setStackHolderObject(quotient);
+    } else
+    {
+        // remainder = dividend - quotient * divisor
+        compiler.loadInt32(temp->getTemporaryObject(), divisor);
+        compiler.mul32(quotient->getTemporaryObject(), temp->getTemporaryObject());
+        compiler.sub32(dividend, quotient->getTemporaryObject());
+    }
+
+    // Remove the constant divisor
+    stack.pop2null();
+}
+
 void Bin32Opcodes::compare32(EmitContext& emitContext,
                              BinaryOpcodes::ComparisonOperation operation)
 {
@@ -75,6 +75,51 @@ public:
      */
     static void compare32(EmitContext& emitContext,
                           BinaryOpcodes::ComparisonOperation operation);
+
+    /*
+     * Calculate the magic number for an unsigned division by a constant which
+     * isn't a power of 2. The quotient is (mulhi(x, magic) >> shift). If
+     * 'isAdd' is true the magic number is 33 bit long and the quotient is
+     * (((x - mulhi(x, magic)) >> 1) + mulhi(x, magic)) >> (shift - 1)
+     */
+    static void getUnsignedMagic(uint32 divisor,
+                                 uint32& magic,
+                                 bool& isAdd,
+                                 uint& shift);
+
+    /*
+     * Calculate the magic number for a signed division by a constant 'divisor'
+     * where 2 <= |divisor| < 2^31. The quotient is
+     * (mulhs(x, magic) [+/- x]) >> shift, plus one if it is negative. 'x' is
+     * added when the divisor is positive and the magic is negative, and
+     * subtracted when the divisor is negative and the magic is positive.
+     */
+    static void getSignedMagic(int32 divisor,
+                               int32& magic,
+                               uint& shift);
+
+private:
+    // Constants below this value are added using CompilerInterface::addConst32
+    // (All processors encode them as an immediate)
+    enum { MAX_IMMEDIATE_ADD = 0x100 };
+
+    /*
+     * Return true if 'value' is a power of 2, and fill 'shift' with its
+     * exponent.
+     */
+    static bool getShiftCount(uint32 value, uint& shift);
+
+    /*
+     * Replace a div/rem of the two topmost stack entities, whose divisor is a
+     * constant, with a multiply-high sequence.
+     *
+     * isDiv    - true for the quotient, false for the remainder
+     * isSigned - true for div/rem, false for div.un/rem.un
+     */
+    static void divideByConstant(EmitContext& emitContext,
+                                 uint32 divisor,
+                                 bool isDiv,
+                                 bool isSigned);
 };
 
 #endif // __TBA_CLR_COMPILER_OPCODES_BIN32OPCODES_H
@@ -42,22 +42,29 @@
 #include "compiler/CompilerEngine.h"
 #include "compiler/opcodes/BinaryOpcodes.h"
 #include "compiler/opcodes/Bin32Opcodes.h"
+#include "compiler/opcodes/ConstOpcodes.h"
 #include "compiler/opcodes/RegisterEvaluatorOpcodes.h"
 
 void BinaryOpcodes::convert(EmitContext& emitContext,
                             CorElementType coreType)
 {
+    if (ConstOpcodes::convert(emitContext, coreType))
+        return;
     Bin32Opcodes::convert32(emitContext, coreType);
 }
 
 void BinaryOpcodes::binary(EmitContext& emitContext,
                            BinaryOpcodes::BinaryOperation operation)
 {
+    if (ConstOpcodes::binary(emitContext, operation))
+        return;
     Bin32Opcodes::binary32(emitContext, operation);
 }
 
 void BinaryOpcodes::compare(EmitContext& emitContext,
                             BinaryOpcodes::ComparisonOperation operation)
 {
+    if (ConstOpcodes::compare(emitContext, operation))
+        return;
     Bin32Opcodes::compare32(emitContext, operation);
 }
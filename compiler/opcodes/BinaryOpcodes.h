@@ -91,8 +91,10 @@ public:
         BIN_XOR,
         // Shift left (<<) operation
         BIN_SHL,
-        // Shift right (>>) operation
-        BIN_SHR
+        // Arithmetic shift right (>>) operation, the sign bit is kept
+        BIN_SHR,
+        // Logical shift right (>>) operation
+        BIN_SHR_UN
     };
 
     /*
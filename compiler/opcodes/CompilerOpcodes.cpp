@@ -37,6 +37,7 @@
 #include "compiler/opcodes/RegisterEvaluatorOpcodes.h"
 #include "compiler/opcodes/ObjectOpcodes.h"
 #include "compiler/opcodes/ArrayOpcodes.h"
+#include "compiler/opcodes/ConstOpcodes.h"
 #include "compiler/opcodes/CompilerOpcodes.h"
 
 bool CompilerOpcodes::compilerOpcodes(EmitContext& emitContext,
@@ -241,6 +242,63 @@ bool CompilerOpcodes::compilerOpcodes(EmitContext& emitContext,
         stack.push(object);
         ArrayOpcodes::stind(emitContext,ConstElements::gU4);
         return false;
+    } else if (opcode.compare("getFramePointer") == cString::EqualTo)
+    {
+        // public static void* getFramePointer()
+        CHECK(!methodSignature.isHasThis());
+        CHECK(methodSignature.getParams().getSize() == 0);
+
+        TemporaryStackHolderPtr framePointer(new TemporaryStackHolder(
+                                    currentBlock,
+                                    ELEMENT_TYPE_PTR,
+                                    compiler.getStackSize(),
+                                    TemporaryStackHolder::TEMP_ONLY_REGISTER));
+        compiler.setFramePointer(framePointer->getTemporaryObject());
+        StackEntity object(StackEntity::ENTITY_REGISTER, ConstElements::gVoidPtr);
+        object.setStackHolderObject(framePointer);
+        stack.push(object);
+        return false;
+    } else if (opcode.compare("getUnwindTable") == cString::EqualTo)
+    {
+        // public static void* getUnwindTable()
+        CHECK(!methodSignature.isHasThis());
+        CHECK(methodSignature.getParams().getSize() == 0);
+
+        // Without unwind data the original function returns null
+        if (!compiler.isUnwindDataSupported())
+            return true;
+
+        // The linker places the table, see CallingConvention::gUnwindTableName
+        TemporaryStackHolderPtr table(new TemporaryStackHolder(
+                                    currentBlock,
+                                    ELEMENT_TYPE_PTR,
+                                    compiler.getStackSize(),
+                                    TemporaryStackHolder::TEMP_ONLY_REGISTER));
+        compiler.loadInt32(table->getTemporaryObject(), CallingConvention::gUnwindTableName);
+        StackEntity object(StackEntity::ENTITY_REGISTER, ConstElements::gVoidPtr);
+        object.setStackHolderObject(table);
+        stack.push(object);
+        return false;
+    } else if (opcode.compare("callFunction") == cString::EqualTo)
+    {
+        // public static void callFunction(void* function, void* param)
+        // Calls the function directly, so the frame chain of the caller is
+        // kept for the exception unwinder
+        CHECK(!methodSignature.isHasThis());
+        CHECK(methodSignature.getParams().getSize() == 2);
+        CHECK(methodSignature.getReturnType() == ConstElements::gVoid);
+
+        RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(0));
+        RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(1));
+        TemporaryStackHolderPtr param = stack.getArg(0).getStackHolderObject();
+        TemporaryStackHolderPtr function = stack.getArg(1).getStackHolderObject();
+        stack.pop2null();
+        stack.pop2null();
+
+        // The handlers are "void function(void* param)" stdcall functions
+        compiler.pushArg32(param->getTemporaryObject());
+        compiler.call(function->getTemporaryObject(), 1);
+        return false;
     } else
     {
         CompilerTrace("CallingConvention::call(): Missing instruction! " <<
@@ -273,21 +331,20 @@ void CompilerOpcodes::compilerReturn(EmitContext& emitContext)
     if (emitContext.methodRuntime.m_cleanupIndex != ElementType::UnresolvedTokenIndex)
     {
 
-        if (emitContext.methodRuntime.m_compiler->getCompilerParameters().m_bSupportExceptionHandling)
+        if (emitContext.methodRuntime.m_compiler->getCompilerParameters().m_bSupportExceptionHandling &&
+            !emitContext.methodRuntime.m_compiler->isUnwindDataSupported())
         {
-            // pop the cleanup routine from the exception stack, and execute it
-            // Call clr's PopAndExec
-            CallingConvention::call(emitContext, emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getPopAndExec());
+            // pop the cleanup routine from the exception stack. It is known,
+            // so it's executed directly instead of calling clr's PopAndExec
+            CallingConvention::call(emitContext, emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getPop());
         }
-        else
-        {
-            cString dependencyTokenName(CallingConvention::serializedMethod(emitContext.methodRuntime.m_cleanupIndex));
 
-            // Push the current base pointer
-            emitContext.methodRuntime.m_compiler->pushArg32(emitContext.currentBlock.getBaseStackRegister());
-            // And call the cleanup function directly
-            emitContext.methodRuntime.m_compiler->call(dependencyTokenName, 1);
-        }
+        cString dependencyTokenName(CallingConvention::serializedMethod(emitContext.methodRuntime.m_cleanupIndex));
+
+        // Push the current base pointer
+        emitContext.methodRuntime.m_compiler->pushArg32(emitContext.currentBlock.getBaseStackRegister());
+        // And call the cleanup function directly
+        emitContext.methodRuntime.m_compiler->call(dependencyTokenName, 1);
     }
 
     if (shouldDrefNotDestory)
@@ -309,3 +366,124 @@ void CompilerOpcodes::pop2null(EmitContext& emitContext)
     else
         emitContext.currentBlock.getCurrentStack().pop2null();
 }
+
+CompilerOpcodes::CopyMethod CompilerOpcodes::getCopyMethod(uint size,
+                                                           uint inlineCopySize,
+                                                           uint wordSize,
+                                                           bool isCopyMemorySupported)
+{
+    if (size <= inlineCopySize)
+        return COPY_UNROLLED;
+    if (isCopyMemorySupported && ((size % wordSize) == 0))
+        return COPY_BLOCK;
+    return COPY_CALL;
+}
+
+uint CompilerOpcodes::getCopyTransactionSize(uint size)
+{
+    if (size >= 4)
+        return 4;
+    if (size >= 2)
+        return 2;
+    return 1;
+}
+
+bool CompilerOpcodes::inlineMemcpy(EmitContext& emitContext)
+{
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
+
+    // memcpy(destination, source, size)
+    if ((!ConstOpcodes::isConst32(stack.getArg(0))) ||
+        (stack.getArg(0).getConst().getConstValue() < 0))
+        return false;
+
+    uint size = stack.getArg(0).getConst().getConstValue();
+    CopyMethod method = getCopyMethod(size,
+                                      compiler.getInlineCopySize(),
+                                      compiler.getStackSize(),
+                                      compiler.isCopyMemorySupported());
+    if (method == COPY_CALL)
+        return false;
+
+    CompilerTrace("CompilerOpcodes::inlineMemcpy(): " << size << " bytes" << endl);
+
+    RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(1));
+    RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(2));
+    TemporaryStackHolderPtr source = stack.getArg(1).getStackHolderObject();
+    TemporaryStackHolderPtr destination = stack.getArg(2).getStackHolderObject();
+    stack.pop2null();
+    stack.pop2null();
+    stack.pop2null();
+
+    if (method == COPY_BLOCK)
+    {
+        compiler.copyMemory(destination->getTemporaryObject(),
+                            source->getTemporaryObject(),
+                            size);
+        return true;
+    }
+
+    TemporaryStackHolder temp(emitContext.currentBlock,
+                              ELEMENT_TYPE_I4,
+                              CompilerInterface::STACK_32,
+                              TemporaryStackHolder::TEMP_ONLY_REGISTER);
+    for (uint offset = 0; offset < size; )
+    {
+        uint transactionSize = getCopyTransactionSize(size - offset);
+        compiler.loadMemory(source->getTemporaryObject(),
+                            temp.getTemporaryObject(),
+                            offset,
+                            transactionSize);
+        compiler.storeMemory(destination->getTemporaryObject(),
+                             temp.getTemporaryObject(),
+                             offset,
+                             transactionSize);
+        offset+= transactionSize;
+    }
+    return true;
+}
+
+bool CompilerOpcodes::inlineMemset(EmitContext& emitContext)
+{
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
+
+    // memset(destination, value, size). Only constant values are handled,
+    // which covers the struct zeroing of 'initobj'
+    if ((!ConstOpcodes::isConst32(stack.getArg(0))) ||
+        (!ConstOpcodes::isConst32(stack.getArg(1))) ||
+        (stack.getArg(0).getConst().getConstValue() < 0))
+        return false;
+
+    uint size = stack.getArg(0).getConst().getConstValue();
+    if (size > compiler.getInlineCopySize())
+        return false;
+
+    CompilerTrace("CompilerOpcodes::inlineMemset(): " << size << " bytes" << endl);
+
+    // Replicate the byte into all the bytes of a word
+    uint32 value = (stack.getArg(1).getConst().getConstValue() & 0xFF) * 0x01010101;
+
+    RegisterEvaluatorOpcodes::evaluateInt32(emitContext, stack.getArg(2));
+    TemporaryStackHolderPtr destination = stack.getArg(2).getStackHolderObject();
+    stack.pop2null();
+    stack.pop2null();
+    stack.pop2null();
+
+    TemporaryStackHolder temp(emitContext.currentBlock,
+                              ELEMENT_TYPE_I4,
+                              CompilerInterface::STACK_32,
+                              TemporaryStackHolder::TEMP_ONLY_REGISTER);
+    compiler.loadInt32(temp.getTemporaryObject(), value);
+    for (uint offset = 0; offset < size; )
+    {
+        uint transactionSize = getCopyTransactionSize(size - offset);
+        compiler.storeMemory(destination->getTemporaryObject(),
+                             temp.getTemporaryObject(),
+                             offset,
+                             transactionSize);
+        offset+= transactionSize;
+    }
+    return true;
+}
@@ -69,6 +69,54 @@ public:
     // Pop an entity from the evaluation stack
     // If this entity is an object, and it was returned, and the object has no references - then destroy it
     static void pop2null(EmitContext& emitContext);
+
+    /*
+     * Called by CallingConvention::copyStruct/clearStruct before calling the
+     * framework memcpy and memset. If the size is a constant small enough
+     * (See CompilerInterface::getInlineCopySize) the operation is expanded
+     * into load/store operations and the arguments are popped from the stack.
+     * Larger memcpy of whole words are done by CompilerInterface::copyMemory,
+     * when the architecture implements it.
+     *
+     * NOTE: Both addresses must be aligned to a word, since whole words are
+     *       loaded and stored.
+     *
+     * Return true if the call was replaced.
+     */
+    static bool inlineMemcpy(EmitContext& emitContext);
+    static bool inlineMemset(EmitContext& emitContext);
+
+    /*
+     * The way a memcpy of a constant size is compiled. See getCopyMethod()
+     */
+    enum CopyMethod {
+        // Call the framework memcpy
+        COPY_CALL,
+        // A sequence of load/store transactions, see getCopyTransactionSize()
+        COPY_UNROLLED,
+        // A single CompilerInterface::copyMemory
+        COPY_BLOCK
+    };
+
+    /*
+     * Return how a memcpy of 'size' bytes is compiled.
+     *
+     * inlineCopySize - See CompilerInterface::getInlineCopySize
+     * wordSize - The stack size of the architecture
+     * isCopyMemorySupported - See CompilerInterface::isCopyMemorySupported
+     */
+    static CopyMethod getCopyMethod(uint size,
+                                    uint inlineCopySize,
+                                    uint wordSize,
+                                    bool isCopyMemorySupported);
+
+    /*
+     * Return the size of the next load/store transaction of an unrolled copy,
+     * when 'size' bytes are left. Words are copied first, then a half word
+     * and a byte, so every transaction of a block which starts aligned is
+     * aligned to its own size.
+     */
+    static uint getCopyTransactionSize(uint size);
 };
 
 #endif // __TBA_CLR_COMPILER_OPCODES_COMPILEROPCODES_H
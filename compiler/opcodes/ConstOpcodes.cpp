@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * ConstOpcodes.cpp
+ *
+ * Implementation file
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "compiler/stdafx.h"
+#include "data/ConstElements.h"
+#include "compiler/CompilerTrace.h"
+#include "compiler/opcodes/ConstOpcodes.h"
+
+bool ConstOpcodes::isConst32(const StackEntity& entity)
+{
+    if (entity.getType() != StackEntity::ENTITY_CONST)
+        return false;
+
+    // Only integers which are handled as 32 bit numbers
+    switch (entity.getElementType().getType())
+    {
+    case ELEMENT_TYPE_BOOLEAN:
+    case ELEMENT_TYPE_CHAR:
+    case ELEMENT_TYPE_I1:
+    case ELEMENT_TYPE_U1:
+    case ELEMENT_TYPE_I2:
+    case ELEMENT_TYPE_U2:
+    case ELEMENT_TYPE_I4:
+    case ELEMENT_TYPE_U4:
+    case ELEMENT_TYPE_I:
+    case ELEMENT_TYPE_U:
+        return !entity.getElementType().isPointer();
+    default:
+        return false;
+    }
+}
+
+bool ConstOpcodes::binary(EmitContext& emitContext,
+                          BinaryOpcodes::BinaryOperation operation)
+{
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+    if (!isConst32(stack.getArg(1)) || !isConst32(stack.getArg(0)))
+        return false;
+
+    int a = stack.getArg(1).getConst().getConstValue();
+    int b = stack.getArg(0).getConst().getConstValue();
+    int result;
+    if (!fold32(operation, a, b, result))
+        return false;
+
+    CompilerTrace("\t\tFolded constant " << HEXDWORD((uint32)a) << " op " << HEXDWORD((uint32)b) <<
+                  " = " << HEXDWORD((uint32)result) << endl);
+
+    // The result has the type of the first operand. See Bin32Opcodes::binary32
+    stack.pop2null();
+    stack.getArg(0).getConst().setConstValue(result);
+    return true;
+}
+
+bool ConstOpcodes::fold32(BinaryOpcodes::BinaryOperation operation,
+                          int a, int b,
+                          int& result)
+{
+    uint32 ua = (uint32)a;
+    uint32 ub = (uint32)b;
+
+    switch (operation)
+    {
+    case BinaryOpcodes::BIN_ADD: result = (int)(ua + ub); break;
+    case BinaryOpcodes::BIN_SUB: result = (int)(ua - ub); break;
+    case BinaryOpcodes::BIN_MUL: result = (int)(ua * ub); break;
+    case BinaryOpcodes::BIN_AND: result = (int)(ua & ub); break;
+    case BinaryOpcodes::BIN_OR:  result = (int)(ua | ub); break;
+    case BinaryOpcodes::BIN_XOR: result = (int)(ua ^ ub); break;
+    case BinaryOpcodes::BIN_SHL:
+    case BinaryOpcodes::BIN_SHR_UN:
+        // The result of an out of range shift depends on the processor
+        if (ub >= 32)
+            return false;
+        result = (int)((operation == BinaryOpcodes::BIN_SHL) ? (ua << ub) : (ua >> ub));
+        break;
+    case BinaryOpcodes::BIN_SHR:
+        if (ub >= 32)
+            return false;
+        // Arithmetic shift. The sign bits are shifted in, without relying on
+        // the host '>>' of a negative integer
+        result = (int)((a < 0) ? ~((~ua) >> ub) : (ua >> ub));
+        break;
+    case BinaryOpcodes::BIN_DIV:
+    case BinaryOpcodes::BIN_REM:
+        // Division by zero and overflow are raised at runtime
+        if ((b == 0) || ((b == -1) && (ua == 0x80000000)))
+            return false;
+        result = (operation == BinaryOpcodes::BIN_DIV) ? (a / b) : (a % b);
+        break;
+    case BinaryOpcodes::BIN_DIV_UN:
+    case BinaryOpcodes::BIN_REM_UN:
+        if (ub == 0)
+            return false;
+        result = (int)((operation == BinaryOpcodes::BIN_DIV_UN) ? (ua / ub) : (ua % ub));
+        break;
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+bool ConstOpcodes::compare(EmitContext& emitContext,
+                           BinaryOpcodes::ComparisonOperation operation)
+{
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+    if (!isConst32(stack.getArg(1)) || !isConst32(stack.getArg(0)))
+        return false;
+
+    int a = stack.getArg(1).getConst().getConstValue();
+    int b = stack.getArg(0).getConst().getConstValue();
+    bool result;
+    if (!compare32(operation, a, b, result))
+        return false;
+
+    stack.pop2null();
+    stack.getArg(0).getConst().setConstValue(result ? 1 : 0);
+    stack.getArg(0).setElementType(ConstElements::gBool);
+    return true;
+}
+
+bool ConstOpcodes::compare32(BinaryOpcodes::ComparisonOperation operation,
+                             int a, int b,
+                             bool& result)
+{
+    switch (operation)
+    {
+    case BinaryOpcodes::CMP_EQUAL:                 result = (a == b); break;
+    case BinaryOpcodes::CMP_GREATER_THEN:          result = (a > b); break;
+    case BinaryOpcodes::CMP_GREATER_THEN_UNSIGNED: result = ((uint32)a > (uint32)b); break;
+    case BinaryOpcodes::CMP_LESS_THEN:             result = (a < b); break;
+    case BinaryOpcodes::CMP_LESS_THEN_UNSIGNED:    result = ((uint32)a < (uint32)b); break;
+    default:
+        return false;
+    }
+    return true;
+}
+
+bool ConstOpcodes::convert(EmitContext& emitContext,
+                           CorElementType coreType)
+{
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+    if (!isConst32(stack.getArg(0)))
+        return false;
+
+    ElementType convType(coreType);
+    if (!convType.isIntegerType() && !convType.isUnsignedIntegerType())
+        return false;
+
+    uint size = emitContext.methodContext.getApartment()->getObjects().getTypedefRepository().getTypeSize(convType);
+    int value = stack.getArg(0).getConst().getConstValue();
+    bool signExtend = convType.isIntegerType();
+
+    // See CompilerInterface::conv32
+    switch (size)
+    {
+    case 1: value = signExtend ? (int)(int8)value : (int)(uint8)value; break;
+    case 2: value = signExtend ? (int)(int16)value : (int)(uint16)value; break;
+    case 4: break;
+    default:
+        // 64 bit conversions
+        return false;
+    }
+
+    stack.getArg(0).getConst().setConstValue(value);
+    stack.getArg(0).setElementType(convType);
+    return true;
+}
+
+bool ConstOpcodes::unary(EmitContext& emitContext,
+                         UnaryOperation operation)
+{
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+    if (!isConst32(stack.getArg(0)))
+        return false;
+
+    uint32 value = (uint32)stack.getArg(0).getConst().getConstValue();
+    switch (operation)
+    {
+    case UNARY_NEG: value = 0 - value; break;
+    case UNARY_NOT: value = ~value; break;
+    default:
+        return false;
+    }
+
+    stack.getArg(0).getConst().setConstValue((int)value);
+    return true;
+}
+
+bool ConstOpcodes::isConstCondition(const StackEntity& condition,
+                                    bool& isNonZero)
+{
+    if (!isConst32(condition))
+        return false;
+
+    isNonZero = (condition.getConst().getConstValue() != 0);
+    return true;
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_COMPILER_OPCODES_CONSTOPCODES_H
+#define __TBA_CLR_COMPILER_OPCODES_CONSTOPCODES_H
+
+/*
+ * ConstOpcodes.h
+ *
+ * Evaluates arithmetic, comparison and conversion operations over constant
+ * operands at compile time.
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "xStl/types.h"
+#include "compiler/StackEntity.h"
+#include "compiler/EmitContext.h"
+#include "compiler/opcodes/BinaryOpcodes.h"
+
+/*
+ * Constant folding over the evaluation stack. Each of the functions looks at
+ * the operands on top of the stack. If all of them are 32 bit integer
+ * constants (See StackEntity::ENTITY_CONST), the operands are replaced with
+ * the constant result and no code is generated. Otherwise, the stack is left
+ * untouched and the caller should emit the operation.
+ */
+class ConstOpcodes
+{
+public:
+    /*
+     * Return true if 'entity' is a constant which can be folded
+     */
+    static bool isConst32(const StackEntity& entity);
+
+    /*
+     * See BinaryOpcodes::binary.
+     *
+     * Return true if the operation was folded.
+     */
+    static bool binary(EmitContext& emitContext,
+                       BinaryOpcodes::BinaryOperation operation);
+
+    /*
+     * Evaluate 'a operation b' the way the generated 32 bit code does.
+     *
+     * result - Will be filled with the result
+     *
+     * Return false if the operation cannot be folded: an exception which
+     * should be raised at runtime, or a result which depends on the processor.
+     */
+    static bool fold32(BinaryOpcodes::BinaryOperation operation,
+                       int a, int b,
+                       int& result);
+
+    /*
+     * See BinaryOpcodes::compare.
+     *
+     * Return true if the operation was folded.
+     */
+    static bool compare(EmitContext& emitContext,
+                        BinaryOpcodes::ComparisonOperation operation);
+
+    /*
+     * Evaluate the comparison 'a operation b'.
+     *
+     * result - Will be filled with the result
+     *
+     * Return false if the comparison is unknown.
+     */
+    static bool compare32(BinaryOpcodes::ComparisonOperation operation,
+                          int a, int b,
+                          bool& result);
+
+    /*
+     * See BinaryOpcodes::convert.
+     *
+     * Return true if the operation was folded.
+     */
+    static bool convert(EmitContext& emitContext,
+                        CorElementType coreType);
+
+    // List for all unary operations
+    enum UnaryOperation
+    {
+        // Minus (-) operation
+        UNARY_NEG,
+        // Bitwise not (~) operation
+        UNARY_NOT
+    };
+
+    /*
+     * Perform neg/not over a constant.
+     *
+     * Return true if the operation was folded.
+     */
+    static bool unary(EmitContext& emitContext,
+                      UnaryOperation operation);
+
+    /*
+     * Test whether a branch condition is known at compile time.
+     *
+     * condition - The entity which is tested by brtrue/brfalse
+     * isNonZero - Will be filled with the value of the condition
+     *
+     * Return true if the condition is a constant.
+     */
+    static bool isConstCondition(const StackEntity& condition,
+                                 bool& isNonZero);
+};
+
+#endif // __TBA_CLR_COMPILER_OPCODES_CONSTOPCODES_H
@@ -45,6 +45,99 @@
 #include "compiler/opcodes/ObjectOpcodes.h"
 #include "compiler/opcodes/CompilerOpcodes.h"
 
+/*
+ * Push the address of the exception stack entry of the clause number
+ * 'clauseIndex'. The entry is reserved inside the method frame, see
+ * MethodRuntimeBoundle::m_clauseEntriesPosition
+ */
+static void pushClauseFrameEntry(EmitContext& emitContext, uint clauseIndex)
+{
+    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
+    uint entrySize = FrameworkMethods::EXCEPTION_ENTRY_WORDS * compiler.getStackSize();
+
+    TemporaryStackHolderPtr entryAddress(new TemporaryStackHolder(emitContext.currentBlock, ELEMENT_TYPE_PTR, compiler.getStackSize(), TemporaryStackHolder::TEMP_ONLY_REGISTER));
+    compiler.load32addr(emitContext.methodRuntime.m_clauseEntriesPosition + clauseIndex * entrySize,
+                        entrySize,
+                        0,
+                        entryAddress->getTemporaryObject());
+
+    StackEntity entry(StackEntity::ENTITY_REGISTER, ConstElements::gVoidPtr);
+    entry.setStackHolderObject(entryAddress);
+    emitContext.currentBlock.getCurrentStack().push(entry);
+}
+
+/*
+ * Register the handler of a protected block on the runtime exception stack,
+ * when entering the protected block
+ */
+static void registerProtectedBlock(EmitContext& emitContext,
+                                   const MethodHeader::ExceptionHandlingClause& clause,
+                                   uint clauseIndex,
+                                   const TokenIndex& handlerIndex,
+                                   bool isFrameEntry)
+{
+    if (clause.flags == MethodHeader::ClauseCatch)
+    {
+        // Determine the caught type's RTTI
+        uint rtti = ExceptionOpcodes::getCatchRTTI(emitContext.methodContext.getApartment(), clause);
+
+        // Param0 for registerFrameCatch is the entry
+        if (isFrameEntry)
+            pushClauseFrameEntry(emitContext, clauseIndex);
+
+        // Param1 for RegisterCatch is the RTTI of the class being caught
+        StackEntity type(StackEntity::ENTITY_CONST, ConstElements::gU2);
+        type.getConst().setConstValue(rtti);
+        emitContext.currentBlock.getCurrentStack().push(type);
+    }
+    else
+    {
+        // Param0 for registerFrameRoutine is the entry
+        if (isFrameEntry)
+            pushClauseFrameEntry(emitContext, clauseIndex);
+
+        // Param1 for registerRoutine is the type
+        StackEntity type(StackEntity::ENTITY_CONST, ConstElements::gU4);
+        type.getConst().setConstValue(FrameworkMethods::GetExceptionRoutineType(clause.flags));
+        emitContext.currentBlock.getCurrentStack().push(type);
+    }
+
+    // Param2 is the address of the cleanup function. store in a stack entity
+    StackEntity cleanupFunctionAddress(StackEntity::ENTITY_METHOD_ADDRESS, ConstElements::gVoidPtr);
+    cleanupFunctionAddress.getConst().setTokenIndex(handlerIndex);
+    emitContext.currentBlock.getCurrentStack().push(cleanupFunctionAddress);
+
+    // Param3 is the stack frame pointer. Load it onto a stack entity
+    TemporaryStackHolderPtr framePointer(new TemporaryStackHolder(emitContext.currentBlock, ELEMENT_TYPE_PTR, emitContext.methodRuntime.m_compiler->getStackSize(), TemporaryStackHolder::TEMP_ONLY_REGISTER));
+    emitContext.methodRuntime.m_compiler->setFramePointer(framePointer->getTemporaryObject());
+    StackEntity framePointerEntity(StackEntity::ENTITY_REGISTER, ConstElements::gVoidPtr);
+    framePointerEntity.setStackHolderObject(framePointer);
+    emitContext.currentBlock.getCurrentStack().push(framePointerEntity);
+
+    TokenIndex routine;
+    if (clause.flags == MethodHeader::ClauseCatch)
+    {
+        // Param4 for registerCatch is the stack-frame pointer (EBP) of the current function
+        StackEntity framePointer(StackEntity::ENTITY_REGISTER, ConstElements::gVoidPtr);
+        framePointer.setStackHolderObject(
+            TemporaryStackHolderPtr(new TemporaryStackHolder(
+                emitContext.currentBlock, emitContext.methodRuntime.getCompiler().getStackPointer())));
+        emitContext.currentBlock.getCurrentStack().push(framePointer);
+
+        if (isFrameEntry)
+            routine = emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getRegisterFrameCatch();
+        else
+            routine = emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getRegisterCatch();
+    }
+    else if (isFrameEntry)
+        routine = emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getRegisterFrameRoutine();
+    else
+        routine = emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getRegisterRoutine();
+
+    // Call clrRegisterRoutine
+    CallingConvention::call(emitContext, routine);
+}
+
 bool ExceptionOpcodes::implementLeave(EmitContext& emitContext, int instructionIndex, int targetIndex)
 {
     if (emitContext.currentBlock.getExceptionsStack().isEmpty())
@@ -67,9 +160,11 @@ bool ExceptionOpcodes::implementLeave(EmitContext& emitContext, int instructionI
             // (*i) is an excepion clause that we are leaving now.
 
             // pop the handler from the registered handler stack by calling pop()
-            // if it's a finally block - then execute too:
+            // if it's a finally block - then execute too. Nothing is registered
+            // with unwind data, so the finally handler is called directly
 
-            if (emitContext.methodRuntime.m_compiler->getCompilerParameters().m_bSupportExceptionHandling)
+            if (emitContext.methodRuntime.m_compiler->getCompilerParameters().m_bSupportExceptionHandling &&
+                !emitContext.methodRuntime.m_compiler->isUnwindDataSupported())
             {
                 TokenIndex routine;
                 if ((*i).getClause().flags == MethodHeader::ClauseFinally)
@@ -80,7 +175,7 @@ bool ExceptionOpcodes::implementLeave(EmitContext& emitContext, int instructionI
             }
             else
             {
-                // Only finally helpers are supported if exception handling is disabled. Others are ignored
+                // Only finally helpers are called directly. Others are ignored
                 if ((*i).getClause().flags == MethodHeader::ClauseFinally)
                 {
                     cString dependencyTokenName(CallingConvention::serializedMethod((*i).getHandlerTokenIndex()));
@@ -184,7 +279,10 @@ void ExceptionOpcodes::enterProtectedBlock(EmitContext& emitContext, uint index,
 {
     // Search all method's clauses for ones that starts on this index
     const MethodHeader::ExceptionHandlingClauseList& exceptions = emitContext.methodContext.getMethodHeader().getExceptionsHandlers();
-    for (MethodHeader::ExceptionHandlingClauseList::iterator i = exceptions.begin(); i != exceptions.end(); i++)
+    // Helpers don't have the entries in their frame, see MethodRuntimeBoundle
+    bool isFrameEntry = emitContext.methodRuntime.m_clauseEntriesPosition != MAX_UINT32;
+    uint clauseIndex = 0;
+    for (MethodHeader::ExceptionHandlingClauseList::iterator i = exceptions.begin(); i != exceptions.end(); i++, clauseIndex++)
     {
         const MethodHeader::ExceptionHandlingClause& clause = (*i);
         // Are we just entering this protected block?
@@ -216,56 +314,14 @@ void ExceptionOpcodes::enterProtectedBlock(EmitContext& emitContext, uint index,
                     MethodBlock* newBlock = emitContext.currentBlock.duplicate(emitContext, t_max(afterTry, afterHandler));
                     emitContext.methodRuntime.m_blockStack.add(StackInterfacePtr(newBlock));
 
-                    // Determine the caught type's RTTI
-                    ElementType catchType = ElementType(ELEMENT_TYPE_CLASS, 0, false, false, false,
-                        buildTokenIndex(emitContext.methodContext.getApartment()->getUniqueID(), clause.classTokenOrFilterOffset));
-                    emitContext.methodContext.getApartment()->getObjects().getTypedefRepository().resolveTyperef(catchType);
-                    uint rtti = emitContext.methodContext.getApartment()->getObjects().getTypedefRepository().getRTTI(catchType.getClassToken());
-
-                    // Param1 for RegisterCatch is the RTTI of the class being caught
-                    StackEntity type(StackEntity::ENTITY_CONST, ConstElements::gU2);
-                    type.getConst().setConstValue(rtti);
-                    emitContext.currentBlock.getCurrentStack().push(type);
-
                     emitContext.methodRuntime.m_bHasCatch = true;
                 }
-                else
-                {
-                    // Param1 for registerRoutine is the type
-                    StackEntity type(StackEntity::ENTITY_CONST, ConstElements::gU4);
-                    type.getConst().setConstValue(FrameworkMethods::GetExceptionRoutineType(clause.flags));
-                    emitContext.currentBlock.getCurrentStack().push(type);
-                }
-
-                // Param2 is the address of the cleanup function. store in a stack entity
-                StackEntity cleanupFunctionAddress(StackEntity::ENTITY_METHOD_ADDRESS, ConstElements::gVoidPtr);
-                cleanupFunctionAddress.getConst().setTokenIndex(exceptionEntry.getHandlerTokenIndex());
-                emitContext.currentBlock.getCurrentStack().push(cleanupFunctionAddress);
-
-                // Param3 is the stack frame pointer. Load it onto a stack entity
-                TemporaryStackHolderPtr framePointer(new TemporaryStackHolder(emitContext.currentBlock, ELEMENT_TYPE_PTR, emitContext.methodRuntime.m_compiler->getStackSize(), TemporaryStackHolder::TEMP_ONLY_REGISTER));
-                emitContext.methodRuntime.m_compiler->setFramePointer(framePointer->getTemporaryObject());
-                StackEntity framePointerEntity(StackEntity::ENTITY_REGISTER, ConstElements::gVoidPtr);
-                framePointerEntity.setStackHolderObject(framePointer);
-                emitContext.currentBlock.getCurrentStack().push(framePointerEntity);
 
-                TokenIndex routine;
-                if (clause.flags == MethodHeader::ClauseCatch)
-                {
-                    // Param4 for registerCatch is the stack-frame pointer (EBP) of the current function
-                    StackEntity framePointer(StackEntity::ENTITY_REGISTER, ConstElements::gVoidPtr);
-                    framePointer.setStackHolderObject(
-                        TemporaryStackHolderPtr(new TemporaryStackHolder(
-                            emitContext.currentBlock, emitContext.methodRuntime.getCompiler().getStackPointer())));
-                    emitContext.currentBlock.getCurrentStack().push(framePointer);
-
-                    routine = emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getRegisterCatch();
-                }
-                else
-                    routine = emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getRegisterRoutine();
-
-                // Call clrRegisterRoutine
-                CallingConvention::call(emitContext, routine);
+                // Processors with unwind data don't register anything. The
+                // protected block is described by
+                // MethodCompiler::methodGenerateUnwindData instead
+                if (!emitContext.methodRuntime.getCompiler().isUnwindDataSupported())
+                    registerProtectedBlock(emitContext, clause, clauseIndex, exceptionEntry.getHandlerTokenIndex(), isFrameEntry);
             }
 
             // Remember this protected block on the exception stack for now
@@ -279,6 +335,15 @@ void ExceptionOpcodes::enterProtectedBlock(EmitContext& emitContext, uint index,
     }
 }
 
+uint ExceptionOpcodes::getCatchRTTI(const ApartmentPtr& apartment,
+                                    const MethodHeader::ExceptionHandlingClause& clause)
+{
+    ElementType catchType = ElementType(ELEMENT_TYPE_CLASS, 0, false, false, false,
+        buildTokenIndex(apartment->getUniqueID(), clause.classTokenOrFilterOffset));
+    apartment->getObjects().getTypedefRepository().resolveTyperef(catchType);
+    return apartment->getObjects().getTypedefRepository().getRTTI(catchType.getClassToken());
+}
+
 MethodHelper::MethodHelper(const MethodBlock::ExceptionEntry& entry, MethodHelper* parent) :
     MethodBlock::ExceptionEntry(entry),
     m_parent(parent),
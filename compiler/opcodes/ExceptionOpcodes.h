@@ -92,6 +92,14 @@ public:
                                     uint instructionIndex,
                                     MethodHelperList& helpers);
 
+    /*
+     * Return the RTTI of the class which is caught by a catch clause
+     * apartment - The apartment of the method
+     * clause - The catch clause
+     */
+    static uint getCatchRTTI(const ApartmentPtr& apartment,
+                             const MethodHeader::ExceptionHandlingClause& clause);
+
 };
 
 // A class that describes a method's helper function
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * LoopOpcodes.cpp
+ *
+ * Implementation file
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "compiler/stdafx.h"
+#include "data/ConstElements.h"
+#include "compiler/CompilerTrace.h"
+#include "compiler/CallingConvention.h"
+#include "compiler/MethodLoops.h"
+#include "compiler/TemporaryStackHolder.h"
+#include "compiler/opcodes/LoopOpcodes.h"
+
+void LoopOpcodes::enterLoop(EmitContext& emitContext, uint source, uint target)
+{
+    // Helpers are compiled as different functions, without the loop slots
+    const MethodLoops* loops = emitContext.methodRuntime.m_loops;
+    if ((loops == NULL) || (emitContext.pCurrentHelper != NULL) ||
+        (!loops->isLoopEntry(target, source)))
+        return;
+
+    Stack& stack = emitContext.currentBlock.getCurrentStack();
+    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
+    const LocalPositions& locals = emitContext.methodRuntime.m_locals;
+    const ArgumentsPositions& args = emitContext.methodRuntime.m_args;
+
+    for (MethodLoops::CursorList::iterator i = loops->getCursors().begin();
+         i != loops->getCursors().end();
+         i++)
+    {
+        const MethodLoops::Cursor& cursor = *i;
+        if ((cursor.m_header != target) || (cursor.m_position == MAX_UINT32))
+            continue;
+
+        CompilerTrace("Loop " << HEXDWORD(target) << ": cursor of " <<
+                      (cursor.m_isArgument ? "arg " : "local ") << cursor.m_array <<
+                      " by local " << cursor.m_inductionVariable << endl);
+
+        // Push the arguments compilerGetArrayCursor(Array arr, uint index, uint sizeofElements)
+        StackEntity array(cursor.m_isArgument ? StackEntity::ENTITY_ARGUMENT : StackEntity::ENTITY_LOCAL,
+                          cursor.m_isArgument ? args.getArgumentStackVariableType(cursor.m_array) :
+                                                locals.getLocalStackVariableType(cursor.m_array));
+        array.getConst().setLocalOrArgValue(cursor.m_array);
+        stack.push(array);
+
+        StackEntity index(StackEntity::ENTITY_LOCAL, locals.getLocalStackVariableType(cursor.m_inductionVariable));
+        index.getConst().setLocalOrArgValue(cursor.m_inductionVariable);
+        stack.push(index);
+
+        StackEntity sizeofElement(StackEntity::ENTITY_CONST, ConstElements::gU);
+        sizeofElement.getConst().setConstValue(cursor.m_elementSize);
+        stack.push(sizeofElement);
+
+        CallingConvention::call(emitContext,
+                                emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getArrayCursor());
+
+        // Keep the address in the frame
+        compiler.store32(cursor.m_position,
+                         compiler.getStackSize(),
+                         stack.peek().getStackHolderObject()->getTemporaryObject());
+        stack.pop2null();
+    }
+}
+
+void LoopOpcodes::storeLocal(EmitContext& emitContext, uint offset, uint local)
+{
+    const MethodLoops* loops = emitContext.methodRuntime.m_loops;
+    int step;
+    if ((loops == NULL) || (emitContext.pCurrentHelper != NULL) ||
+        (!loops->getInductionStep(offset, step)))
+        return;
+
+    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
+    for (MethodLoops::CursorList::iterator i = loops->getCursors().begin();
+         i != loops->getCursors().end();
+         i++)
+    {
+        const MethodLoops::Cursor& cursor = *i;
+        if ((cursor.m_position == MAX_UINT32) ||
+            (cursor.m_inductionVariable != local) ||
+            (!loops->isInLoop(cursor.m_header, offset)))
+            continue;
+
+        // cursor+= step * sizeof(element)
+        TemporaryStackHolder address(emitContext.currentBlock,
+                                     ELEMENT_TYPE_PTR,
+                                     compiler.getStackSize(),
+                                     TemporaryStackHolder::TEMP_ONLY_REGISTER);
+        compiler.load32(cursor.m_position, compiler.getStackSize(), address.getTemporaryObject());
+        compiler.addConst32(address.getTemporaryObject(), step * (int)cursor.m_elementSize);
+        compiler.store32(cursor.m_position, compiler.getStackSize(), address.getTemporaryObject());
+    }
+}
+
+bool LoopOpcodes::loadElementAddress(EmitContext& emitContext,
+                                     StackEntity& arr,
+                                     StackEntity& index,
+                                     uint sizeofElement)
+{
+    const MethodLoops* loops = emitContext.methodRuntime.m_loops;
+    if ((loops == NULL) || (emitContext.pCurrentHelper != NULL))
+        return false;
+
+    // Only variables which weren't evaluated yet are known to the analysis
+    if (((arr.getType() != StackEntity::ENTITY_LOCAL) &&
+         (arr.getType() != StackEntity::ENTITY_ARGUMENT)) ||
+        (index.getType() != StackEntity::ENTITY_LOCAL))
+        return false;
+
+    bool isArgument = arr.getType() == StackEntity::ENTITY_ARGUMENT;
+    uint array = (uint)arr.getConst().getLocalOrArgValue();
+    uint inductionVariable = (uint)index.getConst().getLocalOrArgValue();
+    uint block = (uint)emitContext.currentBlock.getBlockID();
+    CompilerInterface& compiler = *emitContext.methodRuntime.m_compiler;
+
+    for (MethodLoops::CursorList::iterator i = loops->getCursors().begin();
+         i != loops->getCursors().end();
+         i++)
+    {
+        const MethodLoops::Cursor& cursor = *i;
+        if ((cursor.m_position == MAX_UINT32) ||
+            (cursor.m_isArgument != isArgument) ||
+            (cursor.m_array != array) ||
+            (cursor.m_inductionVariable != inductionVariable) ||
+            (cursor.m_elementSize != sizeofElement) ||
+            (!loops->isInLoop(cursor.m_header, block)))
+            continue;
+
+        TemporaryStackHolderPtr address(new TemporaryStackHolder(emitContext.currentBlock,
+                                                                 ELEMENT_TYPE_PTR,
+                                                                 compiler.getStackSize(),
+                                                                 TemporaryStackHolder::TEMP_ONLY_REGISTER));
+        compiler.load32(cursor.m_position, compiler.getStackSize(), address->getTemporaryObject());
+
+        arr = StackEntity();
+        index = StackEntity();
+
+        StackEntity entity(StackEntity::ENTITY_REGISTER, ConstElements::gBytePtr);
+        entity.setStackHolderObject(address);
+        emitContext.currentBlock.getCurrentStack().push(entity);
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_COMPILER_OPCODES_LOOPOPCODES_H
+#define __TBA_CLR_COMPILER_OPCODES_LOOPOPCODES_H
+
+/*
+ * LoopOpcodes.h
+ *
+ * Generate the code of the array cursors of loops. See MethodLoops
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "xStl/types.h"
+#include "compiler/StackEntity.h"
+#include "compiler/EmitContext.h"
+
+class LoopOpcodes
+{
+public:
+    /*
+     * Calculate the cursors of a loop when the loop is entered. Called at the
+     * end of the entering block, before the block is terminated. Nothing is
+     * generated if 'source' doesn't enter a loop.
+     *
+     * emitContext - Method context. See EmitContext
+     * source      - The offset of the last instruction of the block, either a
+     *               'br' or the instruction which is followed by 'target'
+     * target      - The offset of the next block
+     */
+    static void enterLoop(EmitContext& emitContext, uint source, uint target);
+
+    /*
+     * Move the cursors of an induction variable after a store into it.
+     *
+     * emitContext - Method context. See EmitContext
+     * offset      - The offset of the 'stloc' instruction
+     * local       - The index of the stored local
+     */
+    static void storeLocal(EmitContext& emitContext, uint offset, uint local);
+
+    /*
+     * Load the address of an array element from a cursor of the current loop,
+     * instead of calculating it. On success 'arr' and 'index' are cleared and
+     * the address register is pushed onto the stack.
+     *
+     * emitContext   - Method context. See EmitContext
+     * arr           - The array entry of the evaluation stack
+     * index         - The index entry of the evaluation stack
+     * sizeofElement - The size of an element of the array
+     *
+     * Return false if there is no such cursor and no code was generated.
+     */
+    static bool loadElementAddress(EmitContext& emitContext,
+                                   StackEntity& arr,
+                                   StackEntity& index,
+                                   uint sizeofElement);
+};
+
+#endif // __TBA_CLR_COMPILER_OPCODES_LOOPOPCODES_H
@@ -599,8 +599,7 @@ void RegisterEvaluatorOpcodes::storeVar(EmitContext& emitContext,
             stack.push(sizeEntity);
 
             // Add a "call" instruction to memcpy
-            CallingConvention::call(emitContext,
-                                    emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getMemcpy());
+            CallingConvention::copyStruct(emitContext);
         }
         break;
 
@@ -650,7 +649,7 @@ void RegisterEvaluatorOpcodes::loadReturnedValue(EmitContext& emitContext)
         stack.push(sizeEntity);
 
         //call memcpy
-        CallingConvention::call(emitContext, emitContext.methodContext.getApartment()->getObjects().getFrameworkMethods().getMemcpy());
+        CallingConvention::copyStruct(emitContext);
     }
     else
     {
@@ -40,6 +40,19 @@
 #include "compiler/StackEntity.h"
 #include "runnable/FrameworkMethods.h"
 
+/*
+ * Translation of CompilerInterface::CompareCondition into ARM condition codes.
+ * Indexed by [condition][isSigned]
+ */
+static const uint8 gCompareConditions[][2] = {
+    {0x0, 0x0},  // EQ, EQ
+    {0x1, 0x1},  // NE, NE
+    {0x8, 0xC},  // HI, GT
+    {0x2, 0xA},  // HS, GE
+    {0x3, 0xB},  // LO, LT
+    {0x9, 0xD}   // LS, LE
+};
+
 char* gARMRegisters[16] = {
     "r0",
     "r1",
@@ -81,6 +94,7 @@ ARMCompilerInterface::ARMCompilerInterface(const FrameworkMethods& framework, co
     //setBaseStackRegister(getStackPointer());
     m_nonVolSize = 0;
     m_stackRef = 0;
+    m_registerEntryCount = 0;
     m_binary = FirstPassBinaryPtr(new FirstPassBinary(
                                       OpcodeSubsystems::DISASSEMBLER_ARM_32_LE,
                                       false));
@@ -263,26 +277,7 @@ void ARMCompilerInterface::store32(StackLocation source,
                                    bool signExtend,
                                    const cString& dependencyName)
 {
-    int currentBlockID = m_binary->getCurrentBlockID();
-    int newImmediateBlockId = m_binary->getCurrentDependecies().getExtraBlocks() + MethodBlock::BLOCK_EXTRA_DATA;
-
-    MethodBlock* immBlock = new MethodBlock(newImmediateBlockId, *this);
-    StackInterfacePtr pstack(immBlock);
-    m_binary->createNewBlockWithoutChange(immBlock->getBlockID(), pstack);
-    m_binary->changeBasicBlock(immBlock->getBlockID());
-
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->getCurrentDependecies().addDependency(
-        dependencyName,
-        m_binary->getCurrentBlockData().getSize() - 4,
-        BinaryDependencies::DEP_32BIT,
-        BinaryDependencies::DEP_ABSOLUTE);
-
-    immBlock->terminateMethodBlock(NULL, MethodBlock::COND_NON, 0);
-    m_binary->changeBasicBlock(currentBlockID);
+    int newImmediateBlockId = getAddressLiteral(dependencyName);
 
     StackLocation rTemp = m_binary->getCurrentStack()->allocateTemporaryRegister();
 
@@ -314,6 +309,16 @@ void ARMCompilerInterface::move32(StackLocation destination,
                                   uint size,
                                   bool signExtend)
 {
+    // TODO! Sign/zero extension of bytes and words
+    CHECK(size == getStackSize());
+
+    /*
+     * MOV Rd, Rm;
+     */
+    m_binary->appendUint8(getGPEncoding(source.u.reg));
+    m_binary->appendUint8(getGPEncoding(destination.u.reg) << 4);
+    m_binary->appendUint8(0xA0);
+    m_binary->appendUint8(0xE1);
 }
 
 void ARMCompilerInterface::load32(uint stackPosition,
@@ -571,6 +576,59 @@ int ARMCompilerInterface::nlz(unsigned x)
     return n - (x >> 31);
 }
 
+int ARMCompilerInterface::getConstantLiteral(uint32 value)
+{
+    // Reuse the pool entry if the constant was already emitted by this method
+    if (m_constantLiterals.hasKey((int)value))
+        return m_constantLiterals[(int)value];
+
+    int currentBlockID = m_binary->getCurrentBlockID();
+    int newImmediateBlockId = m_binary->getCurrentDependecies().getExtraBlocks() + MethodBlock::BLOCK_EXTRA_DATA;
+
+    MethodBlock* immBlock = new MethodBlock(newImmediateBlockId, *this);
+    StackInterfacePtr pstack(immBlock);
+    m_binary->createNewBlockWithoutChange(immBlock->getBlockID(), pstack);
+    m_binary->changeBasicBlock(immBlock->getBlockID());
+
+    m_binary->appendBuffer((uint8 *)&value, sizeof(value));
+    immBlock->terminateMethodBlock(NULL, MethodBlock::COND_NON, 0);
+    m_binary->changeBasicBlock(currentBlockID);
+
+    m_constantLiterals.append((int)value, newImmediateBlockId);
+    return newImmediateBlockId;
+}
+
+int ARMCompilerInterface::getAddressLiteral(const cString& dependencyName)
+{
+    // Reuse the pool entry if the relocation target was already emitted
+    if (m_addressLiterals.hasKey(dependencyName))
+        return m_addressLiterals[dependencyName];
+
+    int currentBlockID = m_binary->getCurrentBlockID();
+    int newImmediateBlockId = m_binary->getCurrentDependecies().getExtraBlocks() + MethodBlock::BLOCK_EXTRA_DATA;
+
+    MethodBlock* immBlock = new MethodBlock(newImmediateBlockId, *this);
+    StackInterfacePtr pstack(immBlock);
+    m_binary->createNewBlockWithoutChange(immBlock->getBlockID(), pstack);
+    m_binary->changeBasicBlock(immBlock->getBlockID());
+
+    m_binary->appendUint8(0x00);
+    m_binary->appendUint8(0x00);
+    m_binary->appendUint8(0x00);
+    m_binary->appendUint8(0x00);
+    m_binary->getCurrentDependecies().addDependency(
+        dependencyName,
+        m_binary->getCurrentBlockData().getSize() - 4,
+        BinaryDependencies::DEP_32BIT,
+        BinaryDependencies::DEP_ABSOLUTE);
+
+    immBlock->terminateMethodBlock(NULL, MethodBlock::COND_NON, 0);
+    m_binary->changeBasicBlock(currentBlockID);
+
+    m_addressLiterals.append(dependencyName, newImmediateBlockId);
+    return newImmediateBlockId;
+}
+
 void ARMCompilerInterface::loadInt32(StackLocation destination, uint32 value)
 {
     int lead = nlz(value);
@@ -602,17 +660,22 @@ void ARMCompilerInterface::loadInt32(StackLocation destination, uint32 value)
             m_binary->appendUint8(0xE3);
         } else
         {
-            int currentBlockID = m_binary->getCurrentBlockID();
-            int newImmediateBlockId = m_binary->getCurrentDependecies().getExtraBlocks() + MethodBlock::BLOCK_EXTRA_DATA;
-
-            MethodBlock* immBlock = new MethodBlock(newImmediateBlockId, *this);
-            StackInterfacePtr pstack(immBlock);
-            m_binary->createNewBlockWithoutChange(immBlock->getBlockID(), pstack);
-            m_binary->changeBasicBlock(immBlock->getBlockID());
+            uint32 inverted = ~value;
+            int invertedLead = nlz(inverted);
+            int invertedTrail = (inverted == 0) ? 0 : ntz(inverted);
+            invertedTrail -= invertedTrail & (~0xfffffffe);
+            if ((32 - invertedLead - invertedTrail) <= 8)
+            {
+                inverted >>= invertedTrail;
+                // MVN Rd, #~value;
+                m_binary->appendUint8(inverted & 0xFF);
+                m_binary->appendUint8((getGPEncoding(destination.u.reg) << 4) + ((0x10 - (invertedTrail / 2)) & 0x0F));
+                m_binary->appendUint8(0xE0);
+                m_binary->appendUint8(0xE3);
+                return;
+            }
 
-            m_binary->appendBuffer((uint8 *)&value, sizeof(value));
-            immBlock->terminateMethodBlock(NULL, MethodBlock::COND_NON, 0);
-            m_binary->changeBasicBlock(currentBlockID);
+            int newImmediateBlockId = getConstantLiteral(value);
 
             uint stackPosition = -8 + getFrameStackRef();
             /*
@@ -640,26 +703,7 @@ void ARMCompilerInterface::loadInt32(StackLocation destination, uint32 value)
 void ARMCompilerInterface::loadInt32(StackLocation destination,
                                      const cString& dependancyName)
 {
-    int currentBlockID = m_binary->getCurrentBlockID();
-    int newImmediateBlockId = m_binary->getCurrentDependecies().getExtraBlocks() + MethodBlock::BLOCK_EXTRA_DATA;
-
-    MethodBlock* immBlock = new MethodBlock(newImmediateBlockId, *this);
-    StackInterfacePtr pstack(immBlock);
-    m_binary->createNewBlockWithoutChange(immBlock->getBlockID(), pstack);
-    m_binary->changeBasicBlock(immBlock->getBlockID());
-
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->getCurrentDependecies().addDependency(
-        dependancyName,
-        m_binary->getCurrentBlockData().getSize() - 4,
-        BinaryDependencies::DEP_32BIT,
-        BinaryDependencies::DEP_ABSOLUTE);
-
-    immBlock->terminateMethodBlock(NULL, MethodBlock::COND_NON, 0);
-    m_binary->changeBasicBlock(currentBlockID);
+    int newImmediateBlockId = getAddressLiteral(dependancyName);
 
     /*
      * LDR Rd, [PC, #offset];
@@ -725,6 +769,24 @@ void ARMCompilerInterface::pushArg32(StackLocation source)
     m_stackRef += 4;
 }
 
+void ARMCompilerInterface::pushArgConst32(int32 value)
+{
+    // There is no push immediate, go through a temporary register
+    StackLocation rTemp = m_binary->getCurrentStack()->allocateTemporaryRegister();
+    loadInt32(rTemp, (uint32)value);
+    pushArg32(rTemp);
+    m_binary->getCurrentStack()->freeTemporaryRegister(rTemp);
+}
+
+void ARMCompilerInterface::pushArgStack32(uint stackPosition, bool argumentStackLocation)
+{
+    // There is no push from memory, go through a temporary register
+    StackLocation rTemp = m_binary->getCurrentStack()->allocateTemporaryRegister();
+    load32(stackPosition, 4, rTemp, false, argumentStackLocation);
+    pushArg32(rTemp);
+    m_binary->getCurrentStack()->freeTemporaryRegister(rTemp);
+}
+
 void ARMCompilerInterface::popArg32(StackLocation source)
 {
     StackLocation rTemp = source;
@@ -863,6 +925,38 @@ void ARMCompilerInterface::call32(StackLocation address, StackLocation destinati
     }
 }
 
+uint ARMCompilerInterface::getArgumentRegistersCount() const
+{
+    return 4;
+}
+
+StackLocation ARMCompilerInterface::getArgumentRegister(uint index) const
+{
+    CHECK(index < getArgumentRegistersCount());
+    return StackInterface::buildStackLocation(getGPEncoding(ARM_GP32_R0 + index), 0);
+}
+
+void ARMCompilerInterface::pushArgRegisters32(uint count)
+{
+    if (count == 0)
+        return;
+
+    /*
+     * SUB SP, SP, #count*4;
+     */
+    m_binary->appendUint8(count * 4);
+    m_binary->appendUint8(0xD0);
+    m_binary->appendUint8(0x4D);
+    m_binary->appendUint8(0xE2);
+    m_stackRef += count * 4;
+}
+
+void ARMCompilerInterface::setRegisterEntry(uint count)
+{
+    CHECK(count <= getArgumentRegistersCount());
+    m_registerEntryCount = count;
+}
+
 void ARMCompilerInterface::storeMemory(StackLocation destination,
                                        StackLocation value,
                                        uint offset,
@@ -1116,6 +1210,18 @@ void ARMCompilerInterface::shr32(StackLocation destination,
     m_binary->appendUint8(0xE1);
 }
 
+void ARMCompilerInterface::sar32(StackLocation destination,
+                                 StackLocation source)
+{
+    /*
+     * MOV Rd, Rd, ASR Rn;
+     */
+    m_binary->appendUint8((5 << 4) + getGPEncoding(destination.u.reg));
+    m_binary->appendUint8((getGPEncoding(destination.u.reg) << 4) + getGPEncoding(source.u.reg));
+    m_binary->appendUint8(0xA0);
+    m_binary->appendUint8(0xE1);
+}
+
 void ARMCompilerInterface::shl32(StackLocation destination,
                                  StackLocation source)
 {
@@ -1235,6 +1341,49 @@ void ARMCompilerInterface::jumpCondShort(StackLocation compare,
     }
 }
 
+void ARMCompilerInterface::jumpCompare(StackLocation first,
+                                       StackLocation second,
+                                       CompareCondition condition,
+                                       bool isSigned,
+                                       int blockID)
+{
+    jumpCompareShort(first, second, condition, isSigned, blockID);
+}
+
+void ARMCompilerInterface::jumpCompareShort(StackLocation first,
+                                            StackLocation second,
+                                            CompareCondition condition,
+                                            bool isSigned,
+                                            int blockID)
+{
+    /*
+     * CMP    Rd, Rn;
+     */
+    m_binary->appendUint8(getGPEncoding(second.u.reg));
+    m_binary->appendUint8(0x00);
+    m_binary->appendUint8((5 << 4) + getGPEncoding(first.u.reg));
+    m_binary->appendUint8(0xE1);
+
+    /*
+     * The address part of Bcc
+     */
+    m_binary->appendUint8(0xFE);
+    m_binary->appendUint8(0xFF);
+    m_binary->appendUint8(0xFF);
+    // Add dependency to the last byte
+    m_binary->getCurrentDependecies().addDependency(MangledNames::getMangleBlock(blockID, 3, BinaryDependencies::DEP_RELATIVE),
+        m_binary->getCurrentBlockData().getSize() - 3,
+        BinaryDependencies::DEP_24BIT,
+        BinaryDependencies::DEP_RELATIVE,
+        2,
+        true);
+
+    /*
+     * Bcc    blockID
+     */
+    m_binary->appendUint8((gCompareConditions[condition][isSigned ? 1 : 0] << 4) + 0x0A);
+}
+
 void ARMCompilerInterface::ceq32(StackLocation destination,
                                  StackLocation source)
 {
@@ -1390,6 +1539,28 @@ void ARMCompilerInterface::generateMethodEpiProLogs(bool bForceSaveNonVolatiles
     m_binary->createNewBlockWithoutChange(MethodBlock::BLOCK_PROLOG, estack);
     m_binary->changeBasicBlock(MethodBlock::BLOCK_PROLOG);
 
+    if (m_registerEntryCount > 0)
+    {
+        /*
+         * The stack entry jumps over the register entry, at REGISTER_ENTRY_OFFSET:
+         * B     prolog
+         * STR   Ri, [SP, #4*i]; For each argument register
+         *
+         * The arguments slots were reserved by the caller. See pushArgRegisters32
+         */
+        m_binary->appendUint8(m_registerEntryCount - 1);
+        m_binary->appendUint8(0x00);
+        m_binary->appendUint8(0x00);
+        m_binary->appendUint8(0xEA);
+        for (uint i = 0; i < m_registerEntryCount; i++)
+        {
+            m_binary->appendUint8(i * 4);
+            m_binary->appendUint8((ARM_GP32_R0 + i) << 4);
+            m_binary->appendUint8(0x8D);
+            m_binary->appendUint8(0xE5);
+        }
+    }
+
     pushArg32(m_binary->getCurrentStack()->buildStackLocation(getGPEncoding(ARM_GP32_LR), 0));
     m_stackRef -= 4;
     // Revert stackRef since this push is not a part of the function logic
@@ -1640,7 +1811,18 @@ void ARMCompilerInterface::sbb32(StackLocation destination, StackLocation source
 
 void ARMCompilerInterface::mul32h(StackLocation destlow, StackLocation desthigh, StackLocation source, bool sign)
 {
+    /*
+     * SMULL/UMULL RdLo, RdHi, RdLo, Rm;
+     */
+    m_binary->appendUint8(0x90 + getGPEncoding(destlow.u.reg));
+    m_binary->appendUint8((getGPEncoding(destlow.u.reg) << 4) + getGPEncoding(source.u.reg));
+    m_binary->appendUint8((sign ? 0xC0 : 0x80) + getGPEncoding(desthigh.u.reg));
+    m_binary->appendUint8(0xE0);
+}
 
+bool ARMCompilerInterface::isMultiplyHighSupported() const
+{
+    return true;
 }
 
 void ARMCompilerInterface::mov(StackLocation destination, StackLocation source)
@@ -38,6 +38,7 @@
  * Native Compiler for x86 machine.
  */
 #include "xStl/types.h"
+#include "xStl/data/hash.h"
 #include "compiler/CompilerInterface.h"
 #include "dismount/assembler/AssemblerInterface.h"
 
@@ -127,6 +128,10 @@ public:
     virtual void assignRet32(StackLocation source);
     // See CompilerInterface::pushArg32
     virtual void pushArg32(StackLocation source);
+    // See CompilerInterface::pushArgConst32
+    virtual void pushArgConst32(int32 value);
+    // See CompilerInterface::pushArgStack32
+    virtual void pushArgStack32(uint stackPosition, bool argumentStackLocation);
     // See CompilerInterface::popArg32
     virtual void popArg32(StackLocation source);
     // See CompilerInterface::call
@@ -137,6 +142,14 @@ public:
                         StackLocation destination, uint numberOfArguments);
     virtual void call32(StackLocation address,
                         StackLocation destination, uint numberOfArguments);
+    // See CompilerInterface::getArgumentRegistersCount. R0-R3
+    virtual uint getArgumentRegistersCount() const;
+    // See CompilerInterface::getArgumentRegister
+    virtual StackLocation getArgumentRegister(uint index) const;
+    // See CompilerInterface::pushArgRegisters32. SUB SP, SP, #4*count
+    virtual void pushArgRegisters32(uint count);
+    // See CompilerInterface::setRegisterEntry
+    virtual void setRegisterEntry(uint count);
     //////////////////////////////////////////////////////////////////////////
     // Memory handling
 
@@ -173,6 +186,7 @@ public:
     virtual void and32(StackLocation destination, StackLocation source);
     virtual void xor32(StackLocation destination, StackLocation source);
     virtual void shr32(StackLocation destination, StackLocation source);
+    virtual void sar32(StackLocation destination, StackLocation source);
     virtual void shl32(StackLocation destination, StackLocation source);
     virtual void or32 (StackLocation destination, StackLocation source);
 
@@ -186,6 +200,7 @@ public:
     virtual void adc32 (StackLocation destination, StackLocation source);
     virtual void sbb32 (StackLocation destination, StackLocation source);
     virtual void mul32h(StackLocation destlow,     StackLocation desthigh, StackLocation source, bool sign);
+    virtual bool isMultiplyHighSupported() const;
 
     // See CompilerInterface::addConst32
     virtual void addConst32(const StackLocation destination,
@@ -202,6 +217,14 @@ public:
     virtual void jumpCond(StackLocation compare, int blockID, bool isZero);
     virtual void jumpCondShort(StackLocation compare, int blockID, bool isZero);
 
+    // See CompilerInterface::jumpCompare.s
+    virtual void jumpCompare(StackLocation first, StackLocation second,
+                             CompareCondition condition, bool isSigned,
+                             int blockID);
+    virtual void jumpCompareShort(StackLocation first, StackLocation second,
+                                  CompareCondition condition, bool isSigned,
+                                  int blockID);
+
     //////////////////////////////////////////////////////////////////////////
     // Comparison methods
 
@@ -252,6 +275,17 @@ private:
      */
     void saveNonVolatileRegisters(bool shouldPush = true);
 
+    /*
+     * Return the extra-block which holds a 32 bit literal. The literal pool is
+     * per method: a constant (or a relocation target) which was already
+     * emitted is shared by all of its PC-relative loads.
+     *
+     * value          - The constant to store
+     * dependencyName - The absolute address to store
+     */
+    int getConstantLiteral(uint32 value);
+    int getAddressLiteral(const cString& dependencyName);
+
     /*
      * Push all volatile registers before calling other methods
      *
@@ -297,6 +331,14 @@ private:
     // Size of non-volatile registers stored in current stack
     uint32 m_nonVolSize;
 
+    // The number of argument registers the register entry of the method
+    // stores. See setRegisterEntry()
+    uint m_registerEntryCount;
+
+    // The literal pool. Map between a literal and its extra-block ID
+    cHash<int, int> m_constantLiterals;
+    cHash<cString, int> m_addressLiterals;
+
     // Function specific information
     //       NOTE: All of the following members can be implemented as the
     //             FirstBinary private data. This should be useful when encoding
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * THUMB2CompilerInterface.cpp
+ *
+ * Implementation file
+ */
+#include "compiler/stdafx.h"
+
+#include "compiler/processors/arm/THUMB2CompilerInterface.h"
+
+/*
+ * Thumb-2 condition codes, see ARMv7-M Architecture Reference Manual A7.3
+ */
+enum {
+    THUMB2_COND_EQ = 0x0,
+    THUMB2_COND_LO = 0x3,
+    THUMB2_COND_HI = 0x8,
+    THUMB2_COND_LT = 0xB,
+    THUMB2_COND_GT = 0xC
+};
+
+THUMB2CompilerInterface::THUMB2CompilerInterface(const FrameworkMethods& framework, const CompilerParameters& params) :
+    THUMBCompilerInterface(framework, params)
+{
+}
+
+void THUMB2CompilerInterface::appendInstruction(uint16 instruction)
+{
+    m_binary->appendUint8(instruction & 0xFF);
+    m_binary->appendUint8((instruction >> 8) & 0xFF);
+}
+
+void THUMB2CompilerInterface::appendInstruction(uint16 first, uint16 second)
+{
+    appendInstruction(first);
+    appendInstruction(second);
+}
+
+void THUMB2CompilerInterface::moveWide(StackLocation destination, uint16 value, bool isTop)
+{
+    // MOVW/MOVT Rd, #imm16 (imm4:i:imm3:imm8)
+    appendInstruction((isTop ? 0xF2C0 : 0xF240) |
+                      (((value >> 11) & 1) << 10) |
+                      ((value >> 12) & 0xF),
+                      (((value >> 8) & 7) << 12) |
+                      (getGPEncoding(destination.u.reg) << 8) |
+                      (value & 0xFF));
+}
+
+void THUMB2CompilerInterface::loadInt32(StackLocation destination, uint32 value)
+{
+    // MOVS/MVNS are shorter than any 32-bit encoding
+    if ((value <= 0xFF) || ((~value) <= 0xFF))
+    {
+        THUMBCompilerInterface::loadInt32(destination, value);
+        return;
+    }
+
+    // MOVW Rd, #(value & 0xFFFF)
+    moveWide(destination, value & 0xFFFF, false);
+    if ((value >> 16) != 0)
+    {
+        // MOVT Rd, #(value >> 16)
+        moveWide(destination, value >> 16, true);
+    }
+}
+
+void THUMB2CompilerInterface::mul32(StackLocation destination,
+                                    StackLocation source)
+{
+    if ((getGPEncoding(destination.u.reg) <= THUMB_GP32_R7) && (getGPEncoding(source.u.reg) <= THUMB_GP32_R7))
+    {
+        // MULS Rd, Rn;
+        THUMBCompilerInterface::mul32(destination, source);
+        return;
+    }
+
+    // MUL Rd, Rd, Rm;
+    appendInstruction(0xFB00 | getGPEncoding(destination.u.reg),
+                      0xF000 | (getGPEncoding(destination.u.reg) << 8) | getGPEncoding(source.u.reg));
+}
+
+void THUMB2CompilerInterface::div32(StackLocation destination,
+                                    StackLocation source,
+                                    bool sign)
+{
+    // SDIV/UDIV Rd, Rd, Rm;
+    appendInstruction((sign ? 0xFB90 : 0xFBB0) | getGPEncoding(destination.u.reg),
+                      0xF0F0 | (getGPEncoding(destination.u.reg) << 8) | getGPEncoding(source.u.reg));
+}
+
+void THUMB2CompilerInterface::rem32(StackLocation destination,
+                                    StackLocation source,
+                                    bool sign)
+{
+    StackLocation rTemp = m_binary->getCurrentStack()->allocateTemporaryRegister();
+
+    // SDIV/UDIV rTemp, Rd, Rm;
+    appendInstruction((sign ? 0xFB90 : 0xFBB0) | getGPEncoding(destination.u.reg),
+                      0xF0F0 | (getGPEncoding(rTemp.u.reg) << 8) | getGPEncoding(source.u.reg));
+
+    // MLS Rd, rTemp, Rm, Rd; (Rd = Rd - rTemp * Rm)
+    appendInstruction(0xFB00 | getGPEncoding(rTemp.u.reg),
+                      (getGPEncoding(destination.u.reg) << 12) |
+                      (getGPEncoding(destination.u.reg) << 8) |
+                      0x10 |
+                      getGPEncoding(source.u.reg));
+
+    m_binary->getCurrentStack()->freeTemporaryRegister(rTemp);
+}
+
+void THUMB2CompilerInterface::mul32h(StackLocation destlow, StackLocation desthigh, StackLocation source, bool sign)
+{
+    // SMULL/UMULL RdLo, RdHi, RdLo, Rm;
+    appendInstruction((sign ? 0xFB80 : 0xFBA0) | getGPEncoding(destlow.u.reg),
+                      (getGPEncoding(destlow.u.reg) << 12) |
+                      (getGPEncoding(desthigh.u.reg) << 8) |
+                      getGPEncoding(source.u.reg));
+}
+
+bool THUMB2CompilerInterface::isMultiplyHighSupported() const
+{
+    return true;
+}
+
+void THUMB2CompilerInterface::addConst32(const StackLocation destination, int32 value)
+{
+    if (value == 0)
+        return;
+
+    int reg = getGPEncoding(destination.u.reg);
+
+    // The 16-bit encodings: ADD SP, #imm7*4 and ADDS Rd, #imm8
+    if (((reg == THUMB_GP32_SP) && (value > 0) && (value < 0x200) && ((value & 3) == 0)) ||
+        ((reg <= THUMB_GP32_R7) && (value > 0) && (value <= 0xFF)))
+    {
+        THUMBCompilerInterface::addConst32(destination, value);
+        return;
+    }
+
+    uint32 magnitude = (value < 0) ? -value : value;
+    if (magnitude < 0x1000)
+    {
+        // ADDW/SUBW Rd, Rd, #imm12 (i:imm3:imm8)
+        appendInstruction(((value < 0) ? 0xF2A0 : 0xF200) |
+                          (((magnitude >> 11) & 1) << 10) |
+                          reg,
+                          (((magnitude >> 8) & 7) << 12) |
+                          (reg << 8) |
+                          (magnitude & 0xFF));
+    } else
+    {
+        StackLocation rTemp = m_binary->getCurrentStack()->allocateTemporaryRegister();
+        loadInt32(rTemp, value);
+        add32(destination, rTemp);
+        m_binary->getCurrentStack()->freeTemporaryRegister(rTemp);
+    }
+}
+
+void THUMB2CompilerInterface::jumpCond(StackLocation compare,
+                                       int blockID,
+                                       bool isZero)
+{
+    if (getGPEncoding(compare.u.reg) > THUMB_GP32_R7)
+    {
+        THUMBCompilerInterface::jumpCond(compare, blockID, isZero);
+        return;
+    }
+
+    // CBNZ/CBZ only branch forward over a fixed distance, so skip an
+    // unconditional branch which reaches any block.
+    // CBNZ/CBZ Rn, #2;
+    appendInstruction((isZero ? 0xB900 : 0xB100) | (1 << 3) | getGPEncoding(compare.u.reg));
+    // B.W blockID
+    jump(blockID);
+}
+
+void THUMB2CompilerInterface::compareAndSet(StackLocation destination,
+                                            StackLocation source,
+                                            uint8 condition)
+{
+    // CMP Rd, Rn;
+    appendInstruction(0x4280 | (getGPEncoding(source.u.reg) << 3) | getGPEncoding(destination.u.reg));
+
+    // ITE cond;
+    appendInstruction(0xBF00 | (condition << 4) | ((((condition & 1) ^ 1) << 3) | 4));
+
+    // MOV Rd, #1;
+    appendInstruction(0x2000 | (getGPEncoding(destination.u.reg) << 8) | 1);
+
+    // MOV Rd, #0;
+    appendInstruction(0x2000 | (getGPEncoding(destination.u.reg) << 8));
+}
+
+void THUMB2CompilerInterface::ceq32(StackLocation destination,
+                                    StackLocation source)
+{
+    compareAndSet(destination, source, THUMB2_COND_EQ);
+}
+
+void THUMB2CompilerInterface::cgt32(StackLocation destination,
+                                    StackLocation source,
+                                    bool isSigned)
+{
+    compareAndSet(destination, source, isSigned ? THUMB2_COND_GT : THUMB2_COND_HI);
+}
+
+void THUMB2CompilerInterface::clt32(StackLocation destination,
+                                    StackLocation source,
+                                    bool isSigned)
+{
+    compareAndSet(destination, source, isSigned ? THUMB2_COND_LT : THUMB2_COND_LO);
+}
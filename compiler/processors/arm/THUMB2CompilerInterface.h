@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_COMPILER_PROCESSORS_ARM_THUMB2COMPILERINTERFACE_H
+#define __TBA_CLR_COMPILER_PROCESSORS_ARM_THUMB2COMPILERINTERFACE_H
+
+/*
+ * THUMB2CompilerInterface.h
+ *
+ * Native Compiler for ARMv7-M (Cortex-M3/M4/M7) machines.
+ */
+#include "xStl/types.h"
+#include "compiler/processors/arm/THUMBCompilerInterface.h"
+
+/*
+ * Thumb-2 extends the Thumb-1 compiler with the 32-bit encodings found on
+ * ARMv7-M parts:
+ *   - MOVW/MOVT for wide immediates instead of literal-pool loads
+ *   - ADDW/SUBW for 12-bit immediates
+ *   - SDIV/UDIV and MLS instead of the framework division routines
+ *   - SMULL/UMULL for the 64-bit multiplication result
+ *   - IT blocks for comparisons instead of short branches
+ *   - CBZ/CBNZ for branches on zero which don't touch the flags
+ *
+ * Every other operation is encoded by the Thumb-1 compiler.
+ */
+class THUMB2CompilerInterface : public THUMBCompilerInterface {
+public:
+    /*
+     * Default constructor
+     */
+    THUMB2CompilerInterface(const FrameworkMethods& framework, const CompilerParameters& params);
+
+    // See CompilerInterface::loadInt32
+    virtual void loadInt32(StackLocation destination, uint32 value);
+
+    // See CompilerInterface::mul32 etc. etc.
+    virtual void mul32(StackLocation destination, StackLocation source);
+    virtual void div32(StackLocation destination, StackLocation source, bool sign);
+    virtual void rem32(StackLocation destination, StackLocation source, bool sign);
+    virtual void mul32h(StackLocation destlow, StackLocation desthigh, StackLocation source, bool sign);
+    virtual bool isMultiplyHighSupported() const;
+
+    // See CompilerInterface::addConst32
+    virtual void addConst32(const StackLocation destination,
+                            int32 value);
+
+    // See CompilerInterface::jump.s.XXX
+    virtual void jumpCond(StackLocation compare, int blockID, bool isZero);
+
+    // See CompilerInterface::cXX32
+    virtual void ceq32(StackLocation destination, StackLocation source);
+    virtual void cgt32(StackLocation destination, StackLocation source, bool isSigned);
+    virtual void clt32(StackLocation destination, StackLocation source, bool isSigned);
+
+private:
+    /*
+     * Append a 16-bit or a 32-bit Thumb-2 instruction. 32-bit instructions are
+     * stored as two little-endian half-words, the first half-word first.
+     */
+    void appendInstruction(uint16 instruction);
+    void appendInstruction(uint16 first, uint16 second);
+
+    /*
+     * MOVW/MOVT Rd, #value
+     *
+     * isTop - Set to true in order to write the upper 16 bits (MOVT)
+     */
+    void moveWide(StackLocation destination, uint16 value, bool isTop);
+
+    /*
+     * Generate CMP Rd, Rn; ITE cond; MOV Rd, #1; MOV Rd, #0
+     *
+     * condition - The condition code which sets the destination to 1
+     */
+    void compareAndSet(StackLocation destination, StackLocation source, uint8 condition);
+};
+
+#endif // __TBA_CLR_COMPILER_PROCESSORS_ARM_THUMB2COMPILERINTERFACE_H
@@ -39,6 +39,19 @@
 #include "compiler/processors/arm/THUMBCompilerInterface.h"
 #include "compiler/StackEntity.h"
 
+/*
+ * Translation of CompilerInterface::CompareCondition into THUMB condition codes.
+ * Indexed by [condition][isSigned]
+ */
+static const uint8 gCompareConditions[][2] = {
+    {0x0, 0x0},  // EQ, EQ
+    {0x1, 0x1},  // NE, NE
+    {0x8, 0xC},  // HI, GT
+    {0x2, 0xA},  // HS, GE
+    {0x3, 0xB},  // LO, LT
+    {0x9, 0xD}   // LS, LE
+};
+
 /*
  * RAZI REMARKS:
  *
@@ -308,21 +321,7 @@ void THUMBCompilerInterface::store32(StackLocation source,
                                    bool signExtend,
                                    const cString& dependencyName)
 {
-    MethodBlock* immBlock;
-    int newImmediateBlockId;
-    int currentBlockID = createExtraBlock(newImmediateBlockId, immBlock);
-
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->getCurrentDependecies().addDependency(
-                    dependencyName,
-                    m_binary->getCurrentBlockData().getSize() - 4,
-                    BinaryDependencies::DEP_32BIT,
-                    BinaryDependencies::DEP_ABSOLUTE);
-
-    exitExtraBlock(currentBlockID, immBlock);
+    int newImmediateBlockId = getAddressLiteral(dependencyName);
 
     StackLocation rTemp = m_binary->getCurrentStack()->allocateTemporaryRegister();
 
@@ -339,8 +338,21 @@ void THUMBCompilerInterface::move32(StackLocation destination,
                                     uint size,
                                     bool signExtend)
 {
-    // TODO!!!
-    CHECK_FAIL();
+    // TODO! Sign/zero extension of bytes and words
+    CHECK(size == getStackSize());
+
+    uint rd = getGPEncoding(destination.u.reg);
+    uint rm = getGPEncoding(source.u.reg);
+    if ((rd <= THUMB_GP32_R7) && (rm <= THUMB_GP32_R7))
+    {
+        // LSL Rd, Rm, #0; (MOV of low registers)
+        m_binary->appendUint8((rm << 3) + rd);
+        m_binary->appendUint8(0x00);
+    } else {
+        // MOV Rd, Rm; (High registers)
+        m_binary->appendUint8(((rd & 8) << 4) + (rm << 3) + (rd & 7));
+        m_binary->appendUint8(0x46);
+    }
 }
 
 void THUMBCompilerInterface::load32(uint stackPosition,
@@ -470,6 +482,54 @@ void THUMBCompilerInterface::exitExtraBlock(int oldValue, MethodBlock* immBlock)
     m_binary->changeBasicBlock(oldValue);
 }
 
+int THUMBCompilerInterface::getConstantLiteral(uint32 value)
+{
+    // Reuse the pool entry if the constant was already emitted by this method
+    if (m_constantLiterals.hasKey((int)value))
+        return m_constantLiterals[(int)value];
+
+    MethodBlock* immBlock;
+    int newImmediateBlockId;
+    int currentBlockID = createExtraBlock(newImmediateBlockId, immBlock);
+
+    // TODO! Thumb big endian
+    m_binary->appendUint8((value >>  0) & 0xFF);
+    m_binary->appendUint8((value >>  8) & 0xFF);
+    m_binary->appendUint8((value >> 16) & 0xFF);
+    m_binary->appendUint8((value >> 24) & 0xFF);
+
+    exitExtraBlock(currentBlockID, immBlock);
+
+    m_constantLiterals.append((int)value, newImmediateBlockId);
+    return newImmediateBlockId;
+}
+
+int THUMBCompilerInterface::getAddressLiteral(const cString& dependencyName)
+{
+    // Reuse the pool entry if the relocation target was already emitted
+    if (m_addressLiterals.hasKey(dependencyName))
+        return m_addressLiterals[dependencyName];
+
+    MethodBlock* immBlock;
+    int newImmediateBlockId;
+    int currentBlockID = createExtraBlock(newImmediateBlockId, immBlock);
+
+    m_binary->appendUint8(0x00);
+    m_binary->appendUint8(0x00);
+    m_binary->appendUint8(0x00);
+    m_binary->appendUint8(0x00);
+    m_binary->getCurrentDependecies().addDependency(
+                                        dependencyName,
+                                        m_binary->getCurrentBlockData().getSize() - 4,
+                                        BinaryDependencies::DEP_32BIT,
+                                        BinaryDependencies::DEP_ABSOLUTE);
+
+    exitExtraBlock(currentBlockID, immBlock);
+
+    m_addressLiterals.append(dependencyName, newImmediateBlockId);
+    return newImmediateBlockId;
+}
+
 void THUMBCompilerInterface::loadInt32(StackLocation destination, uint32 value)
 {
     int lead = nlz(value);
@@ -493,19 +553,16 @@ void THUMBCompilerInterface::loadInt32(StackLocation destination, uint32 value)
                 m_binary->appendUint8(((trail << 6) & 0xFF) + (getGPEncoding(destination.u.reg) << 3) + (getGPEncoding(destination.u.reg)));
                 m_binary->appendUint8((trail & 0x1C) >> 2);
             }
+        } else if ((~value) <= 255)
+        {
+            // MOVS Rd, #~value
+            m_binary->appendUint8(~value);
+            m_binary->appendUint8(0x20 + getGPEncoding(destination.u.reg));
+            // MVNS Rd, Rd
+            not32(destination);
         } else
         {
-            MethodBlock* immBlock;
-            int newImmediateBlockId;
-            int currentBlockID = createExtraBlock(newImmediateBlockId, immBlock);
-
-            // TODO! Thumb big endian
-            m_binary->appendUint8((value >>  0) & 0xFF);
-            m_binary->appendUint8((value >>  8) & 0xFF);
-            m_binary->appendUint8((value >> 16) & 0xFF);
-            m_binary->appendUint8((value >> 24) & 0xFF);
-
-            exitExtraBlock(currentBlockID, immBlock);
+            int newImmediateBlockId = getConstantLiteral(value);
 
             // LDR Rd, =value;
             loadBlock(getGPEncoding(destination.u.reg), newImmediateBlockId);
@@ -516,21 +573,7 @@ void THUMBCompilerInterface::loadInt32(StackLocation destination, uint32 value)
 void THUMBCompilerInterface::loadInt32(StackLocation destination,
                                        const cString& dependancyName)
 {
-    MethodBlock* immBlock;
-    int newImmediateBlockId;
-    int currentBlockID = createExtraBlock(newImmediateBlockId, immBlock);
-
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->appendUint8(0x00);
-    m_binary->getCurrentDependecies().addDependency(
-                                        dependancyName,
-                                        m_binary->getCurrentBlockData().getSize() - 4,
-                                        BinaryDependencies::DEP_32BIT,
-                                        BinaryDependencies::DEP_ABSOLUTE);
-
-    exitExtraBlock(currentBlockID, immBlock);
+    int newImmediateBlockId = getAddressLiteral(dependancyName);
 
     // LDR Rd, =value;
     loadBlock(getGPEncoding(destination.u.reg), newImmediateBlockId);
@@ -572,6 +615,24 @@ void THUMBCompilerInterface::pushArg32(StackLocation source)
     m_stackRef += 4;
 }
 
+void THUMBCompilerInterface::pushArgConst32(int32 value)
+{
+    // There is no push immediate, go through a temporary register
+    StackLocation rTemp = m_binary->getCurrentStack()->allocateTemporaryRegister();
+    loadInt32(rTemp, (uint32)value);
+    pushArg32(rTemp);
+    m_binary->getCurrentStack()->freeTemporaryRegister(rTemp);
+}
+
+void THUMBCompilerInterface::pushArgStack32(uint stackPosition, bool argumentStackLocation)
+{
+    // There is no push from memory, go through a temporary register
+    StackLocation rTemp = m_binary->getCurrentStack()->allocateTemporaryRegister();
+    load32(stackPosition, 4, rTemp, false, argumentStackLocation);
+    pushArg32(rTemp);
+    m_binary->getCurrentStack()->freeTemporaryRegister(rTemp);
+}
+
 void THUMBCompilerInterface::popArg32(StackLocation source)
 {
     StackLocation rTemp = source;
@@ -912,6 +973,20 @@ void THUMBCompilerInterface::shr32(StackLocation destination,
     }
 }
 
+void THUMBCompilerInterface::sar32(StackLocation destination,
+                                   StackLocation source)
+{
+    if ((getGPEncoding(destination.u.reg) <= THUMB_GP32_R7) && (getGPEncoding(source.u.reg) <= THUMB_GP32_R7))
+    {
+        // ASR Rd, Rn;
+        m_binary->appendUint8((getGPEncoding(source.u.reg) << 3) + getGPEncoding(destination.u.reg));
+        m_binary->appendUint8(0x41);
+    } else {
+        // UNSUPPORTED in THUMB
+        CHECK_FAIL();
+    }
+}
+
 void THUMBCompilerInterface::shl32(StackLocation destination,
                                    StackLocation source)
 {
@@ -1084,6 +1159,65 @@ void THUMBCompilerInterface::jumpCondShort(StackLocation compare,
     }
 }
 
+void THUMBCompilerInterface::jumpCompare(StackLocation first,
+                                         StackLocation second,
+                                         CompareCondition condition,
+                                         bool isSigned,
+                                         int blockID)
+{
+    // CMP    Rd, Rn;
+    m_binary->appendUint8((0x08 << 4) + (getGPEncoding(second.u.reg) << 3) + getGPEncoding(first.u.reg));
+    m_binary->appendUint8(0x42);
+
+    // Operand High
+    {
+        uint16 operand = (0xF << 12) |               // opcode
+                         (1 << 10) |                 // signned
+                         (gCompareConditions[condition][isSigned ? 1 : 0] << 6) | // cond
+                         (0x3F);                     // offset [12:17]
+        appendUint16(operand);
+    }
+
+    // Operand low
+    {
+        uint16 operand = (2 << 14) |                 // opcode
+                         (5 << 11) |                 // J1 0 J2
+                         (0x7FE);                    // offset LSB [1:11]
+        appendUint16(operand);
+    }
+
+    m_binary->getCurrentDependecies().addDependency(
+            MangledNames::getMangleBlock(blockID, 2, BinaryDependencies::DEP_RELATIVE),
+            m_binary->getCurrentBlockData().getSize() - 4,
+            BinaryDependencies::DEP_19BIT_2BYTES_LITTLE_ENDIAN,
+            BinaryDependencies::DEP_RELATIVE,
+            1,
+            true);
+}
+
+void THUMBCompilerInterface::jumpCompareShort(StackLocation first,
+                                              StackLocation second,
+                                              CompareCondition condition,
+                                              bool isSigned,
+                                              int blockID)
+{
+    // CMP    Rd, Rn;
+    m_binary->appendUint8((0x08 << 4) + (getGPEncoding(second.u.reg) << 3) + getGPEncoding(first.u.reg));
+    m_binary->appendUint8(0x42);
+
+    // The address part of Bcc
+    m_binary->appendUint8(0xFD);
+    // Add dependency to the last byte
+    m_binary->getCurrentDependecies().addDependency(MangledNames::getMangleBlock(blockID, 1, BinaryDependencies::DEP_RELATIVE),
+        m_binary->getCurrentBlockData().getSize() - 1,
+        BinaryDependencies::DEP_8BIT,
+        BinaryDependencies::DEP_RELATIVE,
+        1, // Divide by 2
+        true);
+    // Bcc    blockID
+    m_binary->appendUint8(0xD0 + gCompareConditions[condition][isSigned ? 1 : 0]);
+}
+
 void THUMBCompilerInterface::ceq32(StackLocation destination,
                                    StackLocation source)
 {
@@ -38,6 +38,7 @@
  * Native Compiler for x86 machine.
  */
 #include "xStl/types.h"
+#include "xStl/data/hash.h"
 #include "compiler/CompilerInterface.h"
 #include "compiler/MethodBlock.h"
 #include "dismount/assembler/AssemblerInterface.h"
@@ -126,6 +127,10 @@ public:
     virtual void assignRet32(StackLocation source);
     // See CompilerInterface::pushArg32
     virtual void pushArg32(StackLocation source);
+    // See CompilerInterface::pushArgConst32
+    virtual void pushArgConst32(int32 value);
+    // See CompilerInterface::pushArgStack32
+    virtual void pushArgStack32(uint stackPosition, bool argumentStackLocation);
     // See CompilerInterface::popArg32
     virtual void popArg32(StackLocation source);
     // See CompilerInterface::call
@@ -173,6 +178,7 @@ public:
     virtual void and32(StackLocation destination, StackLocation source);
     virtual void xor32(StackLocation destination, StackLocation source);
     virtual void shr32(StackLocation destination, StackLocation source);
+    virtual void sar32(StackLocation destination, StackLocation source);
     virtual void shl32(StackLocation destination, StackLocation source);
     virtual void or32 (StackLocation destination, StackLocation source);
 
@@ -195,6 +201,14 @@ public:
     virtual void jumpCond(StackLocation compare, int blockID, bool isZero);
     virtual void jumpCondShort(StackLocation compare, int blockID, bool isZero);
 
+    // See CompilerInterface::jumpCompare.s
+    virtual void jumpCompare(StackLocation first, StackLocation second,
+                             CompareCondition condition, bool isSigned,
+                             int blockID);
+    virtual void jumpCompareShort(StackLocation first, StackLocation second,
+                                  CompareCondition condition, bool isSigned,
+                                  int blockID);
+
     //////////////////////////////////////////////////////////////////////////
     // Comparison methods
 
@@ -219,7 +233,7 @@ protected:
     // See CompilerInterface::generateMethodEpiProLogs
     virtual void generateMethodEpiProLogs(bool bForceSaveNonVolatiles = false);
 
-private:
+    // NOTE: The following helpers are shared with THUMB2CompilerInterface
     /*
      * Translates between GP register index and an encoded FirstBinaryPass value
      */
@@ -257,6 +271,17 @@ private:
     int createExtraBlock(int& newImmediateBlockId, MethodBlock*& immBlock);
     void exitExtraBlock(int oldValue, MethodBlock* immBlock);
 
+    /*
+     * Return the extra-block which holds a 32 bit literal. The literal pool is
+     * per method: a constant (or a relocation target) which was already
+     * emitted is shared by all of its PC-relative loads.
+     *
+     * value          - The constant to store
+     * dependencyName - The absolute address to store
+     */
+    int getConstantLiteral(uint32 value);
+    int getAddressLiteral(const cString& dependencyName);
+
     /*
      * Returns a free register
      * If there are no free registers, store r0 in the stack and return it
@@ -305,6 +330,10 @@ private:
     // Size of non-volatile registers stored in current stack
     uint32 m_nonVolSize;
 
+    // The literal pool. Map between a literal and its extra-block ID
+    cHash<int, int> m_constantLiterals;
+    cHash<cString, int> m_addressLiterals;
+
     // Function specific information
     //       NOTE: All of the following members can be implemented as the
     //             FirstBinary private data. This should be useful when encoding
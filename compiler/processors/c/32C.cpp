@@ -353,10 +353,27 @@ void c32CCompilerInterface::assignRet32(StackLocation source)
 }
 
 void c32CCompilerInterface::pushArg32(StackLocation source)
+{
+    pushArgValue(getRegsiterName(source));
+}
+
+void c32CCompilerInterface::pushArgConst32(int32 value)
+{
+    pushArgValue(cString((uint32)value));
+}
+
+void c32CCompilerInterface::pushArgStack32(uint stackPosition,
+                                           bool argumentStackLocation)
+{
+    pushArgValue(getStackReference124(stackPosition, 4,
+                                      argumentStackLocation));
+}
+
+void c32CCompilerInterface::pushArgValue(const cString& value)
 {
     cCFirstBinaryStream compiler(m_binary);
     // Use a local int, named ap#
-    compiler << "ap" << (uint32)m_currentArgs << " = " << getRegsiterName(source) << ";" << endl;
+    compiler << "ap" << (uint32)m_currentArgs << " = " << value << ";" << endl;
     // And remember that we need to use it
     m_currentArgs++;
     if (m_maximumNumberOfArgs < m_currentArgs)
@@ -541,6 +558,14 @@ void c32CCompilerInterface::xor32(StackLocation destination,
 
 void c32CCompilerInterface::shr32(StackLocation destination,
                                   StackLocation source)
+{
+    cCFirstBinaryStream compiler(m_binary);
+    // The registers are signed integers
+    compiler << getRegsiterName(destination) << " = (int)((unsigned int)" << getRegsiterName(destination) << " >> " << getRegsiterName(source) << ");" << endl;
+}
+
+void c32CCompilerInterface::sar32(StackLocation destination,
+                                  StackLocation source)
 {
     cCFirstBinaryStream compiler(m_binary);
     compiler << getRegsiterName(destination) << ">>= " << getRegsiterName(source) << ";" << endl;
@@ -611,6 +636,30 @@ void c32CCompilerInterface::jumpCondShort(StackLocation compare,
     compiler << "if (" << getRegsiterName(compare) << ((isZero) ? " == " : " != ") << "0) goto cblk" << blockID << ";" << endl;
 }
 
+void c32CCompilerInterface::jumpCompare(StackLocation first,
+                                        StackLocation second,
+                                        CompareCondition condition,
+                                        bool isSigned,
+                                        int blockID)
+{
+    // The operators of CompilerInterface::CompareCondition
+    static const char* operators[] = {" == ", " != ", " > ", " >= ", " < ", " <= "};
+    const char* cast = isSigned ? "(int)" : "(unsigned int)";
+
+    cCFirstBinaryStream compiler(m_binary);
+    compiler << "if (" << cast << getRegsiterName(first) << operators[condition]
+             << cast << getRegsiterName(second) << ") goto cblk" << blockID << ";" << endl;
+}
+
+void c32CCompilerInterface::jumpCompareShort(StackLocation first,
+                                             StackLocation second,
+                                             CompareCondition condition,
+                                             bool isSigned,
+                                             int blockID)
+{
+    jumpCompare(first, second, condition, isSigned, blockID);
+}
+
 void c32CCompilerInterface::ceq32(StackLocation destination,
                                   StackLocation source)
 {
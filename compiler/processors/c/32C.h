@@ -160,6 +160,10 @@ public:
     virtual void assignRet32(StackLocation source);
     // See CompilerInterface::pushArg32
     virtual void pushArg32(StackLocation source);
+    // See CompilerInterface::pushArgConst32
+    virtual void pushArgConst32(int32 value);
+    // See CompilerInterface::pushArgStack32
+    virtual void pushArgStack32(uint stackPosition, bool argumentStackLocation);
     // See CompilerInterface::popArg32
     virtual void popArg32(StackLocation source);
     // See CompilerInterface::call
@@ -208,6 +212,7 @@ public:
     virtual void and32(StackLocation destination, StackLocation source);
     virtual void xor32(StackLocation destination, StackLocation source);
     virtual void shr32(StackLocation destination, StackLocation source);
+    virtual void sar32(StackLocation destination, StackLocation source);
     virtual void shl32(StackLocation destination, StackLocation source);
     virtual void or32 (StackLocation destination, StackLocation source);
 
@@ -230,6 +235,14 @@ public:
     virtual void jumpCond(StackLocation compare, int blockID, bool isZero);
     virtual void jumpCondShort(StackLocation compare, int blockID, bool isZero);
 
+    // See CompilerInterface::jumpCompare.s
+    virtual void jumpCompare(StackLocation first, StackLocation second,
+                             CompareCondition condition, bool isSigned,
+                             int blockID);
+    virtual void jumpCompareShort(StackLocation first, StackLocation second,
+                                  CompareCondition condition, bool isSigned,
+                                  int blockID);
+
     //////////////////////////////////////////////////////////////////////////
     // Comparison methods
 
@@ -322,6 +335,11 @@ private:
      */
     void callArgs(cCFirstBinaryStream& compiler, uint numberOfArguments, bool isPrototype = false);
 
+    /*
+     * Assign 'value' into the next argument local (ap#)
+     */
+    void pushArgValue(const cString& value);
+
     /*
      * Translate dependencyName to C function name
      */
@@ -42,7 +42,9 @@
 #include "dismount/assembler/MangledNames.h"
 #include "dismount/assembler/StackInterface.h"
 #include "compiler/MethodBlock.h"
+#include "compiler/CallingConvention.h"
 #include "compiler/processors/ia32/IA32CompilerInterface.h"
+#include "compiler/processors/ia32/IA32Encoder.h"
 
 
 // Optimization
@@ -53,6 +55,29 @@ static const cString g_dwordptrOnly("dword ptr ");
 static const char g_open = '[';
 static const char g_terminate = ']';
 
+/*
+ * Translation of CompilerInterface::CompareCondition into x86 conditions.
+ * Indexed by [condition][isSigned]
+ */
+static const IA32Encoder::Condition gCompareConditions[][2] = {
+    {IA32Encoder::COND_Z,  IA32Encoder::COND_Z},   // COMPARE_EQUAL
+    {IA32Encoder::COND_NZ, IA32Encoder::COND_NZ},  // COMPARE_NOT_EQUAL
+    {IA32Encoder::COND_A,  IA32Encoder::COND_G},   // COMPARE_GREATER
+    {IA32Encoder::COND_AE, IA32Encoder::COND_GE},  // COMPARE_GREATER_EQUAL
+    {IA32Encoder::COND_B,  IA32Encoder::COND_L},   // COMPARE_LESS
+    {IA32Encoder::COND_BE, IA32Encoder::COND_LE}   // COMPARE_LESS_EQUAL
+};
+
+// The mnemonics of the conditions above, for the short jumps
+static const char* gCompareJumps[][2] = {
+    {"jz",  "jz"},
+    {"jnz", "jnz"},
+    {"ja",  "jg"},
+    {"jae", "jge"},
+    {"jb",  "jl"},
+    {"jbe", "jle"}
+};
+
 #define EAX (0)
 #define EDI (1)
 #define ESI (2)
@@ -60,7 +85,9 @@ static const char g_terminate = ']';
 #define ECX (4)
 #define EDX (5)
 
-IA32CompilerInterface::IA32CompilerInterface(const FrameworkMethods& framework, const CompilerParameters& params) : OptimizerOperationCompilerInterface(framework, params)
+IA32CompilerInterface::IA32CompilerInterface(const FrameworkMethods& framework, const CompilerParameters& params) : OptimizerOperationCompilerInterface(framework, params),
+    m_isFrameRequired(false),
+    m_registerEntryCount(0)
 {
     // Generate new first-binary pass
     // Don't forget the negative size! This sign mark the register as temporary
@@ -119,11 +146,11 @@ void IA32CompilerInterface::localloc(StackLocation destination,
                                      bool isStackEmpty)
 {
 #if 1
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "sub esp, " << getRegister32(size) << endl;
-    compiler << "mov " << getRegister32(destination) << ", esp" << endl;
+    // The stack pointer is restored from the frame
+    m_isFrameRequired = true;
+    IA32Encoder encoder(*m_binary);
+    encoder.alu(IA32Encoder::ALU_SUB, ia32dis::IA32_GP32_ESP, getEncoding(size));
+    encoder.move(getEncoding(destination), ia32dis::IA32_GP32_ESP);
 #else
     // TODO! This call can be implemented by reducing the base size of the stack
     //       and copying all pending stack into the new location.
@@ -171,6 +198,12 @@ void IA32CompilerInterface::generateMethodEpiProLogs(bool bForceSaveNonVolatiles
     // Check for allocated registers, and debug!
     RegToLocation locationMap;
 
+    // A leaf method which never touched its frame, the stack or a non-volatile
+    // register only needs the return instruction
+    bool isFrameless = !m_isFrameRequired && !bForceSaveNonVolatiles &&
+                       (m_binary->getStackSize() == 0) &&
+                       !isNonVolatileRegistersTouched();
+
     // Add prolog
     // Generate new first stream, and switch to it.
     MethodBlock* prolog = new MethodBlock(MethodBlock::BLOCK_PROLOG, *this);
@@ -178,6 +211,28 @@ void IA32CompilerInterface::generateMethodEpiProLogs(bool bForceSaveNonVolatiles
 
     m_binary->createNewBlockWithoutChange(MethodBlock::BLOCK_PROLOG, pstack);
     m_binary->changeBasicBlock(MethodBlock::BLOCK_PROLOG);
+    if (m_registerEntryCount > 0)
+    {
+        // The stack entry jumps over the register entry:
+        //      jmp short prolog
+        //      nop / nop                       ; REGISTER_ENTRY_OFFSET
+        //      mov [esp + 4 + 4*i], register i ; For each argument register
+        // The arguments slots were reserved by the caller. See pushArgRegisters32
+        // Only indirect calls (delegates and function pointers) take the stack
+        // entry, since virtual methods have no register entry. See
+        // CallingConvention::getRegisterArgumentsCount
+        IA32Encoder encoder(*m_binary);
+        uint storesSize = m_registerEntryCount * 4;
+        encoder.jumpShort((int8)(REGISTER_ENTRY_OFFSET - 2 + storesSize));
+        encoder.nop();
+        encoder.nop();
+        for (uint i = 0; i < m_registerEntryCount; i++)
+        {
+            encoder.store(ia32dis::IA32_GP32_ESP, (i + 1) * getStackSize(),
+                          getEncoding(getArgumentRegister(i)), getStackSize());
+        }
+    }
+    if (!isFrameless)
     {
         cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
         cStringerStream& compiler = *ia32compiler;
@@ -201,19 +256,48 @@ void IA32CompilerInterface::generateMethodEpiProLogs(bool bForceSaveNonVolatiles
     {
         cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
         cStringerStream& compiler = *ia32compiler;
-        // Restore the non-volatile registers touching
-        saveNonVolatileRegisters(compiler, locationMap, false, bForceSaveNonVolatiles);
-
-
+        if (!isFrameless)
+        {
+            // Restore the non-volatile registers touching
+            saveNonVolatileRegisters(compiler, locationMap, false, bForceSaveNonVolatiles);
 
-        compiler << "mov  esp, ebp" << endl;
-        compiler << "pop  ebp" << endl;
+            compiler << "mov  esp, ebp" << endl;
+            compiler << "pop  ebp" << endl;
+        }
         if (m_binary->isStdCall())
             compiler << "retn " << (int)m_binary->getArgumentsSize() << endl;
         else
             compiler << "ret" << endl;
     }
     epilog->terminateMethodBlock(NULL, MethodBlock::COND_NON, 0);
+
+    // Conclude the tail calls the same way, now that the saved registers are
+    // known. See tailCall()
+    cList<int> tailBlocks = m_tailCalls.keys();
+    for (cList<int>::iterator i = tailBlocks.begin(); i != tailBlocks.end(); i++)
+    {
+        m_binary->changeBasicBlock(*i);
+        {
+            cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
+            cStringerStream& compiler = *ia32compiler;
+            saveNonVolatileRegisters(compiler, locationMap, false, bForceSaveNonVolatiles);
+
+            compiler << "mov  esp, ebp" << endl;
+            compiler << "pop  ebp" << endl;
+        }
+        IA32Encoder(*m_binary).jumpRelative();
+
+        // Add dependency to the last 4 bytes
+        m_binary->getCurrentDependecies().addDependency(
+                    m_tailCalls[*i],
+                    m_binary->getCurrentBlockData().getSize() - getStackSize(),
+                    getStackSize(),
+                    BinaryDependencies::DEP_RELATIVE,
+                    0,
+                    false,
+                    -4);
+    }
+    m_binary->changeBasicBlock(MethodBlock::BLOCK_RET);
 }
 
 // Generate instruction: mov [ebp + stackPosition], buffer
@@ -250,42 +334,25 @@ void IA32CompilerInterface::store32(uint stackPosition,
 {
     // Validate register
     CHECK(isRegister32(source));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
     CHECK(size != 0);
 
     if ((size != 4) && (!isRegister8(source)))
     {
-        freeRegister32(ia32dis::IA32_GP32_EAX, compiler);
-        compiler << "mov eax, " << getRegister32(source) << endl;
+        {
+            cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
+            cStringerStream& compiler = *ia32compiler;
+            freeRegister32(ia32dis::IA32_GP32_EAX, compiler);
+        }
+        IA32Encoder(*m_binary).move(ia32dis::IA32_GP32_EAX, getEncoding(source));
         source.u.reg = getGPEncoding(ia32dis::IA32_GP32_EAX);
     }
 
-    compiler << "mov ";
-    if (isTempStack)
-    {
-        compiler << getTempStack32(stackPosition, size);
-    } else
-    {
-        compiler << getStackReference124(stackPosition, size,
-                                         argumentStackLocation);
-    }
-    compiler << ", ";
-
-    switch (size)
-    {
-    case 1:
-        compiler << getRegister8(source);
-        break;
-    case 2:
-        compiler << getRegister16(source);
-        break;
-    case 4:
-        compiler << getRegister32(source);
-        break;
-    }
-    compiler << endl;
+    int32 displacement = isTempStack ?
+                            getTempStackDisplacement(stackPosition) :
+                            getStackDisplacement(stackPosition,
+                                                 argumentStackLocation);
+    IA32Encoder(*m_binary).store(getBaseStackEncoding(), displacement,
+                                 getEncoding(source), size);
 }
 
 void IA32CompilerInterface::store32(StackLocation source,
@@ -353,12 +420,18 @@ void IA32CompilerInterface::move32(StackLocation destination,
     CHECK(isRegister32(destination));
     CHECK(isRegister32(source));
     CHECK(size != 0);
+
+    if (size == 4)
+    {
+        IA32Encoder(*m_binary).move(getEncoding(destination),
+                                    getEncoding(source));
+        return;
+    }
+
     cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
     cStringerStream& compiler = *ia32compiler;
 
-    if (size == 4)
-        compiler << "mov ";
-    else if (signExtend)
+    if (signExtend)
     {
         compiler << "movsx ";
     } else
@@ -382,30 +455,14 @@ void IA32CompilerInterface::load32(uint stackPosition,
     // Validate register
     CHECK(isRegister32(destination));
     CHECK(size != 0);
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
 
-    if (size == 4)
-        compiler << "mov ";
-    else if (signExtend)
-    {
-        compiler << "movsx ";
-    } else
-    {
-        compiler << "movzx ";
-    }
-    compiler << getRegister32(destination) << ", ";
-
-    if (!isTempStack)
-    {
-        compiler << getStackReference124(stackPosition, size,
-                                         argumentStackLocation);
-    } else
-    {
-        compiler << getTempStack32(stackPosition, size);
-    }
-
-    compiler << endl;
+    int32 displacement = isTempStack ?
+                            getTempStackDisplacement(stackPosition) :
+                            getStackDisplacement(stackPosition,
+                                                 argumentStackLocation);
+    IA32Encoder(*m_binary).load(getEncoding(destination),
+                                getBaseStackEncoding(), displacement,
+                                size, signExtend);
 }
 
 void IA32CompilerInterface::load32(StackLocation destination,
@@ -465,34 +522,29 @@ void IA32CompilerInterface::load32addr(uint stackPosition,
 {
     // Validate register
     CHECK(isRegister32(destination));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "lea " << getRegister32(destination) << ", ";
-
-    compiler << g_open;
-    compiler << getBaseStackRegister(getMethodBaseStackRegister());
 
+    int32 displacement;
     if (!argumentStackLocation)
     {
         // locals
-        compiler << " - ";
         if (isTempStack)
         {
             stackPosition+= m_binary->getStackBaseSize() - StackInterface::LOCAL_STACK_START_VALUE;
         }
         //Add the size minus the offset into it
         stackPosition += Alignment::alignUpToDword(size) - offset;
+        displacement = -(int32)stackPosition;
     } else
     {
         // Argument
         // Add the EIP and EBP that are on the stack
         stackPosition+= 8 + offset;
-        compiler << " + ";
+        displacement = (int32)stackPosition;
     }
 
     // The -4 for the load32/store32 is not nessasery since we do that on "size"
-    compiler << cString(stackPosition) << g_terminate << endl;
+    IA32Encoder(*m_binary).loadAddress(getEncoding(destination),
+                                       getBaseStackEncoding(), displacement);
 }
 
 void IA32CompilerInterface::load32addr(StackLocation destination,
@@ -500,11 +552,8 @@ void IA32CompilerInterface::load32addr(StackLocation destination,
 {
     // Validate register
     CHECK(isRegister32(destination));
-    {
-        cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-        cStringerStream& compiler = *ia32compiler;
-        compiler << "mov " << getRegister32(destination) << ", 0x66600666" << endl;
-    }
+    IA32Encoder(*m_binary).moveConst(getEncoding(destination),
+                                     IA32Encoder::DEPENDENCY_PLACEHOLDER);
     m_binary->getCurrentDependecies().addDependency(
                 dependencyName,
                 m_binary->getCurrentBlockData().getSize() - getStackSize(),
@@ -520,11 +569,7 @@ void IA32CompilerInterface::loadInt32(StackLocation destination,
 {
     // Validate register
     CHECK(isRegister32(destination));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "mov " << getRegister32(destination) << ", 0x"
-             << HEXDWORD(value) << endl;
+    IA32Encoder(*m_binary).moveConst(getEncoding(destination), value);
 }
 
 void IA32CompilerInterface::loadInt32(StackLocation destination,
@@ -545,13 +590,11 @@ void IA32CompilerInterface::assignRet32(StackLocation source)
 {
     // Validate register
     CHECK(isRegister32(source));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
 
     if (getGPEncoding(source.u.reg) != ia32dis::IA32_GP32_EAX)
     {
         // TODO! Allocate and HOLDS! EAX register.
-        compiler << "mov eax, " << getRegister32(source) << endl;
+        IA32Encoder(*m_binary).move(ia32dis::IA32_GP32_EAX, getEncoding(source));
     }
 }
 
@@ -559,30 +602,35 @@ void IA32CompilerInterface::pushArg32(StackLocation source)
 {
     // Validate register
     CHECK(isRegister32(source));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
+    m_isFrameRequired = true;
+    IA32Encoder(*m_binary).push(getEncoding(source));
+}
 
-    compiler << "push " << getRegister32(source) << endl;
+void IA32CompilerInterface::pushArgConst32(int32 value)
+{
+    m_isFrameRequired = true;
+    IA32Encoder(*m_binary).pushConst(value);
+}
+
+void IA32CompilerInterface::pushArgStack32(uint stackPosition,
+                                           bool argumentStackLocation)
+{
+    IA32Encoder(*m_binary).pushMemory(getBaseStackEncoding(),
+                                      getStackDisplacement(stackPosition,
+                                                           argumentStackLocation));
 }
 
 void IA32CompilerInterface::popArg32(StackLocation source)
 {
     // Validate register
     CHECK(isRegister32(source));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "pop " << getRegister32(source) << endl;
+    IA32Encoder(*m_binary).pop(getEncoding(source));
 }
 
 void IA32CompilerInterface::call(const cString& dependancyName, uint)
 {
-    {
-        cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-        cStringerStream& compiler = *ia32compiler;
-        saveVolatileRegisters();
-        compiler << "call $+66600666" << endl;
-    }
+    saveVolatileRegisters();
+    IA32Encoder(*m_binary).callRelative();
 
     // Add dependency to the last 4 bytes
     m_binary->getCurrentDependecies().addDependency(
@@ -597,10 +645,8 @@ void IA32CompilerInterface::call(const cString& dependancyName, uint)
 
 void IA32CompilerInterface::call(StackLocation address, uint)
 {
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
     saveVolatileRegisters();
-    compiler << "call " << getRegister32(address) << endl;
+    IA32Encoder(*m_binary).callRegister(getEncoding(address));
 }
 
 void IA32CompilerInterface::call32(const cString& dependancyName,
@@ -616,14 +662,9 @@ void IA32CompilerInterface::call32(const cString& dependancyName,
         shouldCopyEax = true;
     }
 
-    if (true)
-    {
-        cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-        cStringerStream& compiler = *ia32compiler;
-        saveVolatileRegisters(getGPEncoding(ia32dis::IA32_GP32_EAX),
-                              destination.u.reg);
-        compiler << "call $+66600666" << endl;
-    }
+    saveVolatileRegisters(getGPEncoding(ia32dis::IA32_GP32_EAX),
+                          destination.u.reg);
+    IA32Encoder(*m_binary).callRelative();
 
     // Add dependency to the last 4 bytes
     m_binary->getCurrentDependecies().addDependency(
@@ -638,12 +679,172 @@ void IA32CompilerInterface::call32(const cString& dependancyName,
 
     if (shouldCopyEax)
     {
-        cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-        cStringerStream& compiler = *ia32compiler;
-        compiler << "mov " << getRegister32(destination) << ", eax" << endl;
+        IA32Encoder(*m_binary).move(getEncoding(destination),
+                                    ia32dis::IA32_GP32_EAX);
     }
 }
 
+bool IA32CompilerInterface::isTailCallSupported() const
+{
+    return true;
+}
+
+void IA32CompilerInterface::tailCall(const cString& dependencyName,
+                                     uint argumentsSize)
+{
+    // The arguments are addressed through EBP, and the frame is torn down
+    // before the jump
+    m_isFrameRequired = true;
+
+    // Move the new arguments over the current ones. The first argument was
+    // pushed last, so it's on top of the stack
+    int base = getBaseStackEncoding();
+    for (uint i = 0; i < argumentsSize; i+= getStackSize())
+    {
+        IA32Encoder(*m_binary).popMemory(base, getStackDisplacement(i, true));
+    }
+
+    // The frame is released once the saved non-volatile registers are known.
+    // See generateMethodEpiProLogs()
+    m_tailCalls.append(m_binary->getCurrentBlockID(), dependencyName);
+}
+
+bool IA32CompilerInterface::isGuardedCallSupported() const
+{
+    return true;
+}
+
+void IA32CompilerInterface::guardedCall(const cString& guardName,
+                                        const cString& dependencyName)
+{
+    // The registers are spilled on both paths, so the stack layout is the
+    // same after the operation
+    saveVolatileRegisters();
+    IA32Encoder encoder(*m_binary);
+
+    // cmp byte [guard], 0
+    uint guardPosition = encoder.compareByteAbsolute(0);
+    m_binary->getCurrentDependecies().addDependency(
+                guardName,
+                guardPosition,
+                getStackSize(),
+                BinaryDependencies::DEP_ABSOLUTE,
+                0,
+                false,
+                -4);
+
+    // jnz over the 5 bytes of the call rel32
+    encoder.jumpCondShort(IA32Encoder::COND_NZ, 5);
+    encoder.callRelative();
+    m_binary->getCurrentDependecies().addDependency(
+                dependencyName,
+                m_binary->getCurrentBlockData().getSize() - getStackSize(),
+                getStackSize(),
+                BinaryDependencies::DEP_RELATIVE,
+                0,
+                false,
+                -4);
+}
+
+uint IA32CompilerInterface::getArgumentRegistersCount() const
+{
+    return 2;
+}
+
+StackLocation IA32CompilerInterface::getArgumentRegister(uint index) const
+{
+    static const int registers[] = {ia32dis::IA32_GP32_EDX, ia32dis::IA32_GP32_EBX};
+    CHECK(index < arraysize(registers));
+    return StackInterface::buildStackLocation(getGPEncoding(registers[index]), 0);
+}
+
+void IA32CompilerInterface::pushArgRegisters32(uint count)
+{
+    if (count == 0)
+        return;
+
+    m_isFrameRequired = true;
+    IA32Encoder(*m_binary).aluConst(IA32Encoder::ALU_SUB,
+                                    ia32dis::IA32_GP32_ESP, count * getStackSize());
+}
+
+void IA32CompilerInterface::setRegisterEntry(uint count)
+{
+    CHECK(count <= getArgumentRegistersCount());
+    m_registerEntryCount = count;
+}
+
+bool IA32CompilerInterface::isUnwindDataSupported() const
+{
+    return true;
+}
+
+void IA32CompilerInterface::appendUnwindWord(uint32 value,
+                                             const cString& dependencyName)
+{
+    m_binary->appendBuffer((const uint8*)&value, sizeof(value));
+    if (dependencyName.length() == 0)
+        return;
+
+    // Add dependency to the last 4 bytes
+    m_binary->getCurrentDependecies().addDependency(
+                dependencyName,
+                m_binary->getCurrentBlockData().getSize() - getStackSize(),
+                getStackSize(),
+                BinaryDependencies::DEP_ABSOLUTE,
+                0,
+                true);
+}
+
+void IA32CompilerInterface::appendUnwindBlock(int blockID)
+{
+    uint32 value = 0;
+    m_binary->appendBuffer((const uint8*)&value, sizeof(value));
+
+    // Relative to the end of the word, the same as "jmp rel32"
+    m_binary->getCurrentDependecies().addDependency(
+                MangledNames::getMangleBlock(blockID, getStackSize(), BinaryDependencies::DEP_RELATIVE),
+                m_binary->getCurrentBlockData().getSize() - getStackSize(),
+                getStackSize(),
+                BinaryDependencies::DEP_RELATIVE,
+                0,
+                false,
+                -4);
+}
+
+void IA32CompilerInterface::generateUnwindData(bool isHelper,
+                                               const cString& cleanupName,
+                                               const UnwindClauseList& clauses)
+{
+    // The data is placed after the epilog, the same way as the literal pools
+    // of ARM. The layout is ExceptionHandling.UnwindData followed by an
+    // ExceptionHandling.UnwindClause for each clause
+    int currentBlockID = m_binary->getCurrentBlockID();
+    int dataBlockID = m_binary->getCurrentDependecies().getExtraBlocks() + MethodBlock::BLOCK_EXTRA_DATA;
+
+    MethodBlock* dataBlock = new MethodBlock(dataBlockID, *this);
+    StackInterfacePtr pstack(dataBlock);
+    m_binary->createNewBlockWithoutChange(dataBlockID, pstack);
+    m_binary->changeBasicBlock(dataBlockID);
+
+    appendUnwindWord(0, CallingConvention::gUnwindDataName);
+    appendUnwindWord(isHelper ? UNWIND_HELPER_FRAME : 0);
+    appendUnwindWord(0, cleanupName);
+    appendUnwindWord(clauses.length());
+
+    for (UnwindClauseList::iterator i = clauses.begin(); i != clauses.end(); i++)
+    {
+        appendUnwindBlock((*i).m_tryStartBlock);
+        appendUnwindBlock((*i).m_tryEndBlock);
+        appendUnwindWord((*i).m_type);
+        appendUnwindWord(0, (*i).m_handlerName);
+        appendUnwindWord((*i).m_exceptionRtti);
+    }
+
+    dataBlock->terminateMethodBlock(NULL, MethodBlock::COND_NON, 0);
+    m_binary->changeBasicBlock(currentBlockID);
+}
+
 void IA32CompilerInterface::call32(StackLocation address,
                                    StackLocation destination, uint)
 {
@@ -657,20 +858,14 @@ void IA32CompilerInterface::call32(StackLocation address,
         shouldCopyEax = true;
     }
 
-    if (true)
-    {
-        cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-        cStringerStream& compiler = *ia32compiler;
-        saveVolatileRegisters(getGPEncoding(ia32dis::IA32_GP32_EAX),
-                              destination.u.reg);
-        compiler << "call " << getRegister32(address) << endl;
-    }
+    saveVolatileRegisters(getGPEncoding(ia32dis::IA32_GP32_EAX),
+                          destination.u.reg);
+    IA32Encoder(*m_binary).callRegister(getEncoding(address));
 
     if (shouldCopyEax)
     {
-        cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-        cStringerStream& compiler = *ia32compiler;
-        compiler << "mov " << getRegister32(destination) << ", eax" << endl;
+        IA32Encoder(*m_binary).move(getEncoding(destination),
+                                    ia32dis::IA32_GP32_EAX);
     }
 }
 
@@ -813,21 +1008,37 @@ void IA32CompilerInterface::loadMemory(StackLocation destination,
     compiler << "]" << endl;
 }
 
+bool IA32CompilerInterface::isCopyMemorySupported() const
+{
+    return true;
+}
+
+void IA32CompilerInterface::copyMemory(StackLocation destination,
+                                       StackLocation source,
+                                       uint size)
+{
+    CHECK(isRegister32(destination));
+    CHECK(isRegister32(source));
+    CHECK((size % getStackSize()) == 0);
+
+    IA32Encoder encoder(*m_binary);
+    encoder.copyDwords(getEncoding(destination), getEncoding(source), size / getStackSize());
+}
+
 void IA32CompilerInterface::conv32(StackLocation destination,
                                    uint size,
                                    bool signExtend)
 {
     CHECK(isRegister32(destination));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
+    IA32Encoder encoder(*m_binary);
 
     switch (size)
     {
     case 1:
-        compiler << "and " << getRegister32(destination) << ", " << "0xFF";
+        encoder.aluConst(IA32Encoder::ALU_AND, getEncoding(destination), 0xFF);
         break;
     case 2:
-        compiler << "and " << getRegister32(destination) << ", " << "0xFFFF";
+        encoder.aluConst(IA32Encoder::ALU_AND, getEncoding(destination), 0xFFFF);
         break;
     case 4:
         // Nothing to do
@@ -835,25 +1046,18 @@ void IA32CompilerInterface::conv32(StackLocation destination,
     default:
         CHECK_FAIL();
     }
-    compiler << endl;
 }
 
 void IA32CompilerInterface::neg32(StackLocation destination)
 {
     CHECK(isRegister32(destination));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "neg " << getRegister32(destination) << endl;
+    IA32Encoder(*m_binary).unary(IA32Encoder::UNARY_NEG, getEncoding(destination));
 }
 
 void IA32CompilerInterface::not32(StackLocation destination)
 {
     CHECK(isRegister32(destination));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "not " << getRegister32(destination) << endl;
+    IA32Encoder(*m_binary).unary(IA32Encoder::UNARY_NOT, getEncoding(destination));
 }
 
 void IA32CompilerInterface::add32(StackLocation destination,
@@ -862,11 +1066,8 @@ void IA32CompilerInterface::add32(StackLocation destination,
     // Validate register
     CHECK(isRegister32(destination));
     CHECK(isRegister32(source));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "add " << getRegister32(destination) << ", " <<
-                          getRegister32(source) << endl;
+    IA32Encoder(*m_binary).alu(IA32Encoder::ALU_ADD, getEncoding(destination),
+                               getEncoding(source));
 }
 
 void IA32CompilerInterface::sub32(StackLocation destination,
@@ -875,11 +1076,8 @@ void IA32CompilerInterface::sub32(StackLocation destination,
     // Validate register
     CHECK(isRegister32(destination));
     CHECK(isRegister32(source));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "sub " << getRegister32(destination) << ", " <<
-                          getRegister32(source) << endl;
+    IA32Encoder(*m_binary).alu(IA32Encoder::ALU_SUB, getEncoding(destination),
+                               getEncoding(source));
 }
 
 void IA32CompilerInterface::mul32(StackLocation destination,
@@ -1050,11 +1248,8 @@ void IA32CompilerInterface::and32(StackLocation destination,
     // Validate register
     CHECK(isRegister32(destination));
     CHECK(isRegister32(source));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "and " << getRegister32(destination) << ", " <<
-                          getRegister32(source) << endl;
+    IA32Encoder(*m_binary).alu(IA32Encoder::ALU_AND, getEncoding(destination),
+                               getEncoding(source));
 }
 
 void IA32CompilerInterface::xor32(StackLocation destination,
@@ -1063,15 +1258,13 @@ void IA32CompilerInterface::xor32(StackLocation destination,
     // Validate register
     CHECK(isRegister32(destination));
     CHECK(isRegister32(source));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "xor " << getRegister32(destination) << ", " <<
-                          getRegister32(source) << endl;
+    IA32Encoder(*m_binary).alu(IA32Encoder::ALU_XOR, getEncoding(destination),
+                               getEncoding(source));
 }
 
-void IA32CompilerInterface::shr32(StackLocation destination,
-                                  StackLocation source)
+void IA32CompilerInterface::internalShift32(StackLocation destination,
+                                            StackLocation source,
+                                            const char* instruction)
 {
     // Validate register
     CHECK(isRegister32(destination));
@@ -1080,7 +1273,6 @@ void IA32CompilerInterface::shr32(StackLocation destination,
     cStringerStream& compiler = *ia32compiler;
 
     bool shouldMovDestinationEcx = false;
-
     if (source.u.reg != getGPEncoding(ia32dis::IA32_GP32_ECX))
     {
         if (destination.u.reg == getGPEncoding(ia32dis::IA32_GP32_ECX))
@@ -1097,46 +1289,30 @@ void IA32CompilerInterface::shr32(StackLocation destination,
 
     if (shouldMovDestinationEcx)
     {
-        compiler << "shr " << getRegister32(source) << ", cl" << endl;
+        compiler << instruction << " " << getRegister32(source) << ", cl" << endl;
         compiler << "xchg " << getRegister32(source) << ", " << getRegister32(destination) << endl;
     } else
     {
-        compiler << "shr " << getRegister32(destination) << ", cl" << endl;
+        compiler << instruction << " " << getRegister32(destination) << ", cl" << endl;
     }
 }
 
-void IA32CompilerInterface::shl32(StackLocation destination,
+void IA32CompilerInterface::shr32(StackLocation destination,
                                   StackLocation source)
 {
-    // Validate register
-    CHECK(isRegister32(destination));
-    CHECK(isRegister32(source));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
+    internalShift32(destination, source, "shr");
+}
 
-    bool shouldMovDestinationEcx = false;
-    if (source.u.reg != getGPEncoding(ia32dis::IA32_GP32_ECX))
-    {
-        if (destination.u.reg == getGPEncoding(ia32dis::IA32_GP32_ECX))
-        {
-            // ECX is the destination (should be the rotator)
-            shouldMovDestinationEcx = true;
-            compiler << "xchg " << getRegister32(source) << ", " << getRegister32(destination) << endl;
-        } else
-        {
-            freeRegister32(ia32dis::IA32_GP32_ECX, compiler);
-            compiler << "mov ecx, " << getRegister32(source) << endl;
-        }
-    }
+void IA32CompilerInterface::sar32(StackLocation destination,
+                                  StackLocation source)
+{
+    internalShift32(destination, source, "sar");
+}
 
-    if (shouldMovDestinationEcx)
-    {
-        compiler << "shl " << getRegister32(source) << ", cl" << endl;
-        compiler << "xchg " << getRegister32(source) << ", " << getRegister32(destination) << endl;
-    } else
-    {
-        compiler << "shl " << getRegister32(destination) << ", cl" << endl;
-    }
+void IA32CompilerInterface::shl32(StackLocation destination,
+                                  StackLocation source)
+{
+    internalShift32(destination, source, "shl");
 }
 
 void IA32CompilerInterface::or32(StackLocation destination,
@@ -1145,71 +1321,124 @@ void IA32CompilerInterface::or32(StackLocation destination,
     // Validate register
     CHECK(isRegister32(destination));
     CHECK(isRegister32(source));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "or " << getRegister32(destination) << ", " <<
-                         getRegister32(source) << endl;
+    IA32Encoder(*m_binary).alu(IA32Encoder::ALU_OR, getEncoding(destination),
+                               getEncoding(source));
 }
 
 void IA32CompilerInterface::adc32 (StackLocation destination, StackLocation source)
 {
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "adc " << getRegister32(destination) << ", " <<
-                         getRegister32(source) << endl;
+    IA32Encoder(*m_binary).alu(IA32Encoder::ALU_ADC, getEncoding(destination),
+                               getEncoding(source));
 }
 
 void IA32CompilerInterface::sbb32 (StackLocation destination, StackLocation source)
 {
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "sbb " << getRegister32(destination) << ", " <<
-                          getRegister32(source) << endl;
+    IA32Encoder(*m_binary).alu(IA32Encoder::ALU_SBB, getEncoding(destination),
+                               getEncoding(source));
 }
 
 void IA32CompilerInterface::mul32h(StackLocation destlow, StackLocation desthigh, StackLocation source, bool sign)
 {
     // Validate register
-    /*
-    CHECK(isRegister32(destination));
+    CHECK(isRegister32(destlow));
+    CHECK(isRegister32(desthigh));
     CHECK(isRegister32(source));
+    CHECK(destlow.u.reg != desthigh.u.reg);
     cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
     cStringerStream& compiler = *ia32compiler;
 
-    bool saveSourceInEAX = false;
+    int low = getGPEncoding(destlow.u.reg);
+    int high = getGPEncoding(desthigh.u.reg);
 
-    if (getGPEncoding(destination.u.reg) != ia32dis::IA32_GP32_EAX)
+    // The multiplication is commutative, if the source is already in EAX
+    // multiply it by destlow
+    StackLocation first = destlow;
+    StackLocation second = source;
+    if (getGPEncoding(source.u.reg) == ia32dis::IA32_GP32_EAX)
     {
-        if (getGPEncoding(source.u.reg) == ia32dis::IA32_GP32_EAX)
-        {
-            compiler << "push eax" << endl;
-            saveSourceInEAX = true;
-        } else
-        {
-            freeRegister32(ia32dis::IA32_GP32_EAX, compiler);
-            compiler << "mov eax, " << getRegister32(destination) << endl;
-        }
+        first = source;
+        second = destlow;
     }
 
-    // Check for saving result (edx)
-    freeRegister32(ia32dis::IA32_GP32_EDX, compiler);
-    compiler << "imul " << (saveSourceInEAX ? getRegister32(destination) : getRegister32(source)) << endl;
+    // EDX:EAX are the result of the multiplication
+    bool saveEax = (low != ia32dis::IA32_GP32_EAX) && (high != ia32dis::IA32_GP32_EAX);
+    bool saveEdx = (low != ia32dis::IA32_GP32_EDX) && (high != ia32dis::IA32_GP32_EDX);
+    if (saveEax)
+        compiler << "push eax" << endl;
+    if (saveEdx)
+        compiler << "push edx" << endl;
 
-    // Remove the memory pointer if exsisted.
-    if (getGPEncoding(destination.u.reg) != ia32dis::IA32_GP32_EAX)
+    if (getGPEncoding(first.u.reg) != ia32dis::IA32_GP32_EAX)
+        compiler << "mov  eax, " << getRegister32(first) << endl;
+
+    compiler << (sign ? "imul " : "mul ") << getRegister32(second) << endl;
+
+    // Move EDX:EAX into desthigh:destlow
+    if ((low == ia32dis::IA32_GP32_EDX) && (high == ia32dis::IA32_GP32_EAX))
     {
-        compiler << "mov " << getRegister32(destination) << ", eax" << endl;
+        compiler << "xchg eax, edx" << endl;
+    } else if (high == ia32dis::IA32_GP32_EAX)
+    {
+        compiler << "mov " << getRegister32(destlow) << ", eax" << endl;
+        compiler << "mov eax, edx" << endl;
+    } else
+    {
+        if (high != ia32dis::IA32_GP32_EDX)
+            compiler << "mov " << getRegister32(desthigh) << ", edx" << endl;
+        if (low != ia32dis::IA32_GP32_EAX)
+            compiler << "mov " << getRegister32(destlow) << ", eax" << endl;
     }
 
-    // Return EAX register
-    if (saveSourceInEAX)
-    {
+    // Restore properties
+    if (saveEdx)
+        compiler << "pop edx" << endl;
+    if (saveEax)
         compiler << "pop eax" << endl;
+}
+
+bool IA32CompilerInterface::isMultiplyHighSupported() const
+{
+    return true;
+}
+
+void IA32CompilerInterface::mulHigh32(StackLocation destination, StackLocation source, bool sign)
+{
+    // Validate register
+    CHECK(isRegister32(destination));
+    CHECK(isRegister32(source));
+    CHECK(destination.u.reg != source.u.reg);
+    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
+    cStringerStream& compiler = *ia32compiler;
+
+    int high = getGPEncoding(destination.u.reg);
+
+    // EDX:EAX are the result of the multiplication. The optimizer allocates
+    // the destination at EDX, see getOperationRegisterAllocationInfo
+    bool saveEax = (high != ia32dis::IA32_GP32_EAX);
+    bool saveEdx = (high != ia32dis::IA32_GP32_EDX);
+    if (saveEax)
+        compiler << "push eax" << endl;
+    if (saveEdx)
+        compiler << "push edx" << endl;
+
+    if (getGPEncoding(source.u.reg) == ia32dis::IA32_GP32_EAX)
+    {
+        compiler << (sign ? "imul " : "mul ") << getRegister32(destination) << endl;
+    } else
+    {
+        if (high != ia32dis::IA32_GP32_EAX)
+            compiler << "mov  eax, " << getRegister32(destination) << endl;
+        compiler << (sign ? "imul " : "mul ") << getRegister32(source) << endl;
     }
-    */
+
+    if (high != ia32dis::IA32_GP32_EDX)
+        compiler << "mov " << getRegister32(destination) << ", edx" << endl;
+
+    // Restore properties
+    if (saveEdx)
+        compiler << "pop edx" << endl;
+    if (saveEax)
+        compiler << "pop eax" << endl;
 }
 
 void IA32CompilerInterface::addConst32(const StackLocation destination,
@@ -1219,22 +1448,14 @@ void IA32CompilerInterface::addConst32(const StackLocation destination,
         return;
     // Validate register
     CHECK(isRegister32(destination));
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
-    compiler << "add " << getRegister32(destination) << ", 0x" <<
-                          HEXDWORD(value) << endl;
+    IA32Encoder(*m_binary).aluConst(IA32Encoder::ALU_ADD,
+                                    getEncoding(destination), value);
 }
 
 void IA32CompilerInterface::jump(int blockID)
 {
     // Compile the instruction
-    if (true)
-    {
-        cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-        cStringerStream& compiler = *ia32compiler;
-        compiler << "jmp $+66600666" << endl;
-    }
+    IA32Encoder(*m_binary).jumpRelative();
     // Add dependency to the last byte
     m_binary->getCurrentDependecies().addDependency(
                     MangledNames::getMangleBlock(blockID,
@@ -1277,14 +1498,11 @@ void IA32CompilerInterface::jumpCond(StackLocation compare,
     // Compile the instructions
     if (true)
     {
-        cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-        cStringerStream& compiler = *ia32compiler;
+        IA32Encoder encoder(*m_binary);
         // I don't know of a better way
-        compiler << "cmp " << getRegister32(compare) << ", 0" << endl;
-        if (isZero)
-            compiler << "jz $+66600666" << endl;
-        else
-            compiler << "jnz $+66600666" << endl;
+        encoder.aluConst(IA32Encoder::ALU_CMP, getEncoding(compare), 0);
+        encoder.jumpCondRelative(isZero ? IA32Encoder::COND_Z :
+                                          IA32Encoder::COND_NZ);
     }
 
     // Add dependency to the last byte
@@ -1327,6 +1545,61 @@ void IA32CompilerInterface::jumpCondShort(StackLocation compare,
                     true);
 }
 
+void IA32CompilerInterface::jumpCompare(StackLocation first,
+                                        StackLocation second,
+                                        CompareCondition condition,
+                                        bool isSigned,
+                                        int blockID)
+{
+    // Validate registers
+    CHECK(isRegister32(first));
+    CHECK(isRegister32(second));
+    // Compile the instructions
+    IA32Encoder encoder(*m_binary);
+    encoder.alu(IA32Encoder::ALU_CMP, getEncoding(first), getEncoding(second));
+    encoder.jumpCondRelative(gCompareConditions[condition][isSigned ? 1 : 0]);
+
+    // Add dependency to the last 4 bytes
+    m_binary->getCurrentDependecies().addDependency(
+                    MangledNames::getMangleBlock(blockID, getStackSize(), BinaryDependencies::DEP_RELATIVE),
+                    m_binary->getCurrentBlockData().getSize() - getStackSize(),
+                    getStackSize(),
+                    BinaryDependencies::DEP_RELATIVE,
+                    0,
+                    false,
+                    -4);
+}
+
+void IA32CompilerInterface::jumpCompareShort(StackLocation first,
+                                             StackLocation second,
+                                             CompareCondition condition,
+                                             bool isSigned,
+                                             int blockID)
+{
+    // Validate registers
+    CHECK(isRegister32(first));
+    CHECK(isRegister32(second));
+    // Compile the instructions
+    IA32Encoder(*m_binary).alu(IA32Encoder::ALU_CMP, getEncoding(first),
+                               getEncoding(second));
+    if (true)
+    {
+        cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
+        cStringerStream& compiler = *ia32compiler;
+        compiler << gCompareJumps[condition][isSigned ? 1 : 0] << " $-1" << endl;
+    }
+    // Add dependency to the last byte
+    m_binary->getCurrentDependecies().addDependency(
+                    MangledNames::getMangleBlock(blockID,
+                                            BinaryDependencies::DEP_8BIT,
+                                            BinaryDependencies::DEP_RELATIVE),
+                    m_binary->getCurrentBlockData().getSize()-1,
+                    BinaryDependencies::DEP_8BIT,
+                    BinaryDependencies::DEP_RELATIVE,
+                    0,
+                    true);
+}
+
 void IA32CompilerInterface::ceq32(StackLocation destination,
                                   StackLocation source)
 {
@@ -1555,6 +1828,8 @@ cString IA32CompilerInterface::getStackReference124(uint stackPosition,
                                                     uint size,
                                                     bool argumentStackLocation)
 {
+    m_isFrameRequired = true;
+
     cString ret;
     switch (size)
     {
@@ -1583,8 +1858,41 @@ cString IA32CompilerInterface::getStackReference124(uint stackPosition,
     return ret;
 }
 
+int32 IA32CompilerInterface::getStackDisplacement(uint stackPosition,
+                                                  bool argumentStackLocation)
+{
+    // See getStackReference124
+    if (argumentStackLocation)
+        return (int32)(stackPosition + 8);
+    return -(int32)(stackPosition + 4);
+}
+
+int32 IA32CompilerInterface::getTempStackDisplacement(uint stackPosition)
+{
+    // See getTempStack32
+    return -(int32)(stackPosition + 4 + m_binary->getStackBaseSize()
+                    - StackInterface::LOCAL_STACK_START_VALUE);
+}
+
+int IA32CompilerInterface::getEncoding(StackLocation destination)
+{
+    ASSERT(isRegister32(destination));
+    return getGPEncoding(destination.u.reg);
+}
+
+int IA32CompilerInterface::getBaseStackEncoding()
+{
+    m_isFrameRequired = true;
+    StackLocation baseRegister = getMethodBaseStackRegister();
+    if (baseRegister == StackInterface::NO_MEMORY)
+        return ia32dis::IA32_GP32_EBP;
+    ASSERT(baseRegister.u.flags == 0);
+    return getEncoding(baseRegister);
+}
+
 cString IA32CompilerInterface::getTempStack32(uint stackPosition, uint size)
 {
+    m_isFrameRequired = true;
     cString ret;
     switch (size)
     {
@@ -1652,10 +1960,26 @@ void IA32CompilerInterface::saveNonVolatileRegisters(cStringerStream& compiler,
     }
 }
 
+bool IA32CompilerInterface::isNonVolatileRegistersTouched()
+{
+    const RegisterAllocationTable& touched = m_binary->getTouchedRegisters();
+
+    cList<int> regs = m_archRegisters.keys();
+    for (cList<int>::iterator i = regs.begin(); i != regs.end(); i++)
+    {
+        if ((m_archRegisters[*i].m_eType == NonVolatile) && touched.hasKey(*i))
+            return true;
+    }
+    return false;
+}
+
 void IA32CompilerInterface::saveVolatileRegisters(int saveRegister1,
                                                   int saveRegister2,
                                                   int saveRegister3)
 {
+    // Only calls spill the volatile registers. The method is not a leaf
+    m_isFrameRequired = true;
+
     // Examine all known registers
     cList<int> regs = m_archRegisters.keys();
     cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
@@ -1681,19 +2005,20 @@ void IA32CompilerInterface::revertStack(uint32 size)
     if (size == 0)
         return;
 
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-    compiler << "add esp, 0x" << HEXDWORD(size) << endl;
+    m_isFrameRequired = true;
+
+    IA32Encoder(*m_binary).aluConst(IA32Encoder::ALU_ADD,
+                                    ia32dis::IA32_GP32_ESP, size);
 }
 
 void IA32CompilerInterface::setFramePointer(StackLocation destination)
 {
+    m_isFrameRequired = true;
     if (destination == getMethodBaseStackRegister())
         return;
 
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-    compiler << "mov " << getRegister32(destination) << ", " << getRegister32(getMethodBaseStackRegister()) << endl;
+    IA32Encoder(*m_binary).move(getEncoding(destination),
+                                getEncoding(getMethodBaseStackRegister()));
 }
 
 void IA32CompilerInterface::resetBaseStackRegister(const StackLocation& targetRegister)
@@ -1702,11 +2027,9 @@ void IA32CompilerInterface::resetBaseStackRegister(const StackLocation& targetRe
     if (getMethodBaseStackRegister() == targetRegister)
         return;
 
-    cStringerStreamPtr ia32compiler = m_assembler->getAssembler();
-    cStringerStream& compiler = *ia32compiler;
-
     // Set EBP (or otherwise the target's base register) to its real value
-    compiler << "mov " << getRegister32(targetRegister) << ", " << getRegister32(getMethodBaseStackRegister()) << endl;
+    IA32Encoder(*m_binary).move(getEncoding(targetRegister),
+                                getEncoding(getMethodBaseStackRegister()));
 
     // And forget that we ever used a different register
     setMethodBaseStackRegister(getStackPointer());
@@ -1776,6 +2099,17 @@ RegisterAllocationInfo IA32CompilerInterface::getOperationRegisterAllocationInfo
         {
             break;
         }
+        case CompilerInterface::OPCODE_PUSH_ARG_CONST_32:
+        case CompilerInterface::OPCODE_PUSH_ARG_STACK_32:
+        {
+            // No register is involved
+            break;
+        }
+        case CompilerInterface::OPCODE_TAIL_CALL:
+        {
+            // The method never returns here
+            break;
+        }
         case CompilerInterface::OPCODE_POP_ARG_32:
         {
             break;
@@ -1790,6 +2124,7 @@ RegisterAllocationInfo IA32CompilerInterface::getOperationRegisterAllocationInfo
             break;
         }
         case CompilerInterface::OPCODE_CALL_DEPENDENCY:
+        case CompilerInterface::OPCODE_GUARDED_CALL:
         {
             // Volatile registers should be saved before call
             registerAllocationInfo.m_modifiable.set(EAX);
@@ -1826,6 +2161,11 @@ RegisterAllocationInfo IA32CompilerInterface::getOperationRegisterAllocationInfo
         {
             break;
         }
+        case CompilerInterface::OPCODE_COPY_MEMORY:
+        {
+            // All the registers are restored
+            break;
+        }
         case CompilerInterface::OPCODE_CONV_32:
         {
             registerAllocationInfo.m_isDestAlsoSource = true;
@@ -1897,6 +2237,13 @@ RegisterAllocationInfo IA32CompilerInterface::getOperationRegisterAllocationInfo
             registerAllocationInfo.m_acceptableSource.set(ECX);
             break;
         }
+        case CompilerInterface::OPCODE_SAR_32:
+        {
+            registerAllocationInfo.m_isDestAlsoSource = true;
+            registerAllocationInfo.m_acceptableSource.resetArray();
+            registerAllocationInfo.m_acceptableSource.set(ECX);
+            break;
+        }
         case CompilerInterface::OPCODE_SHL_32:
         {
             registerAllocationInfo.m_isDestAlsoSource = true;
@@ -1921,7 +2268,12 @@ RegisterAllocationInfo IA32CompilerInterface::getOperationRegisterAllocationInfo
         }
         case CompilerInterface::OPCODE_MUL_32H:
         {
+            // See mulHigh32
             registerAllocationInfo.m_isDestAlsoSource = true;
+            registerAllocationInfo.m_acceptableDest.resetArray();
+            registerAllocationInfo.m_acceptableDest.set(EDX);
+            registerAllocationInfo.m_acceptableSource.clear(EAX);
+            registerAllocationInfo.m_modifiable.set(EAX);
             break;
         }
         case CompilerInterface::OPCODE_ADD_CONST_32:
@@ -1945,6 +2297,13 @@ RegisterAllocationInfo IA32CompilerInterface::getOperationRegisterAllocationInfo
         {
             break;
         }
+        case CompilerInterface::OPCODE_JUMP_COMPARE:
+        case CompilerInterface::OPCODE_JUMP_COMPARE_SHORT:
+        {
+            // Both registers are only read
+            registerAllocationInfo.m_isDestAlsoSource = true;
+            break;
+        }
         case CompilerInterface::OPCODE_CEQ_32:
         {
             break;
@@ -118,6 +118,9 @@ public:
 
     virtual RegisterAllocationInfo getOperationRegisterAllocationInfo(CompilerInterface::CompilerOperation& operation);
 
+    // See OptimizerOperationCompilerInterface::mulHigh32
+    virtual void mulHigh32(StackLocation destination, StackLocation source, bool sign);
+
     //////////////////////////////////////////////////////////////////////////
     // Stack operations
 
@@ -171,6 +174,10 @@ public:
     virtual void assignRet32(StackLocation source);
     // See CompilerInterface::pushArg32
     virtual void pushArg32(StackLocation source);
+    // See CompilerInterface::pushArgConst32
+    virtual void pushArgConst32(int32 value);
+    // See CompilerInterface::pushArgStack32
+    virtual void pushArgStack32(uint stackPosition, bool argumentStackLocation);
     // See CompilerInterface::popArg32
     virtual void popArg32(StackLocation source);
     // See CompilerInterface::call
@@ -181,6 +188,30 @@ public:
                         StackLocation destination, uint numberOfArguments);
     virtual void call32(StackLocation address,
                         StackLocation destination, uint numberOfArguments);
+    // See CompilerInterface::isTailCallSupported
+    virtual bool isTailCallSupported() const;
+    // See CompilerInterface::tailCall
+    virtual void tailCall(const cString& dependencyName, uint argumentsSize);
+    // See CompilerInterface::isGuardedCallSupported
+    virtual bool isGuardedCallSupported() const;
+    // See CompilerInterface::guardedCall. cmp byte [guard], 0 / jnz / call
+    virtual void guardedCall(const cString& guardName, const cString& dependencyName);
+    // See CompilerInterface::getArgumentRegistersCount. EDX and EBX, the
+    // volatile registers which no call preserves anyway
+    virtual uint getArgumentRegistersCount() const;
+    // See CompilerInterface::getArgumentRegister
+    virtual StackLocation getArgumentRegister(uint index) const;
+    // See CompilerInterface::pushArgRegisters32. sub esp, 4*count
+    virtual void pushArgRegisters32(uint count);
+    // See CompilerInterface::setRegisterEntry
+    virtual void setRegisterEntry(uint count);
+    // See CompilerInterface::isUnwindDataSupported. The frames are chained
+    // through ebp
+    virtual bool isUnwindDataSupported() const;
+    // See CompilerInterface::generateUnwindData
+    virtual void generateUnwindData(bool isHelper,
+                                    const cString& cleanupName,
+                                    const UnwindClauseList& clauses);
     //////////////////////////////////////////////////////////////////////////
     // Memory handling
 
@@ -192,6 +223,10 @@ public:
     // See CompilerInterface::loadMemory
     virtual void loadMemory(StackLocation destination, StackLocation value, uint offset,
                             uint size, bool signExtend = false);
+    // See CompilerInterface::isCopyMemorySupported
+    virtual bool isCopyMemorySupported() const;
+    // See CompilerInterface::copyMemory. Implemented with rep movsd
+    virtual void copyMemory(StackLocation destination, StackLocation source, uint size);
 
 
 
@@ -218,16 +253,22 @@ public:
     virtual void and32(StackLocation destination, StackLocation source);
     virtual void xor32(StackLocation destination, StackLocation source);
     virtual void shr32(StackLocation destination, StackLocation source);
+    virtual void sar32(StackLocation destination, StackLocation source);
     virtual void shl32(StackLocation destination, StackLocation source);
     virtual void or32 (StackLocation destination, StackLocation source);
 
     virtual void adc32 (StackLocation destination, StackLocation source);
     virtual void sbb32 (StackLocation destination, StackLocation source);
     virtual void mul32h(StackLocation destlow, StackLocation desthigh, StackLocation source, bool sign);
+    virtual bool isMultiplyHighSupported() const;
     // Internal implementation of div32 and rem32. The algorithm is the same
     // the return register is the different
     void internalDiv32(StackLocation destination, StackLocation source,
                        bool sign, bool isDiv);
+    // Internal implementation of shr32, sar32 and shl32. The count is moved
+    // into CL. 'instruction' is the mnemonic of the shift
+    void internalShift32(StackLocation destination, StackLocation source,
+                         const char* instruction);
 
     // See CompilerInterface::addConst32
     virtual void addConst32(const StackLocation destination,
@@ -244,6 +285,14 @@ public:
     virtual void jumpCond(StackLocation compare, int blockID, bool isZero);
     virtual void jumpCondShort(StackLocation compare, int blockID, bool isZero);
 
+    // See CompilerInterface::jumpCompare.s
+    virtual void jumpCompare(StackLocation first, StackLocation second,
+                             CompareCondition condition, bool isSigned,
+                             int blockID);
+    virtual void jumpCompareShort(StackLocation first, StackLocation second,
+                                  CompareCondition condition, bool isSigned,
+                                  int blockID);
+
     //////////////////////////////////////////////////////////////////////////
     // Comparison methods
 
@@ -320,6 +369,24 @@ private:
      */
     cString getTempStack32(uint stackPosition, uint size);
 
+    /*
+     * Return the displacement from the base stack register for the references
+     * returned by getStackReference124() and getTempStack32()
+     */
+    static int32 getStackDisplacement(uint stackPosition,
+                                      bool argumentStackLocation);
+    int32 getTempStackDisplacement(uint stackPosition);
+
+    /*
+     * Return the ModR/M encoding of a 32 bit register. See IA32Encoder
+     */
+    static int getEncoding(StackLocation destination);
+
+    /*
+     * Return the ModR/M encoding of the base register for locals/arguments
+     */
+    int getBaseStackEncoding();
+
     /*
      * Return the name of a 32/16/8 bit register according to the register index
      */
@@ -354,11 +421,42 @@ private:
                                int saveRegister3 = 0);
 
 
+    /*
+     * Return true if any of the non-volatile registers was touched
+     */
+    bool isNonVolatileRegistersTouched();
+
+    // The flag of the unwind data of a helper. See
+    // ExceptionHandling.UnwindHelperFrame
+    enum { UNWIND_HELPER_FRAME = 1 };
+
+    /*
+     * Append a word of the unwind data to the current block. If
+     * 'dependencyName' isn't empty the word is its absolute address.
+     */
+    void appendUnwindWord(uint32 value, const cString& dependencyName = cString());
+
+    /*
+     * Append a word of the unwind data which holds the address of the block
+     * 'blockID', relative to the end of the word
+     */
+    void appendUnwindBlock(int blockID);
+
     // Function specific information
     //       NOTE: All of the following members can be implemented as the
     //             FirstBinary private data. This should be useful when encoding
     //             will be in use.
 
+    // Set once the method addresses its frame (arguments, locals, temporary
+    // stack), calls another method or moves the stack pointer. Leaf methods
+    // which never do that are compiled without "push ebp/mov ebp, esp"
+    bool m_isFrameRequired;
+    // The blocks which end with a tail call, and the method they jump into.
+    // The jump is emitted by generateMethodEpiProLogs
+    cHash<int, cString> m_tailCalls;
+    // The number of argument registers the register entry of the method
+    // stores. See setRegisterEntry()
+    uint m_registerEntryCount;
 };
 
 #endif // __TBA_CLR_COMPILER_PROCESSORS_IA32_IA32COMPILERINTERFACE_H
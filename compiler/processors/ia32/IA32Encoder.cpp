@@ -0,0 +1,344 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * IA32Encoder.cpp
+ *
+ * Implementation file
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "compiler/stdafx.h"
+#include "compiler/processors/ia32/IA32Encoder.h"
+
+// The registers which have special meaning in the ModR/M byte
+#define ESP (4)
+#define EBP (5)
+// The registers of rep movsd
+#define ECX (1)
+#define ESI (6)
+#define EDI (7)
+
+// Opcodes
+#define OPCODE_ALU_RM32_R32 (0x01) // Or'ed with operation << 3
+#define OPCODE_ALU_RM32_IMM32 (0x81)
+#define OPCODE_ALU_RM32_IMM8 (0x83)
+#define OPCODE_UNARY_RM32 (0xF7)
+#define OPCODE_MOV_RM32_R32 (0x89)
+#define OPCODE_MOV_R32_IMM32 (0xB8) // Or'ed with the register
+#define OPCODE_LEA (0x8D)
+#define OPCODE_PUSH_R32 (0x50) // Or'ed with the register
+#define OPCODE_POP_R32 (0x58)  // Or'ed with the register
+#define OPCODE_PUSH_IMM32 (0x68)
+#define OPCODE_PUSH_IMM8 (0x6A)
+#define OPCODE_POP_RM32 (0x8F) // /0
+#define OPCODE_CALL_REL32 (0xE8)
+#define OPCODE_JMP_REL32 (0xE9)
+#define OPCODE_JMP_REL8 (0xEB)
+#define OPCODE_NOP (0x90)
+#define OPCODE_GROUP5 (0xFF) // call r/m32 is /2
+#define OPCODE_TWO_BYTES (0x0F)
+#define OPCODE_JCC_REL32 (0x80) // Second byte. Or'ed with the condition
+#define OPCODE_JCC_REL8 (0x70) // Or'ed with the condition
+#define OPCODE_ALU_RM8_IMM8 (0x80)
+#define OPCODE_OPERAND_SIZE (0x66)
+#define OPCODE_REP (0xF3)
+#define OPCODE_MOVSD (0xA5)
+
+#define GROUP5_CALL (2)
+#define GROUP5_PUSH (6)
+
+/*
+ * The load opcodes table, indexed by [size][signExtend]. A zero in the first
+ * byte means a single byte opcode.
+ */
+struct LoadOpcode {
+    uint8 m_prefix;
+    uint8 m_opcode;
+};
+
+static const LoadOpcode gLoadOpcodes[3][2] = {
+    // 8 bit: movzx, movsx
+    {{OPCODE_TWO_BYTES, 0xB6}, {OPCODE_TWO_BYTES, 0xBE}},
+    // 16 bit: movzx, movsx
+    {{OPCODE_TWO_BYTES, 0xB7}, {OPCODE_TWO_BYTES, 0xBF}},
+    // 32 bit: mov
+    {{0, 0x8B}, {0, 0x8B}}
+};
+
+/*
+ * The store opcodes table, indexed by size
+ */
+static const LoadOpcode gStoreOpcodes[3] = {
+    {0, 0x88},                   // 8 bit
+    {OPCODE_OPERAND_SIZE, 0x89}, // 16 bit
+    {0, 0x89}                    // 32 bit
+};
+
+/*
+ * Translate size 1, 2, 4 into the index of the tables above
+ */
+static uint getSizeIndex(uint size)
+{
+    switch (size)
+    {
+    case 1: return 0;
+    case 2: return 1;
+    case 4: return 2;
+    }
+    CHECK_FAIL();
+    return 0;
+}
+
+IA32Encoder::IA32Encoder(FirstPassBinary& binary) :
+    m_binary(binary)
+{
+}
+
+void IA32Encoder::alu(AluOperation operation, int destination, int source)
+{
+    m_binary.appendUint8(OPCODE_ALU_RM32_R32 | (operation << 3));
+    encodeRegister(source, destination);
+}
+
+void IA32Encoder::aluConst(AluOperation operation, int destination,
+                           int32 value)
+{
+    if ((value >= -0x80) && (value < 0x80))
+    {
+        m_binary.appendUint8(OPCODE_ALU_RM32_IMM8);
+        encodeRegister(operation, destination);
+        m_binary.appendUint8((uint8)value);
+    } else
+    {
+        m_binary.appendUint8(OPCODE_ALU_RM32_IMM32);
+        encodeRegister(operation, destination);
+        appendUint32((uint32)value);
+    }
+}
+
+void IA32Encoder::unary(UnaryOperation operation, int destination)
+{
+    m_binary.appendUint8(OPCODE_UNARY_RM32);
+    encodeRegister(operation, destination);
+}
+
+void IA32Encoder::move(int destination, int source)
+{
+    m_binary.appendUint8(OPCODE_MOV_RM32_R32);
+    encodeRegister(source, destination);
+}
+
+void IA32Encoder::moveConst(int destination, uint32 value)
+{
+    m_binary.appendUint8(OPCODE_MOV_R32_IMM32 | destination);
+    appendUint32(value);
+}
+
+void IA32Encoder::load(int destination, int base, int32 displacement,
+                       uint size, bool signExtend)
+{
+    const LoadOpcode& opcode = gLoadOpcodes[getSizeIndex(size)][signExtend ? 1 : 0];
+    if (opcode.m_prefix != 0)
+        m_binary.appendUint8(opcode.m_prefix);
+    m_binary.appendUint8(opcode.m_opcode);
+    encodeMemory(destination, base, displacement);
+}
+
+void IA32Encoder::store(int base, int32 displacement, int source, uint size)
+{
+    // Only al, cl, dl, bl can be encoded for 8 bit stores
+    CHECK((size != 1) || (source < ESP));
+
+    const LoadOpcode& opcode = gStoreOpcodes[getSizeIndex(size)];
+    if (opcode.m_prefix != 0)
+        m_binary.appendUint8(opcode.m_prefix);
+    m_binary.appendUint8(opcode.m_opcode);
+    encodeMemory(source, base, displacement);
+}
+
+void IA32Encoder::loadAddress(int destination, int base, int32 displacement)
+{
+    m_binary.appendUint8(OPCODE_LEA);
+    encodeMemory(destination, base, displacement);
+}
+
+void IA32Encoder::push(int source)
+{
+    m_binary.appendUint8(OPCODE_PUSH_R32 | source);
+}
+
+void IA32Encoder::pop(int destination)
+{
+    m_binary.appendUint8(OPCODE_POP_R32 | destination);
+}
+
+void IA32Encoder::pushConst(int32 value)
+{
+    if ((value >= -0x80) && (value < 0x80))
+    {
+        m_binary.appendUint8(OPCODE_PUSH_IMM8);
+        m_binary.appendUint8((uint8)value);
+    } else
+    {
+        m_binary.appendUint8(OPCODE_PUSH_IMM32);
+        appendUint32((uint32)value);
+    }
+}
+
+void IA32Encoder::pushMemory(int base, int32 displacement)
+{
+    m_binary.appendUint8(OPCODE_GROUP5);
+    encodeMemory(GROUP5_PUSH, base, displacement);
+}
+
+void IA32Encoder::popMemory(int base, int32 displacement)
+{
+    m_binary.appendUint8(OPCODE_POP_RM32);
+    encodeMemory(0, base, displacement);
+}
+
+void IA32Encoder::repMoveDwords()
+{
+    m_binary.appendUint8(OPCODE_REP);
+    m_binary.appendUint8(OPCODE_MOVSD);
+}
+
+void IA32Encoder::copyDwords(int destination, int source, uint32 count)
+{
+    // rep movsd is bound to esi, edi and ecx. Save them and pass the addresses
+    // through the stack, so it doesn't matter which of them holds what
+    push(ESI);
+    push(EDI);
+    push(ECX);
+    push(source);
+    push(destination);
+    pop(EDI);
+    pop(ESI);
+    moveConst(ECX, count);
+    repMoveDwords();
+    pop(ECX);
+    pop(EDI);
+    pop(ESI);
+}
+
+uint IA32Encoder::compareByteAbsolute(uint8 value)
+{
+    // mod 00 with r/m 101 encodes a [disp32] address
+    m_binary.appendUint8(OPCODE_ALU_RM8_IMM8);
+    m_binary.appendUint8((ALU_CMP << 3) | EBP);
+    uint position = m_binary.getCurrentBlockData().getSize();
+    appendUint32(DEPENDENCY_PLACEHOLDER);
+    m_binary.appendUint8(value);
+    return position;
+}
+
+void IA32Encoder::callRelative()
+{
+    m_binary.appendUint8(OPCODE_CALL_REL32);
+    appendUint32(DEPENDENCY_PLACEHOLDER);
+}
+
+void IA32Encoder::callRegister(int address)
+{
+    m_binary.appendUint8(OPCODE_GROUP5);
+    encodeRegister(GROUP5_CALL, address);
+}
+
+void IA32Encoder::jumpRelative()
+{
+    m_binary.appendUint8(OPCODE_JMP_REL32);
+    appendUint32(DEPENDENCY_PLACEHOLDER);
+}
+
+void IA32Encoder::jumpCondRelative(Condition condition)
+{
+    m_binary.appendUint8(OPCODE_TWO_BYTES);
+    m_binary.appendUint8(OPCODE_JCC_REL32 | condition);
+    appendUint32(DEPENDENCY_PLACEHOLDER);
+}
+
+void IA32Encoder::jumpCondShort(Condition condition, int8 displacement)
+{
+    m_binary.appendUint8(OPCODE_JCC_REL8 | condition);
+    m_binary.appendUint8((uint8)displacement);
+}
+
+void IA32Encoder::jumpShort(int8 displacement)
+{
+    m_binary.appendUint8(OPCODE_JMP_REL8);
+    m_binary.appendUint8((uint8)displacement);
+}
+
+void IA32Encoder::nop()
+{
+    m_binary.appendUint8(OPCODE_NOP);
+}
+
+void IA32Encoder::encodeRegister(int reg, int rm)
+{
+    ASSERT((reg >= 0) && (reg < 8) && (rm >= 0) && (rm < 8));
+    // mod = 11
+    m_binary.appendUint8(0xC0 | (reg << 3) | rm);
+}
+
+void IA32Encoder::encodeMemory(int reg, int base, int32 displacement)
+{
+    ASSERT((reg >= 0) && (reg < 8) && (base >= 0) && (base < 8));
+
+    // [ebp] must be encoded with a displacement, mod = 00 means disp32
+    uint8 mod;
+    if ((displacement == 0) && (base != EBP))
+        mod = 0x00;
+    else if ((displacement >= -0x80) && (displacement < 0x80))
+        mod = 0x40;
+    else
+        mod = 0x80;
+
+    m_binary.appendUint8(mod | (reg << 3) | base);
+
+    // [esp + X] requires a SIB byte: no index, base esp
+    if (base == ESP)
+        m_binary.appendUint8((ESP << 3) | ESP);
+
+    if (mod == 0x40)
+        m_binary.appendUint8((uint8)displacement);
+    else if (mod == 0x80)
+        appendUint32((uint32)displacement);
+}
+
+void IA32Encoder::appendUint32(uint32 value)
+{
+    m_binary.appendUint8((uint8)(value));
+    m_binary.appendUint8((uint8)(value >> 8));
+    m_binary.appendUint8((uint8)(value >> 16));
+    m_binary.appendUint8((uint8)(value >> 24));
+}
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_COMPILER_PROCESSORS_IA32_IA32ENCODER_H
+#define __TBA_CLR_COMPILER_PROCESSORS_IA32_IA32ENCODER_H
+
+/*
+ * IA32Encoder.h
+ *
+ * Encodes the common x86 instructions directly into a FirstPassBinary.
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "xStl/types.h"
+#include "dismount/assembler/FirstPassBinary.h"
+
+/*
+ * The IA32CompilerInterface generates most of its code as text which is
+ * parsed by the dismount assembler. For the hot instructions (moves, stack
+ * loads/stores, ALU operations, calls and jumps) this class writes the
+ * machine bytes directly into the binary.
+ *
+ * Registers are given in their ModR/M encoding, which is the same numbering
+ * used by ia32dis::IA32_GP32_XXX (eax, ecx, edx, ebx, esp, ebp, esi, edi).
+ *
+ * Instructions which carry a dependency are encoded with a 32-bit
+ * placeholder as their last 4 bytes, exactly like the text path, so the
+ * caller adds the dependency for the last 'getStackSize()' bytes.
+ *
+ * NOTE: The encoder must not be used while a text assembler stream
+ *       (AssemblerInterface::getAssembler()) is still open, otherwise the
+ *       order of the instructions will be broken.
+ */
+class IA32Encoder {
+public:
+    /*
+     * Constructor. Appends all instructions into the current block of
+     * 'binary'
+     */
+    IA32Encoder(FirstPassBinary& binary);
+
+    // The value written for instructions which are fixed by a dependency
+    enum { DEPENDENCY_PLACEHOLDER = 0x66600666 };
+
+    // The ALU operations. The value is the /digit of the 0x81/0x83 opcodes
+    enum AluOperation {
+        ALU_ADD = 0,
+        ALU_OR  = 1,
+        ALU_ADC = 2,
+        ALU_SBB = 3,
+        ALU_AND = 4,
+        ALU_SUB = 5,
+        ALU_XOR = 6,
+        ALU_CMP = 7
+    };
+
+    // The unary operations. The value is the /digit of the 0xF7 opcode
+    enum UnaryOperation {
+        UNARY_NOT = 2,
+        UNARY_NEG = 3
+    };
+
+    // Jump conditions. The value is the 'tttn' field of the Jcc opcode
+    enum Condition {
+        COND_B  = 0x2,
+        COND_AE = 0x3,
+        COND_Z  = 0x4,
+        COND_NZ = 0x5,
+        COND_BE = 0x6,
+        COND_A  = 0x7,
+        COND_L  = 0xC,
+        COND_GE = 0xD,
+        COND_LE = 0xE,
+        COND_G  = 0xF
+    };
+
+    /*
+     * op destination, source
+     */
+    void alu(AluOperation operation, int destination, int source);
+
+    /*
+     * op destination, value
+     *
+     * Values which fit in a signed byte are encoded in the short form
+     */
+    void aluConst(AluOperation operation, int destination, int32 value);
+
+    /*
+     * neg/not destination
+     */
+    void unary(UnaryOperation operation, int destination);
+
+    /*
+     * mov destination, source
+     */
+    void move(int destination, int source);
+
+    /*
+     * mov destination, value
+     */
+    void moveConst(int destination, uint32 value);
+
+    /*
+     * mov/movsx/movzx destination, [base + displacement]
+     *
+     * size       - 1, 2 or 4 bytes
+     * signExtend - Use movsx instead of movzx for sizes 1 and 2
+     */
+    void load(int destination, int base, int32 displacement, uint size,
+              bool signExtend);
+
+    /*
+     * mov [base + displacement], source
+     *
+     * size - 1, 2 or 4 bytes. For size 1 'source' must be eax, ecx, edx or ebx
+     */
+    void store(int base, int32 displacement, int source, uint size);
+
+    /*
+     * lea destination, [base + displacement]
+     */
+    void loadAddress(int destination, int base, int32 displacement);
+
+    /*
+     * push/pop register
+     */
+    void push(int source);
+    void pop(int destination);
+
+    /*
+     * push imm8/imm32 (sign-extended), push dword [base + displacement]
+     */
+    void pushConst(int32 value);
+    void pushMemory(int base, int32 displacement);
+
+    /*
+     * pop dword [base + displacement]
+     */
+    void popMemory(int base, int32 displacement);
+
+    /*
+     * rep movsd. Copies ecx dwords from [esi] into [edi]
+     */
+    void repMoveDwords();
+
+    /*
+     * Copy 'count' dwords from [source] into [destination] with rep movsd.
+     * esi, edi and ecx are saved and restored, so all the registers keep
+     * their values.
+     */
+    void copyDwords(int destination, int source, uint32 count);
+
+    /*
+     * cmp byte [address], value. The address is a placeholder which is
+     * followed by the 1 byte immediate, so unlike the other instructions its
+     * dependency doesn't end the instruction.
+     *
+     * Return the position of the address inside the current block, which is
+     * the position of the dependency.
+     */
+    uint compareByteAbsolute(uint8 value);
+
+    /*
+     * call rel32 (placeholder) / call register
+     */
+    void callRelative();
+    void callRegister(int address);
+
+    /*
+     * jmp rel32 (placeholder) / jcc rel32 (placeholder)
+     */
+    void jumpRelative();
+    void jumpCondRelative(Condition condition);
+
+    /*
+     * jcc rel8. Used for jumps inside a single operation, which are known
+     * when the operation is encoded
+     */
+    void jumpCondShort(Condition condition, int8 displacement);
+
+    /*
+     * jmp rel8 / nop. Used for the register entry of a method
+     */
+    void jumpShort(int8 displacement);
+    void nop();
+
+private:
+    /*
+     * Encode the ModR/M byte (and SIB/displacement if needed) for the
+     * register-direct addressing mode.
+     */
+    void encodeRegister(int reg, int rm);
+
+    /*
+     * Encode the ModR/M byte, SIB and displacement of [base + displacement]
+     */
+    void encodeMemory(int reg, int base, int32 displacement);
+
+    /*
+     * Append a 32-bit little-endian value
+     */
+    void appendUint32(uint32 value);
+
+    // The binary to write into
+    FirstPassBinary& m_binary;
+};
+
+#endif // __TBA_CLR_COMPILER_PROCESSORS_IA32_IA32ENCODER_H
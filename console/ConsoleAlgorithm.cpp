@@ -32,8 +32,9 @@
 #include "stdafx.h"
 #include "console/ConsoleAlgorithm.h"
 
-ConsoleAlgorithm::ConsoleAlgorithm(const TokenIndex& mainMethod, ApartmentPtr mainApartment, CompilerEngineThread& engine, const LinkerInterfacePtr& linker):
-    DefaultCompilerAlgorithm(mainMethod, mainApartment, engine, linker)
+ConsoleAlgorithm::ConsoleAlgorithm(const TokenIndex& mainMethod, ApartmentPtr mainApartment, CompilerEngineThread& engine, const LinkerInterfacePtr& linker,
+                                   bool shouldScanDependencies):
+    DefaultCompilerAlgorithm(mainMethod, mainApartment, engine, linker, shouldScanDependencies)
 {
 }
 
@@ -44,7 +44,8 @@ class ConsoleAlgorithm : public DefaultCompilerAlgorithm
 {
 public:
     // See DefaultCompilerAlgorithm::DefaultCompilerAlgorithm
-    ConsoleAlgorithm(const TokenIndex& mainMethod, ApartmentPtr mainApartment, CompilerEngineThread& engine, const LinkerInterfacePtr& linker);
+    ConsoleAlgorithm(const TokenIndex& mainMethod, ApartmentPtr mainApartment, CompilerEngineThread& engine, const LinkerInterfacePtr& linker,
+                     bool shouldScanDependencies = true);
     virtual void onMethodCompiled(const TokenIndex& mid, SecondPassBinary& compiled, bool inCache);
 private:
     // Deny copy-constructor and operator =
@@ -29,6 +29,7 @@
  * POSSIBILITY OF SUCH DAMAGE
  */
 
+#include <stdlib.h>
 #include "stdafx.h"
 #include "data/exceptions.h"
 #include "runnable/GlobalContext.h"
@@ -40,12 +41,16 @@
 #include "format/EncodingUtils.h"
 #include "format/tables/TablesID.h"
 #include "format/tables/AssemblyRefTable.h"
+#include "xStl/data/list.h"
+#include "xStl/os/threadedClass.h"
+#include "xStl/os/event.h"
 #include "console/minidump.h"
 #include "console/ConsoleAlgorithm.h"
 
 // TODO! Add class
-static ApartmentPtr loadPE(const cString& exePath, const char * dllPath, MemoryLayoutInterfacePtr& memoryLayout);
-static ApartmentPtr createApartment(const cString& pePath, MemoryLayoutInterfacePtr& memoryLayout, ApartmentPtr& parentApartment);
+static ApartmentPtr loadPE(const ApartmentImagePtr& exeImage, const ApartmentImagePtr& dllImage, MemoryLayoutInterfacePtr& memoryLayout);
+static ApartmentImagePtr loadImage(const cString& pePath);
+static ApartmentPtr createApartment(const ApartmentImagePtr& image, MemoryLayoutInterfacePtr& memoryLayout, ApartmentPtr& parentApartment);
 static void loadAssemblyRef(ApartmentPtr& apt, ApartmentPtr& mainApartment, MemoryLayoutInterfacePtr& memoryLayout);
 
 struct WorkType
@@ -60,9 +65,11 @@ static const WorkType workTypes[] =
 {
     {"x86",            CompilerFactory::COMPILER_IA32,             LinkerFactory::ELF_LINKER, "Create an ELF output.o file compiled for x86"},
     {"x86-mem",           CompilerFactory::COMPILER_IA32,             LinkerFactory::MEMORY_LINKER, "Create memory-linked x86 code and execute it"},
-    {"32c",               CompilerFactory::COMPILER_32C,             LinkerFactory::FILE_LINKER, "Create a C/C++ language output.c file"},
+    {"x86-lazy",          CompilerFactory::COMPILER_IA32,             LinkerFactory::LAZY_MEMORY_LINKER, "Execute memory-linked x86 code, compiling methods on first call"},
+    {"32c",               CompilerFactory::COMPILER_32C,             LinkerFactory::FILE_LINKER, "Create C/C++ language output.h and output.c files"},
     {"arm",               CompilerFactory::COMPILER_ARM,             LinkerFactory::ELF_LINKER, "Create an ARM-compiled output file"},
     {"thumb",           CompilerFactory::COMPILER_THUMB,             LinkerFactory::ELF_LINKER, "Create an THUMB-compiled output file"},
+    {"thumb2",          CompilerFactory::COMPILER_THUMB2,            LinkerFactory::ELF_LINKER, "Create an THUMB-2 (ARMv7-M) compiled output file"},
 };
 
 const uint workTypeCount = sizeof(workTypes) / sizeof(workTypes[0]);
@@ -86,22 +93,47 @@ const uint compilerParamCount = sizeof(compilerParams) / sizeof(compilerParams[0
 
 // Program parameters
 cString precompiledMethodsPath = "";
+bool shouldFreezeTypes = false;
+bool shouldMergeStringTails = false;
+cString outputDirectory = "";
+uint outputUnitsCount = 1;
 cSetArray works;
 CompilerParameters params = CompilerInterface::defaultParameters;
 
 static void runEngine(ApartmentPtr mainApartment,
                       const CompilerFactory::CompilerType compilerType,
                       const LinkerFactory::LinkerType linkerType,
-                      const cString& repositoryFilename)
+                      const cString& repositoryFilename,
+                      const cString& elfOutputFilename)
 {
     CompilerEngineThread thread(compilerType, params, mainApartment, repositoryFilename);
-    LinkerInterfacePtr linker = LinkerFactory::getLinker(linkerType, thread, mainApartment);
-    ConsoleAlgorithm consoleAlgo(mainApartment->getEntryPointToken(), mainApartment, thread, linker);
+    LinkerInterfacePtr linker = LinkerFactory::getLinker(linkerType, thread, mainApartment, outputDirectory, outputUnitsCount, elfOutputFilename);
+    // The lazy linker compiles the rest of the methods on their first call
+    bool shouldScanDependencies = (linkerType != LinkerFactory::LAZY_MEMORY_LINKER);
+    ConsoleAlgorithm consoleAlgo(mainApartment->getEntryPointToken(), mainApartment, thread, linker, shouldScanDependencies);
     thread.addNotifier(consoleAlgo);
     thread.run(consoleAlgo);
 }
 
-static ApartmentPtr createApartment(const cString& pePath,
+static ApartmentImagePtr loadImage(const cString& pePath)
+{
+    ApartmentImagePtr image;
+
+    XSTL_TRY
+    {
+        // The file is mapped, its pages are shared with other compilations
+        image = ApartmentFactory::mapImage(pePath);
+    }
+    XSTL_CATCH_ALL
+    {
+        ConsoleTrace("Unable to load image " << pePath << endl);
+        XSTL_RETHROW;
+    }
+
+    return image;
+}
+
+static ApartmentPtr createApartment(const ApartmentImagePtr& image,
                                     MemoryLayoutInterfacePtr& memoryLayout,
                                     ApartmentPtr& parentApartment)
 {
@@ -109,10 +141,7 @@ static ApartmentPtr createApartment(const cString& pePath,
 
     XSTL_TRY
     {
-        cFileStream peStream(pePath);
-        cNtHeaderPtr ntFile = ApartmentFactory::loadEXEFile(peStream);
-        cNtDirCli cliDirectory(*ntFile);
-        apartment = ApartmentFactory::createApartment(ntFile, cliDirectory, *memoryLayout, parentApartment);
+        apartment = ApartmentFactory::createApartment(image, *memoryLayout, parentApartment);
     }
     XSTL_CATCH_ALL
     {
@@ -142,16 +171,11 @@ static void loadAssemblyRef(ApartmentPtr& apt, ApartmentPtr& mainApartment, Memo
     }
 }
 
-static ApartmentPtr loadPE(const cString& exePath, const char * dllPath, MemoryLayoutInterfacePtr& memoryLayout)
+static ApartmentPtr loadPE(const ApartmentImagePtr& exeImage, const ApartmentImagePtr& dllImage, MemoryLayoutInterfacePtr& memoryLayout)
 {
     ApartmentPtr tempApt(NULL, SMARTPTR_DESTRUCT_NONE);
-    ApartmentPtr mainApartment = createApartment(exePath, memoryLayout, tempApt);
-    if (0 == getTokenID(mainApartment->getEntryPointToken()))
-    {
-        XSTL_THROW(ClrRuntimeException, XSTL_STRING("Invalid exe, missing entry point token."));
-    }
-
-    ApartmentPtr clrApartment = createApartment(dllPath, memoryLayout, mainApartment);
+    ApartmentPtr mainApartment = createApartment(exeImage, memoryLayout, tempApt);
+    ApartmentPtr clrApartment = createApartment(dllImage, memoryLayout, mainApartment);
 
     if (false == mainApartment->getObjects().getFrameworkMethods().isAllResolved())
     {
@@ -161,9 +185,126 @@ static ApartmentPtr loadPE(const cString& exePath, const char * dllPath, MemoryL
     // Add all dependancy apartments
     loadAssemblyRef(mainApartment, mainApartment, memoryLayout);
 
+    // All apartments are loaded, the typedefs can be served without locking
+    if (shouldFreezeTypes)
+        mainApartment->getObjects().getTypedefRepository().freeze();
+
+    // Strings which are tails of other strings share their content
+    mainApartment->getObjects().getStringRepository().setTailMerging(shouldMergeStringTails);
+
     return mainApartment;
 }
 
+/*
+ * Compiles all the work types which share the same memory layout.
+ *
+ * The apartments (and their typedefs, strings and framework methods) are
+ * created once for the memory layout, and the work types are compiled one
+ * after the other. Different memory layouts have nothing in common except
+ * the (read-only) images, so each layout is compiled in its own thread.
+ */
+class LayoutWorkThread : public cThreadedClass {
+public:
+    /*
+     * Constructor
+     *
+     * layoutType - The memory layout of all the work types of this thread
+     * exeImage   - The loaded .NET PE file
+     * dllImage   - The loaded clrcore.dll
+     * elfTargets - The number of ELF work types which were requested
+     */
+    LayoutWorkThread(CompilerFactory::MemoryLayoutType layoutType,
+                     const ApartmentImagePtr& exeImage,
+                     const ApartmentImagePtr& dllImage,
+                     uint elfTargets) :
+        m_layoutType(layoutType),
+        m_exeImage(exeImage),
+        m_dllImage(dllImage),
+        m_elfTargets(elfTargets),
+        m_failed(false)
+    {
+        m_finished.resetEvent();
+    }
+
+    /*
+     * Wait until all the work types were compiled.
+     *
+     * Return true if all the work types were compiled successfully
+     */
+    bool waitForCompletion()
+    {
+        m_finished.wait();
+        return !m_failed;
+    }
+
+protected:
+    // See cThreadedClass::run
+    virtual void run()
+    {
+        XSTL_TRY
+        {
+            MemoryLayoutInterfacePtr memoryLayout;
+            ApartmentPtr mainApartment;
+            for (uint type = 0; type < workTypeCount; type++)
+            {
+                // Do we need to perform this work?
+                if (!works.isSet(type))
+                    continue;
+                if (CompilerFactory::getMemoryLayoutType(workTypes[type].compilerType) != m_layoutType)
+                    continue;
+
+                // All work types of this layout share the same apartments
+                if (mainApartment.isEmpty())
+                {
+                    memoryLayout = CompilerFactory::getMemoryLayout(workTypes[type].compilerType);
+                    mainApartment = loadPE(m_exeImage, m_dllImage, memoryLayout);
+                }
+
+                // Several ELF outputs cannot share the same object file
+                cString elfOutputFilename;
+                if (m_elfTargets > 1)
+                    elfOutputFilename = cString("output-") + workTypes[type].param + ".o";
+
+                // Perform the work.
+                runEngine(mainApartment, workTypes[type].compilerType, workTypes[type].linkerType,
+                          precompiledMethodsPath, elfOutputFilename);
+            }
+        }
+        XSTL_CATCH(cException& e)
+        {
+            ConsoleTrace("Caught unhandled exception at compilation thread..." << endl);
+            e.print();
+            m_failed = true;
+        }
+        XSTL_CATCH_ALL
+        {
+            ConsoleTrace("Caught **unknown** unhandled exception at compilation thread..." << endl);
+            m_failed = true;
+        }
+
+        m_finished.setEvent();
+    }
+
+private:
+    // Deny copy-constructor and operator =
+    LayoutWorkThread(const LayoutWorkThread& other);
+    LayoutWorkThread& operator = (const LayoutWorkThread& other);
+
+    // The memory layout of all the work types of this thread
+    CompilerFactory::MemoryLayoutType m_layoutType;
+    // The loaded images
+    ApartmentImagePtr m_exeImage;
+    ApartmentImagePtr m_dllImage;
+    // The number of ELF work types which were requested
+    uint m_elfTargets;
+    // Set to true if one of the work types failed
+    bool m_failed;
+    // Set when all the work types were compiled
+    cEvent m_finished;
+};
+
+typedef cSmartPtr<LayoutWorkThread> LayoutWorkThreadPtr;
+
 void setCompilerParameter(uint index)
 {
     // Todo: Find a better code structure when more parameters are introduced
@@ -194,7 +335,14 @@ void print_usage(const char * exe)
     cout << "Usage: " << exe <<  " [options] <clrcore.dll path> <.NET PE file-name>" << endl;
     cout << "  Where options may be:" << endl;
     cout << "  -p <path>   Specify the path to the precompiled repository file" << endl;
+    cout << "  -f          Resolve all types after loading and serve type queries without locking" << endl;
+    cout << "  -t          Merge string literals which are the tail of other string literals" << endl;
+    cout << "  -d <path>   Specify the output directory of the 32c source files" << endl;
+    cout << "  -u <count>  Split the 32c methods into <count> source files which can be compiled in parallel" << endl;
     cout << "  -o <type>   Specify output type. This option may be specified more than once." << endl;
+    cout << "              The input files are loaded once and shared by all the outputs. Outputs with" << endl;
+    cout << "              different memory layouts (x86/32c and arm/thumb) are compiled in parallel." << endl;
+    cout << "              When more than one ELF output is specified, each is named output-<type>.o" << endl;
     cout << "              If not specified, the default is x86. Possible outputs are:" << endl;
     for (uint type = 0; type < workTypeCount; type++)
         cout << "                  " << workTypes[type].param << "   " << workTypes[type].description << endl;
@@ -228,6 +376,46 @@ bool processParameter(const char** argv, uint& firstArg)
         firstArg++;
         return true;
     }
+    if (strcmp(argv[firstArg], "-f") == 0)
+    {
+        shouldFreezeTypes = true;
+        // Skip the -f
+        firstArg++;
+        return true;
+    }
+    if (strcmp(argv[firstArg], "-t") == 0)
+    {
+        shouldMergeStringTails = true;
+        // Skip the -t
+        firstArg++;
+        return true;
+    }
+    if (strcmp(argv[firstArg], "-d") == 0)
+    {
+        // Skip the -d, then fetch the path
+        firstArg++;
+        outputDirectory = argv[firstArg];
+        // Skip the path
+        firstArg++;
+        return true;
+    }
+    if (strcmp(argv[firstArg], "-u") == 0)
+    {
+        // Skip the -u, then fetch the count
+        firstArg++;
+        int count = atoi(argv[firstArg]);
+        // Skip the count
+        firstArg++;
+
+        if (count <= 0)
+        {
+            cout << "Error: Invalid number of source files specified for -u. Please see command-line usage.";
+            firstArg = 0;
+            return false;
+        }
+        outputUnitsCount = (uint)count;
+        return true;
+    }
     if (strcmp(argv[firstArg], "-o") == 0)
     {
         // Skip the -o, then fetch the type
@@ -338,17 +526,49 @@ int main(const int argc, const char** argv)
 
     XSTL_TRY
     {
+        // Load and parse the input files once, for all work types
+        ApartmentImagePtr exeImage = loadImage(exePath);
+        if (0 == exeImage->getEntryPointToken())
+        {
+            XSTL_THROW(ClrRuntimeException, XSTL_STRING("Invalid exe, missing entry point token."));
+        }
+        ApartmentImagePtr dllImage = loadImage(dllPath);
+
+        // Group the work types by their memory layout
+        uint elfTargets = 0;
+        cSetArray layouts;
+        layouts.changeSize(CompilerFactory::LAYOUT_ARM + 1);
+        layouts.resetArray();
         for (uint type = 0; type < workTypeCount; type++)
         {
             // Do we need to perform this work?
             if (!works.isSet(type))
                 continue;
+            layouts.set(CompilerFactory::getMemoryLayoutType(workTypes[type].compilerType));
+            if (workTypes[type].linkerType == LinkerFactory::ELF_LINKER)
+                elfTargets++;
+        }
 
-            // Perform the work.
-            MemoryLayoutInterfacePtr memoryLayout = CompilerFactory::getMemoryLayout(workTypes[type].compilerType);
-            ApartmentPtr mainApartment = loadPE(exePath, dllPath, memoryLayout);
-            runEngine(mainApartment, workTypes[type].compilerType, workTypes[type].linkerType, precompiledMethodsPath);
+        // Compile each memory layout in its own thread
+        cList<LayoutWorkThreadPtr> threads;
+        for (uint layout = 0; layout < layouts.getLength(); layout++)
+        {
+            if (!layouts.isSet(layout))
+                continue;
+            LayoutWorkThreadPtr thread(new LayoutWorkThread(
+                (CompilerFactory::MemoryLayoutType)layout, exeImage, dllImage, elfTargets));
+            threads.append(thread);
+            thread->start();
         }
+
+        bool failed = false;
+        for (cList<LayoutWorkThreadPtr>::iterator i = threads.begin(); i != threads.end(); ++i)
+        {
+            if (!(*i)->waitForCompletion())
+                failed = true;
+        }
+        if (failed)
+            return RC_ERROR;
     }
     XSTL_CATCH(cException& e)
     {
@@ -37,12 +37,80 @@
  * Author: Elad Raz <e@eladraz.com>
  */
 #include "stdafx.h"
+#include "xStl/os/lock.h"
 #include "data/ElementType.h"
 #include "data/exceptions.h"
 #include "runnable/ResolverInterface.h"
 
 const TokenIndex ElementType::UnresolvedTokenIndex(-1, -1);
 
+/*
+ * See ElementType::internGeneric
+ */
+class ElementType::GenericInstance {
+public:
+    GenericInstance(const ElementType& genericClass,
+                    const cArray<ElementType>& genericTypes,
+                    uint hash) :
+        m_genericClass(genericClass),
+        m_genericTypes(genericTypes),
+        m_hash(hash),
+        m_next(NULL)
+    {
+    }
+
+    // The class token. The "stack" in "Stack<int>"
+    ElementType m_genericClass;
+    // The type of the generic instance: The "int" in "Stack<int>"
+    cArray<ElementType> m_genericTypes;
+    // See ElementType::getHash
+    uint m_hash;
+    // The next instance with the same hash value
+    GenericInstance* m_next;
+};
+
+cHash<uint, ElementType::GenericInstance*> ElementType::m_genericInstances;
+cXstlLockable ElementType::m_genericInstancesLock;
+
+// Returned by getGenericTypes() for non-generic elements
+static const cArray<ElementType> gEmptyGenericTypes;
+
+const ElementType::GenericInstance* ElementType::internGeneric(
+                                        const ElementType& genericClass,
+                                        const cArray<ElementType>& genericTypes)
+{
+    uint hash = genericClass.getHash();
+    for (uint i = 0; i < genericTypes.getSize(); i++)
+        hash = hash * 31 + genericTypes[i].getHash();
+
+    cLock lock(m_genericInstancesLock);
+    GenericInstance* first = NULL;
+    if (m_genericInstances.hasKey(hash))
+    {
+        first = m_genericInstances[hash];
+        for (GenericInstance* instance = first; instance != NULL; instance = instance->m_next)
+        {
+            if ((instance->m_genericClass == genericClass) &&
+                (instance->m_genericTypes.getSize() == genericTypes.getSize()))
+            {
+                bool isEqual = true;
+                for (uint i = 0; (i < genericTypes.getSize()) && isEqual; i++)
+                    isEqual = (instance->m_genericTypes[i] == genericTypes[i]);
+                if (isEqual)
+                    return instance;
+            }
+        }
+    }
+
+    // New generic instance
+    GenericInstance* instance = new GenericInstance(genericClass, genericTypes, hash);
+    instance->m_next = first;
+    if (first != NULL)
+        m_genericInstances.remove(hash);
+    m_genericInstances.append(hash, instance);
+    return instance;
+}
+
 ElementType::ElementType(CorElementType type,
                          uint pointerLevel,
                          bool isReference,
@@ -56,7 +124,8 @@ ElementType::ElementType(CorElementType type,
     m_isPinned(isPinned),
     m_isReference(isReference),
     m_classToken(classToken),
-    m_isSingleArray(isSingleArray)
+    m_isSingleArray(isSingleArray),
+    m_generic(NULL)
 {
     #ifndef CLR_FLOAT_ENABLE
     // If the enviroment doesn't support floating-point operation. Each
@@ -72,13 +141,11 @@ ElementType::ElementType(CorElementType type,
             m_type = ELEMENT_TYPE_I4;
     #endif
 
-    if (genericClass != NULL)
+    if ((genericClass != NULL) || (genericTypes != NULL))
     {
-        m_genericClass = cSmartPtr<ElementType>(new ElementType(*genericClass));
-    }
-    if (genericTypes != NULL)
-    {
-        m_genericTypes = *genericTypes;
+        // Both must be given
+        CHECK((genericClass != NULL) && (genericTypes != NULL));
+        m_generic = internGeneric(*genericClass, *genericTypes);
     }
 
     CHECK(((type >= ELEMENT_TYPE_END) && (type < ELEMENT_TYPE_PTR)) ||
@@ -203,20 +270,9 @@ bool ElementType::operator == (const ElementType& other) const
         (m_pointerLevel == other.m_pointerLevel) &&
         (m_isPinned == other.m_isPinned) &&
         (m_isReference == other.m_isReference) &&
-        (m_genericTypes.getSize() == other.m_genericTypes.getSize()))
+        // Generic instances are interned
+        (m_generic == other.m_generic))
     {
-        if (!m_genericClass.isEmpty())
-        {
-            if (other.m_genericClass.isEmpty())
-                return false;
-            if (*m_genericClass != *other.m_genericClass)
-                return false;
-        }
-
-        for (uint i = 0; i < m_genericTypes.getSize(); i++)
-            if (m_genericTypes[i] != other.m_genericTypes[i])
-                return false;
-
         return true;
     }
 
@@ -228,6 +284,18 @@ bool ElementType::operator != (const ElementType& other) const
     return !(*this == other);
 }
 
+uint ElementType::getHash() const
+{
+    uint hash = (getApartmentID(m_classToken) << 16) + getTokenID(m_classToken);
+    hash = hash * 31 + ((uint)m_type | (m_pointerLevel << 8));
+    hash = hash * 31 + ((m_isReference ? 1 : 0) |
+                        (m_isPinned ? 2 : 0) |
+                        (m_isSingleArray ? 4 : 0));
+    if (m_generic != NULL)
+        hash = hash * 31 + m_generic->m_hash;
+    return hash;
+}
+
 bool ElementType::isIntegerType() const
 {
     if (isPointer())
@@ -323,11 +391,14 @@ bool ElementType::isObject() const
 
 const cArray<ElementType>& ElementType::getGenericTypes() const
 {
-    return m_genericTypes;
+    if (m_generic == NULL)
+        return gEmptyGenericTypes;
+    return m_generic->m_genericTypes;
 }
 const ElementType& ElementType::getGenericClass() const
 {
-    return *m_genericClass;
+    CHECK(m_generic != NULL);
+    return m_generic->m_genericClass;
 }
 
 
@@ -344,12 +415,12 @@ CorElementType ElementType::convertUnsignedToSigned(CorElementType unsignedType)
     return (CorElementType)ret;
 }
 
-ElementType ElementType::readType(basicInput& stream, mdToken apartmentId)
+ElementType ElementType::readType(ByteCursor& blob, mdToken apartmentId)
 {
-    return privateReadType(stream, apartmentId);
+    return privateReadType(blob, apartmentId);
 }
 
-ElementType ElementType::privateReadType(basicInput& stream,
+ElementType ElementType::privateReadType(ByteCursor& blob,
                             mdToken apartmentId,
                             uint pointerLevel,
                             bool isReference,
@@ -357,8 +428,7 @@ ElementType ElementType::privateReadType(basicInput& stream,
                             const TokenIndex& paramClassToken,
                             bool paramIsSingleArray)
 {
-    uint8 type;
-    stream.streamReadUint8(type);
+    uint8 type = blob.readUint8();
 
     if (type == ELEMENT_TYPE_END)
         XSTL_THROW(NoElementException);
@@ -394,7 +464,7 @@ ElementType ElementType::privateReadType(basicInput& stream,
 
     if (isRP)
     {
-        return privateReadType(stream, apartmentId, pointerLevel, isReference, isPinned, paramClassToken, paramIsSingleArray);
+        return privateReadType(blob, apartmentId, pointerLevel, isReference, isPinned, paramClassToken, paramIsSingleArray);
     }
 
     // Test for class element
@@ -403,7 +473,7 @@ ElementType ElementType::privateReadType(basicInput& stream,
         (type == ELEMENT_TYPE_VAR))
     {
         // Read the class token
-        mdToken classTokenId = EncodingUtils::unpackTypeDefOrRefToken(EncodingUtils::readCompressedNumber(stream));
+        mdToken classTokenId = EncodingUtils::unpackTypeDefOrRefToken(EncodingUtils::readCompressedNumber(blob));
         return ElementType((CorElementType)type,
                            pointerLevel, isReference, isPinned, paramIsSingleArray,
                            buildTokenIndex(apartmentId, classTokenId));
@@ -412,14 +482,13 @@ ElementType ElementType::privateReadType(basicInput& stream,
     if (type == ELEMENT_TYPE_GENERICINST)
     {
         // Read the class type of the generic
-        ElementType genericClass = privateReadType(stream, apartmentId);
+        ElementType genericClass = privateReadType(blob, apartmentId);
         ElementsArrayType genericTypes;
-        uint8 argCount;
-        stream.streamReadUint8(argCount);
+        uint8 argCount = blob.readUint8();
         genericTypes.changeSize(argCount);
         for (int i = 0; i < argCount; i++)
         {
-            genericTypes[i] = privateReadType(stream, apartmentId, 0, false, false, UnresolvedTokenIndex, false);
+            genericTypes[i] = privateReadType(blob, apartmentId, 0, false, false, UnresolvedTokenIndex, false);
         }
         return ElementType((CorElementType)type, pointerLevel, isReference, isPinned, paramIsSingleArray, paramClassToken,
                            &genericClass, &genericTypes);
@@ -428,7 +497,7 @@ ElementType ElementType::privateReadType(basicInput& stream,
     if (type == ELEMENT_TYPE_SZARRAY)
     {
         CHECK(!paramIsSingleArray);
-        return privateReadType(stream, apartmentId, pointerLevel, isReference, isPinned, paramClassToken, true);
+        return privateReadType(blob, apartmentId, pointerLevel, isReference, isPinned, paramClassToken, true);
     }
 
     /*
@@ -549,6 +618,11 @@ uint cHashFunction(const TokenIndex& index, uint range)
     return ((getApartmentID(index) << 16) + getTokenID(index)) % range;
 }
 
+uint cHashFunction(const ElementType& type, uint range)
+{
+    return type.getHash() % range;
+}
+
 cString HEXTOKEN(const TokenIndex& tokenIndex)
 {
     return cString(getApartmentID(tokenIndex)) + ":" + HEXDWORD(getTokenID(tokenIndex));
@@ -42,13 +42,16 @@
 #include "xStl/types.h"
 #include "xStl/enc/digest.h"
 #include "xStl/data/array.h"
+#include "xStl/data/hash.h"
 #include "xStl/data/string.h"
 #include "xStl/data/smartptr.h"
 #include "xStl/data/dualElement.h"
 #include "xStl/except/exception.h"
+#include "xStl/os/xstlLockable.h"
 #include "xStl/stream/basicIO.h"
 #include "xStl/stream/stringerStream.h"
 #include "format/coreHeadersTypes.h"
+#include "format/ByteCursor.h"
 
 /*
  * Forward deceleration for output streams
@@ -92,6 +95,9 @@ class ResolverInterface;
  * See CorElementType. Encode one of the ELEMENT_TYPE_XXX.
  * A type can be one of the following
  *
+ * The generic part of a generic instance ("Stack<int>") is interned, see
+ * GenericInstance. Elements are therefore cheap to copy and compare.
+ *
  * Author: Elad Raz <e@eladraz.com>
  */
 class ElementType {
@@ -194,15 +200,23 @@ public:
 
     /*
      * Compare the types of two elements and return true if they are identical.
+     * The generic parts are compared by their interned instance, so the
+     * comparison doesn't depend on the number of generic arguments.
      */
     bool operator == (const ElementType& other) const;
     bool operator != (const ElementType& other) const;
 
     /*
-     * Read encoded Element type from a stream
+     * Return a hash value for the element. Identical elements have the same
+     * hash value.
+     */
+    uint getHash() const;
+
+    /*
+     * Read encoded Element type from a signature blob
      *
-     * stream - An input-stream which point to the position of the ElementType
-     *          encoding.
+     * blob - A cursor which point to the position of the ElementType
+     *        encoding. The cursor is advanced beyond the element.
      * apartmentId - The apartment Index
      *
      * Return the decoded element-type
@@ -216,7 +230,7 @@ public:
      *       function which might encode list of element will have to wrap thier
      *       body with a 'try-catch' block
      */
-    static ElementType readType(basicInput& stream, mdToken apartmentId);
+    static ElementType readType(ByteCursor& blob, mdToken apartmentId);
 
     /*
      * Convert ELEMENT_TYPE_U1..ELEMENT_TYPE_U8 to thier coressponding integer
@@ -307,7 +321,7 @@ private:
      * Private recursive implementation of 'readType'
      * See ElementType::readType
      */
-    static ElementType privateReadType(basicInput& stream,
+    static ElementType privateReadType(ByteCursor& blob,
                                        mdToken apartmentId,
                                        uint pointerLevel = 0,
                                        bool isReference = false,
@@ -315,6 +329,27 @@ private:
                                        const TokenIndex& paramClassToken = UnresolvedTokenIndex,
                                        bool paramIsSingleArray = false);
 
+    /*
+     * The generic class and the generic types of a generic instance. The
+     * object is immutable and never freed. See internGeneric
+     */
+    class GenericInstance;
+
+    /*
+     * Return the single GenericInstance object for a generic class and its
+     * generic types. Generic instances are shared by all the apartments (the
+     * tokens contain the apartment ID)
+     *
+     * NOTE: This function is thread-safe
+     */
+    static const GenericInstance* internGeneric(const ElementType& genericClass,
+                                                const cArray<ElementType>& genericTypes);
+
+    // All the interned generic instances, by their hash value. Elements with
+    // the same hash value are chained. Protected by m_genericInstancesLock
+    static cHash<uint, GenericInstance*> m_genericInstances;
+    static cXstlLockable m_genericInstancesLock;
+
 
     // The type of the element
     CorElementType m_type;
@@ -329,15 +364,17 @@ private:
     // Set to true for single-dimension array
     bool m_isSingleArray;
 
-    // Contains type of inner generic types
+    // The generic class and the inner generic types, or NULL
     // Example List<Node, Value> has 2 inner types class Node and class Value
-    cArray<ElementType> m_genericTypes;
-    cSmartPtr<ElementType> m_genericClass;
+    const GenericInstance* m_generic;
 };
 
 // An array of element's types
 typedef cArray<ElementType> ElementsArrayType;
 
+// Hashing function declarations
+uint cHashFunction(const ElementType& type, uint range);
+
 #ifdef TRACED_CLR
 cStringerStream& operator << (cStringerStream& out, const ElementType& object);
 cStringerStream& operator << (cStringerStream& out, const TokenIndex& tokenIndex);
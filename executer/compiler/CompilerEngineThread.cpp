@@ -140,134 +140,142 @@ void CompilerEngineThread::run(ScanningAlgorithmInterface& scanAlgorithm)
         }
         else
         {
-            SecondPassBinaryPtr pass;
+            compileMethod(mid);
+            // Reference is removed.
+        }
+    }
+}
+
+SecondPassBinaryPtr CompilerEngineThread::compileMethod(const TokenIndex& mid)
+{
+    addressNumericValue currentThread =  getNumeric((void*)(cThread::getCurrentThreadHandle()));
+
+    SecondPassBinaryPtr pass;
+
+    // Check for recompiled cached method
+    if (m_binaryRepository.isMethodExist(mid, &pass))
+    {
+        //ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
+        //              << "] Method " << HEXTOKEN(mid) << " is in repository." << endl);
+        // Notify that the method was completed
+        notifyOnCompiled(mid, *pass, true);
+    }
+    else
+    {
+#ifdef _DEBUG
+        // A nice spot to start debugging a specific function
+        if ((getApartmentID(mid) == 2) && (getTokenID(mid) == 0x6000124))
+        {
+            //cOS::debuggerBreak();
+        }
+#endif
+
+        if (EncodingUtils::getTokenTableIndex(getTokenID(mid)) == TABLE_CLR_METHOD_INSTANCE_DETOR)
+        {
+            pass = MethodCompiler::compileInstanceDestructor(*m_main->getApt(mid),
+                                                             m_compilerType, m_compilerParams, mid);
+            m_binaryRepository.addSecondPassMethod(mid, pass);
+            notifyOnCompiled(mid, *pass, false);
+            ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
+                << "] Instance destructor DONE - " << HEXTOKEN(mid) << endl);
+        } else if (EncodingUtils::getTokenTableIndex(getTokenID(mid)) == TABLE_CLR_CCTOR_WRAPPERS)
+        {
+            // Generate method wrapper
+            mdToken wrapper = EncodingUtils::buildToken(TABLE_TYPEDEF_TABLE,
+                EncodingUtils::getTokenPosition(getTokenID(mid)));
+            TokenIndex cctorToken = buildTokenIndex(getApartmentID(mid), wrapper);
+            // The boolean is shared with the inline checks of the accessors
+            TokenIndex booleanAddress = m_main->getObjects().getTypedefRepository().getStaticInitializerGuard(cctorToken);
+            cctorToken = m_main->getObjects().getTypedefRepository().getStaticInitializerMethod(cctorToken);
+            // And compile
+            pass = MethodCompiler::compileCCTORWrapper(*m_main->getApt(mid),
+                m_compilerType, m_compilerParams, booleanAddress, getTokenID(cctorToken));
+            m_binaryRepository.addSecondPassMethod(mid, pass);
+            notifyOnCompiled(mid, *pass, false);
+            ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
+                << "] Static Wrapper DONE - " << HEXTOKEN(mid) << endl);
+        } else if ((EncodingUtils::getTokenTableIndex(getTokenID(mid)) == TABLE_MEMBERREF_TABLE) ||
+            EncodingUtils::getTokenTableIndex(getTokenID(mid)) == TABLE_CLR_INTERNAL)
+        {
+            if (getApartmentID(mid) != -1) {
+                ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
+                    << "] is memberref/internal, skipping. " << HEXTOKEN(mid) << endl);
+
+                ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
+                    << "] DONE - " << HEXTOKEN(mid) << endl);
+            }
+            // The method belongs to an external module
+            // TODO! Check for module loading...
+            //notifyOnCompiled(mid, apartmentId, *pass, false);
+        }
+        else if (EncodingUtils::getTokenTableIndex(getTokenID(mid)) == TABLE_CLR_METHOD_HELPERS)
+        {
+            // The cleanup and other helper functions must also be in the precompiled repository, calculate simple signature
+            ApartmentPtr apt(m_main->getApt(mid));
+            CRC64 crc64;
+            mdToken token(getTokenID(mid));
+            crc64.update(&token, sizeof(token));
+            cBuffer signature(crc64.digest());
+            pass = m_precompiledRepository.getPrecompiledMethod(apt->getApartmentName(),
+                signature);
+
+            // If this helper function was not compiled - then this is a bug
+            CHECK(!pass.isEmpty());
+
+            onMethodCompiled(apt->getApartmentName(), signature, mid, pass, false);
+        }
+        else
+        {
+            // Prepare runnable object
+            ApartmentPtr apt(m_main->getApt(mid));
+            MethodRunnable method(apt);
+            method.loadMethod(getTokenID(mid));
 
-            // Check for recompiled cached method
-            if (m_binaryRepository.isMethodExist(mid, &pass))
+            // Calculate signature and check old runnable signatures
+            cBuffer signature = MethodSignature::getMethodSignature(apt, method, (uint)m_compilerType);
+
+            // Check for signature
+            pass = m_precompiledRepository.getPrecompiledMethod(apt->getApartmentName(),
+                signature);
+            if (!pass.isEmpty())
             {
-                //ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
-                //              << "] Method " << HEXTOKEN(mid) << " is in repository." << endl);
-                // Notify that the method was completed
-                notifyOnCompiled(mid, *pass, true);
+                // ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
+                //     << "] Method  " << HEXTOKEN(mid) << " in precompiled repository" << endl);
             }
             else
             {
-#ifdef _DEBUG
-                // A nice spot to start debugging a specific function
-                if ((getApartmentID(mid) == 2) && (getTokenID(mid) == 0x6000124))
-                {
-                    mid = mid;
-                    //cOS::debuggerBreak();
-                }
-#endif
+                // There is no function in the precompiled header, compile
+                ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
+                    << "] Compiling method " << HEXTOKEN(mid) << endl);
 
-                if (EncodingUtils::getTokenTableIndex(getTokenID(mid)) == TABLE_CLR_METHOD_INSTANCE_DETOR)
+                XSTL_TRY
                 {
-                    pass = MethodCompiler::compileInstanceDestructor(*m_main->getApt(mid),
-                                                                     m_compilerType, m_compilerParams, mid);
-                    m_binaryRepository.addSecondPassMethod(mid, pass);
-                    notifyOnCompiled(mid, *pass, false);
-                    ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
-                        << "] Instance destructor DONE - " << HEXTOKEN(mid) << endl);
-                } else if (EncodingUtils::getTokenTableIndex(getTokenID(mid)) == TABLE_CLR_CCTOR_WRAPPERS)
-                {
-                    // Generate method wrapper
-                    mdToken wrapper = EncodingUtils::buildToken(TABLE_TYPEDEF_TABLE,
-                        EncodingUtils::getTokenPosition(getTokenID(mid)));
-                    TokenIndex cctorToken = buildTokenIndex(getApartmentID(mid), wrapper);
-                    cctorToken = m_main->getObjects().getTypedefRepository().getStaticInitializerMethod(cctorToken);
-                    // Increase static size by a boolean
-                    TokenIndex booleanAddress = m_main->getObjects().getTypedefRepository().allocateStatic(1);
+                    // Prepare Method compiler
+                    MethodCompiler compiler(m_compilerType, m_compilerParams, apt, getTokenID(mid), method);
                     // And compile
-                    pass = MethodCompiler::compileCCTORWrapper(*m_main->getApt(mid),
-                        m_compilerType, m_compilerParams, booleanAddress, getTokenID(cctorToken));
-                    m_binaryRepository.addSecondPassMethod(mid, pass);
-                    notifyOnCompiled(mid, *pass, false);
+                    pass = compiler.compile(*this);
                     ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
-                        << "] Static Wrapper DONE - " << HEXTOKEN(mid) << endl);
-                } else if ((EncodingUtils::getTokenTableIndex(getTokenID(mid)) == TABLE_MEMBERREF_TABLE) ||
-                    EncodingUtils::getTokenTableIndex(getTokenID(mid)) == TABLE_CLR_INTERNAL)
-                {
-                    if (getApartmentID(mid) != -1) {
-                        ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
-                            << "] is memberref/internal, skipping. " << HEXTOKEN(mid) << endl);
-
-                        ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
-                            << "] DONE - " << HEXTOKEN(mid) << endl);
-                    }
-                    // The method belongs to an external module
-                    // TODO! Check for module loading...
-                    //notifyOnCompiled(mid, apartmentId, *pass, false);
+                        << "] DONE - " << HEXTOKEN(mid) << endl);
                 }
-                else if (EncodingUtils::getTokenTableIndex(getTokenID(mid)) == TABLE_CLR_METHOD_HELPERS)
+                XSTL_CATCH_ALL
                 {
-                    // The cleanup and other helper functions must also be in the precompiled repository, calculate simple signature
-                    ApartmentPtr apt(m_main->getApt(mid));
-                    CRC64 crc64;
-                    mdToken token(getTokenID(mid));
-                    crc64.update(&token, sizeof(token));
-                    cBuffer signature(crc64.digest());
-                    pass = m_precompiledRepository.getPrecompiledMethod(apt->getApartmentName(),
-                        signature);
-
-                    // If this helper function was not compiled - then this is a bug
-                    CHECK(!pass.isEmpty());
-
-                    onMethodCompiled(apt->getApartmentName(), signature, mid, pass, false);
-                }
-                else
-                {
-                    // Prepare runnable object
-                    ApartmentPtr apt(m_main->getApt(mid));
-                    MethodRunnable method(apt);
-                    method.loadMethod(getTokenID(mid));
-
-                    // Calculate signature and check old runnable signatures
-                    cBuffer signature = MethodSignature::getMethodSignature(apt, method, (uint)m_compilerType);
-
-                    // Check for signature
-                    pass = m_precompiledRepository.getPrecompiledMethod(apt->getApartmentName(),
-                        signature);
-                    if (!pass.isEmpty())
-                    {
-                        // ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
-                        //     << "] Method  " << HEXTOKEN(mid) << " in precompiled repository" << endl);
-                    }
-                    else
-                    {
-                        // There is no function in the precompiled header, compile
-                        ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
-                            << "] Compiling method " << HEXTOKEN(mid) << endl);
-
-                        XSTL_TRY
-                        {
-                            // Prepare Method compiler
-                            MethodCompiler compiler(m_compilerType, m_compilerParams, apt, getTokenID(mid), method);
-                            // And compile
-                            pass = compiler.compile(*this);
-                            ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
-                                << "] DONE - " << HEXTOKEN(mid) << endl);
-                        }
-                        XSTL_CATCH_ALL
-                        {
-                            ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
-                                << "] ERROR! Failed!  " << HEXTOKEN(mid) << endl);
-                            // Throw exception? Transfer into virtual mode?
-                            // Just notify the algorithm
+                    ExecuterTrace("CompilerEngineThread [" << HEXADDRESS(currentThread)
+                        << "] ERROR! Failed!  " << HEXTOKEN(mid) << endl);
+                    // Throw exception? Transfer into virtual mode?
+                    // Just notify the algorithm
 
-                            notifyOnCompilationFalied(mid);
-                            XSTL_RETHROW;
-                        }
-                    }
-                    // Compilation done
-                    if (!pass.isEmpty()) {
-                        onMethodCompiled(apt->getApartmentName(), signature, mid, pass, false);
-                    }
+                    notifyOnCompilationFalied(mid);
+                    XSTL_RETHROW;
                 }
             }
-            // Reference is removed.
+            // Compilation done
+            if (!pass.isEmpty()) {
+                onMethodCompiled(apt->getApartmentName(), signature, mid, pass, false);
+            }
         }
     }
+
+    return pass;
 }
 
 void CompilerEngineThread::onMethodCompiled(const cString& aptName,
@@ -86,6 +86,19 @@ public:
      */
     void run(ScanningAlgorithmInterface& scanAlgorithm);
 
+    /*
+     * Compile a single method (or fetch it from the caches) and notify all
+     * the notifiers. Used by run() and by linkers which compile methods on
+     * demand.
+     *
+     * mid - The method to compile
+     *
+     * Return the compiled method. An empty pointer is returned for methods
+     * which belong to an external module.
+     * NOTE: This method may throw compilation exceptions.
+     */
+    SecondPassBinaryPtr compileMethod(const TokenIndex& mid);
+
     /*
      * Return the binary repository
      */
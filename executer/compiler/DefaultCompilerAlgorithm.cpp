@@ -55,8 +55,10 @@
 DefaultCompilerAlgorithm::DefaultCompilerAlgorithm(const TokenIndex& mainMethod,
                                                    ApartmentPtr mainApartment,
                                                    CompilerEngineThread& engine,
-                                                   const LinkerInterfacePtr& linker) :
+                                                   const LinkerInterfacePtr& linker,
+                                                   bool shouldScanDependencies) :
     m_shouldExit(false),
+    m_shouldScanDependencies(shouldScanDependencies),
     m_mainMethod(mainMethod),
     m_mainApartment(mainApartment),
     m_engine(engine),
@@ -110,7 +112,7 @@ void DefaultCompilerAlgorithm::onMethodCompiled(const TokenIndex& mid,
     // NOTE! If the method is in the repository then it ALL of it's sub-methods
     //       are also in the repository. Change this method if methods are paged
     //       out from the pool
-    if (!inCache)
+    if ((!inCache) && (m_shouldScanDependencies))
     {
         // Try to find all sub-methods
         const BinaryDependencies::DependencyObjectList& dependencies = compiled.getDependencies().getList();
@@ -119,7 +121,8 @@ void DefaultCompilerAlgorithm::onMethodCompiled(const TokenIndex& mid,
         {
             // Check for CIL methods links
             TokenIndex methodToken;
-            if (CallingConvention::deserializeMethod((*i).m_name, methodToken))
+            bool isRegisterEntry;
+            if (CallingConvention::deserializeMethod((*i).m_name, methodToken, &isRegisterEntry))
             {
                 m_methodStack.push(m_clrResolver.resolve(m_mainApartment, methodToken));
             } else if (CallingConvention::deserializeToken((*i).m_name, methodToken))
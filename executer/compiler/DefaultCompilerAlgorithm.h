@@ -66,13 +66,17 @@ public:
     * mainApartmentID - The apartment ID of the first method
     * mainApartment   - The apartment handler
     * engine          - The compilation engine. Used to bind to all methods.
+    * shouldScanDependencies - Set to false in order to compile only the main
+    *                          method ahead. The linker is then responsible to
+    *                          compile the rest of the methods on demand.
     *
     * TODO! Add initialized stack arguments
     */
     DefaultCompilerAlgorithm(const TokenIndex& mainMethod,
                              ApartmentPtr mainApartment,
                              CompilerEngineThread& engine,
-                             const LinkerInterfacePtr& linker);
+                             const LinkerInterfacePtr& linker,
+                             bool shouldScanDependencies = true);
 
     // See ScanningAlgorithmInterface::getNextMethod
     virtual bool getNextMethod(TokenIndex& mid);
@@ -96,6 +100,9 @@ private:
     // Mark to true
     volatile bool m_shouldExit;
 
+    // Set to false if only the main method should be compiled ahead
+    bool m_shouldScanDependencies;
+
     // The main routine. Execute only if there are no methods left
     TokenIndex m_mainMethod;
     ApartmentPtr m_mainApartment;
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * CodeArena.cpp
+ *
+ * Implementation file
+ */
+#include "executer/stdafx.h"
+#include "xStl/types.h"
+#include "xStl/except/trace.h"
+#include "xStl/stream/traceStream.h"
+#include "xStl/stream/ioStream.h"
+#include "executer/linker/CodeArena.h"
+
+#ifdef XSTL_LINUX
+    #include <sys/mman.h>
+    #include <unistd.h>
+    #include <errno.h>
+#endif
+
+CodeArena::CodeArena(uint alignment, uint chunkSize) :
+    m_alignment(alignment),
+    m_chunkSize(chunkSize),
+    m_isWritable(true)
+{
+    // The alignment must be a power of 2
+    CHECK((m_alignment != 0) && ((m_alignment & (m_alignment - 1)) == 0));
+}
+
+CodeArena::~CodeArena()
+{
+    cList<Chunk>::iterator i = m_chunks.begin();
+    for (; i != m_chunks.end(); ++i)
+    {
+#ifdef XSTL_WINDOWS
+        VirtualFree((*i).m_base, 0, MEM_RELEASE);
+#elif defined XSTL_LINUX
+        munmap((*i).m_base, (*i).m_size);
+#endif
+    }
+}
+
+void* CodeArena::allocate(uint size)
+{
+    // New code can only be written into a writable arena
+    CHECK(m_isWritable);
+
+    if (!m_chunks.isEmpty())
+    {
+        Chunk& chunk = *(--m_chunks.end());
+        uint position = (chunk.m_used + m_alignment - 1) & ~(m_alignment - 1);
+        if (position + size <= chunk.m_size)
+        {
+            chunk.m_used = position + size;
+            return chunk.m_base + position;
+        }
+    }
+
+    appendChunk(size);
+    Chunk& chunk = *(--m_chunks.end());
+    chunk.m_used = size;
+    return chunk.m_base;
+}
+
+void CodeArena::makeWritable()
+{
+    if (m_isWritable)
+        return;
+    cList<Chunk>::iterator i = m_chunks.begin();
+    for (; i != m_chunks.end(); ++i)
+        protect(*i, false);
+    m_isWritable = true;
+}
+
+void CodeArena::makeExecutable()
+{
+    if (!m_isWritable)
+        return;
+    cList<Chunk>::iterator i = m_chunks.begin();
+    for (; i != m_chunks.end(); ++i)
+        protect(*i, true);
+    m_isWritable = false;
+}
+
+bool CodeArena::isWritable() const
+{
+    return m_isWritable;
+}
+
+void CodeArena::appendChunk(uint size)
+{
+    uint pageSize = getPageSize();
+    if (size < m_chunkSize)
+        size = m_chunkSize;
+    size = (size + pageSize - 1) & ~(pageSize - 1);
+
+    Chunk chunk;
+    chunk.m_size = size;
+    chunk.m_used = 0;
+#ifdef XSTL_WINDOWS
+    chunk.m_base = (uint8*)VirtualAlloc(0, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    CHECK(chunk.m_base != NULL);
+#elif defined XSTL_LINUX
+
+    void* area;
+#ifdef XSTL_64BIT
+    // The compiled code is 32 bit, it must be placed in the low 2GB
+#ifdef MAP_32BIT
+    area = mmap(NULL, size, PROT_WRITE | PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS | MAP_32BIT, -1, 0);
+#else
+    area = MAP_FAILED;
+#endif
+#else
+    area = mmap(NULL, size, PROT_WRITE | PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#endif
+
+    if (area == MAP_FAILED)
+    {
+        cout << "Cannot create executable code (errno): " << errno << endl;
+        CHECK_FAIL();
+    }
+    chunk.m_base = (uint8*)area;
+#else
+    #error "Please add execution allocation right\n"
+#endif
+
+    m_chunks.append(chunk);
+}
+
+void CodeArena::protect(const Chunk& chunk, bool shouldExecute)
+{
+#ifdef XSTL_WINDOWS
+    DWORD oldProtection;
+    CHECK(VirtualProtect(chunk.m_base, chunk.m_size,
+                         shouldExecute ? PAGE_EXECUTE_READ : PAGE_READWRITE,
+                         &oldProtection));
+    if (shouldExecute)
+        FlushInstructionCache(GetCurrentProcess(), chunk.m_base, chunk.m_size);
+#elif defined XSTL_LINUX
+    int protection = shouldExecute ? (PROT_READ | PROT_EXEC) : (PROT_READ | PROT_WRITE);
+    if (mprotect(chunk.m_base, chunk.m_size, protection) != 0)
+    {
+        cout << "Cannot change code protection (errno): " << errno << endl;
+        CHECK_FAIL();
+    }
+#endif
+}
+
+uint CodeArena::getPageSize()
+{
+#ifdef XSTL_WINDOWS
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#elif defined XSTL_LINUX
+    return (uint)sysconf(_SC_PAGESIZE);
+#else
+    return 0x1000;
+#endif
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_EXECUTER_LINKER_CODEARENA_H
+#define __TBA_CLR_EXECUTER_LINKER_CODEARENA_H
+
+/*
+ * CodeArena.h
+ *
+ * Growable executable memory made of page-aligned chunks. The memory is
+ * written while it is read/write and flipped into read/execute before the
+ * code runs, so there is never a writable and executable mapping.
+ *
+ * On 64 bit hosts the chunks are mapped into the low 2GB (MAP_32BIT), since
+ * the compiled code is 32 bit. Hosts without MAP_32BIT cannot allocate code.
+ */
+#include "xStl/types.h"
+#include "xStl/data/list.h"
+
+class CodeArena {
+public:
+    /*
+     * Constructor.
+     *
+     * alignment - The alignment of each allocation. Must be a power of 2
+     * chunkSize - The minimum size of a new chunk. Rounded up to pages
+     */
+    CodeArena(uint alignment = DEFAULT_ALIGNMENT,
+              uint chunkSize = DEFAULT_CHUNK_SIZE);
+
+    /*
+     * Destructor. Free all the chunks
+     */
+    ~CodeArena();
+
+    /*
+     * Allocate 'size' bytes, packed after the previous allocation.
+     * The memory is writable until the next call to makeExecutable()
+     *
+     * Throw exception if the memory cannot be allocated
+     */
+    void* allocate(uint size);
+
+    /*
+     * Flip all the chunks into read/write so the code can be changed.
+     */
+    void makeWritable();
+
+    /*
+     * Flip all the chunks into read/execute.
+     */
+    void makeExecutable();
+
+    /*
+     * Return true if the chunks are currently writable
+     */
+    bool isWritable() const;
+
+    // The default alignment for methods
+    enum { DEFAULT_ALIGNMENT = 16 };
+    // The default chunk size
+    enum { DEFAULT_CHUNK_SIZE = 0x10000 };
+
+private:
+    // Deny copy-constructor and operator =
+    CodeArena(const CodeArena& other);
+    CodeArena& operator = (const CodeArena& other);
+
+    /*
+     * A single mapped region
+     */
+    struct Chunk {
+        // The base address
+        uint8* m_base;
+        // The mapped size (pages)
+        uint m_size;
+        // The number of bytes allocated so far
+        uint m_used;
+    };
+
+    /*
+     * Map a new chunk of at least 'size' bytes in read/write protection
+     */
+    void appendChunk(uint size);
+
+    /*
+     * Change the protection of a chunk
+     */
+    static void protect(const Chunk& chunk, bool shouldExecute);
+
+    /*
+     * Return the page size of the system
+     */
+    static uint getPageSize();
+
+    // All the chunks. The last one is the active chunk
+    cList<Chunk> m_chunks;
+    // The allocation alignment
+    uint m_alignment;
+    // The minimum chunk size
+    uint m_chunkSize;
+    // Set to true while the chunks are read/write
+    bool m_isWritable;
+};
+
+#endif // __TBA_CLR_EXECUTER_LINKER_CODEARENA_H
@@ -51,6 +51,7 @@ const cString ELFLinker::m_sectionRDataString(".rdata");
 const cString ELFLinker::m_sectionVtblString(".vtbl");
 const cString ELFLinker::m_sectionTextString(".text");
 const cString ELFLinker::m_sectionImportString(".import");
+const cString ELFLinker::m_sectionUnwindString(".unwind_table");
 
 // 8kb of code per memory allocation
 #define PAGE_SIZE (8192)
@@ -73,6 +74,7 @@ cString ELFLinker::GlobalObject::buildExportString(cHash<uint, cString> function
         case SECTION_RDATA: ret = m_sectionRDataString; break;
         case SECTION_TEXT:  ret = m_sectionTextString; break;
         case SECTION_VTBL:  ret = m_sectionVtblString; break;
+        case SECTION_UNWIND: ret = m_sectionUnwindString; break;
     }
     ret[0] = 'g';
     ret += HEXDWORD(m_globalIndex);
@@ -80,18 +82,22 @@ cString ELFLinker::GlobalObject::buildExportString(cHash<uint, cString> function
 }
 
 ELFLinker::ELFLinker(CompilerEngineThread& compilerEngineThread,
-                     ApartmentPtr apartment) :
+                     ApartmentPtr apartment,
+                     const cString& outputFilename) :
     LinkerInterface(compilerEngineThread, apartment),
     m_elfObj(),
     m_isThumb(FALSE),
+    m_outputFilename(outputFilename),
     m_secText((uint)0, PAGE_SIZE),
     m_vtblBuffer((uint)0, PAGE_SIZE),
     m_codeSize(0),
+    m_isUnwindTableUsed(false),
     m_importLength(0)
 {
     switch (compilerEngineThread.getCompilerType())
     {
     case CompilerFactory::COMPILER_THUMB:
+    case CompilerFactory::COMPILER_THUMB2:
         m_isThumb = TRUE;
     case CompilerFactory::COMPILER_ARM:
         m_globalRelocationType = R_ARM_ABS32;
@@ -116,7 +122,8 @@ uint ELFLinker::getImportRelocationType(BinaryDependencies::DependencyLength len
     if ((m_engine.getCompilerType() == CompilerFactory::COMPILER_IA32))
         return R_386_PC32;
     CHECK((m_engine.getCompilerType() == CompilerFactory::COMPILER_ARM) ||
-          (m_engine.getCompilerType() == CompilerFactory::COMPILER_THUMB));
+          (m_engine.getCompilerType() == CompilerFactory::COMPILER_THUMB) ||
+          (m_engine.getCompilerType() == CompilerFactory::COMPILER_THUMB2));
     switch (length)
     {
     case BinaryDependencies::DEP_11BIT: return R_ARM_PC13;
@@ -147,6 +154,8 @@ const cString& ELFLinker::getSectionName(ELFLinker::SectionType sectionType)
             return m_sectionTextString;
         case SECTION_VTBL:
             return m_sectionVtblString;
+        case SECTION_UNWIND:
+            return m_sectionUnwindString;
     }
     CHECK_FAIL();
 }
@@ -211,6 +220,17 @@ void ELFLinker::registerSections()
             0,
             false);
     }
+
+    if (m_unwindBuffer.getSize() != 0)
+    {
+        m_elfObj.addSection(SHT_PROGBITS, m_sectionUnwindString, m_unwindBuffer, SHF_ALLOC | SHF_WRITE);
+        m_elfObj.addSymbol(m_sectionUnwindString,
+            cElfSymbol::SYMTYPE_SECTION,
+            m_sectionUnwindString,
+            0,
+            0,
+            false);
+    }
 }
 
 void ELFLinker::registerLocalFunctions(RelocationHash& relocHash)
@@ -340,7 +360,7 @@ void ELFLinker::buildDebugInfo()
 void ELFLinker::resolveAndExecuteAllDependencies(TokenIndex& mainMethod)
 {
     // Prepare the global table
-    cFileStream elfOutputFileStream(cString("output.o"), cFile::WRITE | cFile::CREATE);
+    cFileStream elfOutputFileStream(m_outputFilename, cFile::WRITE | cFile::CREATE);
 
     // Prepare vtable
     m_vtblBuffer.changeSize(m_apartment->getObjects().getTypedefRepository().
@@ -352,6 +372,9 @@ void ELFLinker::resolveAndExecuteAllDependencies(TokenIndex& mainMethod)
     m_importPositions.removeAll();
     m_imports.removeAll();
     m_exports.removeAll();
+    m_unwindData.removeAll();
+    m_unwindBuffer.changeSize(0);
+    m_isUnwindTableUsed = false;
 
     MethodResolvedObject solved;
     MethodStackObject stack;
@@ -359,6 +382,10 @@ void ELFLinker::resolveAndExecuteAllDependencies(TokenIndex& mainMethod)
     stack.push(mainMethod);
     resolveAll(relocHash, stack, solved);
 
+    // The table is needed only if the exception handling refers to it
+    if (m_isUnwindTableUsed)
+        buildUnwindSection(relocHash);
+
     // Fill our members to elf object
     m_vtblBuffer.changeSize(m_vtblFilledSize);
     // And copy .text (relocated)
@@ -447,7 +474,8 @@ void ELFLinker::resolveAll(RelocationHash& relocHash,
             BinaryDependencies::DependencyObject o = *j;
             TokenIndex methodToken;
             uint globalIndex;
-            if (CallingConvention::deserializeMethod((*j).m_name, methodToken))
+            bool isRegisterEntry;
+            if (CallingConvention::deserializeMethod((*j).m_name, methodToken, &isRegisterEntry))
             {
                 addressNumericValue addr = 0;
 
@@ -455,6 +483,10 @@ void ELFLinker::resolveAll(RelocationHash& relocHash,
                 ExternalModuleFunctionEntry* entry;
                 if (m_externalModuleResolver.resolveExternalMethod(methodToken, addr, &entry))
                 {
+                    // Imported methods have no register entry. See
+                    // CallingConvention::getRegisterArgumentsCount()
+                    CHECK(!isRegisterEntry);
+
                     // Add external module
                     appendImport(entry);
                     ImportObject import;
@@ -478,6 +510,8 @@ void ELFLinker::resolveAll(RelocationHash& relocHash,
                     appendMethod(methodToken, relocHash);
                     stack.push(methodToken);
                     addr = relocHash[methodToken];
+                    if (isRegisterEntry)
+                        addr+= CompilerInterface::REGISTER_ENTRY_OFFSET;
                     // And add dependancy (for absoulte calls)
                     if ((*j).m_type == BinaryDependencies::DEP_ABSOLUTE)
                     {
@@ -517,7 +551,7 @@ void ELFLinker::resolveAll(RelocationHash& relocHash,
                 m_globals.append(newGlobal);
                 binaryPtr->resolveDependency(*j, currentMethodAddress, globalIndex, 0, true);
 #ifdef CLR_UNICODE
-            } else if (m_apartment->getObjects().getStringRepository().deserializeStringU((*j).m_name, globalIndex))
+            } else if (m_apartment->getObjects().getStringRepository().deserializeStringA((*j).m_name, globalIndex))
             {
                 // TODO! Add unicode support
                 CHECK_FAIL();
@@ -656,6 +690,30 @@ void ELFLinker::resolveAll(RelocationHash& relocHash,
                               "Unknown token ID: " << HEXTOKEN(methodToken) << endl);
                     CHECK_FAIL();
                 }
+            } else if ((*j).m_name.compare(CallingConvention::gUnwindDataName) == cString::EqualTo)
+            {
+                // The head of the unwind data points to the method itself
+                GlobalObject newGlobal;
+                newGlobal.m_dependancyLength = (*j).m_length;
+                newGlobal.m_dependancyPosition = (*j).m_position + currentMethodAddress;
+                newGlobal.m_sectionTarget = SECTION_TEXT;
+                newGlobal.m_sectionSource = SECTION_TEXT;
+                newGlobal.m_globalIndex = currentMethodAddress;
+                m_globals.append(newGlobal);
+                binaryPtr->resolveDependency(*j, currentMethodAddress, currentMethodAddress, 0, true);
+                m_unwindData.append(currentMethodAddress, newGlobal.m_dependancyPosition);
+            } else if ((*j).m_name.compare(CallingConvention::gUnwindTableName) == cString::EqualTo)
+            {
+                // The header is at the start of .unwind_table
+                GlobalObject newGlobal;
+                newGlobal.m_dependancyLength = (*j).m_length;
+                newGlobal.m_dependancyPosition = (*j).m_position + currentMethodAddress;
+                newGlobal.m_sectionTarget = SECTION_UNWIND;
+                newGlobal.m_sectionSource = SECTION_TEXT;
+                newGlobal.m_globalIndex = 0;
+                m_globals.append(newGlobal);
+                binaryPtr->resolveDependency(*j, currentMethodAddress, 0, 0, true);
+                m_isUnwindTableUsed = true;
             } else
             {
                 // TODO! Add symbol (use custom attribute) to ELF import section
@@ -665,6 +723,64 @@ void ELFLinker::resolveAll(RelocationHash& relocHash,
     }
 }
 
+void ELFLinker::buildUnwindSection(RelocationHash& relocHash)
+{
+    // The size of each function by its position. The functions are placed
+    // one after the other in .text
+    cHash<uint, uint> sizes;
+    cList<TokenIndex> relocFuncs(relocHash.keys());
+    cList<TokenIndex>::iterator i(relocFuncs.begin());
+    for (; i != relocFuncs.end(); ++i)
+    {
+        SecondPassBinaryPtr binaryPtr(m_engine.getBinaryRepository().getSecondPassMethod(*i));
+        sizes.append(relocHash[*i], binaryPtr->getData().getSize());
+    }
+
+    // The header: the number of functions, and a pointer to the functions
+    // which follow it. Then [start, end, data] for each function
+    uint count = relocFuncs.length();
+    m_unwindBuffer.changeSize((2 + count * 3) * m_pointerSize);
+    uint32* l = (uint32*)m_unwindBuffer.getBuffer();
+    *l++ = count;
+
+    GlobalObject newGlobal;
+    newGlobal.m_dependancyLength = m_pointerSize;
+    newGlobal.m_sectionSource = SECTION_UNWIND;
+
+    // The functions pointer
+    *l = 2 * m_pointerSize;
+    newGlobal.m_dependancyPosition = ((uint8*)l) - m_unwindBuffer.getBuffer();
+    newGlobal.m_sectionTarget = SECTION_UNWIND;
+    newGlobal.m_globalIndex = *l;
+    m_globals.append(newGlobal);
+    l++;
+
+    // The rest of the pointers are into .text
+    newGlobal.m_sectionTarget = SECTION_TEXT;
+    uint position = 0;
+    while (position < m_codeSize)
+    {
+        uint size = sizes[position];
+        CHECK(size != 0);
+
+        uint32 values[3] = { position,
+                             position + size,
+                             m_unwindData.hasKey(position) ? m_unwindData[position] : 0 };
+        for (uint k = 0; k < 3; k++, l++)
+        {
+            *l = values[k];
+            // Null data pointers are not relocated
+            if ((k == 2) && (values[k] == 0))
+                continue;
+            newGlobal.m_dependancyPosition = ((uint8*)l) - m_unwindBuffer.getBuffer();
+            newGlobal.m_globalIndex = values[k];
+            m_globals.append(newGlobal);
+        }
+
+        position+= size;
+    }
+}
+
 uint32 ELFLinker::getCodeSize()
 {
     uint32 res = 0;
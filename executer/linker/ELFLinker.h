@@ -47,8 +47,14 @@
 class ELFLinker : public LinkerInterface
 {
 public:
-    // Constructor
-    ELFLinker(CompilerEngineThread& compilerEngineThread, ApartmentPtr apartment);
+    /*
+     * Constructor
+     *
+     * outputFilename - The name of the generated object file
+     */
+    ELFLinker(CompilerEngineThread& compilerEngineThread,
+              ApartmentPtr apartment,
+              const cString& outputFilename = cString("output.o"));
 
     // See LinkerInterface::resolveAndExecuteAllDependencies
     virtual void resolveAndExecuteAllDependencies(TokenIndex& mainMethod);
@@ -79,6 +85,8 @@ private:
         SECTION_VTBL = 3,
         // Initialized data section
         SECTION_RDATA = 4,
+        // Section for .unwind_table
+        SECTION_UNWIND = 5,
     };
 
     class GlobalObject
@@ -132,6 +140,13 @@ private:
      */
     uint getImportRelocationType(BinaryDependencies::DependencyLength length);
 
+    /*
+     * Build the .unwind_table section: the table of all the functions in
+     * .text, sorted by address, with their unwind data.
+     * See ExceptionHandling.UnwindTable
+     */
+    void buildUnwindSection(RelocationHash& relocHash);
+
     /*
      * Get the compiled code section size
      */
@@ -196,6 +211,14 @@ private:
     // The vtable size
     cBuffer m_vtblBuffer;
 
+    // The unwind table
+    cBuffer m_unwindBuffer;
+    // The position of the unwind data of the functions inside .text, by the
+    // position of the function
+    cHash<uint, uint> m_unwindData;
+    // Set to true if the code refers to the unwind table
+    bool m_isUnwindTableUsed;
+
     // Return section name by type
     const cString& getSectionName(SectionType sectionType);
     static const cString m_sectionBssString;
@@ -204,6 +227,7 @@ private:
     static const cString m_sectionVtblString;
     static const cString m_sectionTextString;
     static const cString m_sectionImportString;
+    static const cString m_sectionUnwindString;
 
     // All global dependancies
     GlobalObjectList m_globals;
@@ -220,6 +244,8 @@ private:
 
     // Is (arm) Thumb mode ?
     bool m_isThumb;
+    // The name of the generated object file
+    cString m_outputFilename;
 };
 
 #endif // __TBA_CLR_EXECUTER_RUNTIME_ELFLINKER_H
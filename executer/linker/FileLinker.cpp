@@ -45,15 +45,96 @@
 #include "xStl/stream/fileStream.h"
 #include "xStl/stream/traceStream.h"
 
-FileLinker::FileLinker(CompilerEngineThread& compilerEngineThread, ApartmentPtr apartment) :
-    LinkerInterface(compilerEngineThread, apartment)
+FileLinker::FileLinker(CompilerEngineThread& compilerEngineThread,
+                       ApartmentPtr apartment,
+                       const cString& outputDirectory,
+                       uint unitsCount) :
+    LinkerInterface(compilerEngineThread, apartment),
+    m_outputDirectory(outputDirectory),
+    m_unitsCount(unitsCount)
 {
+    CHECK(m_unitsCount > 0);
 }
 
-void FileLinker::writeString(basicIO& out, const cString& string)
+FileLinker::BufferedWriter::BufferedWriter(basicIO& stream, uint bufferSize) :
+    m_stream(stream),
+    m_buffer(bufferSize),
+    m_used(0)
+{
+}
+
+void FileLinker::BufferedWriter::write(const void* data, uint length)
+{
+    if (m_used + length > m_buffer.getSize())
+    {
+        flush();
+        // Blocks which doesn't fit the buffer are written as is
+        if (length >= m_buffer.getSize())
+        {
+            m_stream.pipeWrite((const uint8*)data, length);
+            return;
+        }
+    }
+
+    cOS::memcpy(m_buffer.getBuffer() + m_used, data, length);
+    m_used+= length;
+}
+
+void FileLinker::BufferedWriter::flush()
+{
+    if (m_used > 0)
+        m_stream.pipeWrite(m_buffer.getBuffer(), m_used);
+    m_used = 0;
+}
+
+cString FileLinker::getOutputFilename(const cString& filename) const
+{
+    if (m_outputDirectory.length() == 0)
+        return filename;
+
+    cString ret(m_outputDirectory);
+    if ((ret[ret.length() - 1] != '/') &&
+        (ret[ret.length() - 1] != '\\'))
+    {
+        ret+= "/";
+    }
+    ret+= filename;
+    return ret;
+}
+
+void FileLinker::writeString(BufferedWriter& out, const cString& string)
 {
     cSArray<char> a = string.getASCIIstring();
-    out.pipeWrite((const uint8*)a.getBuffer(), a.getSize() - 1);
+    out.write(a.getBuffer(), a.getSize() - 1);
+}
+
+void FileLinker::writeByteArray(BufferedWriter& out, const uint8* data, uint size)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    enum { BYTES_PER_LINE = 16, CHARS_PER_BYTE = 6 };
+    // Each byte is encoded as "0xHH, "
+    char line[BYTES_PER_LINE * CHARS_PER_BYTE];
+
+    uint j = 0;
+    while (j < size)
+    {
+        uint length = 0;
+        for (uint k = 0; (k < BYTES_PER_LINE) && (j < size); k++, j++)
+        {
+            line[length++] = '0';
+            line[length++] = 'x';
+            line[length++] = hexDigits[data[j] >> 4];
+            line[length++] = hexDigits[data[j] & 0x0F];
+            if (j != size - 1)
+            {
+                line[length++] = ',';
+                line[length++] = ' ';
+            }
+        }
+        out.write(line, length);
+        if (j != size)
+            writeString(out, endl);
+    }
 }
 
 cString FileLinker::demangleName(const cString& name)
@@ -66,7 +147,7 @@ cString FileLinker::demangleName(const cString& name)
     return name;
 }
 
-void FileLinker::writeFuntionHeaderAndBody(basicIO& out,
+void FileLinker::writeFuntionHeaderAndBody(BufferedWriter& out,
                                            const TokenIndex& function,
                                            const SecondPassBinary& bin,
                                            bool shouldAddBody)
@@ -88,17 +169,17 @@ void FileLinker::writeFuntionHeaderAndBody(basicIO& out,
         uint size = bin.getData().getSize();
         while (data[size-1] == 0)
             size--;
-        out.pipeWrite(data, size);
+        out.write(data, size);
     } else
     {
         // Find the first location of ')'
         uint size = 0;
         while (data[size] != ')') size++;
-        out.pipeWrite(data, size+1);
+        out.write(data, size+1);
     }
 }
 
-void FileLinker::writeVTable(basicIO& out,
+void FileLinker::writeVTable(BufferedWriter& out,
                              const TokenIndex& token)
 {
     ResolverInterface& resolver = m_apartment->getObjects().getTypedefRepository();
@@ -159,34 +240,40 @@ void FileLinker::writeVTable(basicIO& out,
 
 void FileLinker::resolveAndExecuteAllDependencies(TokenIndex& mainMethod)
 {
-    cFileStream outFile(cString("c:\\temp\\testclr\\output.c"), cFile::WRITE | cFile::CREATE);
     const MethodTransTable& table = m_engine.getBinaryRepository().getMethodTransTable();
     cList<TokenIndex> functions = table.keys();
     cHash<TokenIndex, int> externFunctions;
 
+    // All declerations are shared between the translation units
+    cFileStream headerFile(getOutputFilename("output.h"), cFile::WRITE | cFile::CREATE);
+    BufferedWriter header(headerFile);
+    writeString(header, cString("#ifndef __MORPH_OUTPUT_H") + endl);
+    writeString(header, cString("#define __MORPH_OUTPUT_H") + endl);
+
     if (1) // TODO! Check for linker options for MS compatability
     {
-        writeString(outFile, "#include \"32c_wrapper/imports.h\"");
-        writeString(outFile, endl);
+        writeString(header, "#include \"32c_wrapper/imports.h\"");
+        writeString(header, endl);
         // Disable all warnings
-        writeString(outFile, "#ifdef _MSC_VER");
-        writeString(outFile, endl);
-        writeString(outFile, "    #pragma warning(disable:4102)");writeString(outFile, endl);
-        writeString(outFile, "    #pragma warning(disable:4022)");writeString(outFile, endl);
-        writeString(outFile, "    #pragma warning(disable:4047)");writeString(outFile, endl);
-        writeString(outFile, "    #pragma warning(disable:4101)");writeString(outFile, endl);
-        writeString(outFile, "    #pragma warning(disable:4024)");writeString(outFile, endl);
-        writeString(outFile, "#endif");writeString(outFile, endl);
-
-        writeString(outFile, "#ifdef __GNUC__");writeString(outFile, endl);
-        writeString(outFile, "    #pragma GCC diagnostic warning \"-w\"");writeString(outFile, endl);
-        writeString(outFile, "#endif");writeString(outFile, endl);
+        writeString(header, "#ifdef _MSC_VER");
+        writeString(header, endl);
+        writeString(header, "    #pragma warning(disable:4102)");writeString(header, endl);
+        writeString(header, "    #pragma warning(disable:4022)");writeString(header, endl);
+        writeString(header, "    #pragma warning(disable:4047)");writeString(header, endl);
+        writeString(header, "    #pragma warning(disable:4101)");writeString(header, endl);
+        writeString(header, "    #pragma warning(disable:4024)");writeString(header, endl);
+        writeString(header, "#endif");writeString(header, endl);
+
+        writeString(header, "#ifdef __GNUC__");writeString(header, endl);
+        writeString(header, "    #pragma GCC diagnostic warning \"-w\"");writeString(header, endl);
+        writeString(header, "#endif");writeString(header, endl);
     }
 
     // Add all exports & imports, declerations
     cList<TokenIndex>::iterator i = functions.begin();
     cHash<TokenIndex, uint> stringTable, vtblHash, staticTable;
     cList<TokenIndex> strings;
+    uint totalCodeSize = 0;
     for (; i != functions.end(); ++i)
     {
         addressNumericValue addr;
@@ -199,7 +286,7 @@ void FileLinker::resolveAndExecuteAllDependencies(TokenIndex& mainMethod)
             d+= " ";
             d+= demangleName(entry->m_importName);
             d+= endl;
-            writeString(outFile, d);
+            writeString(header, d);
         } else
         {
             cString exportName(table[*i]->getDebugInformation().getExportName());
@@ -210,12 +297,13 @@ void FileLinker::resolveAndExecuteAllDependencies(TokenIndex& mainMethod)
                 d+= " ";
                 d+= demangleName(exportName);
                 d+= endl;
-                writeString(outFile, d);
+                writeString(header, d);
             }
 
             // Add forward deceleration
-            writeFuntionHeaderAndBody(outFile, *i, *table[*i], false);
-            writeString(outFile, cString(";") + endl);
+            writeFuntionHeaderAndBody(header, *i, *table[*i], false);
+            writeString(header, cString(";") + endl);
+            totalCodeSize+= table[*i]->getData().getSize();
         }
 
         // Scan dependency and compile vtbl and string table
@@ -259,76 +347,129 @@ void FileLinker::resolveAndExecuteAllDependencies(TokenIndex& mainMethod)
         }
     }
 
-    // Adding string table
+    // Declare the string table
     uint size = m_apartment->getObjects().getStringRepository().getAsciiStringRepository().getSize();
     if (size > 0)
-    {
-        writeString(outFile, cString("static const unsigned char gStringTable[] = {"));
-        writeString(outFile, endl);
-        const uint8* sdata = m_apartment->getObjects().getStringRepository().getAsciiStringRepository().getBuffer();
-        for (uint j = 0; j < size; j++)
-        {
-            writeString(outFile, "0x");
-            writeString(outFile, HEXBYTE(sdata[j]));
-            if (j != size - 1)
-            {
-                writeString(outFile, ", ");
-                if ((j & 0x0F) == 0x0F)
-                    writeString(outFile, endl);
-            }
-        }
-        writeString(outFile, cString("};") + endl);
-    }
+        writeString(header, cString("extern const unsigned char gStringTable[];") + endl);
     strings = stringTable.keys();
     i = strings.begin();
     for (; i != strings.end(); ++i)
     {
-        writeString(outFile, "#define str");
-        writeString(outFile, HEXDWORD((*i).m_b));
-        writeString(outFile, HEXDWORD((*i).m_a));
-        writeString(outFile, " (gStringTable + ");
-        writeString(outFile, cString(stringTable[*i]));
-        writeString(outFile, ")");
-        writeString(outFile, endl);
+        cString d("#define str");
+        d+= HEXDWORD((*i).m_b);
+        d+= HEXDWORD((*i).m_a);
+        d+= " (gStringTable + ";
+        d+= cString(stringTable[*i]);
+        d+= ")";
+        d+= endl;
+        writeString(header, d);
     }
 
-    strings = vtblHash.keys();
-    i = strings.begin();
-    for (; i != strings.end(); ++i)
+    // Declare the virtual tables
+    cList<TokenIndex> vtbls = vtblHash.keys();
+    i = vtbls.begin();
+    for (; i != vtbls.end(); ++i)
     {
-        writeVTable(outFile, *i);
+        cString d("extern int* vtbl");
+        d+= HEXDWORD((*i).m_b);
+        d+= HEXDWORD((*i).m_a);
+        d+= ";";
+        d+= endl;
+        writeString(header, d);
     }
 
-    // Add globals
-    writeString(outFile, "static unsigned char ");
-    writeString(outFile, c32CCompilerInterface::getGlobalsName());
-    writeString(outFile, "[0x");
-    writeString(outFile, HEXDWORD(getTotalAllocatedStaticBuffer()));
-    writeString(outFile, "];");
-    writeString(outFile, endl);
-
+    // Declare the globals
+    writeString(header, cString("extern unsigned char ") +
+                        c32CCompilerInterface::getGlobalsName() + "[];" + endl);
     strings = staticTable.keys();
     i = strings.begin();
     for (; i != strings.end(); ++i)
     {
-        writeString(outFile, "#define glbl");
-        writeString(outFile, HEXDWORD((*i).m_b));
-        writeString(outFile, HEXDWORD((*i).m_a));
-        writeString(outFile, " (");
-        writeString(outFile, c32CCompilerInterface::getGlobalsName() + " + ");
-        writeString(outFile, cString(staticTable[*i]));
-        writeString(outFile, ")");
-        writeString(outFile, endl);
+        cString d("#define glbl");
+        d+= HEXDWORD((*i).m_b);
+        d+= HEXDWORD((*i).m_a);
+        d+= " (";
+        d+= c32CCompilerInterface::getGlobalsName();
+        d+= " + ";
+        d+= cString(staticTable[*i]);
+        d+= ")";
+        d+= endl;
+        writeString(header, d);
     }
 
-    // Add all functions
+    writeString(header, cString("#endif") + endl);
+    header.flush();
+
+    // Spread the functions over the units, balanced by code size
+    uint unitSize = (totalCodeSize + m_unitsCount - 1) / m_unitsCount;
+    cHash<TokenIndex, uint> functionUnits;
+    uint unitIndex = 0;
+    uint currentSize = 0;
     i = functions.begin();
     for (; i != functions.end(); ++i)
     {
         if (externFunctions.hasKey(*i))
             continue;
 
-        writeFuntionHeaderAndBody(outFile, *i, *table[*i], true);
+        if ((currentSize >= unitSize) && (unitIndex + 1 < m_unitsCount))
+        {
+            unitIndex++;
+            currentSize = 0;
+        }
+        functionUnits.append(*i, unitIndex);
+        currentSize+= table[*i]->getData().getSize();
+    }
+
+    for (unitIndex = 0; unitIndex < m_unitsCount; unitIndex++)
+    {
+        cString filename("output");
+        if (unitIndex > 0)
+            filename+= cString(unitIndex);
+        filename+= ".c";
+        cFileStream unitFile(getOutputFilename(filename), cFile::WRITE | cFile::CREATE);
+        BufferedWriter unit(unitFile);
+        writeString(unit, cString("#include \"output.h\"") + endl);
+
+        // The first unit holds the data tables
+        if (unitIndex == 0)
+        {
+            // Adding string table
+            if (size > 0)
+            {
+                writeString(unit, cString("const unsigned char gStringTable[] = {"));
+                writeString(unit, endl);
+                writeByteArray(unit,
+                    m_apartment->getObjects().getStringRepository().getAsciiStringRepository().getBuffer(),
+                    size);
+                writeString(unit, cString("};") + endl);
+            }
+
+            i = vtbls.begin();
+            for (; i != vtbls.end(); ++i)
+            {
+                writeVTable(unit, *i);
+            }
+
+            // Add globals
+            writeString(unit, "unsigned char ");
+            writeString(unit, c32CCompilerInterface::getGlobalsName());
+            writeString(unit, "[0x");
+            writeString(unit, HEXDWORD(getTotalAllocatedStaticBuffer()));
+            writeString(unit, "];");
+            writeString(unit, endl);
+        }
+
+        // Add all functions of the unit
+        i = functions.begin();
+        for (; i != functions.end(); ++i)
+        {
+            if ((!functionUnits.hasKey(*i)) || (functionUnits[*i] != unitIndex))
+                continue;
+
+            writeFuntionHeaderAndBody(unit, *i, *table[*i], true);
+        }
+
+        unit.flush();
     }
 }
 
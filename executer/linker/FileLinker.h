@@ -39,6 +39,10 @@
  *
  * Author: Pavel Ferencz
  */
+#include "xStl/types.h"
+#include "xStl/data/array.h"
+#include "xStl/data/string.h"
+#include "xStl/stream/basicIO.h"
 #include "executer/compiler/CompilerEngineThread.h"
 #include "executer/linker/LinkerInterface.h"
 #include "dismount/assembler/BinaryDependencies.h"
@@ -46,8 +50,26 @@
 class FileLinker : public LinkerInterface
 {
 public:
-    // Constructor
-    FileLinker(CompilerEngineThread& compilerEngineThread, ApartmentPtr apartment);
+    // The default number of translation units
+    enum { DEFAULT_UNITS_COUNT = 1 };
+
+    /*
+     * Constructor
+     *
+     * outputDirectory - The directory in which the source files are created.
+     *                   Empty string for the current directory
+     * unitsCount      - The number of translation units the methods are
+     *                   spread over. The units are balanced by code size.
+     *
+     * The linker generates 'output.h' with the shared declerations (imports,
+     * prototypes, vtables, strings and globals), 'output.c' with the data
+     * tables and the first methods unit, and 'output1.c'...'output<N-1>.c'
+     * with the rest of the methods. All units can be compiled in parallel.
+     */
+    FileLinker(CompilerEngineThread& compilerEngineThread,
+               ApartmentPtr apartment,
+               const cString& outputDirectory = cString(),
+               uint unitsCount = DEFAULT_UNITS_COUNT);
 
     // See LinkerInterface::resolveAndExecuteAllDependencies
     virtual void resolveAndExecuteAllDependencies(TokenIndex& mainMethod);
@@ -62,10 +84,62 @@ protected:
     virtual addressNumericValue bind(SecondPassBinary& pass);
 
 private:
+    /*
+     * Accumulate the generated source in memory and flush it to the stream
+     * in large blocks, instead of a stream write for every token.
+     */
+    class BufferedWriter {
+    public:
+        // The default size of the buffer
+        enum { DEFAULT_BUFFER_SIZE = 0x100000 };
+
+        /*
+         * Constructor
+         *
+         * stream     - The stream to write into. Must be valid as long as the
+         *              writer is in use.
+         * bufferSize - The size of the buffer
+         */
+        BufferedWriter(basicIO& stream, uint bufferSize = DEFAULT_BUFFER_SIZE);
+
+        /*
+         * Append a block of data
+         */
+        void write(const void* data, uint length);
+
+        /*
+         * Write all pending data into the stream. Must be called before the
+         * writer is destroyed.
+         */
+        void flush();
+
+    private:
+        // Disable copy construction
+        BufferedWriter(const BufferedWriter& other);
+        BufferedWriter& operator=(const BufferedWriter& other);
+
+        // The output stream
+        basicIO& m_stream;
+        // The pending data
+        cBuffer m_buffer;
+        // Number of pending bytes in m_buffer
+        uint m_used;
+    };
+
+    /*
+     * Return the full path of an output file
+     */
+    cString getOutputFilename(const cString& filename) const;
+
     /*
      * Encode a string to a file
      */
-    void writeString(basicIO& out, const cString& string);
+    void writeString(BufferedWriter& out, const cString& string);
+
+    /*
+     * Encode a binary buffer as a C array initializer list
+     */
+    void writeByteArray(BufferedWriter& out, const uint8* data, uint size);
 
     /*
      * Return a function
@@ -73,7 +147,7 @@ private:
      * shouldAddBody - Set to true if adding all body,
      *                 false if only the header
      */
-    void writeFuntionHeaderAndBody(basicIO& out,
+    void writeFuntionHeaderAndBody(BufferedWriter& out,
                                    const TokenIndex& function,
                                    const SecondPassBinary& bin,
                                    bool shouldAddBody);
@@ -81,7 +155,7 @@ private:
     /*
      * Create a new vtbl for token
      */
-    void writeVTable(basicIO& out,
+    void writeVTable(BufferedWriter& out,
                      const TokenIndex& token);
 
     /*
@@ -89,6 +163,11 @@ private:
      */
     cString demangleName(const cString& name);
 
+    // The directory of the generated files
+    cString m_outputDirectory;
+    // The number of methods translation units
+    uint m_unitsCount;
+
     // Disable copy construction
     FileLinker(const FileLinker& other);
     FileLinker& operator=(const FileLinker& other);
@@ -44,16 +44,23 @@
 
 LinkerInterfacePtr LinkerFactory::getLinker(LinkerType type,
                                             CompilerEngineThread& compilerEngineThread,
-                                            ApartmentPtr apartment)
+                                            ApartmentPtr apartment,
+                                            const cString& outputDirectory,
+                                            uint outputUnitsCount,
+                                            const cString& outputFilename)
 {
     switch(type)
     {
     case MEMORY_LINKER:
         return LinkerInterfacePtr(new MemoryLinker(compilerEngineThread, apartment));
+    case LAZY_MEMORY_LINKER:
+        return LinkerInterfacePtr(new MemoryLinker(compilerEngineThread, apartment, true));
     case ELF_LINKER:
-        return LinkerInterfacePtr(new ELFLinker(compilerEngineThread, apartment));
+        if (outputFilename.length() == 0)
+            return LinkerInterfacePtr(new ELFLinker(compilerEngineThread, apartment));
+        return LinkerInterfacePtr(new ELFLinker(compilerEngineThread, apartment, outputFilename));
     case FILE_LINKER:
-        return LinkerInterfacePtr(new FileLinker(compilerEngineThread, apartment));
+        return LinkerInterfacePtr(new FileLinker(compilerEngineThread, apartment, outputDirectory, outputUnitsCount));
     default:
         CHECK_FAIL();
         break;
@@ -38,6 +38,7 @@
  * Author: Pavel Ferencz
  */
 #include "xStl/types.h"
+#include "xStl/data/string.h"
 #include "executer/linker/LinkerInterface.h"
 
 /*
@@ -49,6 +50,8 @@ public:
     enum LinkerType {
         // In-memory linker for 32-bit x86 based machines
         MEMORY_LINKER,
+        // In-memory linker which compiles methods on their first call
+        LAZY_MEMORY_LINKER,
         // COFF format linker
         COFF_LINKER,
         // ELF format linker
@@ -63,12 +66,20 @@ public:
      * type                    - The format type
      * compilerEngineThread -
      * apartment            -
+     * outputDirectory      - The output directory of the file linker
+     * outputUnitsCount     - The number of source files of the file linker.
+     *                        See FileLinker::FileLinker
+     * outputFilename       - The name of the object file of the ELF linker.
+     *                        Empty string for the default name (output.o)
      *
      * Return the linker interface
      */
     static LinkerInterfacePtr getLinker(LinkerType type,
                                         CompilerEngineThread& compilerEngineThread,
-                                        ApartmentPtr apartment);
+                                        ApartmentPtr apartment,
+                                        const cString& outputDirectory = cString(),
+                                        uint outputUnitsCount = 1,
+                                        const cString& outputFilename = cString());
 };
 
 #endif // __TBA_CLR_EXECUTER_RUNTIME_LINKERFACTORY_H
@@ -41,6 +41,7 @@
 #include "xStl/stream/traceStream.h"
 #include "xStl/stream/ioStream.h"
 #include "xStl/os/os.h"
+#include "data/exceptions.h"
 #include "compiler/CallingConvention.h"
 #include "executer/runtime/Executer.h"
 #include "executer/linker/MemoryLinker.h"
@@ -58,18 +59,33 @@
     #include <sys/mman.h>
     #include <errno.h>
 #endif
+#include <stdlib.h>
+
+MemoryLinker::LazyCallSite::LazyCallSite(const SecondPassBinaryPtr& binary,
+                                         const BinaryDependencies::DependencyObject& dependency,
+                                         addressNumericValue binaryAddress,
+                                         addressNumericValue* slot) :
+    m_binary(binary),
+    m_dependency(dependency),
+    m_binaryAddress(binaryAddress),
+    m_slot(slot)
+{
+}
 
 MemoryLinker::MemoryLinker(CompilerEngineThread& compilerEngineThread,
-    ApartmentPtr apartment) :
-    LinkerInterface(compilerEngineThread, apartment)
+    ApartmentPtr apartment,
+    bool isLazy,
+    uint codeAlignment) :
+    LinkerInterface(compilerEngineThread, apartment),
+    m_codeArena(codeAlignment),
+    m_isLazy(isLazy),
+    m_lazyStubsCount(0),
+    m_lazyThunk(NULL)
 {
     // Prepare the data-section
     cForkStreamPtr forked = m_apartment->getStreams().getUserStringsStream()->fork();
     forked->seek(0, basicInput::IO_SEEK_SET);
     forked->readAllStream(m_stringTable);
-
-    m_area = NULL;
-    m_offset = 0;
 }
 
 addressNumericValue MemoryLinker::bind(SecondPassBinary& pass)
@@ -80,85 +96,44 @@ addressNumericValue MemoryLinker::bind(SecondPassBinary& pass)
         return m_reloc[addr];
     }
     else {
-        addressNumericValue new_addr = getNumeric((char*)m_area + m_offset);
+        // Each method is placed as it is bound, and copied by relocate()
+        addressNumericValue new_addr = getNumeric(m_codeArena.allocate(pass.getData().getSize()));
         m_reloc.append(addr, new_addr);
-        m_offset += pass.getData().getSize();
+        m_pendingCopy.append(&pass);
         return new_addr;
     }
 }
 
-void MemoryLinker::allocate()
-{
-    m_offset = 0;
-
-    MethodTransTable transTable = m_engine.getBinaryRepository().getMethodTransTable();
-    const cList<TokenIndex>& transKeys(transTable.keys());
-    cList<TokenIndex>::iterator i = transKeys.begin();
-    for (;  i != transKeys.end(); ++i)
-    {
-        SecondPassBinaryPtr methodPtr(transTable[*i]);
-        m_offset += methodPtr->getData().getSize();
-    }
-
-#ifdef XSTL_WINDOWS
-    m_area = VirtualAlloc(0, m_offset, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-#elif defined XSTL_LINUX
-
-#ifdef XSTL_64BIT
-    m_area = MAP_FAILED;
-#else
-    m_area = mmap(NULL, m_offset, PROT_EXEC | PROT_WRITE | PROT_READ, MAP_PRIVATE  | MAP_ANONYMOUS, -1, 0);
-#endif
-
-    if (m_area == MAP_FAILED)
-    {
-        cout << "Cannot create executable code (errno): " << errno << endl;
-        CHECK_FAIL();
-    }
-#else
-    m_area = cOS::smallMemoryAllocation(m_offset);
-    #error "Please add execution allocation right\n"
-#endif
-
-    // now that a new area has been allocated, we should start all over... :(
-    m_offset = 0;
-    m_reloc.removeAll();
-
-    m_vtblBuffer.changeSize(m_apartment->getObjects().getTypedefRepository().
-                                estimateVirtualTableMaximumSize(sizeof(addressNumericValue)));
-}
-
 void MemoryLinker::relocate()
 {
-    MethodTransTable transTable = m_engine.getBinaryRepository().getMethodTransTable();
-    const cList<TokenIndex>& transKeys(transTable.keys());
-    cList<TokenIndex>::iterator i = transKeys.begin();
-    for (;  i != transKeys.end(); ++i)
+    cList<SecondPassBinary*>::iterator i = m_pendingCopy.begin();
+    for (; i != m_pendingCopy.end(); ++i)
     {
-        SecondPassBinaryPtr methodPtr(transTable[*i]);
-        void *code = methodPtr->getData().getBuffer();
-        addressNumericValue addr = getNumeric(code);
-        if (m_reloc.hasKey(addr)) {
-            void *copy_to = getPtr(m_reloc[addr]);
-            memcpy(copy_to, code, methodPtr->getData().getSize());
-        }
+        const cBuffer& data = (*i)->getData();
+        memcpy(getPtr(m_reloc[getNumeric(data.getBuffer())]), data.getBuffer(), data.getSize());
     }
+    m_pendingCopy.removeAll();
 }
 
 void MemoryLinker::resolveAndExecuteAllDependencies(TokenIndex& mainMethod)
 {
     // Prepare the global table
     m_staticTable = cBuffer(m_apartment->getObjects().getTypedefRepository().getStaticTotalLength());
-    m_staticDataTable = m_apartment->getObjects().getTypedefRepository().getDataSection();
     memset(m_staticTable.getBuffer(), 0, m_staticTable.getSize());
 
     SecondPassBinaryPtr mainMethodPtr(m_engine.getBinaryRepository().
                                         getSecondPassMethod(mainMethod));
 
-    allocate();
+    // In lazy mode, only what was compiled so far is linked. The rest is
+    // bound to trampolines
+    if (m_isLazy)
+        buildLazyThunk();
+
     // Replacing all dependencies
     resolve(mainMethod);
     relocate();
+    // The code is not changed until the next lazy method
+    m_codeArena.makeExecutable();
 
     // And execute the main method
     XSTL_TRY
@@ -172,7 +147,7 @@ void MemoryLinker::resolveAndExecuteAllDependencies(TokenIndex& mainMethod)
         _CrtMemCheckpoint(&cp);
 #endif
 #endif
-        int32 value = Executer::execute(addr);
+        int32 value = m_isLazy ? executeLazy(addr) : Executer::execute(addr);
 #ifdef _MSC_VER
 #ifdef _DEBUG
         _CrtMemDumpAllObjectsSince(&cp);
@@ -186,12 +161,78 @@ void MemoryLinker::resolveAndExecuteAllDependencies(TokenIndex& mainMethod)
     }
 }
 
+addressNumericValue MemoryLinker::getStaticFieldAddress(const TokenIndex& fieldToken)
+{
+    ResolverInterface& resolver = m_apartment->getObjects().getTypedefRepository();
+    uint size = resolver.getTypeSize(resolver.getFieldType(fieldToken, ElementType::UnresolvedTokenIndex));
+    addressNumericValue offset = getStaticAddress(fieldToken);
+    if (offset + size <= m_staticTable.getSize())
+        return getNumeric(m_staticTable.getBuffer() + offset);
+
+    // The static was allocated after the table was placed (a lazily compiled
+    // cctor wrapper for example). The table cannot be moved since compiled
+    // code already holds addresses into it, so give the field its own storage
+    if (!m_lateStatics.hasKey(fieldToken))
+    {
+        cBufferPtr storage(new cBuffer(size));
+        memset(storage->getBuffer(), 0, size);
+        m_lateStatics.append(fieldToken, storage);
+    }
+    return getNumeric(m_lateStatics[fieldToken]->getBuffer());
+}
+
+MemoryLinker::StableCopy::StableCopy() :
+    m_copiedSize(0)
+{
+}
+
+addressNumericValue MemoryLinker::StableCopy::getAddress(const cBuffer& repository,
+                                                         uint offset)
+{
+    // Copy the new entries. An empty repository still gets a segment, so
+    // empty entries have a valid address
+    uint size = repository.getSize();
+    if ((size > m_copiedSize) || (m_segments.length() == 0))
+    {
+        Segment segment;
+        segment.m_offset = m_copiedSize;
+        // An extra null byte terminates the segment
+        segment.m_data = cBufferPtr(new cBuffer(size - m_copiedSize + 1));
+        cOS::memcpy(segment.m_data->getBuffer(),
+                    repository.getBuffer() + m_copiedSize,
+                    size - m_copiedSize);
+        segment.m_data->getBuffer()[size - m_copiedSize] = 0;
+        m_segments.append(segment);
+        m_copiedSize = size;
+    }
+
+    // The entry is inside the last segment which starts before it. An empty
+    // entry at the end of the repository points to the terminator
+    CHECK(offset <= m_copiedSize);
+    const Segment* found = NULL;
+    cList<Segment>::iterator i = m_segments.begin();
+    for (; i != m_segments.end(); ++i)
+    {
+        if ((*i).m_offset <= offset)
+            found = &(*i);
+    }
+    CHECK(found != NULL);
+    return getNumeric(found->m_data->getBuffer() + (offset - found->m_offset));
+}
+
+uint8* MemoryLinker::allocateVirtualTable(uint size)
+{
+    cBufferPtr storage(new cBuffer(size));
+    memset(storage->getBuffer(), 0, size);
+    m_vtables.append(storage);
+    return storage->getBuffer();
+}
+
 void MemoryLinker::resolve(const TokenIndex& methodIndex)
 {
-    MethodResolvedObject solved;
     MethodStackObject stack;
     stack.push(methodIndex);
-    resolve(stack, solved);
+    resolve(stack, m_resolved);
 }
 
 /**
@@ -217,6 +258,7 @@ void MemoryLinker::resolve(MethodStackObject& stack, MethodResolvedObject& resol
         SecondPassBinaryPtr binaryPtr(m_engine.getBinaryRepository().getSecondPassMethod(nextMethod));
         SecondPassBinary& binary = *binaryPtr;
         addressNumericValue binaryAddress = bind(binary);
+        addressNumericValue unwindData = 0;
 
         // Scan the method and resolve it
         const BinaryDependencies::DependencyObjectList& dependencies = binary.getDependencies().getList();
@@ -235,7 +277,8 @@ void MemoryLinker::resolve(MethodStackObject& stack, MethodResolvedObject& resol
             // ExecuterResolveTrace("\tTrying to resolve dependency: " << object.m_name << endl);
 
             TokenIndex methodToken;
-            if (CallingConvention::deserializeMethod(object.m_name, methodToken))
+            bool isRegisterEntry;
+            if (CallingConvention::deserializeMethod(object.m_name, methodToken, &isRegisterEntry))
             {
                 addressNumericValue addr = 0;
 
@@ -246,28 +289,42 @@ void MemoryLinker::resolve(MethodStackObject& stack, MethodResolvedObject& resol
                     // Maybe clrResolver should be applied ?
                     methodToken = m_clrResolver.resolve(m_apartment, methodToken);
 
-                    // . Compile the method
-                    // Check if the method wasn't resolved yet.
-                    if (!resolved.hasKey(methodToken))
+                    if ((m_isLazy) && (!m_engine.getBinaryRepository().isMethodExist(methodToken)))
                     {
-                        // Add the method to the queue
-                        stack.push(methodToken);
-                    }
+                        // The method is compiled on its first call
+                        addr = bindLazyStub(methodToken,
+                                            LazyCallSite(binaryPtr, object, binaryAddress, NULL),
+                                            isRegisterEntry);
+                    } else
+                    {
+                        // . Compile the method
+                        // Check if the method wasn't resolved yet.
+                        if (!resolved.hasKey(methodToken))
+                        {
+                            // Add the method to the queue
+                            stack.push(methodToken);
+                        }
 
 
-                    if (!m_engine.getBinaryRepository().isMethodExist(methodToken))
-                    {
-                        // Throw a nice exception
-                        ExecuterResolveTrace("\tMETHOD NOT FOUND!" << HEXTOKEN(methodToken) << endl);
-                        CHECK_FAIL();
-                    }
+                        if (!m_engine.getBinaryRepository().isMethodExist(methodToken))
+                        {
+                            // Throw a nice exception
+                            ExecuterResolveTrace("\tMETHOD NOT FOUND!" << HEXTOKEN(methodToken) << endl);
+                            CHECK_FAIL();
+                        }
 
-                    // Resolve the address
-                    SecondPassBinaryPtr methodSecondPtr(m_engine.getBinaryRepository().getSecondPassMethod(methodToken));
-                    addr = bind(*methodSecondPtr);
+                        // Resolve the address
+                        SecondPassBinaryPtr methodSecondPtr(m_engine.getBinaryRepository().getSecondPassMethod(methodToken));
+                        addr = bind(*methodSecondPtr);
+                        if (isRegisterEntry)
+                            addr+= CompilerInterface::REGISTER_ENTRY_OFFSET;
+                    }
                 }
                 else {
                     // ExecuterResolveTrace("\tExternal method detected." << endl);
+                    // Imported methods have no register entry. See
+                    // CallingConvention::getRegisterArgumentsCount()
+                    CHECK(!isRegisterEntry);
                 }
 
                 // ExecuterResolveTrace("\tMethod binded to addr: " << HEXDWORD(addr) << endl);
@@ -276,7 +333,9 @@ void MemoryLinker::resolve(MethodStackObject& stack, MethodResolvedObject& resol
             }
             else if (CallingConvention::deserializeGlobalData(object.m_name, globalIndex))
             {
-                addressNumericValue addr = getNumeric(m_staticDataTable.getBuffer()) + globalIndex;
+                addressNumericValue addr = m_staticDataTable.getAddress(
+                    m_apartment->getObjects().getTypedefRepository().getDataSection(),
+                    globalIndex);
                 // ExecuterResolveTrace("\tGlobal binded to addr: " << HEXDWORD(addr) << endl);
                 binary.resolveDependency(object, binaryAddress, addr);
                //  ExecuterResolveTrace("\tGlobal resolved" << endl);
@@ -294,7 +353,7 @@ void MemoryLinker::resolve(MethodStackObject& stack, MethodResolvedObject& resol
                 if (EncodingUtils::getTokenTableIndex(methodID) == TABLE_FIELD_TABLE)
                 {
                     // Static field token
-                    addressNumericValue addr = getNumeric(m_staticTable.getBuffer() + getStaticAddress(methodToken));
+                    addressNumericValue addr = getStaticFieldAddress(methodToken);
                     // ExecuterResolveTrace("\tGlobal binded to addr: " << HEXDWORD(addr) << endl);
                     binary.resolveDependency(object, binaryAddress, addr);
                     //  ExecuterResolveTrace("\tGlobal resolved" << endl);
@@ -309,11 +368,15 @@ void MemoryLinker::resolve(MethodStackObject& stack, MethodResolvedObject& resol
                     if (addr == 0)
                     {
                         // Build new vtbl
-                        addr = m_vtblFilledSize + getNumeric(m_vtblBuffer.getBuffer());
                         // Adding parents table
                         const ResolverInterface::ParentDictonary& parents = resolver.getParentDirectory(methodToken);
                         cList<TokenIndex> parentsId;
                         parents.keys(parentsId);
+                        const ResolverInterface::VirtualTable& vTbl =
+                                m_apartment->getObjects().getTypedefRepository().getVirtualTable(methodToken);
+                        // The parents and self rtti, the sizes and the methods
+                        addr = getNumeric(allocateVirtualTable((parentsId.length() + 2) * 4 +
+                                                               vTbl.length() * sizeof(addressNumericValue)));
                         uint16 ancestorLength = 0;
                         uint16* l = (uint16*)getPtr(addr);
 
@@ -350,8 +413,6 @@ void MemoryLinker::resolve(MethodStackObject& stack, MethodResolvedObject& resol
                         // Setting addr
                         addr = getNumeric(l);
                         setVtblAddress(methodToken, addr);
-                        const ResolverInterface::VirtualTable& vTbl =
-                                m_apartment->getObjects().getTypedefRepository().getVirtualTable(methodToken);
                         ResolverInterface::VirtualTable::iterator i = vTbl.begin();
 
                         addressNumericValue* ftbl = (addressNumericValue*)(l);
@@ -359,6 +420,14 @@ void MemoryLinker::resolve(MethodStackObject& stack, MethodResolvedObject& resol
                         for (; i != vTbl.end(); i++)
                         {
                             TokenIndex func = getVtblMethodIndexOverride(*i);
+                            if ((m_isLazy) && (!m_engine.getBinaryRepository().isMethodExist(func)))
+                            {
+                                // The slot is patched on the first call
+                                *ftbl = bindLazyStub(func, LazyCallSite(binaryPtr, object, binaryAddress, ftbl));
+                                ftbl++;
+                                m_vtblFilledSize += sizeof(addressNumericValue);
+                                continue;
+                            }
                             stack.push(func);
                             SecondPassBinaryPtr spt = m_engine.getBinaryRepository().getSecondPassMethod(func);
                             addressNumericValue binaryAddress = bind(*spt);
@@ -393,12 +462,24 @@ void MemoryLinker::resolve(MethodStackObject& stack, MethodResolvedObject& resol
 #else
             else if (m_apartment->getObjects().getStringRepository().deserializeStringA(object.m_name, globalIndex))
             {
-                addr = getNumeric(m_apartment->getObjects().getStringRepository().getAsciiStringRepository().getBuffer() + globalIndex);
+                addr = m_asciiStrings.getAddress(
+                    m_apartment->getObjects().getStringRepository().getAsciiStringRepository(),
+                    globalIndex);
                 // ExecuterResolveTrace("\tString binded to addr: " << HEXDWORD(addr) << endl);
                 binary.resolveDependency(object, binaryAddress, addr);
                 // ExecuterResolveTrace("\tToken resolved" << endl);
             }
 #endif // CLR_UNICODE
+            else if (object.m_name.compare(CallingConvention::gUnwindDataName) == cString::EqualTo)
+            {
+                // The head of the unwind data points to the method itself
+                unwindData = binaryAddress + object.m_position;
+                binary.resolveDependency(object, binaryAddress, binaryAddress);
+            }
+            else if (object.m_name.compare(CallingConvention::gUnwindTableName) == cString::EqualTo)
+            {
+                binary.resolveDependency(object, binaryAddress, m_unwindTable.getHeaderAddress());
+            }
             else
             {
                 // ExecuterResolveTrace("\tCannot resolve: " << object.m_name << endl);
@@ -418,6 +499,174 @@ void MemoryLinker::resolve(MethodStackObject& stack, MethodResolvedObject& resol
         }
 
         // The method was resolved OK.
+        m_unwindTable.addFunction(binaryAddress, binary.getData().getSize(), unwindData);
         resolved.append(nextMethod, true);
     }
 }
+
+//////////////////////////////////////////////////////////////////////////
+// Lazy compilation
+
+/*
+ * The common thunk. Each trampoline pushes its index and jumps here:
+ *      68 xx xx xx xx          push stubIndex
+ *      e9 xx xx xx xx          jmp  thunk
+ *
+ * The thunk keeps all registers (the arguments of the called method are still
+ * on the stack or in the argument registers), calls onLazyStubCalled() on an aligned stack, replaces the
+ * stub index with the compiled method address and returns into it.
+ */
+static const uint8 gLazyThunkTemplate[] = {
+    0x60,                           // pushad
+    0x8B, 0x44, 0x24, 0x20,         // mov eax, [esp + 20h]      ; stubIndex
+    0x89, 0xE5,                     // mov ebp, esp
+    0x83, 0xE4, 0xF0,               // and esp, 0FFFFFFF0h
+    0x83, 0xEC, 0x08,               // sub esp, 8
+    0x50,                           // push eax
+    0x68, 0x00, 0x00, 0x00, 0x00,   // push linker
+    0xB8, 0x00, 0x00, 0x00, 0x00,   // mov eax, onLazyStubCalled
+    0xFF, 0xD0,                     // call eax
+    0x89, 0xEC,                     // mov esp, ebp
+    0x89, 0x44, 0x24, 0x20,         // mov [esp + 20h], eax      ; target
+    0x61,                           // popad
+    0xC3                            // ret
+};
+// The offsets of the immediate values inside gLazyThunkTemplate
+enum { LAZY_THUNK_LINKER_OFFSET = 15, LAZY_THUNK_FUNCTION_OFFSET = 20 };
+
+// Write a 32 bit relative jump from 'position' into 'target'
+static void writeRelativeJump(uint8* position, addressNumericValue target)
+{
+    position[0] = 0xE9;
+    *((int32*)(position + 1)) = (int32)(target - (getNumeric(position) + 5));
+}
+
+void MemoryLinker::buildLazyThunk()
+{
+#ifdef XSTL_64BIT
+    // The trampolines are encoded for 32 bit x86 only
+    CHECK_FAIL();
+#endif
+    typedef addressNumericValue (*LazyStubCallback)(MemoryLinker*, uint);
+    LazyStubCallback callback = &MemoryLinker::onLazyStubCalled;
+
+    m_lazyThunk = (uint8*)m_codeArena.allocate(sizeof(gLazyThunkTemplate));
+    memcpy(m_lazyThunk, gLazyThunkTemplate, sizeof(gLazyThunkTemplate));
+    *((uint32*)(m_lazyThunk + LAZY_THUNK_LINKER_OFFSET)) = (uint32)getNumeric(this);
+    *((uint32*)(m_lazyThunk + LAZY_THUNK_FUNCTION_OFFSET)) = (uint32)getNumeric((void*)callback);
+}
+
+addressNumericValue MemoryLinker::bindLazyStub(const TokenIndex& methodToken,
+                                               const LazyCallSite& callSite,
+                                               bool isRegisterEntry)
+{
+    // Each entry of the method has its own trampoline
+    cHash<TokenIndex, uint>& stubsIndex = isRegisterEntry ? m_lazyRegisterStubsIndex :
+                                                            m_lazyStubsIndex;
+    if (stubsIndex.hasKey(methodToken))
+    {
+        LazyStub& stub = m_lazyStubs[stubsIndex[methodToken]];
+        stub.m_callSites.append(callSite);
+        return stub.m_stubAddress;
+    }
+
+    // Allocate new trampoline
+    uint8* code = (uint8*)m_codeArena.allocate(LAZY_STUB_SIZE);
+
+    uint index = m_lazyStubsCount++;
+    // push index
+    code[0] = 0x68;
+    *((uint32*)(code + 1)) = index;
+    // jmp thunk
+    writeRelativeJump(code + 5, getNumeric(m_lazyThunk));
+
+    LazyStub stub;
+    stub.m_method = methodToken;
+    stub.m_stubAddress = getNumeric(code);
+    stub.m_entryOffset = isRegisterEntry ? CompilerInterface::REGISTER_ENTRY_OFFSET : 0;
+    stub.m_target = 0;
+    stub.m_callSites.append(callSite);
+    m_lazyStubs.append(index, stub);
+    stubsIndex.append(methodToken, index);
+
+    ExecuterResolveTrace("\tLazy method " << HEXTOKEN(methodToken) << " bound to trampoline " << index << endl);
+    return stub.m_stubAddress;
+}
+
+int32 MemoryLinker::executeLazy(addressNumericValue address)
+{
+    if (setjmp(m_lazyFailure) != 0)
+    {
+        // A lazy method couldn't be compiled. See onLazyStubCalled()
+        XSTL_THROW(ClrRuntimeException);
+    }
+    return Executer::execute(address);
+}
+
+addressNumericValue MemoryLinker::onLazyStubCalled(MemoryLinker* linker, uint stubIndex)
+{
+    XSTL_TRY
+    {
+        return linker->compileLazyStub(stubIndex);
+    }
+    XSTL_CATCH(cException& e)
+    {
+        ExecuterTrace("MemoryLinker: ERROR! Lazy compilation failed" << endl);
+        e.print();
+    }
+    XSTL_CATCH_ALL
+    {
+        ExecuterTrace("MemoryLinker: ERROR! Lazy compilation failed" << endl);
+    }
+
+    // Exceptions cannot be unwound through the compiled code. Drop its frames
+    // and raise the error again from executeLazy()
+    linker->m_codeArena.makeExecutable();
+    longjmp(linker->m_lazyFailure, 1);
+    return 0;
+}
+
+addressNumericValue MemoryLinker::compileLazyStub(uint stubIndex)
+{
+    TokenIndex methodToken = m_lazyStubs[stubIndex].m_method;
+    if (m_lazyStubs[stubIndex].m_target != 0)
+        return m_lazyStubs[stubIndex].m_target;
+
+    ExecuterTrace("Stage: lazy compiling " << HEXTOKEN(methodToken) << endl);
+    SecondPassBinaryPtr pass = m_engine.compileMethod(methodToken);
+    CHECK(!pass.isEmpty());
+
+    // Link the method and every compiled method it reaches
+    m_codeArena.makeWritable();
+    resolve(methodToken);
+    relocate();
+
+    // New trampolines may have been added, take the reference only now
+    LazyStub& stub = m_lazyStubs[stubIndex];
+    stub.m_target = bind(*pass) + stub.m_entryOffset;
+
+    // Following calls through the trampoline jump directly into the method
+    writeRelativeJump((uint8*)getPtr(stub.m_stubAddress), stub.m_target);
+
+    // Patch all known call sites
+    cList<LazyCallSite>::iterator i = stub.m_callSites.begin();
+    for (; i != stub.m_callSites.end(); ++i)
+    {
+        LazyCallSite& site = *i;
+        if (site.m_slot != NULL)
+        {
+            *site.m_slot = stub.m_target;
+            continue;
+        }
+        // Update the caller binary and copy the changed call operand
+        site.m_binary->resolveDependency(site.m_dependency, site.m_binaryAddress, stub.m_target);
+        uint position = site.m_dependency.m_position;
+        memcpy(getPtr(site.m_binaryAddress + position),
+               site.m_binary->getData().getBuffer() + position,
+               sizeof(uint32));
+    }
+    stub.m_callSites.removeAll();
+
+    m_codeArena.makeExecutable();
+    return stub.m_target;
+}
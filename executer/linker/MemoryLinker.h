@@ -41,11 +41,25 @@
  */
 #include "executer/compiler/CompilerEngineThread.h"
 #include "executer/linker/LinkerInterface.h"
+#include "executer/linker/CodeArena.h"
+#include "executer/linker/UnwindTable.h"
+#include <setjmp.h>
 
 class MemoryLinker : public LinkerInterface
 {
 public:
-    MemoryLinker(CompilerEngineThread& compilerEngineThread, ApartmentPtr apartment);
+    /*
+     * Constructor.
+     *
+     * isLazy - Set to true in order to link only the compiled methods. Calls to
+     *          methods which are not compiled yet are bound to trampolines,
+     *          which compile the method on its first call and patch the call
+     *          site. See LinkerFactory::LAZY_MEMORY_LINKER
+     * codeAlignment - The alignment of the methods inside the code arena
+     */
+    MemoryLinker(CompilerEngineThread& compilerEngineThread, ApartmentPtr apartment,
+                 bool isLazy = false,
+                 uint codeAlignment = CodeArena::DEFAULT_ALIGNMENT);
 
     /*
      * Scan a method and all-of it sub-method and resolve all connections.
@@ -73,29 +87,176 @@ private:
     void resolve(const TokenIndex& methodIndex);
 
     /*
-     * Allocate all memory needed for the sections
+     * Copies all the functions that were processed using bind() since the last
+     * call into their place in the code arena.
+     * NOTE: The code arena must be writable
      */
-    void allocate();
+    void relocate();
+
+    // The code arena. Methods are appended as they are bound
+    CodeArena m_codeArena;
+    // Methods which were bound but not copied yet. The methods are owned by
+    // the binary repository
+    cList<SecondPassBinary*> m_pendingCopy;
+
+    //////////////////////////////////////////////////////////////////////////
+    // Lazy compilation
 
     /*
-     * Copies all the functions that were previously processed using bind() to the
-     * designated memory area.
-     * A region of appropriate size with execute permissions is allocated for that purpose.
+     * A location which should be patched once a lazy method is compiled.
      */
-    void relocate();
+    struct LazyCallSite {
+        // Constructor
+        LazyCallSite(const SecondPassBinaryPtr& binary,
+                     const BinaryDependencies::DependencyObject& dependency,
+                     addressNumericValue binaryAddress,
+                     addressNumericValue* slot);
+
+        // The calling method. Not used for virtual-table slots
+        SecondPassBinaryPtr m_binary;
+        // The call dependency inside m_binary
+        BinaryDependencies::DependencyObject m_dependency;
+        // The relocated address of m_binary
+        addressNumericValue m_binaryAddress;
+        // The virtual-table slot, or NULL for a call dependency
+        addressNumericValue* m_slot;
+    };
+
+    /*
+     * A trampoline for a method which wasn't compiled yet.
+     */
+    struct LazyStub {
+        // The method token
+        TokenIndex m_method;
+        // The address of the trampoline code
+        addressNumericValue m_stubAddress;
+        // The offset of the called entry inside the method. See
+        // CompilerInterface::REGISTER_ENTRY_OFFSET
+        uint m_entryOffset;
+        // The compiled entry address, or 0 until the first call
+        addressNumericValue m_target;
+        // All the locations which are bound to the trampoline
+        cList<LazyCallSite> m_callSites;
+    };
+
+    /*
+     * Return the trampoline address for a method which isn't compiled yet, and
+     * register the call site for patching.
+     *
+     * isRegisterEntry - Set to true for calls into the register entry of the
+     *                   method. The thunk keeps the argument registers.
+     */
+    addressNumericValue bindLazyStub(const TokenIndex& methodToken,
+                                     const LazyCallSite& callSite,
+                                     bool isRegisterEntry = false);
+
+    /*
+     * Build the common thunk which is shared by all the trampolines
+     */
+    void buildLazyThunk();
+
+    /*
+     * Called by the common thunk on the first call of a lazy method. The
+     * method is compiled, linked and copied. The trampoline is changed into a
+     * direct jump and all the registered call sites are patched.
+     *
+     * Return the address of the compiled method.
+     *
+     * NOTE: This function is called from compiled code with the cdecl calling
+     *       convention. Exceptions are not allowed to leave it, a failure
+     *       jumps back into executeLazy() instead.
+     */
+    static addressNumericValue onLazyStubCalled(MemoryLinker* linker, uint stubIndex);
+    addressNumericValue compileLazyStub(uint stubIndex);
+
+    // The size of a single trampoline
+    enum { LAZY_STUB_SIZE = 16 };
+    /*
+     * Execute the main method in lazy mode. Throws ClrRuntimeException if a
+     * method couldn't be compiled on its first call.
+     */
+    int32 executeLazy(addressNumericValue address);
+
+    /*
+     * Return the address of a static field. Statics which are allocated after
+     * the static table was placed get their own storage.
+     */
+    addressNumericValue getStaticFieldAddress(const TokenIndex& fieldToken);
+
+    /*
+     * A copy of a repository which only grows, such as the data section or
+     * the strings. The repository is copied in segments: once a segment is
+     * copied it never moves, so compiled code can keep addresses into it while
+     * lazily compiled methods append new entries to the repository.
+     */
+    class StableCopy {
+    public:
+        // Constructor
+        StableCopy();
+
+        /*
+         * Return the address of an entry inside the copy. Entries which were
+         * appended to the repository since the last call are copied into a
+         * new segment.
+         *
+         * repository - The current content of the repository
+         * offset - The offset of the entry inside the repository
+         */
+        addressNumericValue getAddress(const cBuffer& repository, uint offset);
+
+    private:
+        // A copied part of the repository
+        struct Segment {
+            // The offset of the segment inside the repository
+            uint m_offset;
+            // The copied content
+            cBufferPtr m_data;
+        };
+        // All the segments, in the order of the repository
+        cList<Segment> m_segments;
+        // The number of bytes which were copied so far
+        uint m_copiedSize;
+    };
+
+    /*
+     * Allocate storage for a new virtual table. Virtual tables never move,
+     * see m_vtables
+     */
+    uint8* allocateVirtualTable(uint size);
+
+    // Set to true for lazy compilation
+    bool m_isLazy;
+    // All trampolines by index, and the index per method and per method
+    // register entry
+    cHash<uint, LazyStub> m_lazyStubs;
+    cHash<TokenIndex, uint> m_lazyStubsIndex;
+    cHash<TokenIndex, uint> m_lazyRegisterStubsIndex;
+    uint m_lazyStubsCount;
+    // The common thunk
+    uint8* m_lazyThunk;
+    // The host context of executeLazy(), restored when lazy compilation fails
+    jmp_buf m_lazyFailure;
+    // All methods which were resolved so far
+    MethodResolvedObject m_resolved;
 
 
     // The strings
     cBuffer m_stringTable;
+    StableCopy m_asciiStrings;
     // Static data
     cBuffer m_staticTable;
-    cBuffer m_staticDataTable;
-    // Virtual table
-    cBuffer m_vtblBuffer;
+    StableCopy m_staticDataTable;
+    // Statics which didn't fit into m_staticTable. See getStaticFieldAddress()
+    cHash<TokenIndex, cBufferPtr> m_lateStatics;
+    // Virtual tables. Each table gets its own storage, since types can be
+    // first met by a lazily compiled method
+    cList<cBufferPtr> m_vtables;
 
+    // Compiled method buffer vs. address inside the code arena
     cHash<addressNumericValue, addressNumericValue> m_reloc;
-    void *m_area;
-    int  m_offset;
+
+    // The unwind table of all the linked functions
+    UnwindTable m_unwindTable;
 };
 
 #endif // __TBA_CLR_EXECUTER_RUNTIME_MEMORYLINKER_H
\ No newline at end of file
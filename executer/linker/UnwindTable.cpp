@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * UnwindTable.cpp
+ *
+ * Implementation file
+ */
+#include "executer/stdafx.h"
+#include "xStl/types.h"
+#include "xStl/os/os.h"
+#include "xStl/except/trace.h"
+#include "executer/linker/UnwindTable.h"
+
+UnwindTable::UnwindTable(uint capacity) :
+    m_capacity(capacity)
+{
+    CHECK(m_capacity != 0);
+    cBufferPtr functions(new cBuffer(m_capacity * sizeof(Function)));
+    m_arrays.append(functions);
+    m_header.m_count = 0;
+    m_header.m_functions = (Function*)functions->getBuffer();
+}
+
+void UnwindTable::addFunction(addressNumericValue start,
+                              uint size,
+                              addressNumericValue data)
+{
+    uint count = m_header.m_count;
+    if (count == m_capacity)
+    {
+        // Publish a larger copy. The old array is not changed anymore, so a
+        // reader which still holds it sees a consistent table
+        uint capacity = m_capacity * 2;
+        cBufferPtr functions(new cBuffer(capacity * sizeof(Function)));
+        cOS::memcpy(functions->getBuffer(), m_header.m_functions, count * sizeof(Function));
+        m_arrays.append(functions);
+        m_header.m_functions = (Function*)functions->getBuffer();
+        m_capacity = capacity;
+    }
+
+    // Methods are usually bound in ascending addresses, so the insertion
+    // starts from the end
+    Function* functions = m_header.m_functions;
+    uint i = count;
+    while ((i > 0) && (functions[i - 1].m_start > start))
+    {
+        functions[i] = functions[i - 1];
+        i--;
+    }
+    functions[i].m_start = start;
+    functions[i].m_end = start + size;
+    functions[i].m_data = data;
+    m_header.m_count = count + 1;
+}
+
+const UnwindTable::Function* UnwindTable::findFunction(addressNumericValue returnAddress) const
+{
+    uint low = 0;
+    uint high = m_header.m_count;
+    while (low < high)
+    {
+        uint middle = (low + high) / 2;
+        const Function* function = m_header.m_functions + middle;
+        if (returnAddress <= function->m_start)
+            high = middle;
+        else if (returnAddress > function->m_end)
+            low = middle + 1;
+        else
+            return function;
+    }
+    return NULL;
+}
+
+uint UnwindTable::getCount() const
+{
+    return m_header.m_count;
+}
+
+const UnwindTable::Function& UnwindTable::getFunction(uint index) const
+{
+    CHECK(index < m_header.m_count);
+    return m_header.m_functions[index];
+}
+
+addressNumericValue UnwindTable::getHeaderAddress() const
+{
+    return getNumeric(&m_header);
+}
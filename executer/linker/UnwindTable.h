@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_EXECUTER_LINKER_UNWINDTABLE_H
+#define __TBA_CLR_EXECUTER_LINKER_UNWINDTABLE_H
+
+/*
+ * UnwindTable.h
+ *
+ * The table of all the linked functions, sorted by address. Compiled code
+ * reads it when an exception is thrown, see ExceptionHandling.findFunction.
+ *
+ * Functions are added while the table is in use (lazily compiled methods), so
+ * the header never moves and an array of functions is never freed: when the
+ * array is full a larger copy is published and the old one is kept.
+ */
+#include "xStl/types.h"
+#include "xStl/data/list.h"
+#include "xStl/data/datastream.h"
+
+class UnwindTable {
+public:
+    /*
+     * An entry of the table. See ExceptionHandling.UnwindFunction
+     */
+    struct Function {
+        // The first byte of the function
+        addressNumericValue m_start;
+        // The end of the function
+        addressNumericValue m_end;
+        // The unwind data of the function, or 0 if the function is
+        // transparent to exceptions. See CompilerInterface::generateUnwindData
+        addressNumericValue m_data;
+    };
+
+    /*
+     * Constructor.
+     *
+     * capacity - The number of functions in the first array
+     */
+    UnwindTable(uint capacity = DEFAULT_CAPACITY);
+
+    /*
+     * Add a function, keeping the table sorted by address.
+     *
+     * start - The address of the function
+     * size - The size of the function in bytes
+     * data - The address of the unwind data of the function, or 0
+     */
+    void addFunction(addressNumericValue start, uint size, addressNumericValue data);
+
+    /*
+     * Return the function which contains a return address, or NULL. A return
+     * address follows the call instruction, so it may be the end of the
+     * function but never its start. Same as ExceptionHandling.findFunction
+     */
+    const Function* findFunction(addressNumericValue returnAddress) const;
+
+    /*
+     * Return the number of functions and a function by its index
+     */
+    uint getCount() const;
+    const Function& getFunction(uint index) const;
+
+    /*
+     * Return the address of the header which compiled code refers to.
+     * See ExceptionHandling.UnwindTable
+     */
+    addressNumericValue getHeaderAddress() const;
+
+    // The default capacity of the first array
+    enum { DEFAULT_CAPACITY = 256 };
+
+private:
+    // Deny copy-constructor and operator =
+    UnwindTable(const UnwindTable& other);
+    UnwindTable& operator = (const UnwindTable& other);
+
+    /*
+     * The header of the table. See ExceptionHandling.UnwindTable
+     */
+    struct Header {
+        uint32 m_count;
+        Function* m_functions;
+    };
+
+    // The published header
+    Header m_header;
+    // The number of functions which fit in the current array
+    uint m_capacity;
+    // All the arrays. The last one is the current array, the others are kept
+    // since a running exception dispatch may still read them
+    cList<cBufferPtr> m_arrays;
+};
+
+#endif // __TBA_CLR_EXECUTER_LINKER_UNWINDTABLE_H
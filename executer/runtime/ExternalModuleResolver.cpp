@@ -107,11 +107,9 @@ bool ExternalModuleResolver::resolveExternalMethod(const TokenIndex& methodToken
     MethodTable& methodTable = (MethodTable&)(*(apartment.getTables().getTableByToken(getTokenID(methodToken))));
 
     // (Re)Read the method signature
-    cForkStreamPtr blob = apartment.getStreams().getBlobStream()->fork();
-    blob->seek(methodTable.getHeader().m_signature, basicInput::IO_SEEK_SET);
     MethodDefOrRefSignaturePtr methodSignature =
             MethodDefOrRefSignaturePtr(new
-                                MethodDefOrRefSignature(*blob,
+                                MethodDefOrRefSignature(apartment.getStreams().getBlob(methodTable.getHeader().m_signature),
                                                         apartment.getUniqueID(),
                                                         apartment.getObjects().getTypedefRepository()));
 
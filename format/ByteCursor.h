@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_FORMAT_BYTECURSOR_H
+#define __TBA_CLR_FORMAT_BYTECURSOR_H
+
+/*
+ * ByteCursor.h
+ *
+ * A pointer-plus-bounds reader over an in-memory image (#Blob heap, #~ stream
+ * etc.). Used by the signature and metadata parsers instead of forking a
+ * basicInput stream and reading it byte-by-byte through virtual calls.
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "xStl/types.h"
+#include "xStl/os/os.h"
+#include "xStl/except/trace.h"
+
+/*
+ * Reads little-endian integers and ECMA-335 compressed numbers from a memory
+ * range. Every read is bounds checked and throws (CHECK) when it crosses the
+ * end of the range.
+ *
+ * The cursor doesn't own the memory. The caller must keep the underlying
+ * buffer alive for as long as the cursor is used. Copying a cursor is cheap
+ * and both copies advance independently.
+ *
+ * Usage:
+ *     ByteCursor blob = apartment->getStreams().getBlob(blobIndex);
+ *     uint length = blob.readCompressedNumber();
+ *     uint8 signature = blob.readUint8();
+ *
+ * NOTE: This class is not thread-safe, but any number of cursors can read the
+ *       same memory concurrently.
+ */
+class ByteCursor {
+public:
+    /*
+     * Constructor. Empty cursor, every read throws.
+     */
+    ByteCursor() :
+        m_begin(NULL),
+        m_position(NULL),
+        m_end(NULL)
+    {
+    }
+
+    /*
+     * Constructor
+     *
+     * data   - The first byte of the range
+     * length - The number of accessible bytes
+     */
+    ByteCursor(const uint8* data, uint length) :
+        m_begin(data),
+        m_position(data),
+        m_end(data + length)
+    {
+    }
+
+    /*
+     * Return the number of bytes from the beginning of the range to the
+     * current position
+     */
+    uint getPosition() const { return (uint)(m_position - m_begin); }
+
+    /*
+     * Return the total length of the range
+     */
+    uint getLength() const { return (uint)(m_end - m_begin); }
+
+    /*
+     * Return the number of bytes which can still be read
+     */
+    uint getRemaining() const { return (uint)(m_end - m_position); }
+
+    /*
+     * Return true if there are no more bytes to read
+     */
+    bool isEOS() const { return m_position == m_end; }
+
+    /*
+     * Return a pointer to the current position
+     */
+    const uint8* getCurrent() const { return m_position; }
+
+    /*
+     * Move the cursor to 'position' bytes from the beginning of the range
+     *
+     * Throw exception if the position is beyond the end of the range
+     */
+    void seek(uint position)
+    {
+        CHECK(position <= getLength());
+        m_position = m_begin + position;
+    }
+
+    /*
+     * Advance the cursor by 'length' bytes
+     */
+    void skip(uint length)
+    {
+        CHECK(length <= getRemaining());
+        m_position += length;
+    }
+
+    /*
+     * Return a cursor for the next 'length' bytes, and advance this cursor
+     * beyond them.
+     */
+    ByteCursor readCursor(uint length)
+    {
+        CHECK(length <= getRemaining());
+        ByteCursor ret(m_position, length);
+        m_position += length;
+        return ret;
+    }
+
+    /*
+     * Copy the next 'length' bytes into 'buffer'
+     */
+    void read(void* buffer, uint length)
+    {
+        CHECK(length <= getRemaining());
+        cOS::memcpy(buffer, m_position, length);
+        m_position += length;
+    }
+
+    /*
+     * Read little-endian integers
+     */
+    uint8 readUint8()
+    {
+        CHECK(m_position < m_end);
+        return *m_position++;
+    }
+
+    uint16 readUint16()
+    {
+        CHECK(getRemaining() >= sizeof(uint16));
+        uint16 ret = (uint16)(m_position[0] | (m_position[1] << 8));
+        m_position += sizeof(uint16);
+        return ret;
+    }
+
+    uint32 readUint32()
+    {
+        CHECK(getRemaining() >= sizeof(uint32));
+        uint32 ret = ((uint32)m_position[0]) |
+                     ((uint32)m_position[1] << 8) |
+                     ((uint32)m_position[2] << 16) |
+                     ((uint32)m_position[3] << 24);
+        m_position += sizeof(uint32);
+        return ret;
+    }
+
+    /*
+     * Read a 16bit or 32bit little-endian index, according to 'isLarge'.
+     * Used for heap and table indexes in the #~ stream.
+     */
+    uint32 readIndex(bool isLarge)
+    {
+        return isLarge ? readUint32() : readUint16();
+    }
+
+    /*
+     * Read an ECMA-335 compressed unsigned integer.
+     * See EncodingUtils::readCompressedNumber
+     */
+    uint readCompressedNumber()
+    {
+        CHECK(m_position < m_end);
+        uint8 firstByte = m_position[0];
+        // If the high-bit is clear than the value is 7-bit value.
+        if ((firstByte & 0x80) == 0)
+        {
+            m_position++;
+            return firstByte;
+        }
+
+        // Bit 14 is clear. value held in bits 0..13   (Mask: 0x3FFF)
+        if ((firstByte & 0x40) == 0)
+        {
+            CHECK(getRemaining() >= 2);
+            uint ret = ((firstByte & 0x3F) << 8) | m_position[1];
+            m_position += 2;
+            return ret;
+        }
+
+        // Bit 29 must be cleared
+        CHECK((firstByte & 0x20) == 0);
+        CHECK(getRemaining() >= 4);
+        uint ret = ((firstByte & 0x1F) << 24) |
+                   (m_position[1] << 16) |
+                   (m_position[2] << 8) |
+                   m_position[3];
+        m_position += 4;
+        return ret;
+    }
+
+private:
+    // The beginning of the range
+    const uint8* m_begin;
+    // The next byte to be read
+    const uint8* m_position;
+    // One byte beyond the end of the range
+    const uint8* m_end;
+};
+
+#endif // __TBA_CLR_FORMAT_BYTECURSOR_H
@@ -43,6 +43,7 @@
 #include "xStl/types.h"
 #include "xStl/stream/basicIO.h"
 #include "format/coreHeadersTypes.h"
+#include "format/ByteCursor.h"
 
 /*
  * Provide a set of functions which helps to decode structs, integers and all
@@ -70,6 +71,15 @@ public:
      */
     static uint readCompressedNumber(basicInput& stream);
 
+    /*
+     * Read a compressed number from a memory cursor. Same encoding as above,
+     * but without the per-byte virtual stream calls.
+     */
+    static uint readCompressedNumber(ByteCursor& cursor)
+    {
+        return cursor.readCompressedNumber();
+    }
+
     /*
      * Return the higher 8 bits from a 32bit number. This number represent
      * the table ID.
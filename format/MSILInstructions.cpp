@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * MSILInstructions.cpp
+ *
+ * Implementation file
+ */
+#include "xStl/types.h"
+#include "xStl/os/os.h"
+#include "xStl/data/datastream.h"
+#include "xStl/stream/traceStream.h"
+#include "format/MSILInstructions.h"
+
+MSILInstruction::MSILInstruction() :
+    m_opcode(0),
+    m_offset(0),
+    m_nextOffset(0),
+    m_operand(0)
+{
+}
+
+MSILInstruction::MSILInstruction(uint16 opcode, uint offset, uint nextOffset, uint64 operand) :
+    m_opcode(opcode),
+    m_offset(offset),
+    m_nextOffset(nextOffset),
+    m_operand(operand)
+{
+}
+
+bool MSILInstruction::isExtended() const
+{
+    return (m_opcode & 0xFF00) == EXTENDED_OPCODE;
+}
+
+uint8 MSILInstruction::getOpcodeByte() const
+{
+    return (uint8)(m_opcode & 0xFF);
+}
+
+uint32 MSILInstruction::getUint32() const
+{
+    return (uint32)m_operand;
+}
+
+int32 MSILInstruction::getBranchOffset() const
+{
+    return (int32)m_operand;
+}
+
+uint MSILInstruction::getBranchTarget() const
+{
+    return m_nextOffset + getBranchOffset();
+}
+
+MSILInstructions::MSILInstructions(const uint8* msil, uint size) :
+    m_code(size)
+{
+    cOS::memcpy(m_code.getBuffer(), msil, size);
+
+    m_instructionIndex.changeSize(size);
+    for (uint i = 0; i < size; i++)
+        m_instructionIndex[i] = MAX_UINT32;
+
+    // Every instruction is at least one byte long
+    m_instructions.changeSize(size);
+    uint count = 0;
+    uint offset = 0;
+    while (offset < size)
+    {
+        MSILInstruction instruction = decode(offset);
+        m_instructionIndex[offset] = count;
+        m_instructions[count++] = instruction;
+        offset = instruction.m_nextOffset;
+    }
+    m_instructions.changeSize(count);
+}
+
+const cBuffer& MSILInstructions::getCode() const
+{
+    return m_code;
+}
+
+uint MSILInstructions::getCount() const
+{
+    return m_instructions.getSize();
+}
+
+const MSILInstruction& MSILInstructions::operator[] (uint index) const
+{
+    return m_instructions[index];
+}
+
+uint MSILInstructions::getInstructionIndex(uint offset) const
+{
+    if (offset >= m_instructionIndex.getSize())
+        return MAX_UINT32;
+    return m_instructionIndex[offset];
+}
+
+MSILInstruction MSILInstructions::decode(uint offset) const
+{
+    const uint8* msil = m_code.getBuffer();
+    const uint size = m_code.getSize();
+
+    uint i = offset;
+    uint16 opcode = msil[i++];
+    if (opcode == 0xFE) //  2 bytes opcode
+    {
+        CHECK(i < size);
+        opcode = MSILInstruction::EXTENDED_OPCODE | msil[i++];
+    }
+
+    // The size of the immediate operand, and whether it should be sign extended
+    uint operandSize = 0;
+    bool isSigned = false;
+
+    switch (opcode)
+    {
+        case 0xFE00: // arglist
+        case 0xFE01: // ceq
+        case 0xFE02: // cgt
+        case 0xFE03: // cgt.un
+        case 0xFE04: // clt
+        case 0xFE05: // clt.un
+        case 0xFE0F: // localloc
+        case 0xFE11: // endfilter
+        case 0xFE13: // volatile.
+        case 0xFE14: // tail.
+        case 0xFE17: // cpblk
+        case 0xFE18: // initblk
+        case 0xFE1A: // rethrow
+        case 0xFE1D: // refanytype
+        case 0xFE1E: // readonly.
+            // No extra data to read
+            break;
+
+        case 0xFE12: // unaligned. <uint8>
+        case 0xFE19: // no. <uint8>
+            operandSize = 1;
+            break;
+
+        case 0xFE09: // ldarg
+        case 0xFE0A: // ldarga
+        case 0xFE0B: // starg
+        case 0xFE0C: // ldloc
+        case 0xFE0D: // ldloca
+        case 0xFE0E: // stloc
+            // 16bit immediate
+            operandSize = 2;
+            break;
+
+        case 0xFE06: // ldftn
+        case 0xFE07: // ldvirtftn
+        case 0xFE15: // initobj
+        case 0xFE16: // constrained
+        case 0xFE1C: // sizeof
+            // Token
+            operandSize = 4;
+            break;
+
+        case 0x0E: // ldarg.s
+        case 0x0F: // ldarga.s
+        case 0x10: // starg.s
+        case 0x11: // ldloc.s
+        case 0x12: // ldloca.s
+        case 0x13: // stloc.s
+            // Unsigned 8bit index
+            operandSize = 1;
+            break;
+
+        case 0x1F: // ldc.i4.s
+        case 0x2B: // br.s
+        case 0x2C: // brfalse.s
+        case 0x2D: // brtrue.s
+        case 0x2E: // beq.s
+        case 0x2F: // bge.s
+        case 0x30: // bgt.s
+        case 0x31: // ble.s
+        case 0x32: // blt.s
+        case 0x33: // bne.un.s
+        case 0x34: // bge.un.s
+        case 0x35: // bgt.un.s
+        case 0x36: // ble.un.s
+        case 0x37: // blt.un.s
+        case 0xDE: // leave.s
+            // Signed 8bit immediate/offset
+            operandSize = 1;
+            isSigned = true;
+            break;
+
+        case 0x20: // ldc.i4
+        case 0x38: // br
+        case 0x39: // brfalse
+        case 0x3A: // brtrue
+        case 0x3B: // beq
+        case 0x3C: // bge
+        case 0x3D: // bgt
+        case 0x3E: // ble
+        case 0x3F: // blt
+        case 0x40: // bne.un
+        case 0x41: // bge.un
+        case 0x42: // bgt.un
+        case 0x43: // ble.un
+        case 0x44: // blt.un
+        case 0xDD: // leave
+            // Signed 32bit immediate/offset
+            operandSize = 4;
+            isSigned = true;
+            break;
+
+        case 0x22: // ldc.r4
+        case 0x27: // jmp
+        case 0x28: // call
+        case 0x29: // calli
+        case 0x6F: // callvirt
+        case 0x70: // cpobj
+        case 0x71: // ldobj
+        case 0x72: // ldstr
+        case 0x73: // newobj
+        case 0x74: // castclass
+        case 0x75: // isinst
+        case 0x79: // unbox
+        case 0x7B: // ldfld
+        case 0x7C: // ldflda
+        case 0x7D: // stfld
+        case 0x7E: // ldsfld
+        case 0x7F: // ldsflda
+        case 0x80: // stsfld
+        case 0x81: // stobj
+        case 0x8C: // box
+        case 0x8D: // newarr
+        case 0x8F: // ldelema
+        case 0xA3: // ldelem
+        case 0xA4: // stelem
+        case 0xA5: // unbox.any
+        case 0xC2: // refanyval
+        case 0xC6: // mkrefany
+        case 0xD0: // ldtoken
+            // Token or raw 32bit value
+            operandSize = 4;
+            break;
+
+        case 0x21: // ldc.i8
+        case 0x23: // ldc.r8
+            operandSize = 8;
+            break;
+
+        case 0x45: // switch - Not implemented yet
+            traceHigh("MSILInstructions: switch opcode is not supported" << endl);
+            CHECK_FAIL();
+
+        default:
+            if ((opcode <= 0x0D) ||                        // nop..stloc.3
+                ((opcode >= 0x14) && (opcode <= 0x1E)) ||  // ldnull, ldc.i4.m1..8
+                (opcode == 0x25) || (opcode == 0x26) ||    // dup, pop
+                (opcode == 0x2A) ||                        // ret
+                ((opcode >= 0x46) && (opcode <= 0x6E)) ||  // ldind, stind, arithmetic, conv
+                (opcode == 0x76) || (opcode == 0x7A) ||    // conv.r.un, throw
+                ((opcode >= 0x82) && (opcode <= 0x8B)) ||  // conv.ovf.*.un
+                (opcode == 0x8E) ||                        // ldlen
+                ((opcode >= 0x90) && (opcode <= 0xA2)) ||  // ldelem.*, stelem.*
+                ((opcode >= 0xB3) && (opcode <= 0xBA)) ||  // conv.ovf.*
+                (opcode == 0xC3) ||                        // ckfinite
+                ((opcode >= 0xD1) && (opcode <= 0xDC)) ||  // conv, *.ovf, endfinally
+                (opcode == 0xDF) || (opcode == 0xE0))      // stind.i, conv.u
+            {
+                // No extra data to read
+                break;
+            }
+
+            traceHigh("MSILInstructions: Unknown opcode - " << HEXWORD(opcode) << endl);
+            CHECK_FAIL();
+    }
+
+    CHECK(i + operandSize <= size);
+    uint64 operand = 0;
+    switch (operandSize)
+    {
+    case 1:
+        operand = isSigned ? (uint64)(int64)(int8)msil[i] : msil[i];
+        break;
+    case 2:
+        operand = (uint16)(msil[i] | (msil[i + 1] << 8));
+        break;
+    case 4:
+        operand = isSigned ? (uint64)(int64)(int32)cLittleEndian::readUint32(msil + i) :
+                             cLittleEndian::readUint32(msil + i);
+        break;
+    case 8:
+        operand = ((uint64)cLittleEndian::readUint32(msil + i + 4) << 32) |
+                  cLittleEndian::readUint32(msil + i);
+        break;
+    }
+
+    return MSILInstruction(opcode, offset, i + operandSize, operand);
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_FORMAT_MSILINSTRUCTIONS_H
+#define __TBA_CLR_FORMAT_MSILINSTRUCTIONS_H
+
+/*
+ * MSILInstructions.h
+ *
+ * Decode a method body once into an array of instructions, so the scanning,
+ * signing and compilation passes don't have to walk the MSIL stream again.
+ */
+#include "xStl/types.h"
+#include "xStl/data/array.h"
+#include "xStl/data/smartptr.h"
+#include "format/coreHeadersTypes.h"
+
+/*
+ * A single decoded MSIL instruction
+ */
+class MSILInstruction {
+public:
+    // Default constructor, for cArray
+    MSILInstruction();
+
+    /*
+     * Constructor
+     *
+     * opcode     - The opcode. See m_opcode
+     * offset     - The offset of the instruction from the beginning of the method
+     * nextOffset - The offset of the next instruction
+     * operand    - The immediate operand. See m_operand
+     */
+    MSILInstruction(uint16 opcode, uint offset, uint nextOffset, uint64 operand = 0);
+
+    // Two bytes opcodes (0xFE xx) are encoded as 0xFExx
+    enum { EXTENDED_OPCODE = 0xFE00 };
+
+    /*
+     * Return true if the opcode is a two bytes opcode (0xFE xx)
+     */
+    bool isExtended() const;
+
+    /*
+     * Return the opcode byte. For extended opcodes return the second byte.
+     */
+    uint8 getOpcodeByte() const;
+
+    /*
+     * Return the token/inline 32 bit operand of the instruction
+     */
+    uint32 getUint32() const;
+
+    /*
+     * Return the relative branch offset. Short forms are sign extended.
+     */
+    int32 getBranchOffset() const;
+
+    /*
+     * Return the absolute offset of the branch target
+     */
+    uint getBranchTarget() const;
+
+    // The opcode
+    uint16 m_opcode;
+    // The offset of the instruction from the beginning of the method
+    uint m_offset;
+    // The offset of the next instruction, which is also the base for the
+    // branch offsets
+    uint m_nextOffset;
+    // The immediate operand. Tokens, variable indexes, constants and branch
+    // offsets. Signed short forms are sign extended, floating point constants
+    // are stored as their raw little-endian encoding.
+    uint64 m_operand;
+};
+
+/*
+ * The decoded body of a method
+ *
+ * Usage:
+ *     MSILInstructions instructions(msil, size);
+ *     for (uint i = 0; i < instructions.getCount(); i++)
+ *         handle(instructions[i]);
+ *
+ * NOTE: This class is not thread-safe.
+ */
+class MSILInstructions {
+public:
+    /*
+     * Decode a method body
+     *
+     * msil - pointer to binary MSIL code
+     * size - size of the MSIL data
+     *
+     * Throw exception if an opcode is unknown or truncated
+     */
+    MSILInstructions(const uint8* msil, uint size);
+
+    /*
+     * Return the raw MSIL bytes
+     */
+    const cBuffer& getCode() const;
+
+    /*
+     * Return the number of instructions
+     */
+    uint getCount() const;
+
+    /*
+     * Return an instruction by it's index
+     */
+    const MSILInstruction& operator[] (uint index) const;
+
+    /*
+     * Return the index of the instruction which starts at 'offset', or
+     * MAX_UINT32 if 'offset' is not an instruction boundary.
+     */
+    uint getInstructionIndex(uint offset) const;
+
+private:
+    // Deny copy-constructor and operator =
+    MSILInstructions(const MSILInstructions& other);
+    MSILInstructions& operator = (const MSILInstructions& other);
+
+    /*
+     * Decode a single instruction, starting at 'offset'
+     */
+    MSILInstruction decode(uint offset) const;
+
+    // The raw method body
+    cBuffer m_code;
+    // The decoded instructions
+    cArray<MSILInstruction> m_instructions;
+    // For each byte of the method body, the index of the instruction which
+    // starts at that byte, or MAX_UINT32
+    cSArray<uint> m_instructionIndex;
+};
+
+// The reference-countable object
+typedef cSmartPtr<MSILInstructions> MSILInstructionsPtr;
+
+#endif // __TBA_CLR_FORMAT_MSILINSTRUCTIONS_H
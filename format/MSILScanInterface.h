@@ -39,6 +39,7 @@
  */
 #include "xStl/types.h"
 #include "format/coreHeadersTypes.h"
+#include "format/MSILInstructions.h"
 
 class MSILScanInterface
 {
@@ -65,6 +66,13 @@ public:
      * size - size of the MSIL data
      */
     void scanMSIL(const uint8* msil, uint size);
+
+    /*
+     * Scan an already decoded method for indexes and tokens
+     *
+     * instructions - The decoded method. See MethodRunnable::getInstructions
+     */
+    void scanMSIL(const MSILInstructions& instructions);
 };
 
 #endif // __TBA_CLR_COMPILER_MSILSCANINTERFACE_H
@@ -62,6 +62,15 @@ MSILStreams::MSILStreams(MetadataHeader& header) :
           m_blobStream,
           m_blobDirectory));
 
+    // Read the #Blob heap once, all signature parsing is done over this copy
+    m_blobHeap.changeSize(m_blobDirectory.Size);
+    if (m_blobDirectory.Size > 0)
+    {
+        cForkStreamPtr blob = m_blobStream->fork();
+        blob->seek(0, basicInput::IO_SEEK_SET);
+        blob->pipeRead(m_blobHeap.getBuffer(), m_blobDirectory.Size);
+    }
+
     m_isUserString = header.getStreamByName(MSILStreams::gUSStreamStringID,
           m_userStringsStream,
           m_userStringsDirectory);
@@ -72,6 +81,14 @@ const cMemoryAccesserStreamPtr& MSILStreams::getBlobStream() const
     return m_blobStream;
 }
 
+ByteCursor MSILStreams::getBlob(mdToken blobIndex) const
+{
+    CHECK(blobIndex < m_blobHeap.getSize());
+    ByteCursor ret(m_blobHeap.getBuffer(), m_blobHeap.getSize());
+    ret.seek(blobIndex);
+    return ret;
+}
+
 const cMemoryAccesserStreamPtr& MSILStreams::getStringsStream() const
 {
     return m_stringStream;
@@ -41,9 +41,11 @@
  * Author: Elad Raz <e@eladraz.com>
  */
 #include "xStl/types.h"
+#include "xStl/data/datastream.h"
 #include "pe/datastruct.h"
 #include "format/coreHeadersTypes.h"
 #include "format/metadataHeader.h"
+#include "format/ByteCursor.h"
 
 /*
  * NOTE: This module is not thread-safe and must be constructed for each stream
@@ -70,6 +72,19 @@ public:
      */
     const cMemoryAccesserStreamPtr& getBlobStream() const;
 
+    /*
+     * Return a cursor positioned at 'blobIndex' inside the #Blob heap. The
+     * cursor is bounded by the end of the heap, the caller should read the
+     * blob length (EncodingUtils::readCompressedNumber) to narrow it further.
+     *
+     * The #Blob heap is read once when this object is constructed, so this
+     * function doesn't fork any stream and can be called from different
+     * threads. The cursor is valid as long as this object exists.
+     *
+     * Throw exception if the index is outside the heap
+     */
+    ByteCursor getBlob(mdToken blobIndex) const;
+
     /*
      * Return a pointer to #Strings stream, where 0 is the beginning of the stream
      *
@@ -130,6 +145,8 @@ private:
     // The stream for the #Blob
     mutable cMemoryAccesserStreamPtr m_blobStream;
     IMAGE_DATA_DIRECTORY m_blobDirectory;
+    // A copy of the #Blob heap. See getBlob()
+    cBuffer m_blobHeap;
     // The stream for the #US
     bool m_isUserString;
     mutable cMemoryAccesserStreamPtr m_userStringsStream;
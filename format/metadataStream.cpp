@@ -47,6 +47,34 @@
 
 const char MetadataStream::gMetaStreamStringID[] = "#~";
 
+// The tables which compose each coded index. See isAnyTableLarge()
+static const uint gTypeDefOrRefTables[] = {
+    TABLE_TYPEDEF_TABLE, TABLE_TYPEREF_TABLE, TABLE_TYPESPEC_TABLE };
+static const uint gHasConstantTables[] = {
+    TABLE_FIELD_TABLE, TABLE_PARAM_TABLE, TABLE_PROPERTY_TABLE };
+static const uint gMethodDefOrRefTables[] = {
+    TABLE_MEMBERREF_TABLE, TABLE_METHOD_TABLE };
+static const uint gTypeOrMethodDefTables[] = {
+    TABLE_TYPEDEF_TABLE, TABLE_METHOD_TABLE };
+static const uint gHasSemanticsTables[] = {
+    TABLE_PROPERTY_TABLE, TABLE_EVENT_TABLE };
+static const uint gHasCustomAttributeTables[] = {
+    TABLE_METHOD_TABLE, TABLE_FIELD_TABLE, TABLE_TYPEREF_TABLE,
+    TABLE_TYPEDEF_TABLE, TABLE_PARAM_TABLE, TABLE_INTERFACEIMPL_TABLE,
+    TABLE_MEMBERREF_TABLE, TABLE_MODULE_TABLE, TABLE_DECLSECURITY_TABLE,
+    TABLE_PROPERTY_TABLE, TABLE_EVENT_TABLE, TABLE_STANDALONGESIG_TABLE,
+    TABLE_MODULEREF_TABLE, TABLE_TYPESPEC_TABLE, TABLE_ASSEMBLY_TABLE,
+    TABLE_ASSEMBLYREF_TABLE, TABLE_FILE_TABLE, TABLE_EXPORTTYPE_TABLE,
+    TABLE_MANIFESTRESOURCE_TABLE };
+static const uint gHasDeclSecurityTables[] = {
+    TABLE_TYPEDEF_TABLE, TABLE_ASSEMBLY_TABLE, TABLE_METHOD_TABLE };
+static const uint gResolutionScopeTables[] = {
+    TABLE_MODULE_TABLE, TABLE_MODULEREF_TABLE, TABLE_ASSEMBLYREF_TABLE,
+    TABLE_TYPEREF_TABLE };
+static const uint gMemberRefParentTables[] = {
+    TABLE_TYPEREF_TABLE, TABLE_MODULEREF_TABLE, TABLE_METHOD_TABLE,
+    TABLE_TYPESPEC_TABLE };
+
 MetadataStream::MetadataStream(MetadataHeader& header) :
     m_largeString(false),
     m_largeGUID(false),
@@ -62,29 +90,45 @@ MetadataStream::MetadataStream(MetadataHeader& header) :
                                  m_metaStream,
                                  m_metaDir));
 
+    // Read the entire #~ stream once. All the tables are parsed from this copy
+    m_metaData.changeSize(m_metaDir.Size);
+    m_metaStream->pipeRead(m_metaData.getBuffer(), m_metaDir.Size);
+    m_cursor = ByteCursor(m_metaData.getBuffer(), m_metaData.getSize());
+
     // Parse the stream
-    m_metaStream->streamReadUint32(m_header.m_reserved);
-    m_metaStream->streamReadUint8(m_header.m_majorVersion);
-    m_metaStream->streamReadUint8(m_header.m_minorVersion);
-    m_metaStream->streamReadUint8(m_header.m_heapSizes);
-    m_metaStream->streamReadUint8(m_header.m_reserved1);
+    m_header.m_reserved = m_cursor.readUint32();
+    m_header.m_majorVersion = m_cursor.readUint8();
+    m_header.m_minorVersion = m_cursor.readUint8();
+    m_header.m_heapSizes = m_cursor.readUint8();
+    m_header.m_reserved1 = m_cursor.readUint8();
 
     m_largeString = ((m_header.m_heapSizes & HEAPSIZE_LARGE_STRING) != 0);
     m_largeGUID = ((m_header.m_heapSizes & HEAPSIZE_LARGE_GUID) != 0);
     m_largeBlob = ((m_header.m_heapSizes & HEAPSIZE_LARGE_BLOB) != 0);
 
     // Start reading tables
-    m_metaStream->streamReadUint32(m_header.m_validLow);
-    m_metaStream->streamReadUint32(m_header.m_validHigh);
-    m_metaStream->streamReadUint32(m_header.m_sortedLow);
-    m_metaStream->streamReadUint32(m_header.m_sortedHigh);
+    m_header.m_validLow = m_cursor.readUint32();
+    m_header.m_validHigh = m_cursor.readUint32();
+    m_header.m_sortedLow = m_cursor.readUint32();
+    m_header.m_sortedHigh = m_cursor.readUint32();
 
     // Read the number of rows
     for (i = 0; i < NUMBER_OF_TABLES; i++)
     {
         if (isTableValid(i))
-            m_metaStream->streamReadUint32(m_rows[i]);
+            m_rows[i] = m_cursor.readUint32();
     }
+
+    // Calculate the size of the coded indexes
+    m_largeTypeDefOrRef = isAnyTableLarge(gTypeDefOrRefTables, arraysize(gTypeDefOrRefTables));
+    m_largeHasConstant = isAnyTableLarge(gHasConstantTables, arraysize(gHasConstantTables));
+    m_largeMethodDefOrRef = isAnyTableLarge(gMethodDefOrRefTables, arraysize(gMethodDefOrRefTables));
+    m_largeTypeOrMethodDef = isAnyTableLarge(gTypeOrMethodDefTables, arraysize(gTypeOrMethodDefTables));
+    m_largeHasSemantics = isAnyTableLarge(gHasSemanticsTables, arraysize(gHasSemanticsTables));
+    m_largeHasCustomAttribute = isAnyTableLarge(gHasCustomAttributeTables, arraysize(gHasCustomAttributeTables));
+    m_largeHasDeclSecurity = isAnyTableLarge(gHasDeclSecurityTables, arraysize(gHasDeclSecurityTables));
+    m_largeResolutionScope = isAnyTableLarge(gResolutionScopeTables, arraysize(gResolutionScopeTables));
+    m_largeMemberRefParent = isAnyTableLarge(gMemberRefParentTables, arraysize(gMemberRefParentTables));
 }
 
 uint MetadataStream::getNumberOfRows(uint index) const
@@ -117,258 +161,110 @@ bool MetadataStream::isTableSorted(uint index) const
     return (m_header.m_sortedHigh & (1 << (index - 32))) != 0;
 }
 
+bool MetadataStream::isAnyTableLarge(const uint* tables, uint count) const
+{
+    for (uint i = 0; i < count; i++)
+    {
+        if (getNumberOfRows(tables[i]) > 0xFFFF)
+            return true;
+    }
+    return false;
+}
+
 //////////////////////////////////////////////////////////////////////////
 // basicInput interface implementation
 
 uint MetadataStream::read(void *buffer, const uint length)
 {
-    return m_metaStream->read(buffer, length);
+    uint count = length;
+    if (count > m_cursor.getRemaining())
+        count = m_cursor.getRemaining();
+    m_cursor.read(buffer, count);
+    return count;
 }
 
 uint MetadataStream::getPointer() const
 {
-    return m_metaStream->getPointer();
+    return m_cursor.getPosition();
 }
 
 uint MetadataStream::length() const
 {
-    return m_metaStream->length();
+    return m_cursor.getLength();
 }
 
 uint MetadataStream::getPipeReadBestRequest() const
 {
-    return m_metaStream->getPipeReadBestRequest();
+    return m_cursor.getRemaining();
 }
 
 bool MetadataStream::isEOS()
 {
-    return m_metaStream->isEOS();
+    return m_cursor.isEOS();
 }
 
 void MetadataStream::seek(const int distance, const seekMethod method)
 {
-    m_metaStream->seek(distance, method);
+    switch (method)
+    {
+    case IO_SEEK_SET: m_cursor.seek(distance); break;
+    case IO_SEEK_CUR: m_cursor.seek(m_cursor.getPosition() + distance); break;
+    case IO_SEEK_END: m_cursor.seek(m_cursor.getLength() + distance); break;
+    default:
+        CHECK_FAIL();
+    }
 }
 
 // MetadataStream private IO interface
 
 mdToken MetadataStream::readStringToken()
 {
-    if (m_largeString)
-    {
-        uint32 index;
-        m_metaStream->streamReadUint32(index);
-        return index;
-    } else
-    {
-        uint16 index;
-        m_metaStream->streamReadUint16(index);
-        return index;
-    }
+    return m_cursor.readIndex(m_largeString);
 }
 
 mdToken MetadataStream::readGuidToken()
 {
-    if (m_largeGUID)
-    {
-        uint32 index;
-        m_metaStream->streamReadUint32(index);
-        return index;
-    } else
-    {
-        uint16 index;
-        m_metaStream->streamReadUint16(index);
-        return index;
-    }
+    return m_cursor.readIndex(m_largeGUID);
 }
 
 mdToken MetadataStream::readBlobToken()
 {
-    if (m_largeBlob)
-    {
-        uint32 index;
-        m_metaStream->streamReadUint32(index);
-        return index;
-    } else
-    {
-        uint16 index;
-        m_metaStream->streamReadUint16(index);
-        return index;
-    }
+    return m_cursor.readIndex(m_largeBlob);
 }
 
 mdToken MetadataStream::readTableToken(uint index)
 {
-    if (getNumberOfRows(index) > 0xFFFF)
-    {
-        uint32 ret;
-        m_metaStream->streamReadUint32(ret);
-        return ret;
-    } else
-    {
-        uint16 ret;
-        m_metaStream->streamReadUint16(ret);
-        return ret;
-    }
+    return m_cursor.readIndex(getNumberOfRows(index) > 0xFFFF);
 }
 
-// The different cached reading values
-enum CachedTableSizes {
-    TABLE_UNKNOWN_SIZE,
-    TABLE_32_BIT,
-    TABLE_16_BIT
-};
-
 mdToken MetadataStream::readTypeDefOrRefToken()
 {
-    // Cache reading
-    static CachedTableSizes gTypeDefOrRefSize = TABLE_UNKNOWN_SIZE;
-    if (gTypeDefOrRefSize == TABLE_UNKNOWN_SIZE)
-    {
-        if ((getNumberOfRows(TABLE_TYPEDEF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_TYPEREF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_TYPESPEC_TABLE) > 0xFFFF))
-            gTypeDefOrRefSize = TABLE_32_BIT;
-        else
-            gTypeDefOrRefSize = TABLE_16_BIT;
-    }
-
-    // Get the table size
-    if (gTypeDefOrRefSize == TABLE_32_BIT)
-    {
-        uint32 ret; m_metaStream->streamReadUint32(ret); return ret;
-    } else
-    {
-        uint16 ret; m_metaStream->streamReadUint16(ret); return ret;
-    }
+    return m_cursor.readIndex(m_largeTypeDefOrRef);
 }
 
 mdToken MetadataStream::readHasConstantToken()
 {
-    // Cache reading
-    static CachedTableSizes gHasConstantSize = TABLE_UNKNOWN_SIZE;
-    if (gHasConstantSize == TABLE_UNKNOWN_SIZE)
-    {
-        if ((getNumberOfRows(TABLE_FIELD_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_PARAM_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_PROPERTY_TABLE) > 0xFFFF))
-            gHasConstantSize = TABLE_32_BIT;
-        else
-            gHasConstantSize = TABLE_16_BIT;
-    }
-
-    if (gHasConstantSize == TABLE_32_BIT)
-    {
-        uint32 ret; m_metaStream->streamReadUint32(ret); return ret;
-    } else
-    {
-        uint16 ret; m_metaStream->streamReadUint16(ret); return ret;
-    }
+    return m_cursor.readIndex(m_largeHasConstant);
 }
 
 mdToken MetadataStream::readMethodDefOrRef()
 {
-    // Cache reading
-    static CachedTableSizes gMethodDefOrRefSize = TABLE_UNKNOWN_SIZE;
-    if (gMethodDefOrRefSize == TABLE_UNKNOWN_SIZE)
-    {
-        if ((getNumberOfRows(TABLE_MEMBERREF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_METHOD_TABLE) > 0xFFFF))
-            gMethodDefOrRefSize = TABLE_32_BIT;
-        else
-            gMethodDefOrRefSize = TABLE_16_BIT;
-    }
-
-    if (gMethodDefOrRefSize == TABLE_32_BIT)
-    {
-        uint32 ret; m_metaStream->streamReadUint32(ret); return ret;
-    } else
-    {
-        uint16 ret; m_metaStream->streamReadUint16(ret); return ret;
-    }
+    return m_cursor.readIndex(m_largeMethodDefOrRef);
 }
 
 mdToken MetadataStream::readTypeOrMethodDef()
 {
-    // Cache reading
-    static CachedTableSizes gTypeOrMethodDefSize = TABLE_UNKNOWN_SIZE;
-    if (gTypeOrMethodDefSize == TABLE_UNKNOWN_SIZE)
-    {
-        if ((getNumberOfRows(TABLE_TYPEDEF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_METHOD_TABLE) > 0xFFFF))
-            gTypeOrMethodDefSize = TABLE_32_BIT;
-        else
-            gTypeOrMethodDefSize = TABLE_16_BIT;
-    }
-
-    if (gTypeOrMethodDefSize == TABLE_32_BIT)
-    {
-        uint32 ret; m_metaStream->streamReadUint32(ret); return ret;
-    } else
-    {
-        uint16 ret; m_metaStream->streamReadUint16(ret); return ret;
-    }
+    return m_cursor.readIndex(m_largeTypeOrMethodDef);
 }
 
 mdToken MetadataStream::readHasHasSemanticsToken()
 {
-    // Cache reading
-    static CachedTableSizes gHasHasSemanticsSize = TABLE_UNKNOWN_SIZE;
-    if (gHasHasSemanticsSize == TABLE_UNKNOWN_SIZE)
-    {
-        if ((getNumberOfRows(TABLE_PROPERTY_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_EVENT_TABLE) > 0xFFFF))
-            gHasHasSemanticsSize = TABLE_32_BIT;
-        else
-            gHasHasSemanticsSize = TABLE_16_BIT;
-    }
-
-    if (gHasHasSemanticsSize == TABLE_32_BIT)
-    {
-        uint32 ret; m_metaStream->streamReadUint32(ret); return ret;
-    } else
-    {
-        uint16 ret; m_metaStream->streamReadUint16(ret); return ret;
-    }
+    return m_cursor.readIndex(m_largeHasSemantics);
 }
 
 mdToken MetadataStream::readHasCustomAttributeToken()
 {
-    // Cache reading
-    static CachedTableSizes gHasCustomAttributeSize = TABLE_UNKNOWN_SIZE;
-    if (gHasCustomAttributeSize == TABLE_UNKNOWN_SIZE)
-    {
-        if ((getNumberOfRows(TABLE_METHOD_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_FIELD_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_TYPEREF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_TYPEDEF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_PARAM_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_INTERFACEIMPL_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_MEMBERREF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_MODULE_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_DECLSECURITY_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_PROPERTY_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_EVENT_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_STANDALONGESIG_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_MODULEREF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_TYPESPEC_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_ASSEMBLY_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_ASSEMBLYREF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_FILE_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_EXPORTTYPE_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_MANIFESTRESOURCE_TABLE) > 0xFFFF))
-            gHasCustomAttributeSize = TABLE_32_BIT;
-        else
-            gHasCustomAttributeSize = TABLE_16_BIT;
-    }
-
-    if (gHasCustomAttributeSize == TABLE_32_BIT)
-    {
-        uint32 ret; m_metaStream->streamReadUint32(ret); return ret;
-    } else
-    {
-        uint16 ret; m_metaStream->streamReadUint16(ret); return ret;
-    }
+    return m_cursor.readIndex(m_largeHasCustomAttribute);
 }
 
 mdToken MetadataStream::readCustomAttributeTypeToken()
@@ -379,73 +275,17 @@ mdToken MetadataStream::readCustomAttributeTypeToken()
 
 mdToken MetadataStream::readHasDeclSecurityToken()
 {
-    // Cache reading
-    static CachedTableSizes gHasDeclSecuritySize = TABLE_UNKNOWN_SIZE;
-    if (gHasDeclSecuritySize == TABLE_UNKNOWN_SIZE)
-    {
-        if ((getNumberOfRows(TABLE_TYPEDEF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_ASSEMBLY_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_METHOD_TABLE) > 0xFFFF))
-            gHasDeclSecuritySize = TABLE_32_BIT;
-        else
-            gHasDeclSecuritySize = TABLE_16_BIT;
-    }
-
-    if (gHasDeclSecuritySize == TABLE_32_BIT)
-    {
-        uint32 ret; m_metaStream->streamReadUint32(ret); return ret;
-    } else
-    {
-        uint16 ret; m_metaStream->streamReadUint16(ret); return ret;
-    }
+    return m_cursor.readIndex(m_largeHasDeclSecurity);
 }
 
 mdToken MetadataStream::readResolutionScopeToken()
 {
-    // Cache reading
-    static CachedTableSizes gResolutionScopeSize = TABLE_UNKNOWN_SIZE;
-    if (gResolutionScopeSize == TABLE_UNKNOWN_SIZE)
-    {
-        if ((getNumberOfRows(TABLE_MODULE_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_MODULEREF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_ASSEMBLYREF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_TYPEREF_TABLE) > 0xFFFF))
-            gResolutionScopeSize = TABLE_32_BIT;
-        else
-            gResolutionScopeSize = TABLE_16_BIT;
-    }
-
-    if (gResolutionScopeSize == TABLE_32_BIT)
-    {
-        uint32 ret; m_metaStream->streamReadUint32(ret); return ret;
-    } else
-    {
-        uint16 ret; m_metaStream->streamReadUint16(ret); return ret;
-    }
+    return m_cursor.readIndex(m_largeResolutionScope);
 }
 
 mdToken MetadataStream::readMemberRefParentToken()
 {
-    // Cache reading
-    static CachedTableSizes gMemberRefParentSize = TABLE_UNKNOWN_SIZE;
-    if (gMemberRefParentSize == TABLE_UNKNOWN_SIZE)
-    {
-        if ((getNumberOfRows(TABLE_TYPEREF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_MODULEREF_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_METHOD_TABLE) > 0xFFFF) ||
-            (getNumberOfRows(TABLE_TYPESPEC_TABLE) > 0xFFFF))
-            gMemberRefParentSize = TABLE_32_BIT;
-        else
-            gMemberRefParentSize = TABLE_16_BIT;
-    }
-
-    if (gMemberRefParentSize == TABLE_32_BIT)
-    {
-        uint32 ret; m_metaStream->streamReadUint32(ret); return ret;
-    } else
-    {
-        uint16 ret; m_metaStream->streamReadUint16(ret); return ret;
-    }
+    return m_cursor.readIndex(m_largeMemberRefParent);
 }
 
 //////////////////////////////////////////////////////////////////////////
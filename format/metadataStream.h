@@ -42,9 +42,11 @@
  * Author: Elad Raz <e@eladraz.com>
  */
 #include "xStl/types.h"
+#include "xStl/data/datastream.h"
 #include "xStl/stream/stringerStream.h"
 #include "format/coreHeadersTypes.h"
 #include "format/metadataHeader.h"
+#include "format/ByteCursor.h"
 
 /*
  * Forward deceleration for output streams
@@ -60,10 +62,10 @@ cStringerStream& operator << (cStringerStream& out,
  * NOTE: This class implements the basicInput interface to allow all the table
  *       parser class to read information in the following way:
  *           FirstTable:
- *              metadataStream.streamReadUint16(bla);
- *              metadataStream.streamReadUint16(bla1);
- *              metadataStream.streamReadUint32(rva.offset);
- *              metadataStream.streamReadUint32(rva.size);
+ *              bla = metadataStream.readTableUint16();
+ *              bla1 = metadataStream.readTableUint16();
+ *              rva.offset = metadataStream.readTableUint32();
+ *              rva.size = metadataStream.readTableUint32();
  *              metadataStream.readStringToken(name);
  *           SecondTable:
  *              metadataStream.readStringToken(name);
@@ -71,6 +73,8 @@ cStringerStream& operator << (cStringerStream& out,
  *              metadataStream.readBlobToken(guid);
  *       This way the following tables can be deserialized in a more convinet
  *       way.
+ *       The #~ stream is read once into memory, and all the reads are served
+ *       from a ByteCursor over that copy.
  *
  * TODO! Add CoreStreamParse inherit
  */
@@ -138,7 +142,7 @@ public:
 
     /*
      * All the following functions inherited from the basicInput interface and
-     * implemented as a simple delegation to "m_metaStream"->function.
+     * implemented over the in-memory copy of the #~ stream (m_cursor).
      *
      * All of these function might throw exception if the stream is invalid
      */
@@ -149,6 +153,16 @@ public:
     virtual bool isEOS();
     virtual void seek(const int distance, const seekMethod method);
 
+    /*
+     * Read a 16bit/32bit table column directly from the cursor, so the table
+     * parsers don't pay for a virtual read() call for each field.
+     *
+     * NOTE: The basicInput::streamReadUintXX() methods read through read()
+     *       and are kept intact.
+     */
+    uint16 readTableUint16() { return m_cursor.readUint16(); }
+    uint32 readTableUint32() { return m_cursor.readUint32(); }
+
     /*
      * Read a 16bit/32bit value according to the string heap-size
      */
@@ -237,8 +251,7 @@ public:
 
 protected:
     // Default empty implementation of the initSeek. The seek function is not
-    // needed here, since the seek implementation is delegation to
-    // cMemoryAccesserStream implementation
+    // needed here, since the seek implementation moves m_cursor
     virtual void initSeek() {};
 
 private:
@@ -263,6 +276,15 @@ private:
     bool isTableValid(uint index) const;
     bool isTableSorted(uint index) const;
 
+    /*
+     * Return true if one of the tables has more than 65535 rows, which means
+     * that a coded index into these tables is encoded as 32bit number
+     *
+     * tables - Array of table IDs
+     * count  - The number of elements in 'tables'
+     */
+    bool isAnyTableLarge(const uint* tables, uint count) const;
+
     // The string which represent the metadata stream (#~)
     static const char gMetaStreamStringID[];
 
@@ -270,12 +292,26 @@ private:
     cMemoryAccesserStreamPtr m_metaStream;
     // The directory for the meta-stream. Used for RVA
     IMAGE_DATA_DIRECTORY m_metaDir;
+    // The content of the #~ stream and the read position inside it
+    cBuffer m_metaData;
+    ByteCursor m_cursor;
 
     // Cached value of the m_header.m_heapSizes
     bool m_largeString;
     bool m_largeGUID;
     bool m_largeBlob;
 
+    // Cached sizes of the coded indexes. True means 32bit index
+    bool m_largeTypeDefOrRef;
+    bool m_largeHasConstant;
+    bool m_largeMethodDefOrRef;
+    bool m_largeTypeOrMethodDef;
+    bool m_largeHasSemantics;
+    bool m_largeHasCustomAttribute;
+    bool m_largeHasDeclSecurity;
+    bool m_largeResolutionScope;
+    bool m_largeMemberRefParent;
+
     // The header of the #~ stream
     Header m_header;
     // The number of rows for each table. 0 means that the table is invalid
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * CilMappedPeLayout.cpp
+ *
+ * Implementation file
+ */
+#include "xStl/types.h"
+#include "xStl/data/sarray.h"
+#include "xStl/except/trace.h"
+#include "xStl/os/threadUnsafeMemoryAccesser.h"
+#include "format/ByteCursor.h"
+#include "format/pe/CilMappedPeLayout.h"
+
+#ifdef XSTL_LINUX
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// PE/COFF constants. See the "Microsoft PE and COFF Specification"
+enum {
+    // The 'MZ' signature of the DOS header
+    PE_DOS_SIGNATURE = 0x5A4D,
+    // Offset of e_lfanew inside the DOS header
+    PE_DOS_LFANEW_OFFSET = 0x3C,
+    // The size of the COFF file header
+    PE_FILE_HEADER_SIZE = 20,
+    // The size of a single section header, and of its name
+    PE_SECTION_HEADER_SIZE = 40,
+    PE_SECTION_NAME_SIZE = 8,
+    // Optional header magic for PE32 and PE32+
+    PE_OPTIONAL_MAGIC_PE32 = 0x10B,
+    PE_OPTIONAL_MAGIC_PE32PLUS = 0x20B,
+    // Offset of SizeOfHeaders inside the optional header
+    PE_OPTIONAL_SIZEOFHEADERS_OFFSET = 60,
+    // Offset of the data directories inside the optional header
+    PE_OPTIONAL_DIRECTORIES_PE32 = 96,
+    PE_OPTIONAL_DIRECTORIES_PE32PLUS = 112,
+    // The index of the CLI header directory (IMAGE_DIRECTORY_ENTRY_COM_DESCRIPTOR)
+    PE_CLI_DIRECTORY_INDEX = 14,
+    // Offsets inside the CLI header (IMAGE_COR20_HEADER)
+    CLI_METADATA_OFFSET = 8,
+    CLI_ENTRYPOINT_OFFSET = 20
+};
+
+CilMappedPeLayout::CilMappedPeLayout(const cString& filename) :
+    m_base(NULL),
+    m_size(0),
+#ifdef XSTL_WINDOWS
+    m_mapping(NULL),
+#endif
+    m_headersSize(0),
+    m_entryPointToken(0),
+    m_memory(new cThreadUnsafeMemoryAccesser())
+{
+    map(filename);
+    XSTL_TRY
+    {
+        parseHeaders();
+    }
+    XSTL_CATCH_ALL
+    {
+        // The destructor will not be called
+        unmap();
+        XSTL_RETHROW;
+    }
+}
+
+CilMappedPeLayout::~CilMappedPeLayout()
+{
+    unmap();
+}
+
+void CilMappedPeLayout::unmap()
+{
+    if (m_base == NULL)
+        return;
+#ifdef XSTL_WINDOWS
+    UnmapViewOfFile(m_base);
+    CloseHandle(m_mapping);
+#elif defined XSTL_LINUX
+    munmap((void*)m_base, m_size);
+#endif
+    m_base = NULL;
+}
+
+void CilMappedPeLayout::map(const cString& filename)
+{
+    cSArray<char> path = filename.getASCIIstring();
+#ifdef XSTL_WINDOWS
+    HANDLE file = CreateFileA(path.getBuffer(), GENERIC_READ, FILE_SHARE_READ,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    CHECK(file != INVALID_HANDLE_VALUE);
+    m_size = GetFileSize(file, NULL);
+    m_mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    // The mapping object keeps the file open
+    CloseHandle(file);
+    CHECK(m_mapping != NULL);
+    m_base = (const uint8*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_base == NULL)
+    {
+        CloseHandle(m_mapping);
+        CHECK_FAIL();
+    }
+#elif defined XSTL_LINUX
+    int file = open(path.getBuffer(), O_RDONLY);
+    CHECK(file >= 0);
+    struct stat info;
+    if ((fstat(file, &info) != 0) || (info.st_size == 0))
+    {
+        close(file);
+        CHECK_FAIL();
+    }
+    m_size = (uint)info.st_size;
+    void* area = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping keeps a reference to the file
+    close(file);
+    CHECK(area != MAP_FAILED);
+    m_base = (const uint8*)area;
+#else
+    #error "Please add file mapping\n"
+#endif
+}
+
+void CilMappedPeLayout::parseHeaders()
+{
+    ByteCursor file(m_base, m_size);
+
+    // DOS header
+    CHECK(file.readUint16() == PE_DOS_SIGNATURE);
+    file.seek(PE_DOS_LFANEW_OFFSET);
+    file.seek(file.readUint32());
+
+    // NT-header
+    CHECK(file.readUint32() == IMAGE_NT_SIGNATURE);
+    ByteCursor fileHeader = file.readCursor(PE_FILE_HEADER_SIZE);
+    fileHeader.skip(sizeof(uint16)); // Machine
+    uint numberOfSections = fileHeader.readUint16();
+    fileHeader.skip(sizeof(uint32) * 3); // TimeDateStamp, symbols
+    uint optionalHeaderSize = fileHeader.readUint16();
+
+    ByteCursor optionalHeader = file.readCursor(optionalHeaderSize);
+    uint magic = optionalHeader.readUint16();
+    CHECK((magic == PE_OPTIONAL_MAGIC_PE32) ||
+          (magic == PE_OPTIONAL_MAGIC_PE32PLUS));
+    optionalHeader.seek(PE_OPTIONAL_SIZEOFHEADERS_OFFSET);
+    m_headersSize = optionalHeader.readUint32();
+
+    // Read the CLI header directory
+    optionalHeader.seek((magic == PE_OPTIONAL_MAGIC_PE32) ?
+                            PE_OPTIONAL_DIRECTORIES_PE32 :
+                            PE_OPTIONAL_DIRECTORIES_PE32PLUS);
+    optionalHeader.skip(sizeof(IMAGE_DATA_DIRECTORY) * PE_CLI_DIRECTORY_INDEX);
+    uint cliHeaderRVA = optionalHeader.readUint32();
+    uint cliHeaderSize = optionalHeader.readUint32();
+    // Not a .NET module
+    CHECK(cliHeaderSize != 0);
+
+    // Read the section table, which follows the optional header
+    m_sections.changeSize(numberOfSections);
+    for (uint i = 0; i < numberOfSections; i++)
+    {
+        ByteCursor sectionHeader = file.readCursor(PE_SECTION_HEADER_SIZE);
+        sectionHeader.skip(PE_SECTION_NAME_SIZE + sizeof(uint32)); // Name, VirtualSize
+        m_sections[i].m_virtualAddress = sectionHeader.readUint32();
+        m_sections[i].m_rawSize = sectionHeader.readUint32();
+        m_sections[i].m_rawOffset = sectionHeader.readUint32();
+        // The raw data must be inside the file
+        CHECK(m_sections[i].m_rawOffset <= m_size);
+        CHECK(m_sections[i].m_rawSize <= m_size - m_sections[i].m_rawOffset);
+    }
+
+    // Read the CLI header
+    addressNumericValue start, end;
+    translate(cliHeaderRVA, cliHeaderRVA + cliHeaderSize, start, end);
+    ByteCursor cliHeader((const uint8*)start, (uint)(end - start));
+    cliHeader.seek(CLI_METADATA_OFFSET);
+    m_metadataDirectory.VirtualAddress = cliHeader.readUint32();
+    m_metadataDirectory.Size = cliHeader.readUint32();
+    cliHeader.seek(CLI_ENTRYPOINT_OFFSET);
+    m_entryPointToken = cliHeader.readUint32();
+}
+
+void CilMappedPeLayout::translate(uint startRVA, uint endRVA,
+                                  addressNumericValue& start,
+                                  addressNumericValue& end) const
+{
+    uint rawOffset = 0;
+    uint rawEnd = 0;
+    if (startRVA < m_headersSize)
+    {
+        // The headers are mapped as is
+        rawOffset = startRVA;
+        rawEnd = (m_headersSize < m_size) ? m_headersSize : m_size;
+    } else
+    {
+        uint i;
+        for (i = 0; i < m_sections.getSize(); i++)
+        {
+            const Section& section = m_sections[i];
+            if ((startRVA >= section.m_virtualAddress) &&
+                (startRVA - section.m_virtualAddress < section.m_rawSize))
+            {
+                rawOffset = section.m_rawOffset + (startRVA - section.m_virtualAddress);
+                rawEnd = section.m_rawOffset + section.m_rawSize;
+                break;
+            }
+        }
+        // The RVA is not backed by the file (e.g. uninitialized data)
+        CHECK(i < m_sections.getSize());
+    }
+
+    if (endRVA != DEFAULT_END_ADDRESS)
+    {
+        CHECK(endRVA > startRVA);
+        CHECK(endRVA - startRVA <= rawEnd - rawOffset);
+        rawEnd = rawOffset + (endRVA - startRVA);
+    }
+
+    start = (addressNumericValue)(m_base + rawOffset);
+    end = (addressNumericValue)(m_base + rawEnd);
+}
+
+cForkStreamPtr CilMappedPeLayout::getVirtualStream(uint startRVA,
+                                                   uint endRVA)
+{
+    addressNumericValue start, end;
+    translate(startRVA, endRVA, start, end);
+    return cForkStreamPtr(new cMemoryAccesserStream(m_memory, start, end));
+}
+
+const IMAGE_DATA_DIRECTORY& CilMappedPeLayout::getMetadataDirectory() const
+{
+    return m_metadataDirectory;
+}
+
+cMemoryAccesserStreamPtr CilMappedPeLayout::getMetadataStream()
+{
+    addressNumericValue start, end;
+    translate(m_metadataDirectory.VirtualAddress,
+              m_metadataDirectory.VirtualAddress + m_metadataDirectory.Size,
+              start, end);
+    return cMemoryAccesserStreamPtr(new cMemoryAccesserStream(m_memory, start, end));
+}
+
+mdToken CilMappedPeLayout::getEntryPointToken() const
+{
+    return m_entryPointToken;
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_FORMAT_PE_CILMAPPEDPELAYOUT_H
+#define __TBA_CLR_FORMAT_PE_CILMAPPEDPELAYOUT_H
+
+/*
+ * CilMappedPeLayout.h
+ *
+ * Implementation of CilFormatLayout over a read-only memory mapping of a PE
+ * file.
+ */
+#include "xStl/types.h"
+#include "xStl/data/array.h"
+#include "xStl/data/string.h"
+#include "xStl/os/virtualMemoryAccesser.h"
+#include "xStl/stream/memoryAccesserStream.h"
+#include "pe/ntheader.h"
+#include "format/coreHeadersTypes.h"
+#include "format/CilFormatLayout.h"
+
+/*
+ * Implementation of CilFormatLayout over a read-only memory mapping of a PE
+ * file.
+ *
+ * Unlike CilPeLayout, the file is not read (and copied) into memory. The
+ * sections are translated from RVA into the file offset and the returned
+ * streams read directly from the mapped pages. The pages are loaded by the
+ * operating system on their first access and are shared with every other
+ * process (or compilation) which maps the same file.
+ *
+ * Usage:
+ *     CilMappedPeLayout* layout = new CilMappedPeLayout("clrcore.dll");
+ *     CilFormatLayoutPtr layoutPtr(layout);
+ *     MetadataHeader header(layout->getMetadataStream(),
+ *                           layout->getMetadataDirectory());
+ *
+ * NOTE: The returned streams are valid as long as this object exist.
+ */
+class CilMappedPeLayout : public CilFormatLayout {
+public:
+    /*
+     * Constructor. Map the file and read the PE and CLI headers
+     *
+     * filename - The PE file to map
+     *
+     * Throw exception if the file cannot be mapped or it's not a .NET PE file
+     */
+    CilMappedPeLayout(const cString& filename);
+
+    /*
+     * Destructor. Unmap the file
+     */
+    virtual ~CilMappedPeLayout();
+
+    /*
+     * See CilFormatLayout::getVirtualStream
+     *
+     * The stream is limited to the raw data of the section which contains
+     * 'startRVA'. If 'endRVA' is DEFAULT_END_ADDRESS, the stream ends at the
+     * end of that section.
+     */
+    virtual cForkStreamPtr getVirtualStream(uint startRVA,
+                                            uint endRVA = DEFAULT_END_ADDRESS);
+
+    /*
+     * Return the CLI metadata directory, as written in the CLI header
+     */
+    const IMAGE_DATA_DIRECTORY& getMetadataDirectory() const;
+
+    /*
+     * Return a stream over the CLI metadata (See MetadataHeader)
+     */
+    cMemoryAccesserStreamPtr getMetadataStream();
+
+    /*
+     * Return the entry point token as written in the CLI header
+     */
+    mdToken getEntryPointToken() const;
+
+private:
+    // Deny copy-constructor and operator =
+    CilMappedPeLayout(const CilMappedPeLayout& other);
+    CilMappedPeLayout& operator = (const CilMappedPeLayout& other);
+
+    /*
+     * Map the file into memory
+     */
+    void map(const cString& filename);
+
+    /*
+     * Unmap the file, if it's mapped
+     */
+    void unmap();
+
+    /*
+     * Parse the PE headers: the section table and the CLI header
+     */
+    void parseHeaders();
+
+    /*
+     * Translate an RVA range into a range of the mapped file.
+     *
+     * startRVA - The relative start address
+     * endRVA   - The relative end address, or DEFAULT_END_ADDRESS
+     * start    - Will be filled with the start address inside the mapping
+     * end      - Will be filled with the end address inside the mapping
+     *
+     * Throw exception if the range is not backed by the file
+     */
+    void translate(uint startRVA, uint endRVA,
+                   addressNumericValue& start,
+                   addressNumericValue& end) const;
+
+    // A single section header
+    struct Section {
+        // The RVA of the section
+        uint m_virtualAddress;
+        // The number of bytes stored in the file
+        uint m_rawSize;
+        // The file offset of the section
+        uint m_rawOffset;
+    };
+
+    // The mapped file
+    const uint8* m_base;
+    // The size of the mapped file
+    uint m_size;
+#ifdef XSTL_WINDOWS
+    // The file mapping object
+    HANDLE m_mapping;
+#endif
+
+    // The size of the PE headers
+    uint m_headersSize;
+    // The sections table
+    cArray<Section> m_sections;
+    // The CLI metadata directory
+    IMAGE_DATA_DIRECTORY m_metadataDirectory;
+    // The entry point token
+    mdToken m_entryPointToken;
+    // Reads directly from the mapped file
+    cMemoryAccesserPtr m_memory;
+};
+
+#endif // __TBA_CLR_FORMAT_PE_CILMAPPEDPELAYOUT_H
@@ -38,19 +38,16 @@
  */
 #include "xStl/types.h"
 #include "xStl/except/trace.h"
-#include "xStl/stream/basicIO.h"
 #include "data/ElementType.h"
 #include "format/EncodingUtils.h"
 #include "format/signatures/FieldSig.h"
 
-FieldSig::FieldSig(basicInput& stream, mdToken apartmentId, const ResolverInterface& resolverInterface)
+FieldSig::FieldSig(ByteCursor blob, mdToken apartmentId, const ResolverInterface& resolverInterface)
 {
     // Read the number of bytes this signature takes
-    uint byteLength = EncodingUtils::readCompressedNumber(stream);
+    ByteCursor stream = blob.readCursor(EncodingUtils::readCompressedNumber(blob));
 
-    uint8 signature;
-    stream.streamReadUint8(signature);
-    CHECK(signature == FIELD_SIGNATURE);
+    CHECK(stream.readUint8() == FIELD_SIGNATURE);
 
     m_type = ElementType::readType(stream, apartmentId);
     resolverInterface.resolveTyperef(m_type);
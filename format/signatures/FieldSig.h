@@ -40,8 +40,8 @@
  * Author: Elad Raz <e@eladraz.com>
  */
 #include "xStl/types.h"
-#include "xStl/stream/basicIO.h"
 #include "data/ElementType.h"
+#include "format/ByteCursor.h"
 #include "runnable/ResolverInterface.h"
 
 /*
@@ -54,10 +54,10 @@
 class FieldSig {
 public:
     /*
-     * Constructor. Read from the #Blob stream position by 'stream' the field
-     * signature
+     * Constructor. Read the field signature from the #Blob heap position
+     * by 'blob'. See MSILStreams::getBlob
      */
-    FieldSig(basicInput& stream, mdToken apartmentId, const ResolverInterface& resolverInterface);
+    FieldSig(ByteCursor blob, mdToken apartmentId, const ResolverInterface& resolverInterface);
 
     // Copy-constructor and operator = will auto-generate by the compiler even
     // if they aren't nessasry...
@@ -40,19 +40,16 @@
 #include "xStl/data/string.h"
 #include "xStl/data/datastream.h"
 #include "xStl/except/trace.h"
-#include "xStl/stream/basicIO.h"
 #include "data/ElementType.h"
 #include "format/signatures/LocalVarSignature.h"
 #include "format/EncodingUtils.h"
 
-LocalVarSignature::LocalVarSignature(basicInput& stream, mdToken apartmentId, const ResolverInterface& resolverInterface)
+LocalVarSignature::LocalVarSignature(ByteCursor blob, mdToken apartmentId, const ResolverInterface& resolverInterface)
 {
     // Read the number of bytes this signature takes
-    /* uint byteLength = */ EncodingUtils::readCompressedNumber(stream);
+    ByteCursor stream = blob.readCursor(EncodingUtils::readCompressedNumber(blob));
 
-    uint8 signature;
-    stream.streamReadUint8(signature);
-    CHECK(signature == LOCAL_VAR_SIGNATURE);
+    CHECK(stream.readUint8() == LOCAL_VAR_SIGNATURE);
 
     uint count = EncodingUtils::readCompressedNumber(stream);
     m_locals.changeSize(count);
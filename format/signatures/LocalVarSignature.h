@@ -47,6 +47,7 @@
 #include "xStl/except/trace.h"
 #include "xStl/stream/stringerStream.h"
 #include "data/ElementType.h"
+#include "format/ByteCursor.h"
 #include "runnable/ResolverInterface.h"
 
 /*
@@ -68,10 +69,10 @@ public:
     /*
      * Constructor. Read the blob section:
      *
-     * stream - The stream into the blob section which points to the beginning
-     *          of the signature
+     * blob - A cursor into the blob section which points to the beginning
+     *        of the signature. See MSILStreams::getBlob
      */
-    LocalVarSignature(basicInput& stream,
+    LocalVarSignature(ByteCursor blob,
                       mdToken apartmentId,
                       const ResolverInterface& resolverInterface);
 
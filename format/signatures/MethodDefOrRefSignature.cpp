@@ -39,27 +39,25 @@
 #include "xStl/types.h"
 #include "xStl/except/trace.h"
 #include "xStl/data/array.h"
-#include "xStl/stream/basicIO.h"
 #include "xStl/stream/stringerStream.h"
 #include "data/ElementType.h"
 #include "format/EncodingUtils.h"
 #include "format/signatures/MethodDefOrRefSignature.h"
 
-MethodDefOrRefSignature::MethodDefOrRefSignature(basicInput& stream, mdToken apartmentId, const ResolverInterface& resolverInterface) :
+MethodDefOrRefSignature::MethodDefOrRefSignature(ByteCursor blob, mdToken apartmentId, const ResolverInterface& resolverInterface) :
     m_hasThis(false),
     m_explicit(false),
     m_callingConvention(CALLCONV_DEFAULT)
 {
     // Read the number of bytes this signature takes
-    uint byteLength = EncodingUtils::readCompressedNumber(stream);
+    ByteCursor stream = blob.readCursor(EncodingUtils::readCompressedNumber(blob));
 
     bool stop = false;
 
     // Read header
     while (!stop)
     {
-        uint8 data;
-        stream.streamReadUint8(data);
+        uint8 data = stream.readUint8();
         switch (data)
         {
         case HASTHIS: CHECK(!m_hasThis); m_hasThis = true;
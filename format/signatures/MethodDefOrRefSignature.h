@@ -42,9 +42,9 @@
 #include "xStl/types.h"
 #include "xStl/data/array.h"
 #include "xStl/data/smartptr.h"
-#include "xStl/stream/basicIO.h"
 #include "xStl/stream/stringerStream.h"
 #include "data/ElementType.h"
+#include "format/ByteCursor.h"
 #include "runnable/ResolverInterface.h"
 
 /*
@@ -103,10 +103,10 @@ public:
 
 
     /*
-     * Constructor. Read from the #Blob stream position by 'stream' the method
-     * signature
+     * Constructor. Read the method signature from the #Blob heap position
+     * by 'blob'. See MSILStreams::getBlob
      */
-    MethodDefOrRefSignature(basicInput& stream, mdToken apartmentId, const ResolverInterface& resolverInterface);
+    MethodDefOrRefSignature(ByteCursor blob, mdToken apartmentId, const ResolverInterface& resolverInterface);
 
     /*
      * Explicit constructor
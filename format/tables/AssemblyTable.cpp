@@ -49,12 +49,12 @@ AssemblyTable::AssemblyTable(MetadataStream& stream,
                              mdToken token) :
     Table(token)
 {
-    stream.streamReadUint32(m_header.m_hashAlgId);
-    stream.streamReadUint16(m_header.m_majorVersion);
-    stream.streamReadUint16(m_header.m_minorVersion);
-    stream.streamReadUint16(m_header.m_buildNumber);
-    stream.streamReadUint16(m_header.m_revisionNumber);
-    stream.streamReadUint32(m_header.m_flags);
+    m_header.m_hashAlgId = stream.readTableUint32();
+    m_header.m_majorVersion = stream.readTableUint16();
+    m_header.m_minorVersion = stream.readTableUint16();
+    m_header.m_buildNumber = stream.readTableUint16();
+    m_header.m_revisionNumber = stream.readTableUint16();
+    m_header.m_flags = stream.readTableUint32();
     m_header.m_publicKey = stream.readBlobToken();
     m_header.m_name    = stream.readStringToken();
     m_header.m_culture = stream.readStringToken();
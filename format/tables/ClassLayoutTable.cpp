@@ -46,8 +46,8 @@
 ClassLayoutTable::ClassLayoutTable(MetadataStream& stream, mdToken token) :
     Table(token)
 {
-    stream.streamReadUint16(m_header.m_packingSize);
-    stream.streamReadUint32(m_header.m_classSize);
+    m_header.m_packingSize = stream.readTableUint16();
+    m_header.m_classSize = stream.readTableUint32();
     m_header.m_parent = stream.readTypeDefOrRefToken();
 }
 
@@ -50,7 +50,7 @@ ConstantTable::ConstantTable(MetadataStream& stream,
                              mdToken token) :
     Table(token)
 {
-    stream.streamReadUint16(m_header.m_type);
+    m_header.m_type = stream.readTableUint16();
 
     // Read Field, Param or Property value
     m_header.m_parent = EncodingUtils::unpackHasConstantToken(
@@ -50,7 +50,7 @@ DeclSecurityTable::DeclSecurityTable(MetadataStream& stream,
                                      mdToken token) :
     Table(token)
 {
-    stream.streamReadUint16(m_header.m_action);
+    m_header.m_action = stream.readTableUint16();
     m_header.m_parent = EncodingUtils::unpackHasDeclSecurityToken(
         stream.readHasDeclSecurityToken());
     m_header.m_permissionSet = stream.readBlobToken();
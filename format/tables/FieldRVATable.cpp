@@ -51,7 +51,7 @@ FieldRVATable::FieldRVATable(MetadataStream& stream,
     Table(token)
 {
     // Start reading the table
-    stream.streamReadUint32(m_header.m_fieldRva);
+    m_header.m_fieldRva = stream.readTableUint32();
     m_header.m_field = EncodingUtils::buildToken(TABLE_FIELD_TABLE,
                             stream.readTableToken(TABLE_FIELD_TABLE));
 }
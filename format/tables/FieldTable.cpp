@@ -50,7 +50,7 @@ FieldTable::FieldTable(MetadataStream& stream,
     Table(token)
 {
     // Start reading the table
-    stream.streamReadUint16(m_header.m_flags);
+    m_header.m_flags = stream.readTableUint16();
     m_header.m_name = stream.readStringToken();
     m_header.m_signature = stream.readBlobToken();
 }
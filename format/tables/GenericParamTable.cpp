@@ -50,8 +50,8 @@ GenericParamTable::GenericParamTable(MetadataStream& stream,
                              mdToken token) :
     Table(token)
 {
-    stream.streamReadUint16(m_header.m_numer);
-    stream.streamReadUint16(m_header.m_flags);
+    m_header.m_numer = stream.readTableUint16();
+    m_header.m_flags = stream.readTableUint16();
 
     // Read Field, Param or Property value
     m_header.m_owner = EncodingUtils::unpackTypeOrMethodDefToken(
@@ -49,7 +49,7 @@ MethodSemanticsTable::MethodSemanticsTable(MetadataStream& stream,
                                            mdToken token) :
     Table(token)
 {
-    stream.streamReadUint16(m_header.m_semantics);
+    m_header.m_semantics = stream.readTableUint16();
     m_header.m_method = stream.readTableToken(TABLE_METHOD_TABLE);
     m_header.m_association = EncodingUtils::unpackHasSemanticsToken(
                                               stream.readHasHasSemanticsToken());
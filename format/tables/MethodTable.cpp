@@ -51,9 +51,9 @@ MethodTable::MethodTable(MetadataStream& stream,
     Table(token)
 {
     // Start reading the table
-    stream.streamReadUint32(m_header.m_rva);
-    stream.streamReadUint16(m_header.m_implementationFlags);
-    stream.streamReadUint16(m_header.m_flags);
+    m_header.m_rva = stream.readTableUint32();
+    m_header.m_implementationFlags = stream.readTableUint16();
+    m_header.m_flags = stream.readTableUint16();
     m_header.m_name = stream.readStringToken();
     m_header.m_signature = stream.readBlobToken();
     m_header.m_params = EncodingUtils::buildToken(TABLE_PARAM_TABLE,
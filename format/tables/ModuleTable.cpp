@@ -50,7 +50,7 @@ ModuleTable::ModuleTable(MetadataStream& stream,
     Table(token)
 {
     // Start reading the table
-    stream.streamReadUint16(m_header.m_generation);
+    m_header.m_generation = stream.readTableUint16();
     m_header.m_name = stream.readStringToken();
     m_header.m_mvid = stream.readGuidToken();
     m_header.m_endId = stream.readGuidToken();
@@ -49,8 +49,8 @@ ParamTable::ParamTable(MetadataStream& stream,
                        mdToken token) :
     Table(token)
 {
-    stream.streamReadUint16(m_header.m_flags);
-    stream.streamReadUint16(m_header.m_sequence);
+    m_header.m_flags = stream.readTableUint16();
+    m_header.m_sequence = stream.readTableUint16();
     m_header.m_name = stream.readStringToken();
 }
 
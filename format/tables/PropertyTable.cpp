@@ -49,7 +49,7 @@ PropertyTable::PropertyTable(MetadataStream& stream,
                                    mdToken token) :
     Table(token)
 {
-    stream.streamReadUint16(m_header.m_flags);
+    m_header.m_flags = stream.readTableUint16();
     m_header.m_name = stream.readStringToken();
     m_header.m_type = stream.readBlobToken();
 }
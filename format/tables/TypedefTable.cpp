@@ -50,7 +50,7 @@ TypedefTable::TypedefTable(MetadataStream& stream,
                            mdToken token) :
     Table(token)
 {
-    stream.streamReadUint32(m_header.m_flags);
+    m_header.m_flags = stream.readTableUint32();
     m_header.m_name = stream.readStringToken();
     m_header.m_namespace = stream.readStringToken();
 
@@ -117,7 +117,7 @@ namespace clrcore
             if (dtor != null)
             {
                 // Simple object
-                Morph.Imports.callFunction(dtor, buffer);
+                ExceptionHandling.callFunction(dtor, buffer);
             }
 
 #if MEMORY_HELPER_STATISTICS
@@ -142,7 +142,7 @@ namespace clrcore
             if (dtor != null)
             {
                 // Simple object
-                Morph.Imports.callFunction(dtor, buffer);
+                ExceptionHandling.callFunction(dtor, buffer);
             }
 
 #if MEMORY_HELPER_STATISTICS
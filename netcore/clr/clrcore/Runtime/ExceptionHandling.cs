@@ -17,6 +17,10 @@ namespace clrcore
         private const int Catch = 4;
         private const int Filter = 5;
 
+        // Must be kept in a fixed size of 8 words. The compiler reserves
+        // entries inside the method frames, see registerFrameRoutine().
+        // Processors with unwind data don't register entries at all, see
+        // unwindFrames()
         private unsafe struct Entry
         {
             // The type of entry - see constants above
@@ -24,7 +28,7 @@ namespace clrcore
             // Handler routine function pointer
             public void* handler;
             // The exception class RTTI number, if this is a catch handler
-            public ushort exceptionRtti;
+            public uint exceptionRtti;
             // The filter routine function pointer, if this is a filter handler
             public void* filter;
             // Stack pointer to use when running the handler or filter routine
@@ -33,11 +37,102 @@ namespace clrcore
             public void* stackPointerRet;
             // Pointer to the next entry in the linked-list
             public Entry* next;
+            // 1 if the entry was allocated by register*() and should be freed
+            // when popped, 0 if it is stored inside a method frame
+            public uint isAllocated;
         }
 
         // Pointer to the head of the exception stack
         private unsafe static Entry* exceptionStack = null;
 
+        // The frame of a compiled function. Every function which calls
+        // another function starts with "push ebp; mov ebp, esp"
+        private unsafe struct Frame
+        {
+            // The frame of the caller
+            public Frame* next;
+            // The return address into the caller
+            public byte* returnAddress;
+            // The first stack argument. The locals frame of the method, for
+            // the handler functions
+            public void* argument;
+        }
+
+        // The table of all the linked functions, sorted by address. Built by
+        // the linker, see getUnwindTable(). Methods which are compiled on
+        // their first call are added while the table is read, so an entry
+        // shouldn't be kept across a call into a handler
+        private unsafe struct UnwindTable
+        {
+            public uint count;
+            public UnwindFunction* functions;
+        }
+
+        private unsafe struct UnwindFunction
+        {
+            // The code of the function is [start, end)
+            public byte* start;
+            public byte* end;
+            // The unwind data of the function, or null if it's transparent to
+            // exceptions
+            public UnwindData* data;
+        }
+
+        // Emitted by the compiler after the code of a function, followed by
+        // 'count' UnwindClause. See CompilerInterface::generateUnwindData
+        private unsafe struct UnwindData
+        {
+            // The function itself
+            public void* function;
+            // See UnwindHelperFrame
+            public uint flags;
+            // The cleanup routine of the method's locals, or null
+            public void* cleanup;
+            // The number of clauses, from the innermost to the outermost
+            public uint count;
+        }
+
+        private unsafe struct UnwindClause
+        {
+            // The protected block, relative to the end of each field
+            public int tryStart;
+            public int tryEnd;
+            // The type of the handler - see constants above
+            public uint type;
+            // Handler routine function pointer
+            public void* handler;
+            // The exception class RTTI number, if this is a catch handler
+            public uint exceptionRtti;
+        }
+
+        // The function is a handler, so its frame has the method's locals
+        // frame as the argument
+        private const uint UnwindHelperFrame = 1;
+
+        // The state of an unwinding which runs a handler. If an exception
+        // leaves the handler, the new unwinding continues from the frame of
+        // the handler's protected block instead of unwinding the frames which
+        // were already unwound
+        private unsafe struct Dispatch
+        {
+            // The frame of unwindFrames()
+            public Frame* framePointer;
+            // The content of that frame, used to detect a stale record of an
+            // unwinding which ended in a catch handler
+            public Frame* frameNext;
+            public byte* frameReturnAddress;
+            // The frame and the return address whose handler is running
+            public Frame* handlerFrame;
+            public byte* handlerReturnAddress;
+            // The running handler
+            public void* handler;
+            // The previous (outer) unwinding
+            public Dispatch* next;
+        }
+
+        // Pointer to the innermost unwinding
+        private unsafe static Dispatch* dispatchStack = null;
+
         // Current thrown exception
         private unsafe static Morph.Exception currentException = null;
         // stack frame pointer of the catch context
@@ -56,6 +151,8 @@ namespace clrcore
             entry->stackPointer = stackPointer;
             entry->stackPointerRet = null;
 
+            entry->isAllocated = 1;
+
             // Link the new entry as the new head of the stack
             entry->next = exceptionStack;
             exceptionStack = entry;
@@ -74,6 +171,48 @@ namespace clrcore
             entry->stackPointer = stackPointer;
             entry->stackPointerRet = stackPointerRet;
 
+            entry->isAllocated = 1;
+
+            // Link the new entry as the new head of the stack
+            entry->next = exceptionStack;
+            exceptionStack = entry;
+        }
+
+        // Same as registerRoutine(), but the entry is given by the caller. The
+        // compiler reserves it inside the method frame, so no allocation is
+        // needed. The entry must be popped before the frame is left.
+        private unsafe static void registerFrameRoutine(void* frameEntry, uint type, void* handler, void* stackPointer)
+        {
+            Entry* entry = (Entry*)frameEntry;
+
+            // Fill in the entry according to arguments
+            entry->type = type;
+            entry->handler = handler;
+            entry->filter = null;
+            entry->exceptionRtti = 0;
+            entry->stackPointer = stackPointer;
+            entry->stackPointerRet = null;
+            entry->isAllocated = 0;
+
+            // Link the new entry as the new head of the stack
+            entry->next = exceptionStack;
+            exceptionStack = entry;
+        }
+
+        // Same as registerCatch(), for an entry inside the method frame
+        private unsafe static void registerFrameCatch(void* frameEntry, ushort exceptionRtti, void* handler, void* stackPointer, void* stackPointerRet)
+        {
+            Entry* entry = (Entry*)frameEntry;
+
+            // Fill in the entry according to arguments
+            entry->type = Catch;
+            entry->handler = handler;
+            entry->filter = null;
+            entry->exceptionRtti = exceptionRtti;
+            entry->stackPointer = stackPointer;
+            entry->stackPointerRet = stackPointerRet;
+            entry->isAllocated = 0;
+
             // Link the new entry as the new head of the stack
             entry->next = exceptionStack;
             exceptionStack = entry;
@@ -92,6 +231,8 @@ namespace clrcore
             entry->stackPointer = stackPointer;
             entry->stackPointerRet = stackPointerRet;
 
+            entry->isAllocated = 1;
+
             // Link the new entry as the new head of the stack
             entry->next = exceptionStack;
             exceptionStack = entry;
@@ -111,7 +252,7 @@ namespace clrcore
             pop();
 
             // Execute the handler
-            Morph.Imports.callFunction(handler, stackPointer);
+            callFunction(handler, stackPointer);
         }
 
         private unsafe static void pop()
@@ -125,8 +266,207 @@ namespace clrcore
             // Unlink from the stack
             exceptionStack = entry->next;
 
-            // Deallocate
-            Morph.Imports.free((void*)entry);
+            // Deallocate. Frame entries are released with their frame
+            if (entry->isAllocated != 0)
+                Morph.Imports.free((void*)entry);
+        }
+
+        // Return the frame pointer of the caller. Implemented by the compiler
+        [CompilerOpcodes("getFramePointer")]
+        private unsafe static void* getFramePointer()
+        {
+            return null;
+        }
+
+        // Return the table of all the linked functions, or null if the
+        // processor doesn't support unwind data. Implemented by the compiler
+        [CompilerOpcodes("getUnwindTable")]
+        private unsafe static void* getUnwindTable()
+        {
+            return null;
+        }
+
+        // Call "void handler(void* param)". Implemented by the compiler as a
+        // direct call, so the frames of the caller can be unwound from the
+        // handler
+        [CompilerOpcodes("callFunction")]
+        internal unsafe static void callFunction(void* handler, void* param)
+        {
+            Morph.Imports.callFunction(handler, param);
+        }
+
+        // Return the function which contains the return address, or null if
+        // it's not a compiled function
+        private unsafe static UnwindFunction* findFunction(byte* returnAddress)
+        {
+            UnwindTable* table = (UnwindTable*)getUnwindTable();
+            uint low = 0;
+            uint high = table->count;
+            while (low < high)
+            {
+                uint middle = (low + high) / 2;
+                UnwindFunction* function = (UnwindFunction*)((byte*)table->functions + middle * (uint)sizeof(UnwindFunction));
+                // The return address follows the call instruction
+                if (returnAddress <= function->start)
+                    high = middle;
+                else if (returnAddress > function->end)
+                    low = middle + 1;
+                else
+                    return function;
+            }
+            return null;
+        }
+
+        // Run a handler of the frame which is unwound by 'dispatch'
+        private unsafe static void runHandler(Dispatch* dispatch, void* handler, void* argument,
+                                              Frame* frame, byte* returnAddress)
+        {
+            dispatch->handlerFrame = frame;
+            dispatch->handlerReturnAddress = returnAddress;
+            dispatch->handler = handler;
+            callFunction(handler, argument);
+        }
+
+        // Unwind the frames of the compiled functions, from the caller of
+        // throwException() up. The handlers of the protected blocks which
+        // contain the return address of each frame are run, and then the
+        // cleanup routine of the frame. Nothing is registered on the
+        // exception stack, so this is done only when an exception is thrown.
+        // Returns if the exception isn't caught.
+        private unsafe static void unwindFrames(void* exceptionVtbl)
+        {
+            Frame* callee = (Frame*)getFramePointer();
+
+            // Drop the records of the unwindings which ended in a catch
+            // handler. Their frames are gone, or were reused by other frames
+            Dispatch* previous = null;
+            Dispatch* outer = dispatchStack;
+            while (outer != null)
+            {
+                Dispatch* next = outer->next;
+                if (((byte*)outer->framePointer <= (byte*)callee) ||
+                    (outer->framePointer->next != outer->frameNext) ||
+                    (outer->framePointer->returnAddress != outer->frameReturnAddress))
+                {
+                    if (previous == null)
+                        dispatchStack = next;
+                    else
+                        previous->next = next;
+                    Morph.Imports.free((void*)outer);
+                }
+                else
+                    previous = outer;
+                outer = next;
+            }
+
+            Dispatch* dispatch = (Dispatch*)Morph.Imports.allocate((uint)sizeof(Dispatch));
+            dispatch->framePointer = callee;
+            dispatch->frameNext = callee->next;
+            dispatch->frameReturnAddress = callee->returnAddress;
+            dispatch->handlerFrame = null;
+            dispatch->handlerReturnAddress = null;
+            dispatch->handler = null;
+            dispatch->next = dispatchStack;
+            dispatchStack = dispatch;
+            outer = dispatch->next;
+
+            // The function which the frame called. It's the handler of one of
+            // the frame's clauses if it was called when leaving a protected
+            // block, or by an outer unwinding
+            void* running = null;
+            Frame* frame = callee->next;
+            byte* returnAddress = callee->returnAddress;
+            while (true)
+            {
+                // Skip the outer unwindings which are inside the frames that
+                // were unwound already
+                while ((outer != null) && ((byte*)outer->framePointer < (byte*)frame))
+                    outer = outer->next;
+
+                if ((outer != null) && (outer->framePointer == frame))
+                {
+                    // The exception left a handler of an outer unwinding.
+                    // Continue it from the frame of the handler
+                    frame = outer->handlerFrame;
+                    returnAddress = outer->handlerReturnAddress;
+                    running = outer->handler;
+                    outer = outer->next;
+                }
+
+                // Stop at the first function which wasn't compiled
+                UnwindFunction* function = findFunction(returnAddress);
+                if (function == null)
+                    break;
+
+                void* functionStart = (void*)function->start;
+                UnwindData* data = function->data;
+                if (data != null)
+                {
+                    void* argument = (void*)frame;
+                    if ((data->flags & UnwindHelperFrame) != 0)
+                        argument = frame->argument;
+
+                    // The clauses until the running handler were left already
+                    UnwindClause* clauses = (UnwindClause*)((byte*)data + sizeof(UnwindData));
+                    uint first = 0;
+                    bool isCleanupLeft = false;
+                    if ((running != null) && (running == data->cleanup))
+                    {
+                        first = data->count;
+                        isCleanupLeft = true;
+                    }
+                    else if (running != null)
+                    {
+                        for (uint i = 0; i < data->count; i++)
+                        {
+                            UnwindClause* clause = (UnwindClause*)((byte*)clauses + i * (uint)sizeof(UnwindClause));
+                            if (clause->handler == running)
+                                first = i + 1;
+                        }
+                    }
+
+                    for (uint i = first; i < data->count; i++)
+                    {
+                        UnwindClause* clause = (UnwindClause*)((byte*)clauses + i * (uint)sizeof(UnwindClause));
+                        byte* start = (byte*)clause + 4 + clause->tryStart;
+                        byte* end = (byte*)clause + 8 + clause->tryEnd;
+                        if ((returnAddress <= start) || (returnAddress > end))
+                            continue;
+
+                        if (clause->type == Filter)
+                        {
+                            // Filter - run filter code. decide to catch or not
+                            Morph.Diagnostics.Debug.Assert(false);
+                        }
+                        else if (clause->type == Catch)
+                        {
+                            if (VirtualTable.virtualTableGetInterfaceLocation(exceptionVtbl, (ushort)clause->exceptionRtti) != 0xFFFFFFFF)
+                            {
+                                // Exception caught! The handler will not
+                                // return, instead it will jump
+                                currentStackPointerRet = (void*)frame;
+                                runHandler(dispatch, clause->handler, argument, frame, returnAddress);
+                            }
+                        }
+                        else
+                        {
+                            // Execute all finallies and faults
+                            runHandler(dispatch, clause->handler, argument, frame, returnAddress);
+                        }
+                    }
+
+                    // And the method cleanup
+                    if ((data->cleanup != null) && (!isCleanupLeft))
+                        runHandler(dispatch, data->cleanup, argument, frame, returnAddress);
+                }
+
+                running = functionStart;
+                returnAddress = frame->returnAddress;
+                frame = frame->next;
+            }
+
+            dispatchStack = dispatch->next;
+            Morph.Imports.free((void*)dispatch);
         }
 
         private unsafe static void* getStackPointerRet()
@@ -147,6 +487,8 @@ namespace clrcore
 
             currentException = exceptionObject;
             void* exceptionVtbl = clrcore.GarbageCollector.garbageCollectorGetVTbl(Morph.Imports.convert(exceptionObject));
+            if (getUnwindTable() != null)
+                unwindFrames(exceptionVtbl);
             while (exceptionStack != null)
             {
                 bool bExecuteHandler = false;
@@ -158,7 +500,7 @@ namespace clrcore
                 }
                 else if (exceptionStack->type == Catch)
                 {
-                    if (VirtualTable.virtualTableGetInterfaceLocation(exceptionVtbl, exceptionStack->exceptionRtti) != 0xFFFFFFFF)
+                    if (VirtualTable.virtualTableGetInterfaceLocation(exceptionVtbl, (ushort)exceptionStack->exceptionRtti) != 0xFFFFFFFF)
                     {
                         // Exception caught!
                         bExecuteHandler = true;
@@ -19,6 +19,17 @@ namespace Morph
             return arr.m_buffer + (index * sizeofElements);
         }
 
+        // The address of an element, calculated once before a loop and moved by the loop counter.
+        // The loop condition reads the array's length right after, so a null array throws here
+        private static unsafe byte* compilerGetArrayCursor(Array arr, uint index, uint sizeofElements)
+        {
+            if (arr == null)
+            {
+                throw new System.NullReferenceException();
+            }
+            return arr.m_buffer + (index * sizeofElements);
+        }
+
         private unsafe Array(void* vtbl, uint numberOfElements)
         {
             m_internalTypeVtbl = vtbl;
@@ -57,25 +57,32 @@ Apartment::Apartment(const CilFormatLayoutPtr& layout,
                      const IMAGE_DATA_DIRECTORY& directory,
                      const DWORD entryPointToken,
                      const ApartmentPtr& mainApartment) :
-    m_layout(layout),
-    m_metaHeader(metadata, directory),
-    // Hopefully the compiler will not ignore the order registered here
-    m_tables(m_metaHeader),
-    m_streams(m_metaHeader),
+    m_image(new ApartmentImage(layout, metadata, directory, entryPointToken)),
     m_objects(NULL),
     m_mainApartment(mainApartment),
     m_unrelatedExternalModules(0),
     m_id(gIdGenerator.increase()),
     m_helperGenerator(0)
 {
-    m_entryPointToken = buildTokenIndex(m_id, entryPointToken);
+    initID();
+}
+
+Apartment::Apartment(const ApartmentImagePtr& image,
+                     const ApartmentPtr& mainApartment) :
+    m_image(image),
+    m_objects(NULL),
+    m_mainApartment(mainApartment),
+    m_unrelatedExternalModules(0),
+    m_id(gIdGenerator.increase()),
+    m_helperGenerator(0)
+{
+    initID();
+}
 
-    // Read the name of the assembly
-    TablePtr asmTablePtr = m_tables.getTableByToken(EncodingUtils::buildToken(TABLE_ASSEMBLY_TABLE, 1)); // 0x20000001
-    CHECK(!asmTablePtr.isEmpty()); // Error module don't have Assembly module (MUST)
-    const AssemblyTable::Header& asmTable = ((AssemblyTable&)(*asmTablePtr)).getHeader();
-    // Read the name from the string
-    m_name = StringReader::readStringName(m_streams.getStringsStream(), asmTable.m_name);
+void Apartment::initID()
+{
+    m_entryPointToken = buildTokenIndex(m_id, m_image->getEntryPointToken());
+    m_name = m_image->getName();
 
     RunnableTrace("Apartment MODULE " << m_id << ": "<< m_name << endl);
 }
@@ -204,17 +211,22 @@ const GlobalContext& Apartment::getObjects() const
 
 const MetadataTables& Apartment::getTables() const
 {
-    return m_tables;
+    return m_image->getTables();
 }
 
 const MSILStreams& Apartment::getStreams() const
 {
-    return m_streams;
+    return m_image->getStreams();
 }
 
 CilFormatLayoutPtr& Apartment::getLayout()
 {
-    return m_layout;
+    return m_image->getLayout();
+}
+
+ApartmentImage& Apartment::getImage()
+{
+    return *m_image;
 }
 
 uint Apartment::getUniqueID() const
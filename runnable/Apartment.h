@@ -51,6 +51,7 @@
 #include "format/CilFormatLayout.h"
 #include "format/MetadataTables.h"
 #include "format/MSILStreams.h"
+#include "runnable/ApartmentImage.h"
 #include "runnable/MemoryLayoutInterface.h"
 
 // Forward deceleration
@@ -87,6 +88,15 @@ public:
               const DWORD entryPointToken,
               const ApartmentPtr& mainApartment);
 
+    /*
+     * Constructor. Construct an apartment over an already parsed module.
+     * The image can be shared with other apartments.
+     *
+     * image - The parsed module. See ApartmentImage
+     */
+    Apartment(const ApartmentImagePtr& image,
+              const ApartmentPtr& mainApartment);
+
     // Free memory
     ~Apartment();
 
@@ -188,6 +198,11 @@ public:
      */
     CilFormatLayoutPtr& getLayout();
 
+    /*
+     * Return the parsed module, which may be shared with other apartments
+     */
+    ApartmentImage& getImage();
+
     /*
      * Return the apartment (current runtime package) ID.
      * Used by the compiler to distinguish different apartments.
@@ -207,16 +222,15 @@ public:
     void setMethodHelperRow(uint initIndex);
 
 private:
+    /*
+     * Set the apartment ID and the entry point. Called by the constructors
+     */
+    void initID();
+
+    // The parsed file: layout, tables and streams
+    ApartmentImagePtr m_image;
     // The DLL/EXE name as inside the Assembly table
     cString m_name;
-    // The file layout
-    CilFormatLayoutPtr m_layout;
-    // The meta-data header for the apartment
-    MetadataHeader m_metaHeader;
-    // The tables of the file
-    MetadataTables m_tables;
-    // The streams of the file
-    MSILStreams m_streams;
     // The objects
     GlobalContext* m_objects;
 
@@ -41,6 +41,7 @@
 #include "format/coreHeadersTypes.h"
 #include "format/CilFormatLayout.h"
 #include "format/pe/CilPeLayout.h"
+#include "format/pe/CilMappedPeLayout.h"
 #include "runnable/ApartmentFactory.h"
 #include "runnable/RunnableTrace.h"
 #include "pe/dosheader.h"
@@ -52,6 +53,14 @@ ApartmentPtr ApartmentFactory::createApartment(cNtHeaderPtr& inputStream,
                                                const cNtDirCli& cliDirectory,
                                                const MemoryLayoutInterface& memoryLayout,
                                                ApartmentPtr& mainApartment)
+{
+    return createApartment(loadImage(inputStream, cliDirectory),
+                           memoryLayout,
+                           mainApartment);
+}
+
+ApartmentImagePtr ApartmentFactory::loadImage(cNtHeaderPtr& inputStream,
+                                              const cNtDirCli& cliDirectory)
 {
     // Generate the layout object
     CilFormatLayoutPtr layoutPtr(new CilPeLayout(inputStream));
@@ -59,12 +68,28 @@ ApartmentPtr ApartmentFactory::createApartment(cNtHeaderPtr& inputStream,
     // Read the entire CLI header
     cNtPrivateDirectory metaData(*inputStream,
                                  cliDirectory.getCoreHeader().MetaData);
+    return ApartmentImagePtr(new ApartmentImage(layoutPtr,
+                                                metaData.getData(),
+                                                metaData.getDirectory(),
+                                                cliDirectory.getCoreHeader().EntryPointToken));
+}
+
+ApartmentImagePtr ApartmentFactory::mapImage(const cString& filename)
+{
+    CilMappedPeLayout* layout = new CilMappedPeLayout(filename);
+    CilFormatLayoutPtr layoutPtr(layout);
+    return ApartmentImagePtr(new ApartmentImage(layoutPtr,
+                                                layout->getMetadataStream(),
+                                                layout->getMetadataDirectory(),
+                                                layout->getEntryPointToken()));
+}
+
+ApartmentPtr ApartmentFactory::createApartment(const ApartmentImagePtr& image,
+                                               const MemoryLayoutInterface& memoryLayout,
+                                               ApartmentPtr& mainApartment)
+{
     // Prepare the apartment
-    ApartmentPtr apartment(new Apartment(layoutPtr,
-                                         metaData.getData(),
-                                         metaData.getDirectory(),
-                                         cliDirectory.getCoreHeader().EntryPointToken,
-                                         mainApartment));
+    ApartmentPtr apartment(new Apartment(image, mainApartment));
     // Init memory
     apartment->init(apartment, memoryLayout);
     RunnableTrace("Created apartment: " << *apartment << endl);
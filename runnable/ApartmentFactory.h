@@ -76,6 +76,33 @@ public:
                                         const MemoryLayoutInterface& memoryLayout,
                                         ApartmentPtr& mainApartment);
 
+    /*
+     * Parse a nt-header image without creating an apartment. The returned
+     * image can be used to create several apartments (e.g. one for each
+     * memory layout), without reading and parsing the module again.
+     */
+    static ApartmentImagePtr loadImage(cNtHeaderPtr& inputStream,
+                                       const cNtDirCli& cliDirectory);
+
+    /*
+     * Map a PE file from the file-system and parse it without creating an
+     * apartment. Unlike loadEXEFile/loadImage the file isn't read into
+     * memory, all the streams read directly from the mapped file.
+     * See CilMappedPeLayout.
+     *
+     * Throw exception if the file cannot be mapped or the fail-format is
+     * invalid
+     */
+    static ApartmentImagePtr mapImage(const cString& filename);
+
+    /*
+     * Generate new apartment object over a parsed image.
+     * See createApartment above.
+     */
+    static ApartmentPtr createApartment(const ApartmentImagePtr& image,
+                                        const MemoryLayoutInterface& memoryLayout,
+                                        ApartmentPtr& mainApartment);
+
     /*
      * Load EXE file from the file-system and generate new nt-header object
      *
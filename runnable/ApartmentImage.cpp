@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+/*
+ * ApartmentImage.cpp
+ *
+ * Implementation file
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "xStl/types.h"
+#include "xStl/os/lock.h"
+#include "xStl/os/xstlLockable.h"
+#include "format/EncodingUtils.h"
+#include "format/tables/TablesID.h"
+#include "format/tables/AssemblyTable.h"
+#include "runnable/ApartmentImage.h"
+#include "runnable/StringReader.h"
+
+ApartmentImage::ApartmentImage(const CilFormatLayoutPtr& layout,
+                               const cMemoryAccesserStreamPtr& metadata,
+                               const IMAGE_DATA_DIRECTORY& directory,
+                               mdToken entryPointToken) :
+    m_layout(layout),
+    m_metaHeader(metadata, directory),
+    // Hopefully the compiler will not ignore the order registered here
+    m_tables(m_metaHeader),
+    m_streams(m_metaHeader),
+    m_entryPointToken(entryPointToken)
+{
+    // Read the name of the assembly
+    TablePtr asmTablePtr = m_tables.getTableByToken(EncodingUtils::buildToken(TABLE_ASSEMBLY_TABLE, 1)); // 0x20000001
+    CHECK(!asmTablePtr.isEmpty()); // Error module don't have Assembly module (MUST)
+    const AssemblyTable::Header& asmTable = ((AssemblyTable&)(*asmTablePtr)).getHeader();
+    // Read the name from the string
+    m_name = StringReader::readStringName(m_streams.getStringsStream(), asmTable.m_name);
+}
+
+const cString& ApartmentImage::getName() const
+{
+    return m_name;
+}
+
+const MetadataTables& ApartmentImage::getTables() const
+{
+    return m_tables;
+}
+
+const MSILStreams& ApartmentImage::getStreams() const
+{
+    return m_streams;
+}
+
+CilFormatLayoutPtr& ApartmentImage::getLayout()
+{
+    return m_layout;
+}
+
+mdToken ApartmentImage::getEntryPointToken() const
+{
+    return m_entryPointToken;
+}
+
+const MSILInstructions* ApartmentImage::getMethodInstructions(mdToken methodToken) const
+{
+    cLock lock(m_lock);
+    if (!m_instructions.hasKey(methodToken))
+        return NULL;
+    return m_instructions[methodToken].getPointer();
+}
+
+const MSILInstructions& ApartmentImage::storeMethodInstructions(mdToken methodToken,
+                                                               const MSILInstructionsPtr& instructions)
+{
+    cLock lock(m_lock);
+    if (!m_instructions.hasKey(methodToken))
+        m_instructions.append(methodToken, instructions);
+    return *m_instructions[methodToken];
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#ifndef __TBA_CLR_RUNNABLE_APARTMENTIMAGE_H
+#define __TBA_CLR_RUNNABLE_APARTMENTIMAGE_H
+
+/*
+ * ApartmentImage.h
+ *
+ * The parsed content of a single module (EXE/DLL) which doesn't depend on the
+ * compilation target: the file layout, the metadata tables, the streams and
+ * the decoded methods' MSIL.
+ *
+ * Author: Elad Raz <e@eladraz.com>
+ */
+#include "xStl/types.h"
+#include "xStl/os/xstlLockable.h"
+#include "xStl/data/hash.h"
+#include "xStl/data/string.h"
+#include "xStl/data/smartptr.h"
+#include "format/coreHeadersTypes.h"
+#include "format/metadataHeader.h"
+#include "format/CilFormatLayout.h"
+#include "format/MetadataTables.h"
+#include "format/MSILStreams.h"
+#include "format/MSILInstructions.h"
+
+/*
+ * The parsed content of a single module.
+ *
+ * An image can be shared between several apartments, for example when the
+ * same modules are compiled for different targets (and different memory
+ * layouts). Each apartment keeps its own GlobalContext, the image is never
+ * changed after it's constructed except the decoded MSIL cache.
+ *
+ * Usage:
+ *       ApartmentImagePtr image(ApartmentFactory::loadImage(ntFile, cliDirectory));
+ *       ApartmentPtr x86(ApartmentFactory::createApartment(image, x86Layout, ...));
+ *       ApartmentPtr arm(ApartmentFactory::createApartment(image, armLayout, ...));
+ *
+ * NOTE: This class is thread-safe.
+ */
+class ApartmentImage {
+public:
+    /*
+     * Constructor. Parse the metadata of a module
+     *
+     * layout - The layout for the file
+     * metadata - The ~ stream
+     * directory - The directory information for the ~ stream
+     * entryPointToken - The entry point of the module, or 0
+     */
+    ApartmentImage(const CilFormatLayoutPtr& layout,
+                   const cMemoryAccesserStreamPtr& metadata,
+                   const IMAGE_DATA_DIRECTORY& directory,
+                   mdToken entryPointToken);
+
+    /*
+     * Return the DLL/EXE name as inside the Assembly table
+     */
+    const cString& getName() const;
+
+    /*
+     * Return the file's tables
+     */
+    const MetadataTables& getTables() const;
+
+    /*
+     * Return the file's streams
+     */
+    const MSILStreams& getStreams() const;
+
+    /*
+     * Return the layout object
+     */
+    CilFormatLayoutPtr& getLayout();
+
+    /*
+     * Return the entry point token as written in the CLI header
+     */
+    mdToken getEntryPointToken() const;
+
+    /*
+     * Return the decoded body of a method, or NULL if the method wasn't
+     * decoded yet.
+     *
+     * methodToken - The method token inside this image
+     */
+    const MSILInstructions* getMethodInstructions(mdToken methodToken) const;
+
+    /*
+     * Store a decoded method body, so other apartments which share this image
+     * will not decode it again.
+     *
+     * methodToken  - The method token inside this image
+     * instructions - The decoded body
+     *
+     * Return the cached body. If another thread stored the method first, the
+     * previously stored body is returned.
+     */
+    const MSILInstructions& storeMethodInstructions(mdToken methodToken,
+                                                    const MSILInstructionsPtr& instructions);
+
+private:
+    // Deny copy-constructor and operator =
+    ApartmentImage(const ApartmentImage& other);
+    ApartmentImage& operator = (const ApartmentImage& other);
+
+    // The DLL/EXE name as inside the Assembly table
+    cString m_name;
+    // The file layout
+    CilFormatLayoutPtr m_layout;
+    // The meta-data header for the image
+    MetadataHeader m_metaHeader;
+    // The tables of the file
+    MetadataTables m_tables;
+    // The streams of the file
+    MSILStreams m_streams;
+    // The entry point token
+    mdToken m_entryPointToken;
+
+    // The decoded methods, protected by m_lock
+    mutable cXstlLockable m_lock;
+    cHash<mdToken, MSILInstructionsPtr> m_instructions;
+};
+
+// The reference-object pointer
+typedef cSmartPtr<ApartmentImage> ApartmentImagePtr;
+
+#endif // __TBA_CLR_RUNNABLE_APARTMENTIMAGE_H
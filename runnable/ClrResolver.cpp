@@ -102,11 +102,10 @@ void ClrResolver::readMethodSignatureAndNames(ApartmentPtr& apartment,
     methodNamespace = StringReader::readStringName(*stringStream, method_namespace_index);
 
     // Read signature.
-    cForkStreamPtr blobStream = apartment->getStreams().getBlobStream()->fork();
-    blobStream->seek(methodSignatureIndex, basicInput::IO_SEEK_SET);
     XSTL_TRY
     {
-        methodSignature = MethodDefOrRefSignaturePtr(new MethodDefOrRefSignature(*blobStream, apartment->getUniqueID(),
+        methodSignature = MethodDefOrRefSignaturePtr(new MethodDefOrRefSignature(apartment->getStreams().getBlob(methodSignatureIndex),
+                                                                                 apartment->getUniqueID(),
                                                                                  apartment->getObjects().getTypedefRepository()));
     }
     XSTL_CATCH_ALL
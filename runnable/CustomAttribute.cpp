@@ -122,11 +122,10 @@ CustomAttributePtr CustomAttribute::factory(mdToken owner,
     cString customAttributeName = StringReader::readStringName(apartment.getStreams().getStringsStream(), ctorMethodTypeTable.getName());
     CustomAttributePtr cAttribPtr = CustomAttributePtr(new CustomAttribute(customAttributeName));
 
-    cForkStreamPtr blob = caApartment.getStreams().getBlobStream()->fork();
-    blob->seek(customAttributeTable.getBlobIndex(), basicInput::IO_SEEK_SET);
+    ByteCursor blob = caApartment.getStreams().getBlob(customAttributeTable.getBlobIndex());
 
     // Create CustomAtribbuteValues (a container class that helps parsing ca values).
-    mdToken cavLength = EncodingUtils::readCompressedNumber(*blob);
+    mdToken cavLength = EncodingUtils::readCompressedNumber(blob);
     CustomAttributeValuesPtr customAttribValuesPtr = CustomAttributeValuesPtr(new CustomAttributeValues(blob, cavLength));
 
     // Read ctor signature to get the types of arguments.
@@ -150,7 +149,7 @@ CustomAttributePtr CustomAttribute::factory(mdToken owner,
         {
         case ELEMENT_TYPE_STRING:
             {
-                mdToken strLength = EncodingUtils::readCompressedNumber(*blob);
+                mdToken strLength = customAttribValuesPtr->getNextCompressedNumber();
                 cBuffer buffer = cBuffer(strLength + 1);
                 customAttribValuesPtr->getNextValue(buffer.getBuffer(), strLength);
                 buffer[strLength] = '\0';
@@ -273,12 +272,27 @@ CustomAttributeValues::CustomAttributeValues(cForkStreamPtr streamPtr, mdToken l
     testValidity();
 }
 
-void CustomAttributeValues::testValidity(void) const
+CustomAttributeValues::CustomAttributeValues(const ByteCursor& blob, mdToken length):
+    m_cursor(blob),
+    m_lengthLeft(length)
+{
+    // Never read beyond the attribute blob
+    if (m_cursor.getRemaining() > length)
+        m_cursor = m_cursor.readCursor(length);
+    testValidity();
+}
+
+void CustomAttributeValues::testValidity(void)
 {
     uint16 prolog;
-    // XXX: FIX THIS.
-    basicInput * bi = (basicInput *) m_stream.getPointer();
-    bi->streamReadUint16(prolog);
+    if (m_stream.isEmpty()) {
+        if (m_cursor.getRemaining() < sizeof(prolog)) {
+            XSTL_THROW(Invalid);
+        }
+        prolog = m_cursor.readUint16();
+    } else {
+        m_stream->streamReadUint16(prolog);
+    }
     if (prolog != m_prologSignature) {
         XSTL_THROW(Invalid);
     }
@@ -287,16 +301,35 @@ void CustomAttributeValues::testValidity(void) const
 void CustomAttributeValues::getNextValue(void * buffer, uint size)
 {
     uint read = 0;
-    basicInput * bi = (basicInput *) m_stream.getPointer();
 
     if (size > m_lengthLeft) {
         XSTL_THROW(OutOfBounds);
     }
 
-    read = bi->pipeRead(buffer, size);
-    if (read != size) {
-        XSTL_THROW(EndOfStream);
+    if (m_stream.isEmpty()) {
+        if (size > m_cursor.getRemaining()) {
+            XSTL_THROW(EndOfStream);
+        }
+        m_cursor.read(buffer, size);
+        read = size;
+    } else {
+        read = m_stream->pipeRead(buffer, size);
+        if (read != size) {
+            XSTL_THROW(EndOfStream);
+        }
     }
 
     m_lengthLeft -= read;
 }
+
+uint CustomAttributeValues::getNextCompressedNumber(void)
+{
+    if (!m_stream.isEmpty())
+        return EncodingUtils::readCompressedNumber(*m_stream);
+
+    uint position = m_cursor.getPosition();
+    uint ret = m_cursor.readCompressedNumber();
+    uint consumed = m_cursor.getPosition() - position;
+    m_lengthLeft = (consumed > m_lengthLeft) ? 0 : (m_lengthLeft - consumed);
+    return ret;
+}
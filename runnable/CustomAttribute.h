@@ -42,6 +42,7 @@
 #include "runnable/Apartment.h"
 #include "runnable/CustomAttributeArgument.h"
 
+#include "format/ByteCursor.h"
 #include "format/tables/MethodTable.h"
 #include "format/tables/CustomAttributeTable.h"
 #include "format/tables/TypedefTable.h"
@@ -122,8 +123,21 @@ class CustomAttributeValues
 {
 public:
     CustomAttributeValues(cForkStreamPtr streamPtr, mdToken length);
+
+    /*
+     * Read the values directly from the #Blob heap. 'blob' points right after
+     * the compressed length of the custom attribute blob.
+     * See MSILStreams::getBlob
+     */
+    CustomAttributeValues(const ByteCursor& blob, mdToken length);
+
     void getNextValue(void * buffer, uint size);
 
+    /*
+     * Read a compressed number (e.g. the length of a SerString)
+     */
+    uint getNextCompressedNumber(void);
+
     /*
      * On constructor, Invalid is thrown if CAV is invalid.
      */
@@ -155,10 +169,12 @@ public:
 
 private:
     const static uint16 m_prologSignature = 0x0001;
+    // Either m_stream or m_cursor is used
     cForkStreamPtr m_stream;
+    ByteCursor m_cursor;
     uint32 m_lengthLeft;
 
-    void testValidity(void) const;
+    void testValidity(void);
 };
 
 #endif // __TBA_CLR_FORMAT_CUSTOM_ATTRIBUTE_H
\ No newline at end of file
@@ -85,6 +85,8 @@ FrameworkMethods::FrameworkMethods()
     InitMethod(THROW_INDEX,            gFrameworkNamespace, gFrameworkExceptionClassname, "throwException", FRAMEWORK_INTERNAL_THROW);
     InitMethod(CURRENT_EXCEPTION_INDEX,gFrameworkNamespace, gFrameworkExceptionClassname, "getCurrentException", FRAMEWORK_INTERNAL_CURRENT_EXCEPTION);
     InitMethod(CURRENT_STACK_RET_INDEX,gFrameworkNamespace, gFrameworkExceptionClassname, "getStackPointerRet", FRAMEWORK_INTERNAL_CURRENT_STACK_RET);
+    InitMethod(REGISTER_FRAME_ROUTINE_INDEX, gFrameworkNamespace, gFrameworkExceptionClassname, "registerFrameRoutine", FRAMEWORK_INTERNAL_REGISTER_FRAME_ROUTINE);
+    InitMethod(REGISTER_FRAME_CATCH_INDEX,   gFrameworkNamespace, gFrameworkExceptionClassname, "registerFrameCatch", FRAMEWORK_INTERNAL_REGISTER_FRAME_CATCH);
 
     InitMethod(GETIFACELOC_INDEX,   gFrameworkNamespace, gFrameworkVirtualTableClassname, "virtualTableGetInterfaceLocation", FRAMEWORK_INTERNAL_GET_IFACE_LOC);
     InitMethod(ISINSTANCE_INDEX,    gFrameworkNamespace, gFrameworkVirtualTableClassname, "virtualTableIsInstance", FRAMEWORK_INTERNAL_IS_INSTANCE);
@@ -93,6 +95,7 @@ FrameworkMethods::FrameworkMethods()
     InitMethod(INSTANCE_STRING_INDEX, CorlibNames::gCoreNamespace, CorlibNames::m_classString, "compilerInstanceNewString", FRAMEWORK_INTERNAL_INSTANCE_STRING);
     InitMethod(INSTANCE_ARRAY1_INDEX, CorlibNames::gCoreNamespace, CorlibNames::m_classArray,  "compilerInstanceNewArray1", FRAMEWORK_INTERNAL_INSTANCE_ARRAY_1);
     InitMethod(GET_ARRAY_BUFFER,      CorlibNames::gCoreNamespace, CorlibNames::m_classArray,  "compilerGetArrayOffset",    FRAMEWORK_INTERNAL_GET_ARRAY_OFFSET);
+    InitMethod(GET_ARRAY_CURSOR,      CorlibNames::gCoreNamespace, CorlibNames::m_classArray,  "compilerGetArrayCursor",    FRAMEWORK_INTERNAL_GET_ARRAY_CURSOR);
 
     InitMethod(BIN32_DIV,  gFrameworkNamespace, gFrameworkBinaryOperations, "bin32div", FRAMEWORK_INTERNAL_BIT32_DIV);
     InitMethod(BIN32_REM,  gFrameworkNamespace, gFrameworkBinaryOperations, "bin32rem", FRAMEWORK_INTERNAL_BIT32_REM);
@@ -263,6 +266,16 @@ const TokenIndex& FrameworkMethods::getCurrentStackPointerRet() const
     return m_methods[CURRENT_STACK_RET_INDEX].methodToken;
 }
 
+const TokenIndex& FrameworkMethods::getRegisterFrameRoutine() const
+{
+    return m_methods[REGISTER_FRAME_ROUTINE_INDEX].methodToken;
+}
+
+const TokenIndex& FrameworkMethods::getRegisterFrameCatch() const
+{
+    return m_methods[REGISTER_FRAME_CATCH_INDEX].methodToken;
+}
+
 
 const TokenIndex& FrameworkMethods::getIfaceLoc() const
 {
@@ -294,6 +307,11 @@ const TokenIndex& FrameworkMethods::getArrayBuffer() const
     return m_methods[GET_ARRAY_BUFFER].methodToken;
 }
 
+const TokenIndex& FrameworkMethods::getArrayCursor() const
+{
+    return m_methods[GET_ARRAY_CURSOR].methodToken;
+}
+
 const TokenIndex& FrameworkMethods::getBin32Div() const
 {
     return m_methods[BIN32_DIV].methodToken;
@@ -493,6 +511,23 @@ MethodDefOrRefSignaturePtr FrameworkMethods::getFrameworkSignature(
         args.changeSize(0);
         returnType = ConstElements::gVoidPtr;
         break;
+    case FRAMEWORK_INTERNAL_REGISTER_FRAME_ROUTINE:
+        // void registerFrameRoutine(void* frameEntry, uint type, void* handler, void* stackPointer)
+        args.changeSize(4);
+        args[0] = ConstElements::gVoidPtr;
+        args[1] = ConstElements::gU4;
+        args[2] = ConstElements::gVoidPtr;
+        args[3] = ConstElements::gVoidPtr;
+        break;
+    case FRAMEWORK_INTERNAL_REGISTER_FRAME_CATCH:
+        // void registerFrameCatch(void* frameEntry, ushort exceptionRtti, void* handler, void* stackPointer, void* stackPointerRet)
+        args.changeSize(5);
+        args[0] = ConstElements::gVoidPtr;
+        args[1] = ConstElements::gU2;
+        args[2] = ConstElements::gVoidPtr;
+        args[3] = ConstElements::gVoidPtr;
+        args[4] = ConstElements::gVoidPtr;
+        break;
 
     case FRAMEWORK_INTERNAL_GET_IFACE_LOC:
         // uint virtualTableGetInterfaceLocation(void* parentvTbl, ushort childRtti)
@@ -537,6 +572,8 @@ MethodDefOrRefSignaturePtr FrameworkMethods::getFrameworkSignature(
 
     case FRAMEWORK_INTERNAL_GET_ARRAY_OFFSET:
         // static unsafe byte* compilerGetArrayOffset(Array arr, uint index, uint sizeofElements)
+    case FRAMEWORK_INTERNAL_GET_ARRAY_CURSOR:
+        // static unsafe byte* compilerGetArrayCursor(Array arr, uint index, uint sizeofElements)
         args.changeSize(3);
         args[0] = ConstElements::gVoidArray;
         args[1] = ConstElements::gU;
@@ -91,6 +91,8 @@ public:
     const TokenIndex& getThrowException() const;
     const TokenIndex& getCurrentException() const;
     const TokenIndex& getCurrentStackPointerRet() const;
+    const TokenIndex& getRegisterFrameRoutine() const;
+    const TokenIndex& getRegisterFrameCatch() const;
 
     /*
      * Return the token for "MethodXXX" virtual table functions
@@ -105,6 +107,7 @@ public:
     const TokenIndex& instanceString() const;
     const TokenIndex& instanceArray1() const;
     const TokenIndex& getArrayBuffer() const;
+    const TokenIndex& getArrayCursor() const;
     const TokenIndex& getBin32Div() const;
     const TokenIndex& getBin32Rem() const;
     const TokenIndex& getBin32uDiv() const;
@@ -194,6 +197,10 @@ public:
         FRAMEWORK_INTERNAL_CURRENT_EXCEPTION = 0xFFDEAD26,
         //public static Morph.Exception getCurrentStackPointerRet()
         FRAMEWORK_INTERNAL_CURRENT_STACK_RET = 0xFFDEAD27,
+        //private unsafe static void registerFrameRoutine(void* frameEntry, uint type, void* handler, void* stackPointer)
+        FRAMEWORK_INTERNAL_REGISTER_FRAME_ROUTINE = 0xFFDEAD28,
+        //private unsafe static void registerFrameCatch(void* frameEntry, ushort exceptionRtti, void* handler, void* stackPointer, void* stackPointerRet)
+        FRAMEWORK_INTERNAL_REGISTER_FRAME_CATCH = 0xFFDEAD29,
 
         //private unsafe static uint virtualTableGetInterfaceLocation(void* parentvTbl, ushort rtti)
         FRAMEWORK_INTERNAL_GET_IFACE_LOC = 0xFFDEAD30,
@@ -208,6 +215,8 @@ public:
         FRAMEWORK_INTERNAL_INSTANCE_ARRAY_1 = 0xFFDEAD41,
         // static unsafe byte* compilerGetArrayOffset(Array arr)
         FRAMEWORK_INTERNAL_GET_ARRAY_OFFSET = 0xFFDEAD42,
+        // static unsafe byte* compilerGetArrayCursor(Array arr, uint index, uint sizeofElements)
+        FRAMEWORK_INTERNAL_GET_ARRAY_CURSOR = 0xFFDEAD43,
 
         //public static int getBit32Div(int a, int b)
         FRAMEWORK_INTERNAL_BIT32_DIV = 0xFFCEAE00,
@@ -258,6 +267,16 @@ public:
         EXCEPTION_ROUTINE_FILTER,
     };
 
+    /*
+     * The size, in stack words, of an entry in the runtime exception stack.
+     * See clrcore.ExceptionHandling.Entry.
+     *
+     * Methods reserve this space inside their frame for each registered entry
+     * and pass it to registerFrameRoutine/registerFrameCatch, so registration
+     * doesn't allocate memory.
+     */
+    enum { EXCEPTION_ENTRY_WORDS = 8 };
+
     /*
      * Translates a .NET clause flags (from the method header) to a CLR runtime exception stack entry type
      */
@@ -290,6 +309,8 @@ private:
         THROW_INDEX,
         CURRENT_EXCEPTION_INDEX,
         CURRENT_STACK_RET_INDEX,
+        REGISTER_FRAME_ROUTINE_INDEX,
+        REGISTER_FRAME_CATCH_INDEX,
 
         GETIFACELOC_INDEX,
         ISINSTANCE_INDEX,
@@ -298,6 +319,7 @@ private:
         INSTANCE_STRING_INDEX,
         INSTANCE_ARRAY1_INDEX,
         GET_ARRAY_BUFFER,
+        GET_ARRAY_CURSOR,
 
         BIN32_DIV,
         BIN32_REM,
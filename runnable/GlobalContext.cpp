@@ -113,6 +113,16 @@ StringRepository& GlobalContext::getStringRepository()
     return *m_stringRepository;
 }
 
+cHash<TokenIndex, cBuffer>& GlobalContext::getInlineCodeCache()
+{
+    return m_inlineCode;
+}
+
+cXstlLockable& GlobalContext::getInlineCodeLock()
+{
+    return m_inlineCodeLock;
+}
+
 const TypesNameRepository& GlobalContext::getTypesNameRepository() const
 {
     ASSERT(m_typesNameRepository != NULL);
@@ -39,6 +39,9 @@
  */
 #include "xStl/types.h"
 #include "xStl/data/counter.h"
+#include "xStl/data/hash.h"
+#include "xStl/data/datastream.h"
+#include "xStl/os/xstlLockable.h"
 #include "runnable/Apartment.h"
 #include "runnable/ResolverInterface.h"
 #include "runnable/GlobalContext.h"
@@ -73,6 +76,16 @@ public:
     StringRepository& getStringRepository();
     const StringRepository& getStringRepository() const;
 
+    /*
+     * [Singleton per main apartment] The code of every MethodDef which was
+     * checked by MethodInliner::getInlineCode. Methods which cannot be inlined
+     * are stored with an empty buffer.
+     *
+     * NOTE: Access the cache only while holding getInlineCodeLock()
+     */
+    cHash<TokenIndex, cBuffer>& getInlineCodeCache();
+    cXstlLockable& getInlineCodeLock();
+
 private:
     // Only apartment can instance and access this fields
     friend class Apartment;
@@ -111,6 +124,9 @@ private:
     StringRepository* m_stringRepository;
     // Memory layout
     const MemoryLayoutInterface* m_memoryLayout;
+    // See getInlineCodeCache
+    cHash<TokenIndex, cBuffer> m_inlineCode;
+    cXstlLockable m_inlineCodeLock;
 };
 
 #endif // __TBA_CLR_RUNNABLE_GLOBALCONTEXT_H
@@ -54,7 +54,8 @@
 MethodRunnable::MethodRunnable(const ApartmentPtr& apartment) :
     m_apartment(apartment),
     m_emptyImpl(false),
-    m_methodToken(ElementType::UnresolvedTokenIndex)
+    m_methodToken(ElementType::UnresolvedTokenIndex),
+    m_instructions(NULL)
 {
 }
 
@@ -106,10 +107,8 @@ void MethodRunnable::loadMethod(mdToken methodToken)
     m_fullMethodName = _namespace + "." + _name + "." + methodName;
 
     // (Re)Read the method signature
-    cForkStreamPtr blob = m_apartment->getStreams().getBlobStream()->fork();
-    blob->seek(methodTable.getHeader().m_signature, basicInput::IO_SEEK_SET);
     m_methodSignature = MethodDefOrRefSignaturePtr(new
-                                MethodDefOrRefSignature(*blob,
+                                MethodDefOrRefSignature(m_apartment->getStreams().getBlob(methodTable.getHeader().m_signature),
                                                         m_apartment->getUniqueID(),
                                                         m_apartment->getObjects().getTypedefRepository()));
 
@@ -140,9 +139,8 @@ void MethodRunnable::loadMethod(mdToken methodToken)
             CHECK(!localSignature.isEmpty());
             CHECK(localSignature->getIndex() == TABLE_STANDALONGESIG_TABLE);
             StandAloneSigTable& sig = (StandAloneSigTable&)(*localSignature);
-            // NOTE: Only this thread can access m_context!
-            blob->seek(sig.getBlobIndex(), basicInput::IO_SEEK_SET);
-            LocalVarSignature localsSignature(*blob, m_apartment->getUniqueID(),
+            LocalVarSignature localsSignature(m_apartment->getStreams().getBlob(sig.getBlobIndex()),
+                                              m_apartment->getUniqueID(),
                                               m_apartment->getObjects().getTypedefRepository());
 
             // Generate a list of locals.
@@ -186,6 +184,30 @@ MethodHeader& MethodRunnable::getMethodHeader()
     return *m_methodHeader;
 }
 
+const MSILInstructions& MethodRunnable::getInstructions()
+{
+    CHECK(!m_emptyImpl);
+    if (m_instructions == NULL)
+    {
+        // The method might be decoded already by another apartment which
+        // shares the same image (e.g. another compilation target)
+        ApartmentImage& image = m_apartment->getImage();
+        mdToken methodToken = getTokenID(m_methodToken);
+        m_instructions = image.getMethodInstructions(methodToken);
+        if (m_instructions == NULL)
+        {
+            cForkStreamPtr stream = m_streamPointer->fork();
+            stream->seek(getMethodStreamStartAddress(), basicInput::IO_SEEK_SET);
+            cBuffer methodData;
+            stream->pipeRead(methodData, m_methodHeader->getFunctionLength());
+            m_instructions = &image.storeMethodInstructions(methodToken,
+                MSILInstructionsPtr(new MSILInstructions(methodData.getBuffer(),
+                                                         methodData.getSize())));
+        }
+    }
+    return *m_instructions;
+}
+
 const MethodDefOrRefSignature& MethodRunnable::getMethodSignature() const
 {
     // Exception will be thrown if 'm_methodSignature' is null
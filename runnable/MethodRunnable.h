@@ -46,6 +46,7 @@
 #include "format/coreHeadersTypes.h"
 #include "data/ElementType.h"
 #include "format/methodHeader.h"
+#include "format/MSILInstructions.h"
 #include "format/tables/Table.h"
 #include "format/tables/MethodTable.h"
 #include "format/signatures/MethodDefOrRefSignature.h"
@@ -106,6 +107,15 @@ public:
      */
     MethodHeader& getMethodHeader();
 
+    /*
+     * Return the decoded instructions of the method body. The body is read
+     * and decoded on the first call, and shared by all the passes over the
+     * method (signing, block-split scanning and compilation).
+     *
+     * Throw exception if the method is empty. See isEmptyMethod()
+     */
+    const MSILInstructions& getInstructions();
+
     /*
      * Returns the method signature
      *
@@ -166,6 +176,10 @@ protected:
     // The locals
     ElementsArrayType m_locals;
 
+    // The decoded method body, owned by the apartment's image.
+    // See getInstructions()
+    const MSILInstructions* m_instructions;
+
     // Set to true if the method is not implemented (e.g. extern method)
     bool m_emptyImpl;
 };
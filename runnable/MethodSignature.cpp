@@ -54,6 +54,7 @@
 #include "runnable/MethodSignature.h"
 #include "compiler/CompilerEngine.h"
 #include "compiler/CallingConvention.h"
+#include "compiler/MethodInliner.h"
 
 class MethodScanAndSignDependencies : public MSILScanInterface
 {
@@ -115,18 +116,11 @@ cBuffer MethodSignature::getMethodSignature(ApartmentPtr& mainApartment,
     // Update method data (Only for non-interface methods)
     if (!methodRunnable.isEmptyMethod())
     {
-        cForkStreamPtr stream = methodRunnable.getStreamPointer()->fork();
-        stream->seek(methodRunnable.getMethodStreamStartAddress(),
-                     basicInput::IO_SEEK_SET);
-        cBuffer methodData;
-        stream->pipeRead(methodData, methodRunnable.getMethodHeader().getFunctionLength());
-        crc64.updateStream(methodData);
-        // Start parsing MSIL opcodes and check for dependencies inside the code
-        const uint8* msil = methodData.getBuffer();
-        const uint size = methodData.getSize();
-
+        const MSILInstructions& instructions = methodRunnable.getInstructions();
+        crc64.updateStream(instructions.getCode());
+        // Check for dependencies inside the code
         MethodScanAndSignDependencies scanner(mainApartment, getApartmentID(methodRunnable.getMethodToken()), crc64);
-        scanner.scanMSIL(msil, size);
+        scanner.scanMSIL(instructions);
     }
 
     return crc64.digest();
@@ -159,6 +153,10 @@ void MethodScanAndSignDependencies::hashToken(ApartmentPtr& mainApartment,
         {
             MethodDefOrRefSignaturePtr methodSignature = CallingConvention::readMethodSignature(apartment, token);
             methodSignature->hashSignature(digest, resolver);
+
+            // The code of a method which might be inlined is part of the caller
+            if (EncodingUtils::getTokenTableIndex(token) == TABLE_METHOD_TABLE)
+                digest.updateStream(MethodInliner::getInlineCode(mainApartment, t));
         }
         break;
 /*
@@ -203,10 +201,12 @@ void MethodScanAndSignDependencies::hashToken(ApartmentPtr& mainApartment,
         break;
 */
     case 0x70: // string
-        // Add string and get length
-        digest.update(mainApartment->getObjects().getStringRepository().getAsciiStringRepository().getBuffer() +
-                      mainApartment->getObjects().getStringRepository().getStringOffset(t),
-                      mainApartment->getObjects().getStringRepository().getStringLength(t));
+        {
+            // Add the string content. The offset isn't fixed while compiling
+            cString str(mainApartment->getObjects().getStringRepository().getString(t));
+            cSArray<char> ascii = str.getASCIIstring();
+            digest.update(ascii.getBuffer(), str.length());
+        }
         break;
 
     default:
@@ -63,19 +63,79 @@ StringRepository::StringRepository(const ApartmentPtr& apartment,
                                    const MemoryLayoutInterface& memoryLayoutInterface) :
     m_apartment(apartment),
     m_memoryLayout(memoryLayoutInterface),
-    m_asciiStringRepository((uint)0, PAGE_SIZE),
-    m_unicodeStringRepository((uint)0, sizeof(unichar) * PAGE_SIZE)
+    m_shouldMergeTails(false),
+    m_isTailsMerged(false),
+    m_asciiStringRepository((uint)0, PAGE_SIZE)
 {
 }
 
-const cBuffer& StringRepository::getAsciiStringRepository() const
+StringRepository::StoredString::StoredString() :
+    m_asciiOffset(0),
+    m_root(ElementType::UnresolvedTokenIndex),
+    m_rootOffset(0)
+{
+}
+
+StringRepository::StoredString::StoredString(const cString& string, uint asciiOffset) :
+    m_string(string),
+    m_asciiOffset(asciiOffset),
+    m_root(ElementType::UnresolvedTokenIndex),
+    m_rootOffset(0)
 {
-    return m_asciiStringRepository;
 }
 
-const cBuffer& StringRepository::getUnicodeStringRepository() const
+/*
+ * Compare two strings by their reversed content. Return a negative number if
+ * 'a' is sorted before 'b', 0 if they are equal and a positive number
+ * otherwise. A string is sorted right before the strings which end with it.
+ */
+static int compareReversed(const cString& a, const cString& b)
 {
-    return m_unicodeStringRepository;
+    uint alength = a.length();
+    uint blength = b.length();
+    const character* abuffer = a.getBuffer();
+    const character* bbuffer = b.getBuffer();
+    for (uint i = 0; (i < alength) && (i < blength); i++)
+    {
+        character ac = abuffer[alength - 1 - i];
+        character bc = bbuffer[blength - 1 - i];
+        if (ac != bc)
+            return (ac < bc) ? -1 : 1;
+    }
+    return (int)alength - (int)blength;
+}
+
+/*
+ * Return true if 'tail' is the end of 'str'
+ */
+static bool isTail(const cString& tail, const cString& str)
+{
+    uint tlength = tail.length();
+    uint slength = str.length();
+    if (tlength > slength)
+        return false;
+
+    const character* tbuffer = tail.getBuffer();
+    const character* sbuffer = str.getBuffer() + slength - tlength;
+    for (uint i = 0; i < tlength; i++)
+    {
+        if (tbuffer[i] != sbuffer[i])
+            return false;
+    }
+    return true;
+}
+
+void StringRepository::setTailMerging(bool shouldMergeTails)
+{
+    cLock lock(m_lock);
+    m_shouldMergeTails = shouldMergeTails;
+}
+
+const cBuffer& StringRepository::getAsciiStringRepository()
+{
+    cLock lock(m_lock);
+    lockMergeTails();
+    return m_asciiStringRepository;
 }
 
 /*
@@ -104,9 +164,17 @@ uint StringRepository::getStringOffset(const TokenIndex& stringToken)
 {
     cLock lock(m_lock);
     lockAppendString(stringToken);
+    lockMergeTails();
     return stringRepoStringOffset(m_asciiStringTable[stringToken]);
 }
 
+cString StringRepository::getString(const TokenIndex& stringToken)
+{
+    cLock lock(m_lock);
+    lockAppendString(stringToken);
+    return m_storedStrings[m_stringOwners[stringToken].m_a].m_string;
+}
+
 cString StringRepository::serializeString(const TokenIndex& stringToken)
 {
     cString relocationTokenName(gCILStringPrefix);
@@ -164,28 +232,11 @@ bool StringRepository::deserializeStringA(const cString& dependency,
 
     cLock lock(m_lock);
     lockAppendString(stringToken);
+    lockMergeTails();
     stringOffset = stringRepoStringOffset(m_asciiStringTable[stringToken]);
     return true;
 }
 
-
-bool StringRepository::deserializeStringU(const cString& dependency,
-                                          uint& stringOffset,
-                                          TokenIndex* tokenIndex)
-{
-    TokenIndex stringToken = getToken(dependency);
-    if (stringToken == ElementType::UnresolvedTokenIndex)
-        return false;
-
-    if (tokenIndex)
-        *tokenIndex = stringToken;
-
-    cLock lock(m_lock);
-    lockAppendString(stringToken);
-    stringOffset = stringRepoStringOffset(m_unicodeStringTable[stringToken]);
-    return true;
-}
-
 void StringRepository::lockAppendString(const TokenIndex& stringToken)
 {
     if (m_asciiStringTable.hasKey(stringToken))
@@ -202,22 +253,149 @@ void StringRepository::lockAppendString(const TokenIndex& stringToken)
 
 void StringRepository::lockAppendString(const cString& str, const TokenIndex& stringToken)
 {
-    // Get length of string.
+    if (m_asciiStringTable.hasKey(stringToken))
+        return;
+
+    // Share the content of an identical string
+    if (!m_stringsPool.hasKey(str))
+        lockStoreString(str, stringToken);
+    cDualElement<TokenIndex,uint> owner = m_stringsPool[str];
+    const StoredString& stored = m_storedStrings[owner.m_a];
+
     uint alength = str.length();
-    uint ulength = alength * sizeof(unichar);
-    uint apos = m_asciiStringRepository.getSize();
-    uint upos = m_unicodeStringRepository.getSize();
+    m_stringOwners.append(stringToken, owner);
+    m_asciiStringTable.append(stringToken,
+        cDualElement<uint,uint>(stored.m_asciiOffset + owner.m_b, alength));
+}
 
-    cSArray<unichar> uarr = str.getUnicodeString();
-    cSArray<char>    aarr = str.getASCIIstring();
+void StringRepository::lockStoreString(const cString& str, const TokenIndex& stringToken)
+{
+    StoredString stored(str, lockAppendAscii(str));
+    m_storedStrings.append(stringToken, stored);
+    m_storedOrder.append(stringToken);
 
+    // Add the string into the pool
+    m_stringsPool.append(str, cDualElement<TokenIndex,uint>(stringToken, 0));
+}
+
+uint StringRepository::lockAppendAscii(const cString& str)
+{
+    // Get length of string.
+    uint alength = str.length();
+    uint apos = m_asciiStringRepository.getSize();
+    cSArray<char> aarr = str.getASCIIstring();
 
     // Append and remove the null-terminate string
     m_asciiStringRepository.changeSize(apos + m_memoryLayout.align(alength));       // Align!
-    m_unicodeStringRepository.changeSize(upos + m_memoryLayout.align(ulength));     // Align!
     cOS::memcpy(m_asciiStringRepository.getBuffer() + apos, aarr.getBuffer(), alength);
-    cOS::memcpy(m_unicodeStringRepository.getBuffer() + upos, uarr.getBuffer(), ulength);
+    return apos;
+}
+
+void StringRepository::lockMergeTails()
+{
+    if ((!m_shouldMergeTails) || (m_isTailsMerged))
+        return;
+    m_isTailsMerged = true;
+
+    // Sort the stored strings by their reversed content. Every string which
+    // ends another string, ends the string which follows it as well.
+    uint count = m_storedOrder.length();
+    if (count < 2)
+        return;
+    cArray<TokenIndex> tokens(count);
+    uint index = 0;
+    cList<TokenIndex>::iterator i = m_storedOrder.begin();
+    for (; i != m_storedOrder.end(); ++i)
+        tokens[index++] = *i;
+    lockSortByReversedContent(tokens);
 
-    m_asciiStringTable.append(stringToken, cDualElement<uint,uint>(apos, alength));
-    m_unicodeStringTable.append(stringToken, cDualElement<uint,uint>(upos, ulength));
+    // Fold each string into one of the strings which follow it, the first
+    // one which the string starts inside at an aligned offset. The strings
+    // which end with it follow it in the sorted order. Going backward, the
+    // roots of the following strings are already known
+    for (index = count - 1; index > 0; index--)
+    {
+        StoredString& tail = m_storedStrings[tokens[index - 1]];
+        for (uint next = index; next < count; next++)
+        {
+            const StoredString& container = m_storedStrings[tokens[next]];
+            if (!isTail(tail.m_string, container.m_string))
+                break;
+
+            TokenIndex root = tokens[next];
+            uint offset = container.m_string.length() - tail.m_string.length();
+            if (container.m_root != ElementType::UnresolvedTokenIndex)
+            {
+                root = container.m_root;
+                offset+= container.m_rootOffset;
+            }
+            // Roots start at an aligned offset
+            if (m_memoryLayout.align(offset) != offset)
+                continue;
+
+            tail.m_root = root;
+            tail.m_rootOffset = offset;
+            break;
+        }
+    }
+
+    // Rebuild the ascii repository from the root strings only
+    m_asciiStringRepository.changeSize(0);
+    for (i = m_storedOrder.begin(); i != m_storedOrder.end(); ++i)
+    {
+        StoredString& stored = m_storedStrings[*i];
+        if (stored.m_root == ElementType::UnresolvedTokenIndex)
+            stored.m_asciiOffset = lockAppendAscii(stored.m_string);
+    }
+    for (i = m_storedOrder.begin(); i != m_storedOrder.end(); ++i)
+    {
+        StoredString& stored = m_storedStrings[*i];
+        if (stored.m_root != ElementType::UnresolvedTokenIndex)
+            stored.m_asciiOffset = m_storedStrings[stored.m_root].m_asciiOffset + stored.m_rootOffset;
+    }
+
+    cList<TokenIndex> strings = m_stringOwners.keys();
+    for (i = strings.begin(); i != strings.end(); ++i)
+    {
+        const cDualElement<TokenIndex,uint>& owner = m_stringOwners[*i];
+        stringRepoStringOffset(m_asciiStringTable[*i]) = m_storedStrings[owner.m_a].m_asciiOffset + owner.m_b;
+    }
+}
+
+void StringRepository::lockSortByReversedContent(cArray<TokenIndex>& tokens)
+{
+    // Heap-sort
+    uint count = tokens.getSize();
+    for (uint start = count / 2; start > 0; start--)
+        lockSiftDown(tokens, start - 1, count);
+    for (uint end = count - 1; end > 0; end--)
+    {
+        TokenIndex top = tokens[0];
+        tokens[0] = tokens[end];
+        tokens[end] = top;
+        lockSiftDown(tokens, 0, end);
+    }
+}
+
+void StringRepository::lockSiftDown(cArray<TokenIndex>& tokens, uint root, uint count)
+{
+    while (root * 2 + 1 < count)
+    {
+        uint child = root * 2 + 1;
+        if ((child + 1 < count) &&
+            (compareReversed(m_storedStrings[tokens[child]].m_string,
+                             m_storedStrings[tokens[child + 1]].m_string) < 0))
+        {
+            child++;
+        }
+        if (compareReversed(m_storedStrings[tokens[root]].m_string,
+                            m_storedStrings[tokens[child]].m_string) >= 0)
+        {
+            return;
+        }
+        TokenIndex swap = tokens[root];
+        tokens[root] = tokens[child];
+        tokens[child] = swap;
+        root = child;
+    }
 }
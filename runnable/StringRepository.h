@@ -40,6 +40,8 @@
 #include "xStl/types.h"
 #include "xStl/os/xstlLockable.h"
 #include "xStl/data/hash.h"
+#include "xStl/data/list.h"
+#include "xStl/data/array.h"
 #include "xStl/data/counter.h"
 #include "xStl/data/string.h"
 #include "data/ElementType.h"
@@ -53,16 +55,24 @@ class GlobalContext;
 
 
 /*
- * Holds string repository as unicode/ascii strings with lengths
+ * Holds string repository as ascii strings with lengths
  */
 class StringRepository
 {
 public:
+    /*
+     * Construct new StringRepository object. Created by GlobalContext.
+     *
+     * apartment - The apartment object
+     * memoryLayoutInterface - The alignment of the strings
+     */
+    StringRepository(const ApartmentPtr& apartment,
+                     const MemoryLayoutInterface& memoryLayoutInterface);
+
     /*
      * Return the string repository
      */
-    const cBuffer& getAsciiStringRepository() const;
-    const cBuffer& getUnicodeStringRepository() const;
+    const cBuffer& getAsciiStringRepository();
 
     /*
      * Get the length of a string.
@@ -75,15 +85,18 @@ public:
     uint getStringLength(const TokenIndex& stringToken);
     uint getStringOffset(const TokenIndex& stringToken);
 
+    /*
+     * Return the content of a string. Unlike getStringOffset(), the layout of
+     * the repository is not fixed by this call.
+     */
+    cString getString(const TokenIndex& stringToken);
+
     /*
      * From a dependancy, get the index inside the string buffer
      */
     bool deserializeStringA(const cString& dependency,
                             uint& stringOffset,
                             TokenIndex* tokenIndex = NULL);
-    bool deserializeStringU(const cString& dependency,
-                            uint& stringOffset,
-                            TokenIndex* tokenIndex = NULL);
 
     /*
      * Translate char[] into a string table, with data convertion (to ascii)
@@ -105,19 +118,24 @@ public:
      */
     // bool isStringUnicode(const TokenIndex& stringToken);
 
-private:
-    friend class GlobalContext;
-    // Deny copy-constructore
-    StringRepository(const StringRepository& other);
-
     /*
-     * Construct new TypedefRepository object
+     * Strings with the same content share a single copy in the repository,
+     * regardless of their apartment. When tail merging is enabled, a string
+     * which is the tail of another stored string is encoded as a pointer into
+     * that string. Like any other string, a merged tail starts at an aligned
+     * offset, so tails which would start at an unaligned offset are stored
+     * by themselves.
      *
-     * apartment - The apartment object
+     * The tails are merged once, when the layout of the repository is first
+     * requested (an offset or the repository buffer). Strings which are added
+     * after that are not merged.
      */
-    StringRepository(const ApartmentPtr& apartment,
-                     const MemoryLayoutInterface& memoryLayoutInterface);
+    void setTailMerging(bool shouldMergeTails);
 
+private:
+    friend class GlobalContext;
+    // Deny copy-constructore
+    StringRepository(const StringRepository& other);
 
     /*
      * Parse a token, return ElementType::Unrsolved if string is invalid.
@@ -130,6 +148,50 @@ private:
     void lockAppendString(const TokenIndex& stringToken);
     void lockAppendString(const cString& str, const TokenIndex& stringToken);
 
+    /*
+     * Copy the content of a new string into the repository and add it to the
+     * strings pool.
+     */
+    void lockStoreString(const cString& str, const TokenIndex& stringToken);
+
+    /*
+     * Append a string into the ascii repository, return it's offset
+     */
+    uint lockAppendAscii(const cString& str);
+
+    /*
+     * If tail merging is enabled, fold every stored string which ends another
+     * stored string at an aligned offset into it and rebuild the repository.
+     * Done only once, see setTailMerging()
+     */
+    void lockMergeTails();
+
+    /*
+     * Sort stored strings tokens by their reversed content (heap-sort)
+     */
+    void lockSortByReversedContent(cArray<TokenIndex>& tokens);
+    void lockSiftDown(cArray<TokenIndex>& tokens, uint root, uint count);
+
+    /*
+     * A string which it's content is copied into the repository
+     */
+    class StoredString {
+    public:
+        // Default constructor, for cHash
+        StoredString();
+        // Constructor
+        StoredString(const cString& string, uint asciiOffset);
+
+        // The string content
+        cString m_string;
+        // The position of the string in the ascii repository
+        uint m_asciiOffset;
+        // For a merged tail, the stored string which holds the content and
+        // the offset (in characters) inside it. See lockMergeTails()
+        TokenIndex m_root;
+        uint m_rootOffset;
+    };
+
     // The apartment and memory layout
     mutable ApartmentPtr m_apartment;
     const MemoryLayoutInterface& m_memoryLayout;
@@ -141,12 +203,23 @@ private:
     #define stringRepoStringOffset(x) ((x).m_a)
     #define stringRepoStringLength(x) ((x).m_b)
     cHash<TokenIndex, cDualElement<uint,uint> > m_asciiStringTable;
-    cHash<TokenIndex, cDualElement<uint,uint> > m_unicodeStringTable;
+
+    // For each string, the token of the stored string holding it's content
+    // and the offset (in characters) inside the stored string
+    cHash<TokenIndex, cDualElement<TokenIndex,uint> > m_stringOwners;
+    // The stored strings, and the order they were stored in
+    cHash<TokenIndex, StoredString> m_storedStrings;
+    cList<TokenIndex> m_storedOrder;
+    // The strings pool. Content to stored string and offset (in characters)
+    cHash<cString, cDualElement<TokenIndex,uint> > m_stringsPool;
+    // Set to true if tails of stored strings should be merged
+    bool m_shouldMergeTails;
+    // Set to true once the tails were merged
+    bool m_isTailsMerged;
 
 
     // The string repository
     cBuffer m_asciiStringRepository;
-    cBuffer m_unicodeStringRepository;
 
     // The serialized string prefix
     static const char gCILStringPrefix[];
@@ -81,7 +81,8 @@ TypedefRepository::TypedefRepository(const ApartmentPtr& apartment,
     m_tokenSystemString(ElementType::UnresolvedTokenIndex),
     m_tokenSystemArray(ElementType::UnresolvedTokenIndex),
     m_tokenSystemValueType(ElementType::UnresolvedTokenIndex),
-    m_tokenStringConstructor(ElementType::UnresolvedTokenIndex)
+    m_tokenStringConstructor(ElementType::UnresolvedTokenIndex),
+    m_isFrozen(false)
 {
     addApartment(apartment);
 }
@@ -126,6 +127,33 @@ void TypedefRepository::doneLoadingApartments()
     }
 }
 
+void TypedefRepository::freeze()
+{
+    if (m_isFrozen)
+        return;
+
+    // Materialize all reachable typedefs
+    doneLoadingApartments();
+
+    // Move the containers into the snapshot one by one, so the table is never
+    // held twice in memory. The locked path looks into both tables.
+    cLock lock(m_lock);
+    cList<TokenIndex> types;
+    m_types.keys(types);
+    for (cList<TokenIndex>::iterator i = types.begin(); i != types.end(); i++)
+    {
+        m_frozenTypes.append(*i, m_types[*i]);
+        m_types.remove(*i);
+    }
+    m_isFrozen = true;
+    RunnableTrace("TypedefRepository: frozen with " << m_frozenTypes.keys().length() << " typedefs" << endl);
+}
+
+bool TypedefRepository::isFrozen() const
+{
+    return m_isFrozen;
+}
+
 void TypedefRepository::repoApartment(const ApartmentPtr& apartment)
 {
     uint typedefTablesSize = apartment->getTables().getNumberOfRows(TABLE_TYPEDEF_TABLE);
@@ -171,10 +199,10 @@ void TypedefRepository::resolveTyperef(ElementType& type) const
             {
                 // Read the blob token
                 ApartmentPtr apt = m_apartment->getApt(type.m_classToken);
-                cForkStreamPtr blob = apt->getStreams().getBlobStream()->fork();
                 const TypeSpecTable::Header& typeSpec = ((TypeSpecTable&)(*apt->getTables().getTableByToken(getTokenID(type.m_classToken)))).getHeader();
-                blob->seek(typeSpec.m_signature + 1, basicInput::IO_SEEK_SET);
-                type = ElementType::readType(*blob, 0);
+                ByteCursor blob = apt->getStreams().getBlob(typeSpec.m_signature);
+                blob = blob.readCursor(EncodingUtils::readCompressedNumber(blob));
+                type = ElementType::readType(blob, 0);
                 resolveTyperef(type);
                 return;
             }
@@ -214,24 +242,21 @@ void TypedefRepository::resolveFieldref(TokenIndex& fieldToken, const TokenIndex
     ApartmentPtr apt = m_apartment->getApt(fieldToken);
     const MemberRefTable::Header& memberRefTable = ((MemberRefTable&)(*apt->getTables().getTableByToken(getTokenID(fieldToken)))).getHeader();
 
-    cForkStreamPtr blob = apt->getStreams().getBlobStream()->fork();
-    blob->seek(memberRefTable.m_signature, basicInput::IO_SEEK_SET);
-    FieldSig fieldSignature(*blob, apt->getUniqueID(), *this);
+    FieldSig fieldSignature(apt->getStreams().getBlob(memberRefTable.m_signature),
+                            apt->getUniqueID(), *this);
     cString fieldName(StringReader::readStringName(*apt->getStreams().getStringsStream()->fork(), memberRefTable.m_name));
 
     // Scan for field name and signature
     cLock lock(m_lock);
-    lockCheckAppendTypedef(parentType);
-    cList<TokenIndex> fields = m_types[parentType].m_fields.keys();
+    cList<TokenIndex> fields = lockGetContainer(parentType).m_fields.keys();
     cList<TokenIndex>::iterator i(fields.begin());
     for (; i != fields.end(); ++i)
     {
         // Read the field name and signature
         ApartmentPtr apt = m_apartment->getApt(*i);
         const MemberRefTable::Header& fieldHeader = ((MemberRefTable&)(*apt->getTables().getTableByToken(getTokenID(*i)))).getHeader();
-        blob = apt->getStreams().getBlobStream()->fork();
-        blob->seek(fieldHeader.m_signature, basicInput::IO_SEEK_SET);
-        FieldSig newFieldSignature(*blob, apt->getUniqueID(), *this);
+        FieldSig newFieldSignature(apt->getStreams().getBlob(fieldHeader.m_signature),
+                                   apt->getUniqueID(), *this);
         cString newFieldName(StringReader::readStringName(*apt->getStreams().getStringsStream()->fork(), fieldHeader.m_name));
 
         if ((newFieldName == fieldName) &&
@@ -247,6 +272,10 @@ void TypedefRepository::resolveFieldref(TokenIndex& fieldToken, const TokenIndex
 const uint TypedefRepository::getRTTI(const TokenIndex& typedefToken) const
 {
     ElementType::assertTyperef(typedefToken);
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typedefToken);
+    if (frozen != NULL)
+        return frozen->m_rtti;
+
     cLock lock(m_lock);
     return lockGetRTTI(typedefToken);
 }
@@ -255,6 +284,10 @@ const TypedefRepository::VirtualTable& TypedefRepository::getVirtualTable(
                                              const TokenIndex&  typedefToken) const
 {
     ElementType::assertTyperef(typedefToken);
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typedefToken);
+    if (frozen != NULL)
+        return frozen->m_virtualTable;
+
     cLock lock(m_lock);
     return lockGetVirtualTable(typedefToken);
 }
@@ -263,14 +296,21 @@ const TypedefRepository::ParentDictonary& TypedefRepository::getParentDirectory(
                                             const TokenIndex& typedefToken) const
 {
     ElementType::assertTyperef(typedefToken);
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typedefToken);
+    if (frozen != NULL)
+        return frozen->m_extends;
+
     cLock lock(m_lock);
-    lockCheckAppendTypedef(typedefToken);
-    return m_types[typedefToken].m_extends;
+    return lockGetContainer(typedefToken).m_extends;
 }
 
 uint TypedefRepository::getTypeSize(const TokenIndex& typeToken) const
 {
     ElementType::assertTyperef(typeToken);
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typeToken);
+    if (frozen != NULL)
+        return m_memoryLayout.align(frozen->m_typedefSize);
+
     cLock lock(m_lock);
     return lockGetTypeSize(typeToken);
 }
@@ -278,6 +318,13 @@ uint TypedefRepository::getTypeSize(const TokenIndex& typeToken) const
 uint TypedefRepository::getTypeSize(const ElementType& typeToken) const
 {
     typeToken.assertTyperef();
+    // Only value-types needs the typedef information. See innerGetTypeSize()
+    if ((typeToken.getType() != ELEMENT_TYPE_VALUETYPE) ||
+        (getFrozenContainer(typeToken.getClassToken()) != NULL))
+    {
+        return innerGetTypeSize(typeToken);
+    }
+
     cLock lock(m_lock);
     return innerGetTypeSize(typeToken);
 }
@@ -285,17 +332,23 @@ uint TypedefRepository::getTypeSize(const ElementType& typeToken) const
 bool TypedefRepository::isTypeInterface(const TokenIndex& typeToken) const
 {
     ElementType::assertTyperef(typeToken);
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typeToken);
+    if (frozen != NULL)
+        return frozen->m_isInterface;
+
     cLock lock(m_lock);
-    lockCheckAppendTypedef(typeToken);
-    return m_types[typeToken].m_isInterface;
+    return lockGetContainer(typeToken).m_isInterface;
 }
 
 bool TypedefRepository::isTypeShouldDref(const TokenIndex& typeToken) const
 {
     ElementType::assertTyperef(typeToken);
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typeToken);
+    if (frozen != NULL)
+        return frozen->m_isSpecialCleanup;
+
     cLock lock(m_lock);
-    lockCheckAppendTypedef(typeToken);
-    return m_types[typeToken].m_isSpecialCleanup;
+    return lockGetContainer(typeToken).m_isSpecialCleanup;
 }
 
 uint TypedefRepository::getStaticFieldOffset(const TokenIndex& fieldToken) const
@@ -322,6 +375,24 @@ TokenIndex TypedefRepository::allocateStatic(uint size)
     return ret;
 }
 
+TokenIndex TypedefRepository::getStaticInitializerGuard(const TokenIndex& typeToken)
+{
+    {
+        cLock lock(m_lock);
+        if (m_staticInitializerGuards.hasKey(typeToken))
+            return m_staticInitializerGuards[typeToken];
+    }
+
+    // allocateStatic() takes the lock by itself. If another thread allocated
+    // the guard meanwhile, this boolean is left unused.
+    TokenIndex guard = allocateStatic(1);
+
+    cLock lock(m_lock);
+    if (!m_staticInitializerGuards.hasKey(typeToken))
+        m_staticInitializerGuards.append(typeToken, guard);
+    return m_staticInitializerGuards[typeToken];
+}
+
 uint TypedefRepository::allocateDataSection(cForkStreamPtr& stream, uint size)
 {
     cLock lock(m_lock);
@@ -337,30 +408,36 @@ const cBuffer& TypedefRepository::getDataSection()
 
 TokenIndex TypedefRepository::getStaticInitializerMethod(const TokenIndex& typeToken) const
 {
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typeToken);
+    if (frozen != NULL)
+        return frozen->m_staticInitializerMethod;
+
     cLock lock(m_lock);
-    lockCheckAppendTypedef(typeToken);
-    return m_types[typeToken].m_staticInitializerMethod;
+    return lockGetContainer(typeToken).m_staticInitializerMethod;
 }
 
 const TypedefRepository::FieldsDictonary& TypedefRepository::getAllFields(const TokenIndex& parentToken) const
 {
-    cLock lock(m_lock);
-    lockCheckAppendTypedef(parentToken);
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(parentToken);
+    if (frozen != NULL)
+        return frozen->m_fields;
 
+    cLock lock(m_lock);
     // Exception might be thrown here. In this case the tables are corrupted.
-    return m_types[parentToken].m_fields;
+    return lockGetContainer(parentToken).m_fields;
 }
 
 uint TypedefRepository::getFieldRelativePosition(const TokenIndex& fieldToken,
                                                  const TokenIndex& parentToken) const
 {
     TokenIndex pt = resolveParentToken(fieldToken, parentToken);
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(pt);
+    if (frozen != NULL)
+        return frozen->m_fields[fieldToken].m_offset;
 
     cLock lock(m_lock);
-    lockCheckAppendTypedef(pt);
-
     // Exception might be thrown here. In this case the tables are corrupted.
-    return m_types[pt].m_fields[fieldToken].m_offset;
+    return lockGetContainer(pt).m_fields[fieldToken].m_offset;
 }
 
 const ElementType& TypedefRepository::getFieldType(const TokenIndex& fieldToken,
@@ -382,10 +459,13 @@ const ElementType& TypedefRepository::getFieldType(const TokenIndex& fieldToken,
     } else
     {
         TokenIndex pt = resolveParentToken(fieldToken, parentToken);
+        const TypedefRepositoryContainer* frozen = getFrozenContainer(pt);
+        if (frozen != NULL)
+            return frozen->m_fields[fieldToken].m_type;
+
         cLock lock(m_lock);
-        lockCheckAppendTypedef(pt);
         // Exception might be thrown here. In this case the tables are corrupted.
-        return m_types[pt].m_fields[fieldToken].m_type;
+        return lockGetContainer(pt).m_fields[fieldToken].m_type;
     }
 }
 
@@ -416,6 +496,9 @@ TokenIndex TypedefRepository::getTypeToken(const cString& _namespace,
         crc.update(genericVal[i].getType());
         crc.update((const byte*)&genericVal[i].getClassToken(), sizeof(TokenIndex));
     }
+    // Generic instances are created lazily, also after freeze()
+    cLock lock(m_lock);
+
     // Find the token
     TokenIndex newToken = buildTokenIndex(getApartmentID(classToken),
                                           EncodingUtils::buildToken(TABLE_CLR_GENERICS_INSTANCES, crc.getValue()));
@@ -437,23 +520,25 @@ TokenIndex TypedefRepository::getTypeToken(const cString& _namespace,
 bool TypedefRepository::isTypedefClass(const TokenIndex& typeToken) const
 {
     ElementType::assertTyperef(typeToken);
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typeToken);
+    if (frozen != NULL)
+        return !frozen->m_extends.hasKey(m_tokenSystemValueType);
 
     cLock lock(m_lock);
-    lockCheckAppendTypedef(typeToken);
-
     // Check the typedef
-    return !m_types[typeToken].m_extends.hasKey(m_tokenSystemValueType);
+    return !lockGetContainer(typeToken).m_extends.hasKey(m_tokenSystemValueType);
 }
 
 const cBuffer& TypedefRepository::getTypeHashSignature(const TokenIndex& typeToken) const
 {
     ElementType::assertTyperef(typeToken);
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typeToken);
+    if (frozen != NULL)
+        return frozen->m_hashSignature;
 
     cLock lock(m_lock);
-    lockCheckAppendTypedef(typeToken);
-
     // And return value
-    return m_types[typeToken].m_hashSignature;
+    return lockGetContainer(typeToken).m_hashSignature;
 }
 
 uint TypedefRepository::estimateVirtualTableMaximumSize(uint callSize) const
@@ -461,14 +546,19 @@ uint TypedefRepository::estimateVirtualTableMaximumSize(uint callSize) const
     cLock lock(m_lock);
     cList<TokenIndex> types;
     m_types.keys(types);
+    cList<TokenIndex> frozenTypes;
+    m_frozenTypes.keys(frozenTypes);
+    for (cList<TokenIndex>::iterator j = frozenTypes.begin(); j != frozenTypes.end(); j++)
+        types.append(*j);
 
     uint estimatedSize = 0;
     for (cList<TokenIndex>::iterator i = types.begin(); i != types.end(); i++)
     {
+        const TypedefRepositoryContainer& type = lockFindContainer(*i);
         // Adding vtbl
-        estimatedSize += m_types[*i].m_virtualTable.length() * callSize;
+        estimatedSize += type.m_virtualTable.length() * callSize;
         // Adding parntes, and number of total parents
-        estimatedSize += (m_types[*i].m_extends.keys().length() + 2) * callSize;
+        estimatedSize += (type.m_extends.keys().length() + 2) * callSize;
     }
 
     return estimatedSize;
@@ -483,29 +573,52 @@ const TokenIndex& TypedefRepository::getSystemObject() const
 // private methods
 
 
-const uint TypedefRepository::lockGetRTTI(const TokenIndex&  typedefToken) const
+const TypedefRepository::TypedefRepositoryContainer*
+             TypedefRepository::getFrozenContainer(const TokenIndex& typedefToken) const
 {
-    ElementType::assertTyperef(typedefToken);
+    // m_frozenTypes is never changed after freeze(), so no lock is needed
+    if ((!m_isFrozen) || (!m_frozenTypes.hasKey(typedefToken)))
+        return NULL;
+    return &m_frozenTypes[typedefToken];
+}
+
+const TypedefRepository::TypedefRepositoryContainer&
+             TypedefRepository::lockGetContainer(const TokenIndex& typedefToken) const
+{
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typedefToken);
+    if (frozen != NULL)
+        return *frozen;
 
     lockCheckAppendTypedef(typedefToken);
-    return m_types[typedefToken].m_rtti;
+    return m_types[typedefToken];
+}
+
+const TypedefRepository::TypedefRepositoryContainer&
+             TypedefRepository::lockFindContainer(const TokenIndex& typedefToken) const
+{
+    const TypedefRepositoryContainer* frozen = getFrozenContainer(typedefToken);
+    if (frozen != NULL)
+        return *frozen;
+    return m_types[typedefToken];
+}
+
+const uint TypedefRepository::lockGetRTTI(const TokenIndex&  typedefToken) const
+{
+    ElementType::assertTyperef(typedefToken);
+    return lockGetContainer(typedefToken).m_rtti;
 }
 
 const TypedefRepository::VirtualTable&
              TypedefRepository::lockGetVirtualTable(const TokenIndex& typedefToken) const
 {
     ElementType::assertTyperef(typedefToken);
-
-    lockCheckAppendTypedef(typedefToken);
-    return m_types[typedefToken].m_virtualTable;
+    return lockGetContainer(typedefToken).m_virtualTable;
 }
 
 uint TypedefRepository::lockGetTypeSize(const TokenIndex& typedefToken) const
 {
     ElementType::assertTyperef(typedefToken);
-
-    lockCheckAppendTypedef(typedefToken);
-    return m_memoryLayout.align(m_types[typedefToken].m_typedefSize);
+    return m_memoryLayout.align(lockGetContainer(typedefToken).m_typedefSize);
 }
 
 void TypedefRepository::appendParents(TypedefRepository::ParentDictonary& dest,
@@ -573,7 +686,7 @@ void TypedefRepository::mergeInterfaceVirtualTables(TypedefRepository::VirtualTa
 
 void TypedefRepository::lockCheckAppendTypedef(const TokenIndex& typedefToken) const
 {
-    if (!m_types.hasKey(typedefToken))
+    if ((!m_types.hasKey(typedefToken)) && (getFrozenContainer(typedefToken) == NULL))
         lockAppendTypedef(typedefToken);
 }
 
@@ -582,7 +695,7 @@ void TypedefRepository::lockAppendTypedef(const TokenIndex& _typedefToken) const
 {
     // We already worked on that typedef
     TokenIndex typedefToken = _typedefToken;
-    if (m_types.hasKey(typedefToken))
+    if (m_types.hasKey(typedefToken) || (getFrozenContainer(typedefToken) != NULL))
         return;
 
     // Checking for generic instance. TODO!
@@ -596,7 +709,7 @@ void TypedefRepository::lockAppendTypedef(const TokenIndex& _typedefToken) const
     uint apartmentId = getApartmentID(typedefToken);
     const ApartmentPtr& apartment = m_apartment->getApartmentByID(apartmentId);
     cForkStreamPtr stringStream = apartment->getStreams().getStringsStream()->fork();
-    cForkStreamPtr blobStream = apartment->getStreams().getBlobStream()->fork();
+    const MSILStreams& streams = apartment->getStreams();
 
     TablePtr tablePtr(apartment->getTables().getTableByToken(getTokenID(typedefToken)));
     ASSERT(tablePtr->getIndex() == TABLE_TYPEDEF_TABLE);
@@ -652,13 +765,14 @@ void TypedefRepository::lockAppendTypedef(const TokenIndex& _typedefToken) const
 
         lockAppendTypedef(extendIndex);
         // Update parent hash
-        crc64.updateStream(m_types[extendIndex].m_hashSignature);
-        newType.m_extends = m_types[extendIndex].m_extends;
+        const TypedefRepositoryContainer& extendType = lockFindContainer(extendIndex);
+        crc64.updateStream(extendType.m_hashSignature);
+        newType.m_extends = extendType.m_extends;
         // Add current parent as prime father
         newType.m_extends.append(extendIndex, 0);
 
         newType.m_virtualTable = lockGetVirtualTable(extendIndex);
-        newType.m_fields = m_types[extendIndex].m_fields;
+        newType.m_fields = extendType.m_fields;
 
         typedefSize = lockGetTypeSize(extendIndex);
     }
@@ -693,8 +807,9 @@ void TypedefRepository::lockAppendTypedef(const TokenIndex& _typedefToken) const
 
         // Add all other interfaces. TODO! Flat model.
         // Update parent hash
-        crc64.updateStream(m_types[iiToken].m_hashSignature);
-        appendParents(newType.m_extends, m_types[iiToken].m_extends, interfaceOffset);
+        const TypedefRepositoryContainer& interfaceType = lockFindContainer(iiToken);
+        crc64.updateStream(interfaceType.m_hashSignature);
+        appendParents(newType.m_extends, interfaceType.m_extends, interfaceOffset);
 
         // Mark myself
         newType.m_extends.append(iiToken, interfaceOffset);
@@ -708,7 +823,7 @@ void TypedefRepository::lockAppendTypedef(const TokenIndex& _typedefToken) const
         /////////////////////////////
 
         // Fields: Mark starting of current fields offset
-        const FieldsDictonary& iifields = m_types[iiToken].m_fields;
+        const FieldsDictonary& iifields = interfaceType.m_fields;
         cList<TokenIndex> fields;
         iifields.keys(fields);
         cList<TokenIndex>::iterator x = fields.begin();
@@ -724,7 +839,7 @@ void TypedefRepository::lockAppendTypedef(const TokenIndex& _typedefToken) const
             // Mark special cleanning
             if (offsetType.m_type.isObject())
             {
-                newType.m_isSpecialCleanup |= m_types[offsetType.m_type.getClassToken()].m_isSpecialCleanup;
+                newType.m_isSpecialCleanup |= lockFindContainer(offsetType.m_type.getClassToken()).m_isSpecialCleanup;
             }
         }
     }
@@ -772,9 +887,9 @@ void TypedefRepository::lockAppendTypedef(const TokenIndex& _typedefToken) const
         ASSERT(ptr->getIndex() == TABLE_FIELD_TABLE);
         // Prepare offset
         const FieldTable& fieldTable((const FieldTable&)(*ptr));
-        blobStream->seek(fieldTable.getHeader().m_signature, basicInput::IO_SEEK_SET);
         // Translate ElementType and remove generic variable (if any)
-        FieldSig fieldType(*blobStream, apartmentId, *this);
+        FieldSig fieldType(streams.getBlob(fieldTable.getHeader().m_signature),
+                           apartmentId, *this);
         FieldRepositoryContainer offsetType;
         offsetType.m_offset = 0;
         offsetType.m_type = getGenericRealElementType(fieldType.getType(), _typedefToken);
@@ -790,7 +905,7 @@ void TypedefRepository::lockAppendTypedef(const TokenIndex& _typedefToken) const
             if (offsetType.m_type.isObject())
             {
                 if ((offsetType.m_type.isObjectAndNotValueType()) ||
-                    (m_types[offsetType.m_type.getClassToken()].m_isSpecialCleanup))
+                    (lockFindContainer(offsetType.m_type.getClassToken()).m_isSpecialCleanup))
                 {
                     classDetorNeeded = newType.m_isSpecialCleanup = true;
                 }
@@ -824,11 +939,10 @@ void TypedefRepository::lockAppendTypedef(const TokenIndex& _typedefToken) const
             apartment->getTables().getTableByToken(currentMethod)).getHeader();
         cString methodName = StringReader::readStringName(*stringStream,
                                                             thisMethod.m_name);
-        blobStream->seek(thisMethod.m_signature, basicInput::IO_SEEK_SET);
 
         XSTL_TRY
         {
-            MethodDefOrRefSignature methodSignature(*blobStream,
+            MethodDefOrRefSignature methodSignature(streams.getBlob(thisMethod.m_signature),
                                                     apartmentId,
                                                     *this);
 
@@ -877,9 +991,7 @@ void TypedefRepository::lockAppendTypedef(const TokenIndex& _typedefToken) const
                                         namespaceName << "." << className << "." << orgName << endl);
                         CHECK_FAIL(); // Throw error message
                     }
-                    cForkStreamPtr orgBlobStream(orgApt->getStreams().getBlobStream()->fork());
-                    orgBlobStream->seek(otherMethod.m_signature, basicInput::IO_SEEK_SET);
-                    MethodDefOrRefSignature orgSignature(*orgBlobStream,
+                    MethodDefOrRefSignature orgSignature(orgApt->getStreams().getBlob(otherMethod.m_signature),
                                                             getApartmentID(orgIndex),
                                                             *this);
 
@@ -98,6 +98,14 @@ public:
     virtual const cBuffer& getDataSection();
     // See ResolverInterface::getStaticInitializerMethod
     virtual TokenIndex getStaticInitializerMethod(const TokenIndex& typeToken) const;
+
+    /*
+     * Return the static boolean which marks that the static initializer of
+     * 'typeToken' was already invoked. The boolean is allocated (see
+     * allocateStatic) on the first request, and the same token is returned for
+     * the cctor wrapper and for all the inline checks of the type.
+     */
+    TokenIndex getStaticInitializerGuard(const TokenIndex& typeToken);
     // See ResolverInterface::getTypeToken
     virtual TokenIndex getTypeToken(const cString& _namespace,
                                     const cString& _className) const;
@@ -131,6 +139,23 @@ public:
      */
     void doneLoadingApartments();
 
+    /*
+     * Materialize all the typedefs of all loaded apartments and take an
+     * immutable snapshot of them. After this call all queries for a snapshot
+     * typedef are served without taking the repository lock. Types which are
+     * created lazily afterwards (generic instances) still go through the
+     * locked path.
+     *
+     * NOTE: Must be called after all apartments are loaded and before any
+     *       compilation thread is started.
+     */
+    void freeze();
+
+    /*
+     * Return true if freeze() was called
+     */
+    bool isFrozen() const;
+
 protected:
     friend class GlobalContext;
     /*
@@ -263,21 +288,51 @@ private:
         cBuffer m_hashSignature;
     };
 
+    /*
+     * Return the frozen container of a typedef, or NULL if the repository is
+     * not frozen or the typedef was not part of the snapshot. The returned
+     * container can be accessed without holding the lock.
+     */
+    const TypedefRepositoryContainer* getFrozenContainer(const TokenIndex& typedefToken) const;
+
+    /*
+     * Return the container of a typedef, appending it if needed.
+     * NOTE: The lock must be held, unless the typedef is frozen.
+     */
+    const TypedefRepositoryContainer& lockGetContainer(const TokenIndex& typedefToken) const;
+
+    /*
+     * Return the container of a typedef which was already appended, either
+     * from the frozen snapshot or from m_types. Unlike lockGetContainer() the
+     * typedef is never appended.
+     * NOTE: The lock must be held.
+     */
+    const TypedefRepositoryContainer& lockFindContainer(const TokenIndex& typedefToken) const;
+
     #ifdef XSTL_WINDOWS
 		// Typedef virtual-table repository layout
         mutable cHash<typename TokenIndex, TypedefRepositoryContainer> m_types;
 		// New generic instances (new tokens) vs Generic elements
 		cHash<typename TokenIndex, ElementType> m_genericInstances;
+        // Immutable snapshot of m_types. See freeze()
+        mutable cHash<typename TokenIndex, TypedefRepositoryContainer> m_frozenTypes;
     #else
 		// Typedef virtual-table repository layout
         mutable cHash<TokenIndex, TypedefRepositoryContainer> m_types;
 		// New generic instances (new tokens) vs Generic elements
 		cHash<TokenIndex, ElementType> m_genericInstances;
+        // Immutable snapshot of m_types. See freeze()
+        mutable cHash<TokenIndex, TypedefRepositoryContainer> m_frozenTypes;
     #endif
 
+    // Set once by freeze(), before any compilation thread is started
+    bool m_isFrozen;
+
     // Global database, stores token and size of each token
     mutable cHash<TokenIndex, uint> m_staticDB;
     mutable uint m_staticDBLength;
+    // Type token vs the static boolean of its initializer wrapper
+    cHash<TokenIndex, TokenIndex> m_staticInitializerGuards;
 
     // The data buffer (.data)
     cBuffer m_dataBuffer;
@@ -0,0 +1,229 @@
+namespace TestExceptionFrames
+{
+    // Only used inside a finally handler, so in lazy mode it's compiled while
+    // the exception is dispatched
+    class Recorder
+    {
+        int m_count;
+
+        public virtual void record()
+        {
+            m_count++;
+        }
+
+        public int getCount()
+        {
+            return m_count;
+        }
+    }
+
+    class TestExceptionFrames
+    {
+        static int s_trace;
+
+        static void thrower(int depth)
+        {
+            if (depth == 0)
+            {
+                throw new System.InvalidOperationException();
+            }
+
+            try
+            {
+                thrower(depth - 1);
+            }
+            finally
+            {
+                // Each frame on the way runs its finally
+                s_trace = s_trace * 10 + depth;
+            }
+        }
+
+        // The exception passes through three frames before it's caught
+        static int test_throw_through_frames()
+        {
+            s_trace = 0;
+            try
+            {
+                thrower(3);
+            }
+            catch (System.InvalidOperationException)
+            {
+                if (s_trace != 123)
+                {
+                    return -1;
+                }
+                return 0;
+            }
+            return -1;
+        }
+
+        static void skip_unmatched_catch()
+        {
+            try
+            {
+                thrower(1);
+            }
+            catch (System.ArgumentException)
+            {
+                // Not the thrown type
+                s_trace = -1;
+            }
+        }
+
+        // An outer frame catches the exception by its base class
+        static int test_unmatched_catch()
+        {
+            s_trace = 0;
+            try
+            {
+                skip_unmatched_catch();
+            }
+            catch (System.SystemException)
+            {
+                if (s_trace != 1)
+                {
+                    return -1;
+                }
+                return 0;
+            }
+            return -1;
+        }
+
+        static void record_and_throw(Recorder recorder)
+        {
+            try
+            {
+                thrower(2);
+            }
+            finally
+            {
+                // A new method and a new type are linked during the dispatch
+                recorder.record();
+            }
+        }
+
+        static int test_handler_links_methods()
+        {
+            Recorder recorder = new Recorder();
+            s_trace = 0;
+            try
+            {
+                record_and_throw(recorder);
+            }
+            catch (System.InvalidOperationException)
+            {
+                if ((recorder.getCount() != 1) || (s_trace != 12))
+                {
+                    return -1;
+                }
+                return 0;
+            }
+            return -1;
+        }
+
+        static void rethrow_from_catch()
+        {
+            try
+            {
+                thrower(1);
+            }
+            catch (System.InvalidOperationException)
+            {
+                s_trace = s_trace * 10 + 5;
+                throw new System.ArgumentException();
+            }
+        }
+
+        // An exception which leaves a catch handler continues in the frames
+        // of the first exception
+        static int test_throw_from_handler()
+        {
+            s_trace = 0;
+            try
+            {
+                try
+                {
+                    rethrow_from_catch();
+                }
+                finally
+                {
+                    s_trace = s_trace * 10 + 7;
+                }
+            }
+            catch (System.ArgumentException)
+            {
+                if (s_trace != 157)
+                {
+                    return -1;
+                }
+                return 0;
+            }
+            return -1;
+        }
+
+        // The frames are unwound again after a caught exception
+        static int test_throw_twice()
+        {
+            for (int i = 0; i < 2; i++)
+            {
+                if (0 != test_throw_through_frames())
+                {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+
+        static int Main()
+        {
+            bool failed = false;
+
+            TBA.Debug.debugString("Test exception frames\n");
+
+            if (0 != test_throw_through_frames())
+            {
+                TBA.Debug.debugString("test_throw_through_frames: not ok.\n");
+                failed = true;
+            }
+            TBA.Debug.debugString("test_throw_through_frames: ok.\n");
+
+            if (0 != test_unmatched_catch())
+            {
+                TBA.Debug.debugString("test_unmatched_catch: not ok.\n");
+                failed = true;
+            }
+            TBA.Debug.debugString("test_unmatched_catch: ok.\n");
+
+            if (0 != test_handler_links_methods())
+            {
+                TBA.Debug.debugString("test_handler_links_methods: not ok.\n");
+                failed = true;
+            }
+            TBA.Debug.debugString("test_handler_links_methods: ok.\n");
+
+            if (0 != test_throw_from_handler())
+            {
+                TBA.Debug.debugString("test_throw_from_handler: not ok.\n");
+                failed = true;
+            }
+            TBA.Debug.debugString("test_throw_from_handler: ok.\n");
+
+            if (0 != test_throw_twice())
+            {
+                TBA.Debug.debugString("test_throw_twice: not ok.\n");
+                failed = true;
+            }
+            TBA.Debug.debugString("test_throw_twice: ok.\n");
+
+            if (failed)
+            {
+                return -1;
+            }
+
+            TBA.Debug.debugString("\n");
+            TBA.Debug.debugString("ALL OK!\n");
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,132 @@
+namespace TestLazyLink
+{
+    // Only referenced by lazily compiled methods, so the virtual tables are
+    // built after the first link
+    class LateShape
+    {
+        public virtual int area()
+        {
+            return 0;
+        }
+    }
+
+    class LateSquare : LateShape
+    {
+        int m_side;
+
+        public LateSquare(int side)
+        {
+            m_side = side;
+        }
+
+        public override int area()
+        {
+            return m_side * m_side;
+        }
+    }
+
+    class TestLazyLink
+    {
+        static int test_late_type()
+        {
+            LateShape shape = new LateSquare(7);
+            if (shape.area() != 49)
+            {
+                return -1;
+            }
+
+            // A second object shares the same virtual table
+            LateShape other = new LateSquare(3);
+            if ((other.area() != 9) || (shape.area() != 49))
+            {
+                return -1;
+            }
+
+            return 0;
+        }
+
+        static string late_string()
+        {
+            return "a string which is first met by a lazy method";
+        }
+
+        static int test_late_string()
+        {
+            string first = late_string();
+            // The first string must stay valid while more strings are added
+            string second = "another string, added after the first one";
+            if (first.Length != 44)
+            {
+                return -1;
+            }
+            if (second.Length != 41)
+            {
+                return -1;
+            }
+            if ((first[0] != 'a') || (first[43] != 'd') || (second[0] != 'a'))
+            {
+                return -1;
+            }
+            if (late_string()[2] != 's')
+            {
+                return -1;
+            }
+
+            return 0;
+        }
+
+        static int test_late_data()
+        {
+            // The initializer is placed in the data section
+            int[] arr = new int[] { 3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5, 8, 9, 7, 9 };
+            int sum = 0;
+            for (int i = 0; i < arr.Length; i++)
+            {
+                sum += arr[i];
+            }
+            if (sum != 77)
+            {
+                return -1;
+            }
+
+            return 0;
+        }
+
+        static int Main()
+        {
+            bool failed = false;
+
+            TBA.Debug.debugString("Test lazy link\n");
+
+            if (0 != test_late_type())
+            {
+                TBA.Debug.debugString("test_late_type: not ok.\n");
+                failed = true;
+            }
+            TBA.Debug.debugString("test_late_type: ok.\n");
+
+            if (0 != test_late_string())
+            {
+                TBA.Debug.debugString("test_late_string: not ok.\n");
+                failed = true;
+            }
+            TBA.Debug.debugString("test_late_string: ok.\n");
+
+            if (0 != test_late_data())
+            {
+                TBA.Debug.debugString("test_late_data: not ok.\n");
+                failed = true;
+            }
+            TBA.Debug.debugString("test_late_data: ok.\n");
+
+            if (failed)
+            {
+                return -1;
+            }
+
+            TBA.Debug.debugString("\n");
+            TBA.Debug.debugString("ALL OK!\n");
+            return 0;
+        }
+    }
+}
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "compiler/opcodes/Bin32Opcodes.h"
+
+class Bin32OpcodesTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    void unsigned_magic(void);
+    void signed_magic(void);
+
+    /*
+     * Run the code sequence of Bin32Opcodes::divideByConstant over 'dividend'
+     */
+    static uint32 unsignedDivide(uint32 dividend, uint32 divisor);
+    static int32 signedDivide(int32 dividend, int32 divisor);
+
+    /*
+     * Test a divisor against a set of dividends which covers the boundaries
+     * of the quotient.
+     */
+    static void testUnsignedDivisor(uint32 divisor);
+    static void testSignedDivisor(int32 divisor);
+
+    // Arithmetic shift right, without relying on the host '>>' of a
+    // negative integer
+    static int32 sar(int32 value, uint shift);
+};
+
+// Instance test object
+Bin32OpcodesTests g_globalBin32Opcodes;
+
+// Dividends which are tested for every divisor
+static const uint32 gDividends[] = {0, 1, 2, 3, 7, 100, 0xFFFF, 0x10000,
+                                    0x12345678, 0x3FFFFFFF, 0x40000000,
+                                    0x7FFFFFFE, 0x7FFFFFFF, 0x80000000,
+                                    0x80000001, 0x87654321, 0xAAAAAAAA,
+                                    0xFFFEFFFF, 0xFFFFFFFE, 0xFFFFFFFF};
+
+int32 Bin32OpcodesTests::sar(int32 value, uint shift)
+{
+    uint32 u = (uint32)value;
+    return (int32)((value < 0) ? ~((~u) >> shift) : (u >> shift));
+}
+
+uint32 Bin32OpcodesTests::unsignedDivide(uint32 dividend, uint32 divisor)
+{
+    uint32 magic;
+    bool isAdd;
+    uint shift;
+    Bin32Opcodes::getUnsignedMagic(divisor, magic, isAdd, shift);
+
+    uint32 high = (uint32)(((uint64)dividend * magic) >> 32);
+    if (!isAdd)
+        return high >> shift;
+
+    TESTS_ASSERT(shift > 0);
+    return (((dividend - high) >> 1) + high) >> (shift - 1);
+}
+
+int32 Bin32OpcodesTests::signedDivide(int32 dividend, int32 divisor)
+{
+    int32 magic;
+    uint shift;
+    Bin32Opcodes::getSignedMagic(divisor, magic, shift);
+    TESTS_ASSERT(shift < 32);
+
+    int32 high = (int32)(((int64)dividend * magic) >> 32);
+    if ((divisor > 0) && (magic < 0))
+        high = (int32)((uint32)high + (uint32)dividend);
+    else if ((divisor < 0) && (magic > 0))
+        high = (int32)((uint32)high - (uint32)dividend);
+    int32 quotient = sar(high, shift);
+    return (int32)((uint32)quotient + ((uint32)quotient >> 31));
+}
+
+void Bin32OpcodesTests::testUnsignedDivisor(uint32 divisor)
+{
+    for (uint i = 0; i < arraysize(gDividends); i++)
+    {
+        uint32 dividend = gDividends[i];
+        TESTS_ASSERT_EQUAL(unsignedDivide(dividend, divisor), dividend / divisor);
+    }
+
+    // Around the multiples of the divisor
+    uint32 multiple = (0xFFFFFFFF / divisor) * divisor;
+    TESTS_ASSERT_EQUAL(unsignedDivide(divisor - 1, divisor), 0);
+    TESTS_ASSERT_EQUAL(unsignedDivide(divisor, divisor), 1);
+    TESTS_ASSERT_EQUAL(unsignedDivide(multiple - 1, divisor), (multiple - 1) / divisor);
+    TESTS_ASSERT_EQUAL(unsignedDivide(multiple, divisor), multiple / divisor);
+}
+
+void Bin32OpcodesTests::testSignedDivisor(int32 divisor)
+{
+    for (uint i = 0; i < arraysize(gDividends); i++)
+    {
+        int32 dividend = (int32)gDividends[i];
+        TESTS_ASSERT_EQUAL(signedDivide(dividend, divisor), dividend / divisor);
+        if (dividend != (int32)0x80000000)
+            TESTS_ASSERT_EQUAL(signedDivide(-dividend, divisor), (-dividend) / divisor);
+    }
+
+    // Around the multiples of the divisor
+    int32 absDivisor = (divisor < 0) ? -divisor : divisor;
+    int32 multiple = (0x7FFFFFFF / absDivisor) * absDivisor;
+    TESTS_ASSERT_EQUAL(signedDivide(multiple, divisor), multiple / divisor);
+    TESTS_ASSERT_EQUAL(signedDivide(multiple - 1, divisor), (multiple - 1) / divisor);
+    TESTS_ASSERT_EQUAL(signedDivide(-multiple, divisor), (-multiple) / divisor);
+    TESTS_ASSERT_EQUAL(signedDivide(-multiple + 1, divisor), (-multiple + 1) / divisor);
+}
+
+void Bin32OpcodesTests::unsigned_magic(void)
+{
+    for (uint32 divisor = 2; divisor <= 0x10000; divisor++)
+        testUnsignedDivisor(divisor);
+
+    static const uint32 edges[] = {0x10001, 0x12345, 641, 6700417,
+                                   0x7FFFFFFF, 0x80000000, 0x80000001,
+                                   0xAAAAAAAB, 0xFFFFFFFE, 0xFFFFFFFF};
+    for (uint i = 0; i < arraysize(edges); i++)
+        testUnsignedDivisor(edges[i]);
+}
+
+void Bin32OpcodesTests::signed_magic(void)
+{
+    // Bin32Opcodes::binary32 never uses the magic number for 1, -1 and
+    // 0x80000000
+    for (int32 divisor = 2; divisor <= 0x10000; divisor++)
+    {
+        testSignedDivisor(divisor);
+        testSignedDivisor(-divisor);
+    }
+
+    static const int32 edges[] = {0x10001, 0x12345, 641, 6700417,
+                                  0x3FFFFFFF, 0x40000000, 0x40000001,
+                                  0x7FFFFFFE, 0x7FFFFFFF};
+    for (uint i = 0; i < arraysize(edges); i++)
+    {
+        testSignedDivisor(edges[i]);
+        testSignedDivisor(-edges[i]);
+    }
+}
+
+void Bin32OpcodesTests::test(void)
+{
+    unsigned_magic();
+    signed_magic();
+}
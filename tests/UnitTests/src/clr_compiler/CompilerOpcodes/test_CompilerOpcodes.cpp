@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "compiler/opcodes/CompilerOpcodes.h"
+
+class CompilerOpcodesTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    void copy_method(void);
+    void unrolled_transactions(void);
+};
+
+// Instance test object
+CompilerOpcodesTests g_globalCompilerOpcodes;
+
+void CompilerOpcodesTests::copy_method(void)
+{
+    // Up to four words are unrolled, on every architecture
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyMethod(0, 16, 4, false), CompilerOpcodes::COPY_UNROLLED);
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyMethod(3, 16, 4, false), CompilerOpcodes::COPY_UNROLLED);
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyMethod(16, 16, 4, true), CompilerOpcodes::COPY_UNROLLED);
+
+    // Larger whole-word copies use copyMemory (IA32 rep movsd)
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyMethod(20, 16, 4, true), CompilerOpcodes::COPY_BLOCK);
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyMethod(0x1000, 16, 4, true), CompilerOpcodes::COPY_BLOCK);
+    // copyMemory only copies whole words
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyMethod(18, 16, 4, true), CompilerOpcodes::COPY_CALL);
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyMethod(21, 16, 4, true), CompilerOpcodes::COPY_CALL);
+
+    // Without copyMemory (ARM, THUMB) the framework is called
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyMethod(20, 16, 4, false), CompilerOpcodes::COPY_CALL);
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyMethod(0x1000, 16, 4, false), CompilerOpcodes::COPY_CALL);
+}
+
+void CompilerOpcodesTests::unrolled_transactions(void)
+{
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyTransactionSize(1), 1);
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyTransactionSize(2), 2);
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyTransactionSize(3), 2);
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyTransactionSize(4), 4);
+    TESTS_ASSERT_EQUAL(CompilerOpcodes::getCopyTransactionSize(7), 4);
+
+    // 11 bytes are a word, a word, a half word and a byte
+    static const uint expected[] = {4, 4, 2, 1};
+    uint offset = 0;
+    for (uint i = 0; i < arraysize(expected); i++)
+    {
+        uint transaction = CompilerOpcodes::getCopyTransactionSize(11 - offset);
+        TESTS_ASSERT_EQUAL(transaction, expected[i]);
+        offset+= transaction;
+    }
+    TESTS_ASSERT_EQUAL(offset, 11);
+
+    // Every transaction of an aligned block is aligned to its own size, which
+    // ARM and THUMB require from ldr/str and ldrh/strh
+    for (uint size = 1; size <= 16; size++)
+    {
+        uint count = 0;
+        for (offset = 0; offset < size; count++)
+        {
+            uint transaction = CompilerOpcodes::getCopyTransactionSize(size - offset);
+            TESTS_ASSERT_EQUAL(offset % transaction, 0);
+            TESTS_ASSERT(offset + transaction <= size);
+            offset+= transaction;
+        }
+        TESTS_ASSERT_EQUAL(offset, size);
+        // At most two transactions are smaller than a word
+        TESTS_ASSERT(count <= (size / 4) + 2);
+    }
+}
+
+void CompilerOpcodesTests::test(void)
+{
+    copy_method();
+    unrolled_transactions();
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "compiler/opcodes/BinaryOpcodes.h"
+#include "compiler/opcodes/ConstOpcodes.h"
+
+class ConstOpcodesTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    void fold_arithmetic(void);
+    void fold_shifts(void);
+    void fold_division(void);
+    void fold_compare(void);
+
+    /*
+     * Fold 'a operation b' and return the result. Throw if the operation
+     * wasn't folded.
+     */
+    static int fold(BinaryOpcodes::BinaryOperation operation, int a, int b);
+
+    /*
+     * Return true if 'a operation b' is left for the runtime
+     */
+    static bool isNotFolded(BinaryOpcodes::BinaryOperation operation, int a, int b);
+};
+
+// Instance test object
+ConstOpcodesTests g_globalConstOpcodes;
+
+int ConstOpcodesTests::fold(BinaryOpcodes::BinaryOperation operation, int a, int b)
+{
+    int result = 0;
+    TESTS_ASSERT(ConstOpcodes::fold32(operation, a, b, result));
+    return result;
+}
+
+bool ConstOpcodesTests::isNotFolded(BinaryOpcodes::BinaryOperation operation, int a, int b)
+{
+    int result = 0;
+    return !ConstOpcodes::fold32(operation, a, b, result);
+}
+
+void ConstOpcodesTests::fold_arithmetic(void)
+{
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_ADD, 2, 3), 5);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_SUB, 2, 3), -1);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_MUL, -7, 6), -42);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_AND, 0x0FF0, 0x00FF), 0x00F0);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_OR,  0x0F00, 0x00F0), 0x0FF0);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_XOR, 0x0FF0, 0x00FF), 0x0F0F);
+
+    // 32 bit wrap around
+    TESTS_ASSERT_EQUAL((uint32)fold(BinaryOpcodes::BIN_ADD, 0x7FFFFFFF, 1), 0x80000000);
+    TESTS_ASSERT_EQUAL((uint32)fold(BinaryOpcodes::BIN_SUB, (int)0x80000000, 1), 0x7FFFFFFF);
+    TESTS_ASSERT_EQUAL((uint32)fold(BinaryOpcodes::BIN_MUL, 0x10000, 0x10000), 0);
+}
+
+void ConstOpcodesTests::fold_shifts(void)
+{
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_SHL, 1, 31), (int)0x80000000);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_SHL, 3, 0), 3);
+
+    // shr is arithmetic, shr.un is logical
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_SHR, -8, 1), -4);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_SHR, -1, 31), -1);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_SHR, (int)0x80000000, 4), (int)0xF8000000);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_SHR, 0x40000000, 30), 1);
+    TESTS_ASSERT_EQUAL((uint32)fold(BinaryOpcodes::BIN_SHR_UN, -8, 1), 0x7FFFFFFC);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_SHR_UN, -1, 31), 1);
+
+    // Out of range shift counts are processor dependent
+    TESTS_ASSERT(isNotFolded(BinaryOpcodes::BIN_SHL, 1, 32));
+    TESTS_ASSERT(isNotFolded(BinaryOpcodes::BIN_SHR, -1, 32));
+    TESTS_ASSERT(isNotFolded(BinaryOpcodes::BIN_SHR_UN, 1, -1));
+}
+
+void ConstOpcodesTests::fold_division(void)
+{
+    // Signed division truncates toward zero
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_DIV, 7, 2), 3);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_DIV, -7, 2), -3);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_REM, -7, 2), -1);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_REM, 7, -2), 1);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_DIV, (int)0x80000000, 1), (int)0x80000000);
+
+    // Unsigned division
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_DIV_UN, -2, 2), 0x7FFFFFFF);
+    TESTS_ASSERT_EQUAL(fold(BinaryOpcodes::BIN_REM_UN, -1, 10), 5);
+
+    // Division by zero and overflow are raised at runtime
+    TESTS_ASSERT(isNotFolded(BinaryOpcodes::BIN_DIV, 1, 0));
+    TESTS_ASSERT(isNotFolded(BinaryOpcodes::BIN_REM, 1, 0));
+    TESTS_ASSERT(isNotFolded(BinaryOpcodes::BIN_DIV_UN, 1, 0));
+    TESTS_ASSERT(isNotFolded(BinaryOpcodes::BIN_REM_UN, 1, 0));
+    TESTS_ASSERT(isNotFolded(BinaryOpcodes::BIN_DIV, (int)0x80000000, -1));
+    TESTS_ASSERT(isNotFolded(BinaryOpcodes::BIN_REM, (int)0x80000000, -1));
+}
+
+void ConstOpcodesTests::fold_compare(void)
+{
+    bool result = false;
+    TESTS_ASSERT(ConstOpcodes::compare32(BinaryOpcodes::CMP_EQUAL, 5, 5, result));
+    TESTS_ASSERT(result);
+    TESTS_ASSERT(ConstOpcodes::compare32(BinaryOpcodes::CMP_EQUAL, 5, -5, result));
+    TESTS_ASSERT(!result);
+
+    // -1 is the largest unsigned number
+    TESTS_ASSERT(ConstOpcodes::compare32(BinaryOpcodes::CMP_GREATER_THEN, -1, 1, result));
+    TESTS_ASSERT(!result);
+    TESTS_ASSERT(ConstOpcodes::compare32(BinaryOpcodes::CMP_GREATER_THEN_UNSIGNED, -1, 1, result));
+    TESTS_ASSERT(result);
+    TESTS_ASSERT(ConstOpcodes::compare32(BinaryOpcodes::CMP_LESS_THEN, -1, 1, result));
+    TESTS_ASSERT(result);
+    TESTS_ASSERT(ConstOpcodes::compare32(BinaryOpcodes::CMP_LESS_THEN_UNSIGNED, -1, 1, result));
+    TESTS_ASSERT(!result);
+}
+
+void ConstOpcodesTests::test(void)
+{
+    fold_arithmetic();
+    fold_shifts();
+    fold_division();
+    fold_compare();
+}
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "dismount/proc/ia32/opcodeTable.h"
+#include "dismount/assembler/FirstPassBinary.h"
+#include "compiler/processors/ia32/IA32Encoder.h"
+
+class IA32EncoderTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    void copy_dwords(void);
+    void copy_dwords_swapped_registers(void);
+    void compare_byte_absolute(void);
+
+    // Return true if the current block of 'binary' holds exactly 'expected'
+    static bool isEncoded(FirstPassBinary& binary, const uint8* expected, uint size);
+};
+
+// Instance test object
+IA32EncoderTests g_globalIA32Encoder;
+
+bool IA32EncoderTests::isEncoded(FirstPassBinary& binary, const uint8* expected, uint size)
+{
+    const cBuffer& data = binary.getCurrentBlockData();
+    if (data.getSize() != size)
+        return false;
+    return memcmp(data.getBuffer(), expected, size) == 0;
+}
+
+void IA32EncoderTests::copy_dwords(void)
+{
+    FirstPassBinary binary(OpcodeSubsystems::DISASSEMBLER_INTEL_32, true);
+    IA32Encoder encoder(binary);
+    encoder.copyDwords(ia32dis::IA32_GP32_EAX, ia32dis::IA32_GP32_EDX, 5);
+
+    static const uint8 expected[] = {
+        0x56,                           // push esi
+        0x57,                           // push edi
+        0x51,                           // push ecx
+        0x52,                           // push edx      ; source
+        0x50,                           // push eax      ; destination
+        0x5F,                           // pop edi
+        0x5E,                           // pop esi
+        0xB9, 0x05, 0x00, 0x00, 0x00,   // mov ecx, 5
+        0xF3, 0xA5,                     // rep movsd
+        0x59,                           // pop ecx
+        0x5F,                           // pop edi
+        0x5E                            // pop esi
+    };
+    TESTS_ASSERT(isEncoded(binary, expected, sizeof(expected)));
+}
+
+void IA32EncoderTests::copy_dwords_swapped_registers(void)
+{
+    // The addresses may already be in the registers of rep movsd, in any
+    // order. They are passed through the stack, after esi and edi are saved
+    FirstPassBinary binary(OpcodeSubsystems::DISASSEMBLER_INTEL_32, true);
+    IA32Encoder encoder(binary);
+    encoder.copyDwords(ia32dis::IA32_GP32_ESI, ia32dis::IA32_GP32_EDI, 0x100);
+
+    static const uint8 expected[] = {
+        0x56,                           // push esi
+        0x57,                           // push edi
+        0x51,                           // push ecx
+        0x57,                           // push edi      ; source
+        0x56,                           // push esi      ; destination
+        0x5F,                           // pop edi
+        0x5E,                           // pop esi
+        0xB9, 0x00, 0x01, 0x00, 0x00,   // mov ecx, 100h
+        0xF3, 0xA5,                     // rep movsd
+        0x59,                           // pop ecx
+        0x5F,                           // pop edi
+        0x5E                            // pop esi
+    };
+    TESTS_ASSERT(isEncoded(binary, expected, sizeof(expected)));
+}
+
+void IA32EncoderTests::compare_byte_absolute(void)
+{
+    FirstPassBinary binary(OpcodeSubsystems::DISASSEMBLER_INTEL_32, true);
+    IA32Encoder encoder(binary);
+    // An instruction before, so the position is relative to the block
+    encoder.push(ia32dis::IA32_GP32_EAX);
+    uint position = encoder.compareByteAbsolute(0);
+
+    static const uint8 expected[] = {
+        0x50,                           // push eax
+        0x80, 0x3D,                     // cmp byte [disp32], imm8
+        0x66, 0x06, 0x60, 0x66,         // disp32, DEPENDENCY_PLACEHOLDER
+        0x00                            // imm8
+    };
+    TESTS_ASSERT(isEncoded(binary, expected, sizeof(expected)));
+    // The dependency is the address, which is followed by the immediate
+    TESTS_ASSERT_EQUAL(position, 3);
+}
+
+void IA32EncoderTests::test(void)
+{
+    copy_dwords();
+    copy_dwords_swapped_registers();
+    compare_byte_absolute();
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "xStl/os/os.h"
+#include "format/MSILInstructions.h"
+#include "compiler/MethodLoops.h"
+
+class MethodLoopsTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    void load_loop(void);
+    void store_loop(void);
+    void no_induction_variable(void);
+    void conditional_entry(void);
+    void unknown_bound(void);
+};
+
+// Instance test object
+MethodLoopsTests g_globalMethodLoops;
+
+/*
+ * int sum(int[] a)
+ * {
+ *     int s = 0;
+ *     for (int i = 0; i < a.Length; i++)
+ *         s+= a[i];
+ *     return s;
+ * }
+ */
+static const uint8 gLoadLoop[] = {0x16,       // 00: ldc.i4.0
+                                  0x0A,       // 01: stloc.0
+                                  0x16,       // 02: ldc.i4.0
+                                  0x0B,       // 03: stloc.1
+                                  0x2B, 0x0A, // 04: br.s 10
+                                  0x06,       // 06: ldloc.0
+                                  0x02,       // 07: ldarg.0
+                                  0x07,       // 08: ldloc.1
+                                  0x94,       // 09: ldelem.i4
+                                  0x58,       // 0A: add
+                                  0x0A,       // 0B: stloc.0
+                                  0x07,       // 0C: ldloc.1
+                                  0x17,       // 0D: ldc.i4.1
+                                  0x58,       // 0E: add
+                                  0x0B,       // 0F: stloc.1
+                                  0x07,       // 10: ldloc.1
+                                  0x02,       // 11: ldarg.0
+                                  0x8E,       // 12: ldlen
+                                  0x69,       // 13: conv.i4
+                                  0x32, 0xF0, // 14: blt.s 06
+                                  0x06,       // 16: ldloc.0
+                                  0x2A};      // 17: ret
+
+void MethodLoopsTests::load_loop(void)
+{
+    MSILInstructions instructions(gLoadLoop, sizeof(gLoadLoop));
+    MethodLoops loops(instructions);
+
+    // The condition at 10 is the header, the loop is entered by the 'br'
+    TESTS_ASSERT_EQUAL(loops.getLoopsCount(), 1U);
+    TESTS_ASSERT(loops.isLoopEntry(0x10, 0x04));
+    TESTS_ASSERT(!loops.isLoopEntry(0x10, 0x0F));
+    TESTS_ASSERT(!loops.isLoopEntry(0x06, 0x04));
+    TESTS_ASSERT(loops.isInLoop(0x10, 0x06));
+    TESTS_ASSERT(loops.isInLoop(0x10, 0x14));
+    TESTS_ASSERT(!loops.isInLoop(0x10, 0x04));
+    TESTS_ASSERT(!loops.isInLoop(0x10, 0x16));
+
+    // i++ moves the cursor, s+= doesn't
+    int step = 0;
+    TESTS_ASSERT(loops.getInductionStep(0x0F, step));
+    TESTS_ASSERT_EQUAL(step, 1);
+    TESTS_ASSERT(!loops.getInductionStep(0x0B, step));
+    TESTS_ASSERT(!loops.getInductionStep(0x03, step));
+
+    // a[i]
+    TESTS_ASSERT_EQUAL(loops.getCursors().length(), 1U);
+    const MethodLoops::Cursor& cursor = *loops.getCursors().begin();
+    TESTS_ASSERT_EQUAL(cursor.m_header, 0x10U);
+    TESTS_ASSERT(cursor.m_isArgument);
+    TESTS_ASSERT_EQUAL(cursor.m_array, 0U);
+    TESTS_ASSERT_EQUAL(cursor.m_inductionVariable, 1U);
+    TESTS_ASSERT_EQUAL(cursor.m_position, MAX_UINT32);
+}
+
+void MethodLoopsTests::store_loop(void)
+{
+    /*
+     * int[] b = a;
+     * for (int i = n; i < b.Length; i-= 2)
+     *     b[i] = 0;
+     */
+    static const uint8 storeLoop[] = {0x02,       // 00: ldarg.0
+                                      0x0A,       // 01: stloc.0
+                                      0x03,       // 02: ldarg.1
+                                      0x0B,       // 03: stloc.1
+                                      0x2B, 0x08, // 04: br.s 0E
+                                      0x06,       // 06: ldloc.0
+                                      0x07,       // 07: ldloc.1
+                                      0x16,       // 08: ldc.i4.0
+                                      0x9E,       // 09: stelem.i4
+                                      0x07,       // 0A: ldloc.1
+                                      0x18,       // 0B: ldc.i4.2
+                                      0x59,       // 0C: sub
+                                      0x0B,       // 0D: stloc.1
+                                      0x07,       // 0E: ldloc.1
+                                      0x06,       // 0F: ldloc.0
+                                      0x8E,       // 10: ldlen
+                                      0x69,       // 11: conv.i4
+                                      0x32, 0xF2, // 12: blt.s 06
+                                      0x2A};      // 14: ret
+    MSILInstructions instructions(storeLoop, sizeof(storeLoop));
+    MethodLoops loops(instructions);
+
+    TESTS_ASSERT_EQUAL(loops.getLoopsCount(), 1U);
+    TESTS_ASSERT(loops.isLoopEntry(0x0E, 0x04));
+
+    int step = 0;
+    TESTS_ASSERT(loops.getInductionStep(0x0D, step));
+    TESTS_ASSERT_EQUAL(step, -2);
+
+    TESTS_ASSERT_EQUAL(loops.getCursors().length(), 1U);
+    const MethodLoops::Cursor& cursor = *loops.getCursors().begin();
+    TESTS_ASSERT_EQUAL(cursor.m_header, 0x0EU);
+    TESTS_ASSERT(!cursor.m_isArgument);
+    TESTS_ASSERT_EQUAL(cursor.m_array, 0U);
+    TESTS_ASSERT_EQUAL(cursor.m_inductionVariable, 1U);
+}
+
+void MethodLoopsTests::no_induction_variable(void)
+{
+    // i*= 2 instead of i++
+    uint8 method[sizeof(gLoadLoop)];
+    cOS::memcpy(method, gLoadLoop, sizeof(gLoadLoop));
+    method[0x0D] = 0x18; // ldc.i4.2
+    method[0x0E] = 0x5A; // mul
+    MSILInstructions instructions(method, sizeof(method));
+    MethodLoops loops(instructions);
+
+    int step = 0;
+    TESTS_ASSERT_EQUAL(loops.getLoopsCount(), 1U);
+    TESTS_ASSERT(!loops.getInductionStep(0x0F, step));
+    TESTS_ASSERT_EQUAL(loops.getCursors().length(), 0U);
+
+    // Taking the address of the array makes it variant
+    cOS::memcpy(method, gLoadLoop, sizeof(gLoadLoop));
+    method[0x00] = 0x0F; // ldarga.s 0
+    method[0x01] = 0x00;
+    method[0x02] = 0x26; // pop
+    method[0x03] = 0x00; // nop
+    MSILInstructions addressTaken(method, sizeof(method));
+    MethodLoops addressTakenLoops(addressTaken);
+    TESTS_ASSERT_EQUAL(addressTakenLoops.getLoopsCount(), 1U);
+    TESTS_ASSERT_EQUAL(addressTakenLoops.getCursors().length(), 0U);
+}
+
+void MethodLoopsTests::conditional_entry(void)
+{
+    // brtrue.s instead of br.s. Both the body and the condition can be
+    // entered from the method start, so neither one dominates the other
+    uint8 method[sizeof(gLoadLoop)];
+    cOS::memcpy(method, gLoadLoop, sizeof(gLoadLoop));
+    method[0x04] = 0x2D; // brtrue.s 10
+    MSILInstructions instructions(method, sizeof(method));
+    MethodLoops loops(instructions);
+
+    TESTS_ASSERT_EQUAL(loops.getLoopsCount(), 0U);
+    TESTS_ASSERT(!loops.isLoopEntry(0x10, 0x04));
+    TESTS_ASSERT_EQUAL(loops.getCursors().length(), 0U);
+}
+
+void MethodLoopsTests::unknown_bound(void)
+{
+    /*
+     * for (int i = 0; i < n; i++)
+     *     s+= a[i];
+     *
+     * The loop may not run at all, so 'a' may be null
+     */
+    uint8 method[sizeof(gLoadLoop)];
+    cOS::memcpy(method, gLoadLoop, sizeof(gLoadLoop));
+    method[0x11] = 0x03; // ldarg.1
+    method[0x12] = 0x00; // nop
+    method[0x13] = 0x00; // nop
+    MSILInstructions instructions(method, sizeof(method));
+    MethodLoops loops(instructions);
+
+    int step = 0;
+    TESTS_ASSERT_EQUAL(loops.getLoopsCount(), 1U);
+    TESTS_ASSERT(loops.getInductionStep(0x0F, step));
+    TESTS_ASSERT_EQUAL(loops.getCursors().length(), 0U);
+
+    // The length of another array doesn't count
+    method[0x11] = 0x03; // ldarg.1
+    method[0x12] = 0x8E; // ldlen
+    method[0x13] = 0x69; // conv.i4
+    MSILInstructions otherInstructions(method, sizeof(method));
+    MethodLoops otherLoops(otherInstructions);
+    TESTS_ASSERT_EQUAL(otherLoops.getLoopsCount(), 1U);
+    TESTS_ASSERT_EQUAL(otherLoops.getCursors().length(), 0U);
+}
+
+void MethodLoopsTests::test(void)
+{
+    load_loop();
+    store_loop();
+    no_induction_variable();
+    conditional_entry();
+    unknown_bound();
+}
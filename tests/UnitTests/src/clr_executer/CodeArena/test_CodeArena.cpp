@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "executer/linker/CodeArena.h"
+
+#ifdef XSTL_LINUX
+    #include <sys/mman.h>
+#endif
+
+// 64 bit hosts can only hold 32 bit code in the low 2GB
+#if defined(XSTL_64BIT) && defined(XSTL_LINUX) && !defined(MAP_32BIT)
+    #define CODE_ARENA_UNSUPPORTED
+#endif
+
+class CodeArenaTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    void allocate_packed_aligned(void);
+    void allocate_larger_than_chunk(void);
+    void execute_then_write(void);
+    void bad_alignment(void);
+};
+
+// Instance test object
+CodeArenaTests g_globalCodeArena;
+
+void CodeArenaTests::allocate_packed_aligned(void)
+{
+    CodeArena arena(16);
+    TESTS_ASSERT(arena.isWritable());
+
+    // Two small methods share the same chunk, one alignment apart
+    uint8* p1 = (uint8*)arena.allocate(5);
+    uint8* p2 = (uint8*)arena.allocate(3);
+    TESTS_ASSERT(p1 != NULL);
+    TESTS_ASSERT_EQUAL(((addressNumericValue)p1) & 15, 0);
+#ifdef XSTL_64BIT
+    // The code is 32 bit
+    TESTS_ASSERT_EQUAL(((addressNumericValue)p1) >> 31, 0);
+#endif
+    TESTS_ASSERT_EQUAL(p2, p1 + 16);
+
+    // The memory can be written and read back
+    for (uint i = 0; i < 5; i++)
+        p1[i] = (uint8)(0xC0 + i);
+    p2[0] = 0xC3;
+    for (uint i = 0; i < 5; i++)
+        TESTS_ASSERT_EQUAL(p1[i], (uint8)(0xC0 + i));
+    TESTS_ASSERT_EQUAL(p2[0], 0xC3);
+}
+
+void CodeArenaTests::allocate_larger_than_chunk(void)
+{
+    CodeArena arena(16, 0x1000);
+    uint8* small = (uint8*)arena.allocate(0x10);
+    uint8* big = (uint8*)arena.allocate(0x3000);
+    TESTS_ASSERT(small != NULL);
+    TESTS_ASSERT(big != NULL);
+
+    // The whole allocation must be accessible
+    big[0] = 0x90;
+    big[0x2FFF] = 0xC3;
+    TESTS_ASSERT_EQUAL(big[0], 0x90);
+    TESTS_ASSERT_EQUAL(big[0x2FFF], 0xC3);
+}
+
+void CodeArenaTests::execute_then_write(void)
+{
+    CodeArena arena;
+    uint8* p = (uint8*)arena.allocate(4);
+    p[0] = 0xC3;
+
+    arena.makeExecutable();
+    TESTS_ASSERT(!arena.isWritable());
+    // The code is sealed, new methods cannot be added
+    TESTS_ALL_EXCEPTION(arena.allocate(4));
+
+    // The code is preserved while flipping the protection
+    arena.makeWritable();
+    TESTS_ASSERT(arena.isWritable());
+    TESTS_ASSERT_EQUAL(p[0], 0xC3);
+    uint8* q = (uint8*)arena.allocate(4);
+    TESTS_ASSERT_EQUAL(q, p + CodeArena::DEFAULT_ALIGNMENT);
+}
+
+void CodeArenaTests::bad_alignment(void)
+{
+    TESTS_ALL_EXCEPTION(CodeArena arena(3));
+    TESTS_ALL_EXCEPTION(CodeArena arena(0));
+}
+
+void CodeArenaTests::test(void)
+{
+#ifdef CODE_ARENA_UNSUPPORTED
+    TESTS_LOG("Code arena is not supported on this host" << endl);
+    return;
+#endif
+    allocate_packed_aligned();
+    allocate_larger_than_chunk();
+    execute_then_write();
+    bad_alignment();
+}
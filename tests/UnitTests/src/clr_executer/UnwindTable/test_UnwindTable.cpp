@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "executer/linker/UnwindTable.h"
+
+class UnwindTableTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    void sorted_insert(void);
+    void grow_keeps_old_array(void);
+    void find_function(void);
+    void find_empty(void);
+};
+
+// Instance test object
+UnwindTableTests g_globalUnwindTable;
+
+void UnwindTableTests::sorted_insert(void)
+{
+    UnwindTable table;
+    // Lazy methods are placed after the methods which call them, but the
+    // methods of a single link aren't always bound in address order
+    table.addFunction(0x2000, 0x100, 0x2080);
+    table.addFunction(0x1000, 0x200, 0);
+    table.addFunction(0x3000, 0x10, 0x3008);
+    table.addFunction(0x1800, 0x40, 0x1820);
+
+    TESTS_ASSERT_EQUAL(table.getCount(), 4);
+    TESTS_ASSERT_EQUAL(table.getFunction(0).m_start, 0x1000);
+    TESTS_ASSERT_EQUAL(table.getFunction(0).m_end, 0x1200);
+    TESTS_ASSERT_EQUAL(table.getFunction(0).m_data, 0);
+    TESTS_ASSERT_EQUAL(table.getFunction(1).m_start, 0x1800);
+    TESTS_ASSERT_EQUAL(table.getFunction(1).m_data, 0x1820);
+    TESTS_ASSERT_EQUAL(table.getFunction(2).m_start, 0x2000);
+    TESTS_ASSERT_EQUAL(table.getFunction(2).m_end, 0x2100);
+    TESTS_ASSERT_EQUAL(table.getFunction(3).m_start, 0x3000);
+    TESTS_ASSERT_EQUAL(table.getFunction(3).m_data, 0x3008);
+    TESTS_ALL_EXCEPTION(table.getFunction(4));
+}
+
+void UnwindTableTests::grow_keeps_old_array(void)
+{
+    UnwindTable table(2);
+    addressNumericValue header = table.getHeaderAddress();
+    table.addFunction(0x1000, 0x10, 0x1001);
+    table.addFunction(0x2000, 0x10, 0x2001);
+    const UnwindTable::Function* old = &table.getFunction(0);
+
+    // The array is full, a larger copy is published
+    table.addFunction(0x1800, 0x10, 0x1801);
+    table.addFunction(0x0800, 0x10, 0x0801);
+    table.addFunction(0x3000, 0x10, 0x3001);
+    TESTS_ASSERT_EQUAL(table.getCount(), 5);
+    TESTS_ASSERT(&table.getFunction(0) != old);
+    for (uint i = 1; i < table.getCount(); i++)
+        TESTS_ASSERT(table.getFunction(i - 1).m_start < table.getFunction(i).m_start);
+
+    // Compiled code refers to the header, it doesn't move. A dispatch which
+    // still reads the old array sees it unchanged
+    TESTS_ASSERT_EQUAL(table.getHeaderAddress(), header);
+    TESTS_ASSERT_EQUAL(old[0].m_start, 0x1000);
+    TESTS_ASSERT_EQUAL(old[1].m_start, 0x2000);
+    TESTS_ASSERT_EQUAL(old[1].m_data, 0x2001);
+
+    TESTS_ALL_EXCEPTION(UnwindTable empty(0));
+}
+
+void UnwindTableTests::find_function(void)
+{
+    UnwindTable table;
+    table.addFunction(0x1000, 0x100, 0x10F0);
+    table.addFunction(0x1100, 0x80, 0);
+    table.addFunction(0x2000, 0x20, 0x2010);
+
+    // A return address follows a call, it's never the start of the caller
+    TESTS_ASSERT(table.findFunction(0x1000) == NULL);
+    TESTS_ASSERT_EQUAL(table.findFunction(0x1001)->m_start, 0x1000);
+    TESTS_ASSERT_EQUAL(table.findFunction(0x1080)->m_data, 0x10F0);
+    // A call which is the last instruction returns to the end of the function
+    TESTS_ASSERT_EQUAL(table.findFunction(0x1100)->m_start, 0x1000);
+    TESTS_ASSERT_EQUAL(table.findFunction(0x1101)->m_start, 0x1100);
+    TESTS_ASSERT_EQUAL(table.findFunction(0x1180)->m_start, 0x1100);
+    // Gaps and addresses outside of the linked code
+    TESTS_ASSERT(table.findFunction(0x1181) == NULL);
+    TESTS_ASSERT(table.findFunction(0x1FFF) == NULL);
+    TESTS_ASSERT_EQUAL(table.findFunction(0x2020)->m_data, 0x2010);
+    TESTS_ASSERT(table.findFunction(0x2021) == NULL);
+    TESTS_ASSERT(table.findFunction(0x10) == NULL);
+}
+
+void UnwindTableTests::find_empty(void)
+{
+    UnwindTable table;
+    TESTS_ASSERT_EQUAL(table.getCount(), 0);
+    TESTS_ASSERT(table.findFunction(0x1000) == NULL);
+}
+
+void UnwindTableTests::test(void)
+{
+    sorted_insert();
+    grow_keeps_old_array();
+    find_function();
+    find_empty();
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "format/ByteCursor.h"
+#include "format/EncodingUtils.h"
+
+class ByteCursorTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    void read_integers(void);
+    void read_compressed_numbers(void);
+    void seek_and_sub_cursor(void);
+    void out_of_bounds(void);
+};
+
+// Instance test object
+ByteCursorTests g_globalByteCursor;
+
+void ByteCursorTests::read_integers(void)
+{
+    uint8 data[] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77};
+    ByteCursor cursor(data, sizeof(data));
+    TESTS_ASSERT_EQUAL(cursor.getLength(), sizeof(data));
+
+    TESTS_ASSERT_EQUAL(cursor.readUint8(), 0x11);
+    TESTS_ASSERT_EQUAL(cursor.readUint16(), 0x3322);
+    TESTS_ASSERT_EQUAL(cursor.readUint32(), 0x77665544);
+    TESTS_ASSERT_EQUAL(cursor.getPosition(), sizeof(data));
+    TESTS_ASSERT(cursor.isEOS());
+
+    cursor.seek(1);
+    TESTS_ASSERT_EQUAL(cursor.readIndex(false), 0x3322);
+    cursor.seek(0);
+    TESTS_ASSERT_EQUAL(cursor.readIndex(true), 0x44332211);
+}
+
+void ByteCursorTests::read_compressed_numbers(void)
+{
+    // 1 byte, 2 bytes and 4 bytes encoding (ECMA-335 II.23.2)
+    uint8 data[] = {0x03,
+                    0x80, 0x80,
+                    0xBF, 0xFF,
+                    0xC0, 0x00, 0x40, 0x00,
+                    0xDF, 0xFF, 0xFF, 0xFF};
+    ByteCursor cursor(data, sizeof(data));
+    TESTS_ASSERT_EQUAL(cursor.readCompressedNumber(), 0x03);
+    TESTS_ASSERT_EQUAL(cursor.readCompressedNumber(), 0x80);
+    TESTS_ASSERT_EQUAL(EncodingUtils::readCompressedNumber(cursor), 0x3FFF);
+    TESTS_ASSERT_EQUAL(cursor.readCompressedNumber(), 0x4000);
+    TESTS_ASSERT_EQUAL(cursor.readCompressedNumber(), 0x1FFFFFFF);
+    TESTS_ASSERT(cursor.isEOS());
+
+    // Bit 29 must be clear
+    uint8 invalid[] = {0xE0, 0x00, 0x00, 0x00};
+    ByteCursor invalidCursor(invalid, sizeof(invalid));
+    TESTS_ALL_EXCEPTION(invalidCursor.readCompressedNumber());
+
+    // Truncated 2 bytes and 4 bytes encoding
+    ByteCursor truncated2(data + 1, 1);
+    TESTS_ALL_EXCEPTION(truncated2.readCompressedNumber());
+    ByteCursor truncated4(data + 5, 3);
+    TESTS_ALL_EXCEPTION(truncated4.readCompressedNumber());
+}
+
+void ByteCursorTests::seek_and_sub_cursor(void)
+{
+    uint8 data[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06};
+    ByteCursor cursor(data, sizeof(data));
+
+    cursor.skip(1);
+    ByteCursor sub = cursor.readCursor(3);
+    TESTS_ASSERT_EQUAL(sub.getLength(), 3);
+    TESTS_ASSERT_EQUAL(sub.getCurrent(), data + 1);
+    TESTS_ASSERT_EQUAL(cursor.getPosition(), 4);
+    TESTS_ASSERT_EQUAL(cursor.getRemaining(), 2);
+
+    // The sub cursor is bounded by it's own range
+    TESTS_ASSERT_EQUAL(sub.readUint16(), 0x0302);
+    TESTS_ASSERT_EQUAL(sub.readUint8(), 0x04);
+    TESTS_ASSERT(sub.isEOS());
+    TESTS_ALL_EXCEPTION(sub.readUint8());
+
+    // Copies advance independently
+    ByteCursor copy = cursor;
+    TESTS_ASSERT_EQUAL(copy.readUint8(), 0x05);
+    TESTS_ASSERT_EQUAL(cursor.readUint8(), 0x05);
+
+    uint8 buffer[2];
+    cursor.seek(4);
+    cursor.read(buffer, sizeof(buffer));
+    TESTS_ASSERT_EQUAL(buffer[0], 0x05);
+    TESTS_ASSERT_EQUAL(buffer[1], 0x06);
+
+    // Seeking to the end is valid
+    cursor.seek(sizeof(data));
+    TESTS_ASSERT(cursor.isEOS());
+}
+
+void ByteCursorTests::out_of_bounds(void)
+{
+    uint8 data[] = {0x01, 0x02, 0x03};
+    ByteCursor cursor(data, sizeof(data));
+
+    TESTS_ALL_EXCEPTION(cursor.readUint32());
+    TESTS_ALL_EXCEPTION(cursor.seek(sizeof(data) + 1));
+    TESTS_ALL_EXCEPTION(cursor.skip(sizeof(data) + 1));
+    TESTS_ALL_EXCEPTION(cursor.readCursor(sizeof(data) + 1));
+
+    // A failed read doesn't move the cursor
+    TESTS_ASSERT_EQUAL(cursor.getPosition(), 0);
+    cursor.skip(2);
+    TESTS_ALL_EXCEPTION(cursor.readUint16());
+    TESTS_ASSERT_EQUAL(cursor.readUint8(), 0x03);
+
+    // An empty cursor cannot be read
+    ByteCursor empty;
+    TESTS_ASSERT(empty.isEOS());
+    TESTS_ALL_EXCEPTION(empty.readUint8());
+    TESTS_ALL_EXCEPTION(empty.readCompressedNumber());
+}
+
+void ByteCursorTests::test(void)
+{
+    read_integers();
+    read_compressed_numbers();
+    seek_and_sub_cursor();
+    out_of_bounds();
+}
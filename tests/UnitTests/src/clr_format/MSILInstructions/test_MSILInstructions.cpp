@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "format/MSILInstructions.h"
+
+class MSILInstructionsTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    void decode_method(void);
+    void instruction_index(void);
+    void bad_method(void);
+};
+
+// Instance test object
+MSILInstructionsTests g_globalMSILInstructions;
+
+// ldarg.0; ldc.i4.s -5; ceq; brfalse.s -7 (0); ldc.i4 0x12345678; ret
+static const uint8 gMethod[] = {0x02,
+                                0x1F, 0xFB,
+                                0xFE, 0x01,
+                                0x2C, 0xF9,
+                                0x20, 0x78, 0x56, 0x34, 0x12,
+                                0x2A};
+
+void MSILInstructionsTests::decode_method(void)
+{
+    MSILInstructions instructions(gMethod, sizeof(gMethod));
+    TESTS_ASSERT_EQUAL(instructions.getCount(), 6);
+    TESTS_ASSERT_EQUAL(instructions.getCode().getSize(), sizeof(gMethod));
+
+    // ldarg.0
+    TESTS_ASSERT_EQUAL(instructions[0].m_offset, 0);
+    TESTS_ASSERT_EQUAL(instructions[0].m_nextOffset, 1);
+    TESTS_ASSERT(!instructions[0].isExtended());
+    TESTS_ASSERT_EQUAL(instructions[0].getOpcodeByte(), 0x02);
+
+    // ldc.i4.s is sign extended
+    TESTS_ASSERT_EQUAL(instructions[1].m_offset, 1);
+    TESTS_ASSERT_EQUAL(instructions[1].getOpcodeByte(), 0x1F);
+    TESTS_ASSERT_EQUAL((int32)instructions[1].getUint32(), -5);
+
+    // ceq is a two bytes opcode
+    TESTS_ASSERT_EQUAL(instructions[2].m_offset, 3);
+    TESTS_ASSERT(instructions[2].isExtended());
+    TESTS_ASSERT_EQUAL(instructions[2].m_opcode, 0xFE01);
+    TESTS_ASSERT_EQUAL(instructions[2].getOpcodeByte(), 0x01);
+
+    // brfalse.s goes backward to the first instruction
+    TESTS_ASSERT_EQUAL(instructions[3].m_offset, 5);
+    TESTS_ASSERT_EQUAL(instructions[3].m_nextOffset, 7);
+    TESTS_ASSERT_EQUAL(instructions[3].getBranchOffset(), -7);
+    TESTS_ASSERT_EQUAL(instructions[3].getBranchTarget(), 0);
+
+    // ldc.i4
+    TESTS_ASSERT_EQUAL(instructions[4].m_offset, 7);
+    TESTS_ASSERT_EQUAL(instructions[4].m_nextOffset, 12);
+    TESTS_ASSERT_EQUAL(instructions[4].getUint32(), 0x12345678);
+
+    // ret
+    TESTS_ASSERT_EQUAL(instructions[5].m_offset, 12);
+    TESTS_ASSERT_EQUAL(instructions[5].m_nextOffset, sizeof(gMethod));
+    TESTS_ASSERT_EQUAL(instructions[5].getOpcodeByte(), 0x2A);
+}
+
+void MSILInstructionsTests::instruction_index(void)
+{
+    MSILInstructions instructions(gMethod, sizeof(gMethod));
+    TESTS_ASSERT_EQUAL(instructions.getInstructionIndex(0), 0);
+    TESTS_ASSERT_EQUAL(instructions.getInstructionIndex(1), 1);
+    TESTS_ASSERT_EQUAL(instructions.getInstructionIndex(3), 2);
+    TESTS_ASSERT_EQUAL(instructions.getInstructionIndex(5), 3);
+    TESTS_ASSERT_EQUAL(instructions.getInstructionIndex(7), 4);
+    TESTS_ASSERT_EQUAL(instructions.getInstructionIndex(12), 5);
+
+    // The middle of an instruction and the end of the method
+    TESTS_ASSERT_EQUAL(instructions.getInstructionIndex(2), MAX_UINT32);
+    TESTS_ASSERT_EQUAL(instructions.getInstructionIndex(4), MAX_UINT32);
+    TESTS_ASSERT_EQUAL(instructions.getInstructionIndex(8), MAX_UINT32);
+    TESTS_ASSERT_EQUAL(instructions.getInstructionIndex(sizeof(gMethod)), MAX_UINT32);
+}
+
+void MSILInstructionsTests::bad_method(void)
+{
+    // Unknown opcode
+    static const uint8 unknown[] = {0x00, 0x24, 0x2A};
+    TESTS_ALL_EXCEPTION(MSILInstructions instructions(unknown, sizeof(unknown)));
+
+    // Truncated ldc.i4
+    static const uint8 truncated[] = {0x20, 0x01};
+    TESTS_ALL_EXCEPTION(MSILInstructions instructions(truncated, sizeof(truncated)));
+
+    // Truncated two bytes opcode
+    static const uint8 extended[] = {0xFE};
+    TESTS_ALL_EXCEPTION(MSILInstructions instructions(extended, sizeof(extended)));
+}
+
+void MSILInstructionsTests::test(void)
+{
+    decode_method();
+    instruction_index();
+    bad_method();
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "format/ByteCursor.h"
+#include "format/signatures/FieldSig.h"
+#include "format/signatures/MethodDefOrRefSignature.h"
+#include "data/ElementType.h"
+#include "runnable/ResolverInterface.h"
+
+/*
+ * A resolver for signatures which reference only primitive types. Any query
+ * other than resolveTyperef is a test failure.
+ */
+class PrimitiveResolver : public ResolverInterface
+{
+public:
+    virtual void resolveTyperef(ElementType& type) const {}
+    virtual void resolveFieldref(TokenIndex& fieldToken, const TokenIndex& parentType) const { CHECK_FAIL(); }
+    virtual uint getTypeSize(const TokenIndex& typeToken) const { CHECK_FAIL(); }
+    virtual uint getTypeSize(const ElementType& typeToken) const { CHECK_FAIL(); }
+    virtual bool isTypeInterface(const TokenIndex& typeToken) const { CHECK_FAIL(); }
+    virtual bool isTypeShouldDref(const TokenIndex& typeToken) const { CHECK_FAIL(); }
+    virtual const VirtualTable& getVirtualTable(const TokenIndex& typedefToken) const { CHECK_FAIL(); }
+    virtual const ParentDictonary& getParentDirectory(const TokenIndex& typedefToken) const { CHECK_FAIL(); }
+    virtual const uint getRTTI(const TokenIndex& typedefToken) const { CHECK_FAIL(); }
+    virtual const FieldsDictonary& getAllFields(const TokenIndex& parentToken) const { CHECK_FAIL(); }
+    virtual uint getFieldRelativePosition(const TokenIndex& fieldToken,
+                                          const TokenIndex& parentToken) const { CHECK_FAIL(); }
+    virtual const ElementType& getFieldType(const TokenIndex& fieldToken,
+                                            const TokenIndex& parentToken) const { CHECK_FAIL(); }
+    virtual uint getStaticFieldOffset(const TokenIndex& fieldToken) const { CHECK_FAIL(); }
+    virtual TokenIndex allocateStatic(uint size) { CHECK_FAIL(); }
+    virtual uint allocateDataSection(cForkStreamPtr& stream, uint size) { CHECK_FAIL(); }
+    virtual const cBuffer& getDataSection() { CHECK_FAIL(); }
+    virtual TokenIndex getStaticInitializerMethod(const TokenIndex& typeToken) const { CHECK_FAIL(); }
+    virtual uint getStaticTotalLength() const { CHECK_FAIL(); }
+    virtual TokenIndex getTypeToken(const cString& _namespace, const cString& _className) const { CHECK_FAIL(); }
+    virtual TokenIndex getNewGenericInstanceToken(const ElementType& type) { CHECK_FAIL(); }
+    virtual bool isTypedefClass(const TokenIndex& typeToken) const { CHECK_FAIL(); }
+    virtual const cBuffer& getTypeHashSignature(const TokenIndex& typeToken) const { CHECK_FAIL(); }
+};
+
+class SignaturesTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    void read_element_types(void);
+    void read_field_signature(void);
+    void read_method_signature(void);
+    void bad_signatures(void);
+
+    enum { APARTMENT_ID = 3 };
+};
+
+// Instance test object
+SignaturesTests g_globalSignatures;
+
+void SignaturesTests::read_element_types(void)
+{
+    // int32; uint8*; int32&; int32[]; class TypeDef(2)
+    uint8 data[] = {ELEMENT_TYPE_I4,
+                    ELEMENT_TYPE_PTR, ELEMENT_TYPE_U1,
+                    ELEMENT_TYPE_BYREF, ELEMENT_TYPE_I4,
+                    ELEMENT_TYPE_SZARRAY, ELEMENT_TYPE_I4,
+                    ELEMENT_TYPE_CLASS, 0x08};
+    ByteCursor cursor(data, sizeof(data));
+
+    ElementType i4 = ElementType::readType(cursor, APARTMENT_ID);
+    TESTS_ASSERT_EQUAL(i4.getType(), ELEMENT_TYPE_I4);
+    TESTS_ASSERT(!i4.isPointer());
+    TESTS_ASSERT(!i4.isReference());
+    TESTS_ASSERT(!i4.isSingleDimensionArray());
+
+    ElementType pointer = ElementType::readType(cursor, APARTMENT_ID);
+    TESTS_ASSERT_EQUAL(pointer.getType(), ELEMENT_TYPE_U1);
+    TESTS_ASSERT(pointer.isPointer());
+    TESTS_ASSERT_EQUAL(pointer.getPointerLevel(), 1);
+
+    ElementType reference = ElementType::readType(cursor, APARTMENT_ID);
+    TESTS_ASSERT_EQUAL(reference.getType(), ELEMENT_TYPE_I4);
+    TESTS_ASSERT(reference.isReference());
+    TESTS_ASSERT(!reference.isPointer());
+
+    ElementType array = ElementType::readType(cursor, APARTMENT_ID);
+    TESTS_ASSERT_EQUAL(array.getType(), ELEMENT_TYPE_I4);
+    TESTS_ASSERT(array.isSingleDimensionArray());
+
+    ElementType classType = ElementType::readType(cursor, APARTMENT_ID);
+    TESTS_ASSERT_EQUAL(classType.getType(), ELEMENT_TYPE_CLASS);
+    TESTS_ASSERT_EQUAL(getTokenID(classType.getClassToken()), 0x02000002);
+    TESTS_ASSERT_EQUAL(getApartmentID(classType.getClassToken()), APARTMENT_ID);
+
+    TESTS_ASSERT(cursor.isEOS());
+}
+
+void SignaturesTests::read_field_signature(void)
+{
+    PrimitiveResolver resolver;
+
+    // Length, FIELD, uint8*. The trailing byte belongs to the next blob
+    uint8 data[] = {0x03, 0x06, ELEMENT_TYPE_PTR, ELEMENT_TYPE_U1, 0xFF};
+    FieldSig field(ByteCursor(data, sizeof(data)), APARTMENT_ID, resolver);
+    TESTS_ASSERT_EQUAL(field.getType().getType(), ELEMENT_TYPE_U1);
+    TESTS_ASSERT(field.getType().isPointer());
+}
+
+void SignaturesTests::read_method_signature(void)
+{
+    PrimitiveResolver resolver;
+
+    // instance void (int32, int32&)
+    uint8 data[] = {0x05, 0x20, 0x02, ELEMENT_TYPE_VOID,
+                    ELEMENT_TYPE_I4,
+                    ELEMENT_TYPE_BYREF, ELEMENT_TYPE_I4};
+    data[0] = sizeof(data) - 1;
+    MethodDefOrRefSignature method(ByteCursor(data, sizeof(data)), APARTMENT_ID, resolver);
+    TESTS_ASSERT(method.isHasThis());
+    TESTS_ASSERT(!method.isExplicitThis());
+    TESTS_ASSERT_EQUAL(method.getCallingConvention(), MethodDefOrRefSignature::CALLCONV_DEFAULT);
+    TESTS_ASSERT_EQUAL(method.getReturnType().getType(), ELEMENT_TYPE_VOID);
+    TESTS_ASSERT_EQUAL(method.getParams().getSize(), 2);
+    TESTS_ASSERT_EQUAL(method.getParams()[0].getType(), ELEMENT_TYPE_I4);
+    TESTS_ASSERT(!method.getParams()[0].isReference());
+    TESTS_ASSERT_EQUAL(method.getParams()[1].getType(), ELEMENT_TYPE_I4);
+    TESTS_ASSERT(method.getParams()[1].isReference());
+
+    // static int32 ()
+    uint8 staticData[] = {0x03, 0x00, 0x00, ELEMENT_TYPE_I4};
+    MethodDefOrRefSignature staticMethod(ByteCursor(staticData, sizeof(staticData)), APARTMENT_ID, resolver);
+    TESTS_ASSERT(!staticMethod.isHasThis());
+    TESTS_ASSERT_EQUAL(staticMethod.getReturnType().getType(), ELEMENT_TYPE_I4);
+    TESTS_ASSERT_EQUAL(staticMethod.getParams().getSize(), 0);
+}
+
+void SignaturesTests::bad_signatures(void)
+{
+    PrimitiveResolver resolver;
+
+    // Not a field signature
+    uint8 notField[] = {0x02, 0x07, ELEMENT_TYPE_I4};
+    TESTS_ALL_EXCEPTION(FieldSig field(ByteCursor(notField, sizeof(notField)), APARTMENT_ID, resolver));
+
+    // The length crosses the end of the blob
+    uint8 truncated[] = {0x04, 0x06, ELEMENT_TYPE_I4};
+    TESTS_ALL_EXCEPTION(FieldSig field(ByteCursor(truncated, sizeof(truncated)), APARTMENT_ID, resolver));
+
+    // The parameters cross the length of the signature
+    uint8 missingParam[] = {0x03, 0x00, 0x01, ELEMENT_TYPE_VOID, ELEMENT_TYPE_I4};
+    TESTS_ALL_EXCEPTION(MethodDefOrRefSignature method(ByteCursor(missingParam, sizeof(missingParam)), APARTMENT_ID, resolver));
+
+    // Unknown element type
+    uint8 unknown[] = {0x02, 0x06, 0x3F};
+    TESTS_ALL_EXCEPTION(FieldSig field(ByteCursor(unknown, sizeof(unknown)), APARTMENT_ID, resolver));
+}
+
+void SignaturesTests::test(void)
+{
+    read_element_types();
+    read_field_signature();
+    read_method_signature();
+    bad_signatures();
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2008-2016, Integrity Project Ltd. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * Neither the name of the Integrity Project nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE
+ */
+
+#include "../../tests.h"
+#include "xStl/types.h"
+#include "xStl/data/datastream.h"
+#include "xStl/stream/memoryStream.h"
+#include "data/ElementType.h"
+#include "runnable/MemoryLayoutInterface.h"
+#include "runnable/StringRepository.h"
+
+/*
+ * Strings are aligned to 4 bytes, as on ARM
+ */
+class DwordMemoryLayout : public MemoryLayoutInterface
+{
+public:
+    virtual uint pointerWidth() const { return sizeof(uint32); }
+    virtual uint align(uint size) const { return (size + 3) & ~3; }
+};
+
+/*
+ * Strings are packed, as on IA32
+ */
+class PackedMemoryLayout : public MemoryLayoutInterface
+{
+public:
+    virtual uint pointerWidth() const { return sizeof(uint32); }
+    virtual uint align(uint size) const { return size; }
+};
+
+class StringRepositoryTests : public cTestObject
+{
+public:
+    virtual void test();
+    virtual cString getName() { return __FILE__; }
+
+private:
+    // Add a string the same way the compiler does, from the UTF-16 content of
+    // an ldstr. Return the serialized name
+    static cString addString(StringRepository& repository,
+                             const char* content,
+                             const TokenIndex& token);
+    // Return true if the repository holds 'content' at 'offset'
+    static bool isStringAt(StringRepository& repository,
+                           uint offset,
+                           const char* content);
+
+    void pool_identical_strings(void);
+    void merge_aligned_tails(void);
+    void merge_packed_tails(void);
+    void serialize_deserialize(void);
+};
+
+// Instance test object
+StringRepositoryTests g_globalStringRepository;
+
+cString StringRepositoryTests::addString(StringRepository& repository,
+                                         const char* content,
+                                         const TokenIndex& token)
+{
+    uint length = (uint)strlen(content);
+    cBuffer utf16(length * 2);
+    for (uint i = 0; i < length; i++)
+    {
+        utf16.getBuffer()[i * 2] = (uint8)content[i];
+        utf16.getBuffer()[i * 2 + 1] = 0;
+    }
+    cMemoryStream stream(utf16);
+    cForkStreamPtr forked = stream.fork();
+    return repository.serializeString(forked, length * 2, token);
+}
+
+bool StringRepositoryTests::isStringAt(StringRepository& repository,
+                                       uint offset,
+                                       const char* content)
+{
+    const cBuffer& strings = repository.getAsciiStringRepository();
+    uint length = (uint)strlen(content);
+    if (offset + length > strings.getSize())
+        return false;
+    return memcmp(strings.getBuffer() + offset, content, length) == 0;
+}
+
+void StringRepositoryTests::pool_identical_strings(void)
+{
+    DwordMemoryLayout layout;
+    StringRepository repository(ApartmentPtr(), layout);
+    TokenIndex first = buildTokenIndex(1, 0x70000001);
+    TokenIndex other = buildTokenIndex(2, 0x70000001);
+    TokenIndex world = buildTokenIndex(1, 0x70000009);
+    addString(repository, "hello", first);
+    // The same content in another apartment shares the copy
+    addString(repository, "hello", other);
+    addString(repository, "world", world);
+
+    TESTS_ASSERT_EQUAL(repository.getStringOffset(first), repository.getStringOffset(other));
+    TESTS_ASSERT_EQUAL(repository.getStringLength(other), 5);
+    TESTS_ASSERT(repository.getString(other) == "hello");
+    TESTS_ASSERT(repository.getStringOffset(world) != repository.getStringOffset(first));
+    TESTS_ASSERT(isStringAt(repository, repository.getStringOffset(world), "world"));
+    // Each copy is aligned
+    TESTS_ASSERT_EQUAL(repository.getAsciiStringRepository().getSize(), 16);
+}
+
+void StringRepositoryTests::merge_aligned_tails(void)
+{
+    DwordMemoryLayout layout;
+    StringRepository repository(ApartmentPtr(), layout);
+    repository.setTailMerging(true);
+    TokenIndex root = buildTokenIndex(1, 0x70000001);
+    TokenIndex tail = buildTokenIndex(1, 0x70000011);
+    TokenIndex other = buildTokenIndex(1, 0x70000021);
+    TokenIndex unaligned = buildTokenIndex(1, 0x70000031);
+    addString(repository, "1234tail", root);
+    addString(repository, "tail", tail);
+    addString(repository, "xtail", other);
+    addString(repository, "ail", unaligned);
+
+    // "tail" starts 4 bytes inside "1234tail"
+    uint rootOffset = repository.getStringOffset(root);
+    TESTS_ASSERT_EQUAL(repository.getStringOffset(tail), rootOffset + 4);
+    TESTS_ASSERT_EQUAL(repository.getStringLength(tail), 4);
+    TESTS_ASSERT(isStringAt(repository, repository.getStringOffset(tail), "tail"));
+
+    // "ail" would start at an unaligned offset inside any other string, so
+    // it's stored by itself
+    uint offset = repository.getStringOffset(unaligned);
+    TESTS_ASSERT_EQUAL(offset & 3, 0);
+    TESTS_ASSERT(isStringAt(repository, offset, "ail"));
+    TESTS_ASSERT_EQUAL(repository.getStringOffset(other) & 3, 0);
+    TESTS_ASSERT(isStringAt(repository, repository.getStringOffset(other), "xtail"));
+
+    // "1234tail", "xtail" and "ail"
+    TESTS_ASSERT_EQUAL(repository.getAsciiStringRepository().getSize(), 8 + 8 + 4);
+}
+
+void StringRepositoryTests::merge_packed_tails(void)
+{
+    PackedMemoryLayout layout;
+    StringRepository repository(ApartmentPtr(), layout);
+    repository.setTailMerging(true);
+    TokenIndex root = buildTokenIndex(1, 0x70000001);
+    TokenIndex tail = buildTokenIndex(1, 0x70000011);
+    TokenIndex other = buildTokenIndex(1, 0x70000021);
+    TokenIndex shortTail = buildTokenIndex(1, 0x70000031);
+    addString(repository, "1234tail", root);
+    addString(repository, "tail", tail);
+    addString(repository, "xtail", other);
+    addString(repository, "ail", shortTail);
+
+    // Without alignment, both tails point into "1234tail"
+    uint rootOffset = repository.getStringOffset(root);
+    TESTS_ASSERT_EQUAL(repository.getStringOffset(tail), rootOffset + 4);
+    TESTS_ASSERT_EQUAL(repository.getStringOffset(shortTail), rootOffset + 5);
+    TESTS_ASSERT(isStringAt(repository, repository.getStringOffset(other), "xtail"));
+    TESTS_ASSERT_EQUAL(repository.getAsciiStringRepository().getSize(), 8 + 5);
+
+    // The layout is fixed, later strings are appended without merging
+    TokenIndex late = buildTokenIndex(1, 0x70000041);
+    addString(repository, "il", late);
+    TESTS_ASSERT_EQUAL(repository.getStringOffset(late), 8 + 5);
+    TESTS_ASSERT_EQUAL(repository.getStringOffset(tail), rootOffset + 4);
+    TESTS_ASSERT_EQUAL(repository.getAsciiStringRepository().getSize(), 8 + 5 + 2);
+}
+
+void StringRepositoryTests::serialize_deserialize(void)
+{
+    DwordMemoryLayout layout;
+    StringRepository repository(ApartmentPtr(), layout);
+    TokenIndex token = buildTokenIndex(3, 0x7000002A);
+    cString name = addString(repository, "serialized", token);
+    TESTS_ASSERT(name == StringRepository::serializeString(token));
+
+    TokenIndex parsed;
+    TESTS_ASSERT(StringRepository::deserializeStringToken(name, parsed));
+    TESTS_ASSERT(parsed == token);
+
+    uint offset = 0xFFFFFFFF;
+    TokenIndex resolved;
+    TESTS_ASSERT(repository.deserializeStringA(name, offset, &resolved));
+    TESTS_ASSERT(resolved == token);
+    TESTS_ASSERT_EQUAL(offset, repository.getStringOffset(token));
+    TESTS_ASSERT(isStringAt(repository, offset, "serialized"));
+
+    // Other dependencies are not strings
+    TESTS_ASSERT(!StringRepository::deserializeStringToken("?CIL?STD?UNWIND?DATA", parsed));
+    TESTS_ASSERT(!repository.deserializeStringA("?CIL?STD?UNWIND?DATA", offset));
+}
+
+void StringRepositoryTests::test(void)
+{
+    pool_identical_strings();
+    merge_aligned_tails();
+    merge_packed_tails();
+    serialize_deserialize();
+}
@@ -1,6 +1,9 @@
 import os
+import re
 import sys
 import glob
+import shutil
+import tempfile
 import unittest
 import subprocess
 
@@ -65,7 +68,78 @@ class ExeTestCase(unittest.TestCase):
         tc_exe_cmd = [self.test_compiler, self.test_compiler_clrcore_dll, self.exe]
         result = self.__run_exe(tc_exe_cmd)
         return result
+
+    def __run_tc_lazy_exe(self):
+        ## Methods are compiled and linked on their first call
+        print 'Running exe (test_compiler, lazy)'
+        tc_exe_cmd = [self.test_compiler, '-o', 'x86-lazy', self.test_compiler_clrcore_dll, self.exe]
+        result = self.__run_exe(tc_exe_cmd)
+        return result
     
+    def __link_tc_32c(self, output_directory, units_count):
+        ## Link the C sources into a directory, split over several units
+        print 'Linking exe (test_compiler, 32c)'
+        tc_exe_cmd = [self.test_compiler, '-o', '32c', '-d', output_directory, '-u', str(units_count),
+                      self.test_compiler_clrcore_dll, self.exe]
+        result = self.__run_exe(tc_exe_cmd)
+        self.assertEqual(result.retcode, 0, 'Linking 32c failed:\n%s' % result)
+
+    def __check_32c_output(self, output_directory, units_count):
+        ## Read back the files of the file linker and check that every
+        ## dependency of the units is declared by output.h, and that every
+        ## relocation falls inside its table
+        print 'Check 32c output...'
+        header = open(os.path.join(output_directory, 'output.h')).read()
+        units = []
+        for index in range(units_count):
+            name = 'output.c'
+            if index > 0:
+                name = 'output%d.c' % index
+            units.append(open(os.path.join(output_directory, name)).read())
+        self.assertFalse(os.path.exists(os.path.join(output_directory, 'output%d.c' % units_count)))
+
+        # The relocations of the shared tables
+        string_table = re.search(r'gStringTable\[\] = \{(.*?)\};', units[0], re.S)
+        string_table_size = 0
+        if string_table is not None:
+            string_table_size = len(re.findall(r'0x[0-9A-F]{2}', string_table.group(1)))
+        globals_size = int(re.search(r'g32CGlobals\[0x([0-9A-F]+)\];', units[0]).group(1), 16)
+        declared = set()
+        for name, offset in re.findall(r'#define (str[0-9A-F]{16}) \(gStringTable \+ (\d+)\)', header):
+            self.assertTrue(int(offset) < string_table_size, '%s is outside the string table' % name)
+            declared.add(name)
+        for name, offset in re.findall(r'#define (glbl[0-9A-F]{16}) \(g32CGlobals \+ (\d+)\)', header):
+            self.assertTrue(int(offset) < globals_size, '%s is outside the globals' % name)
+            declared.add(name)
+        declared.update(re.findall(r'extern int\* (vtbl[0-9A-F]{16});', header))
+        # Imported and exported methods are renamed by the header
+        declared.update(re.findall(r'#define (func[0-9A-F]{16}) ', header))
+
+        # Every method is defined by exactly one unit
+        prototypes = set(re.findall(r'^int (func[0-9A-F]{16})\(', header, re.M))
+        defined = []
+        for unit in units:
+            defined+= re.findall(r'^int (func[0-9A-F]{16})\(', unit, re.M)
+        self.assertEqual(len(defined), len(set(defined)), 'A method is defined twice')
+        self.assertEqual(set(defined), prototypes)
+        declared.update(prototypes)
+
+        # Every dependency of the units is resolved
+        for unit in units:
+            for name in set(re.findall(r'\b((?:str|glbl|vtbl|func)[0-9A-F]{16})\b', unit)):
+                self.assertTrue(name in declared, '%s is not declared by output.h' % name)
+        for name in re.findall(r'\bvtbl([0-9A-F]{16}) = impl_vtbl', units[0]):
+            self.assertTrue(('vtbl' + name) in declared)
+
+    def __run_tc_32c(self):
+        units_count = 3
+        output_directory = tempfile.mkdtemp()
+        try:
+            self.__link_tc_32c(output_directory, units_count)
+            self.__check_32c_output(output_directory, units_count)
+        finally:
+            shutil.rmtree(output_directory)
+
     def __check_mismatch(self, native_exe_result, tc_exe_result):
         print 'Check for mismatch...'
         
@@ -100,6 +174,9 @@ class ExeTestCase(unittest.TestCase):
         native_exe_result = self.__run_native_exe()
         tc_exe_result = self.__run_tc_exe()
         self.__check_mismatch(native_exe_result, tc_exe_result)
+        tc_lazy_exe_result = self.__run_tc_lazy_exe()
+        self.__check_mismatch(native_exe_result, tc_lazy_exe_result)
+        self.__run_tc_32c()
         print 40 * '='
     
 def __generate_suite(test_compiler, exes):
@@ -88,9 +88,9 @@ void printTable(Resolver& resolver,
     case TABLE_TYPESPEC_TABLE:
         {
             const TypeSpecTable::Header& typeSpec = ((TypeSpecTable&)(*table)).getHeader();
-            cForkStreamPtr blob = streams.getBlobStream()->fork();
-            blob->seek(typeSpec.m_signature + 1, basicInput::IO_SEEK_SET);
-            ElementType temp = ElementType::readType(*blob, 0);
+            ByteCursor blob = streams.getBlob(typeSpec.m_signature);
+            blob = blob.readCursor(EncodingUtils::readCompressedNumber(blob));
+            ElementType temp = ElementType::readType(blob, 0);
             output << temp << endl;
             break;
         }
@@ -125,9 +125,7 @@ void printTable(Resolver& resolver,
                 ((MemberRefTable&)(*table)).getHeader();
 
             // Read the method signature
-            cMemoryAccesserStreamPtr blob = streams.getBlobStream();
-            blob->seek(memberRefTable.m_signature, basicInput::IO_SEEK_SET);
-            MethodDefOrRefSignature methodSignature(*blob, 0, resolver);
+            MethodDefOrRefSignature methodSignature(streams.getBlob(memberRefTable.m_signature), 0, resolver);
             output << methodSignature << endl;
 
             output << "Class parsing: " << endl;
@@ -146,9 +144,7 @@ void printTable(Resolver& resolver,
                 ((FieldTable&)(*table)).getHeader();
 
             // Read the signature
-            cMemoryAccesserStreamPtr blob = streams.getBlobStream();
-            blob->seek(fieldHeader.m_signature, basicInput::IO_SEEK_SET);
-            FieldSig fieldType(*blob, 0, resolver);
+            FieldSig fieldType(streams.getBlob(fieldHeader.m_signature), 0, resolver);
             output << "typedef: " << fieldType.getType() << endl;
         }
         break;
@@ -160,9 +156,7 @@ void printTable(Resolver& resolver,
             const MethodTable::Header& methodHeader = methodTable.getHeader();
 
             // Read the method signature
-            cMemoryAccesserStreamPtr blob = streams.getBlobStream();
-            blob->seek(methodHeader.m_signature, basicInput::IO_SEEK_SET);
-            MethodDefOrRefSignature methodSignature(*blob, 0, resolver);
+            MethodDefOrRefSignature methodSignature(streams.getBlob(methodHeader.m_signature), 0, resolver);
             output << methodSignature << endl;
 
             // Parse the method's param